@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include "CandleAggregator.h"
+#include "EventBus.h"
+
+static const char* const INTERVAL_NAMES[CandleAggregator::INTERVAL_COUNT] = { "1s", "1m", "5m", "1h" };
+static const int64_t     INTERVAL_NS[CandleAggregator::INTERVAL_COUNT]    = {
+    1000000000LL, 60000000000LL, 300000000000LL, 3600000000000LL
+};
+
+CandleAggregator::CandleAggregator(EventBus* bus) : bus_(bus) {
+}
+
+int CandleAggregator::intervalIndex(const std::string& name) {
+    for (int i = 0; i < INTERVAL_COUNT; ++i)
+        if (name == INTERVAL_NAMES[i]) return i;
+    return -1;
+}
+
+const char* CandleAggregator::intervalName(int interval) {
+    return INTERVAL_NAMES[interval];
+}
+
+int64_t CandleAggregator::intervalNs(int interval) {
+    return INTERVAL_NS[interval];
+}
+
+// ── Aggregation ───────────────────────────────────────────────────────────────
+
+void CandleAggregator::apply(Series& s, int64_t intervalNs, const TradeRecord& r) {
+    const int64_t start = r.tsNs - r.tsNs % intervalNs;
+    const double  price = r.price;
+
+    if (s.count == 0 || start > s.ring[s.current].startNs) {
+        // Start the next candle, overwriting the oldest once the ring is full
+        s.current = s.count == 0 ? 0 : (s.current + 1) % HISTORY;
+        if (s.count < HISTORY) ++s.count;
+        s.ring[s.current] = Candle{ start, price, price, price, price, 0, 0.0, 0 };
+    }
+
+    Candle& c = s.ring[s.current];
+    c.high      = std::max(c.high, price);
+    c.low       = std::min(c.low, price);
+    c.close     = price;
+    c.volume   += r.quantity;
+    c.notional += price * static_cast<double>(r.quantity);
+    c.trades   += 1;
+    s.touched   = true;
+}
+
+void CandleAggregator::onTrades(const TradeRecord* records, size_t count) {
+    std::vector<std::string> events;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (size_t i = 0; i < count; ++i) {
+            const TradeRecord& r = records[i];
+            if (r.linkId) continue;   // swap leg: not a spot print
+            std::string symbol(r.symbol, strnlen(r.symbol, sizeof(r.symbol)));
+
+            auto& entry = symbols_[symbol];
+            if (!entry) {
+                entry = std::make_unique<SymbolCandles>();
+                entry->symbol = symbol;
+            }
+            for (int k = 0; k < INTERVAL_COUNT; ++k) apply(entry->series[k], INTERVAL_NS[k], r);
+            if (!entry->touched) {
+                entry->touched = true;
+                touched_.push_back(entry.get());
+            }
+        }
+
+        for (SymbolCandles* sc : touched_) {
+            for (int k = 0; k < INTERVAL_COUNT; ++k) {
+                Series& s = sc->series[k];
+                if (!s.touched) continue;
+                s.touched = false;
+                if (bus_)
+                    events.push_back("event: candle\ndata: " +
+                                     candleJson(sc->symbol, k, s.ring[s.current]) + "\n\n");
+            }
+            sc->touched = false;
+        }
+        touched_.clear();
+    }
+
+    for (const auto& e : events) bus_->publish(e);
+}
+
+// ── Reads ─────────────────────────────────────────────────────────────────────
+
+std::vector<Candle> CandleAggregator::getCandles(const std::string& symbol, int interval, size_t limit) const {
+    std::vector<Candle> out;
+    if (interval < 0 || interval >= INTERVAL_COUNT) return out;
+
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = symbols_.find(symbol);
+    if (it == symbols_.end()) return out;
+
+    const Series& s = it->second->series[interval];
+    size_t n = std::min(limit, s.count);
+    out.reserve(n);
+    // Oldest of the n newest first
+    for (size_t i = n; i-- > 0;)
+        out.push_back(s.ring[(s.current + HISTORY - i) % HISTORY]);
+    return out;
+}
+
+std::string CandleAggregator::candleJson(const std::string& symbol, int interval, const Candle& c) {
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(6);
+    j << "{\"symbol\":\""   << symbol << "\""
+      << ",\"interval\":\"" << INTERVAL_NAMES[interval] << "\""
+      << ",\"start\":"      << c.startNs
+      << ",\"open\":"       << c.open
+      << ",\"high\":"       << c.high
+      << ",\"low\":"        << c.low
+      << ",\"close\":"      << c.close
+      << ",\"volume\":"     << c.volume
+      << ",\"vwap\":"       << c.vwap()
+      << ",\"trades\":"     << c.trades
+      << "}";
+    return j.str();
+}
@@ -0,0 +1,87 @@
+#ifndef CANDLEAGGREGATOR_H
+#define CANDLEAGGREGATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TradeFeed.h"
+
+class EventBus;
+
+// One OHLCV bar.  VWAP is notional / volume.
+struct Candle {
+    int64_t startNs;    // interval start, wall-clock ns, aligned to the interval
+    double  open;
+    double  high;
+    double  low;
+    double  close;
+    long    volume;
+    double  notional;   // Σ price × quantity
+    long    trades;
+
+    double vwap() const { return volume ? notional / static_cast<double>(volume) : 0.0; }
+};
+
+// ─── Candle aggregation ──────────────────────────────────────────────────────
+//
+// A TradeFeed sink that folds every spot fill into 1s, 1m, 5m and 1h candles
+// per symbol; swap legs (linkId set) are no prints and are skipped.  Each
+// (symbol, interval) keeps the latest HISTORY candles in a fixed ring; a fill
+// updates the current candle of each interval or starts the next one, so the
+// work per fill is constant.  Intervals with no trades produce no candle.  A
+// fill stamped before the current candle (clock step) is folded into it.
+//
+// After each batch, the current candle of every (symbol, interval) the batch
+// touched is published once as an SSE "candle" event, so a burst of fills
+// costs one event per bar rather than one per fill.
+//
+// onTrades runs on the feed's consumer thread; getCandles may be called from
+// any thread.  The lock between them is never taken by the matcher.
+class CandleAggregator {
+public:
+    static constexpr int    INTERVAL_COUNT = 4;
+    static constexpr size_t HISTORY        = 512;   // candles kept per symbol and interval
+
+    explicit CandleAggregator(EventBus* bus = nullptr);
+
+    // Interval index for "1s", "1m", "5m" or "1h"; -1 if unknown
+    static int         intervalIndex(const std::string& name);
+    static const char* intervalName(int interval);
+    static int64_t     intervalNs(int interval);
+
+    // TradeFeed sink
+    void onTrades(const TradeRecord* records, size_t count);
+
+    // Up to limit most recent candles, oldest first; empty if the symbol has none
+    std::vector<Candle> getCandles(const std::string& symbol, int interval, size_t limit = HISTORY) const;
+
+    // {"symbol":..,"interval":..,"start":..,"open":..,...,"vwap":..,"trades":..}
+    static std::string candleJson(const std::string& symbol, int interval, const Candle& c);
+
+private:
+    struct Series {
+        Candle ring[HISTORY];
+        size_t count   = 0;   // candles held, ≤ HISTORY
+        size_t current = 0;   // ring index of the newest candle
+        bool   touched = false;
+    };
+
+    struct SymbolCandles {
+        std::string symbol;
+        Series      series[INTERVAL_COUNT];
+        bool        touched = false;
+    };
+
+    EventBus*                                                       bus_;
+    mutable std::mutex                                              mu_;
+    std::unordered_map<std::string, std::unique_ptr<SymbolCandles>> symbols_;
+    std::vector<SymbolCandles*>                                     touched_;   // consumer thread only
+
+    static void apply(Series& s, int64_t intervalNs, const TradeRecord& r);
+};
+
+#endif
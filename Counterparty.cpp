@@ -1,11 +1,26 @@
 #include <algorithm>
 #include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include "Counterparty.h"
 
 std::atomic<long> Counterparty::nextId{1};
 
+// id → name for every counterparty ever constructed, so fills that outlive
+// their Counterparty (post-trade stores) can still be attributed
+static std::mutex                            registryMu;
+static std::unordered_map<long, std::string> registry;
+
 Counterparty::Counterparty(std::string name) : name(std::move(name)) {
     this->id = nextId.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(registryMu);
+    registry.emplace(this->id, this->name);
+}
+
+std::string Counterparty::nameOf(long id) {
+    std::lock_guard<std::mutex> lk(registryMu);
+    auto it = registry.find(id);
+    return it == registry.end() ? std::string() : it->second;
 }
 
 long Counterparty::getId() const { return id; }
@@ -14,19 +29,66 @@ const std::string& Counterparty::getName() const { return name; }
 
 const std::vector<long>& Counterparty::getOrderIds() const { return orderIds; }
 
-const std::vector<TradeNotification>& Counterparty::getTrades() const { return trades; }
+std::string TradeNotification::counterpartyName() const {
+    return counterpartyId ? Counterparty::nameOf(counterpartyId) : "unknown";
+}
+
+std::vector<TradeNotification> Counterparty::getTrades() const {
+    std::vector<TradeNotification> out;
+    out.reserve(trades.size());
+    for (size_t i = 0; i < trades.size(); ++i) out.push_back(trades[(tradeHead + i) % trades.size()]);
+    return out;
+}
 
-void Counterparty::onTrade(TradeNotification notification) {
-    trades.push_back(std::move(notification));
+std::vector<TradeNotification> Counterparty::getTrades(int64_t toNs, size_t limit, size_t skipAtTo) const {
+    std::vector<TradeNotification> out;
+    for (size_t i = trades.size(); i-- > 0 && out.size() < limit;) {
+        const TradeNotification& n = trades[(tradeHead + i) % trades.size()];
+        if (n.tsNs > toNs) continue;
+        if (n.tsNs == toNs && skipAtTo > 0) { --skipAtTo; continue; }
+        out.push_back(n);
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
 }
 
+uint64_t Counterparty::getTradeCount() const { return tradeCount; }
+
+// Fixed memory per counterparty however long the session: once HISTORY fills
+// are held, each new one overwrites the oldest.  An evicted fill is not
+// spilled from here: logAndNotify published it to the trade feed, which
+// never drops a record and carries swap legs too, so a trade store, when
+// enabled, receives it once by that path.  Without a store it is gone.
+void Counterparty::onTrade(const TradeNotification& notification) {
+    if (trades.size() < HISTORY) {
+        trades.push_back(notification);
+    } else {
+        trades[tradeHead] = notification;
+        tradeHead = (tradeHead + 1) % HISTORY;
+    }
+    ++tradeCount;
+}
+
+// Open orders are an indexed set: a dense vector for iteration plus each
+// id's slot in it.  Removal moves the last id into the freed slot, so both
+// operations are O(1) however many orders a counterparty has resting.
 void Counterparty::addOrderId(long orderId) {
+    if (!orderSlots.emplace(orderId, orderIds.size()).second) return;
     orderIds.push_back(orderId);
 }
 
 void Counterparty::removeOrderId(long orderId) {
-    orderIds.erase(
-        std::remove(orderIds.begin(), orderIds.end(), orderId),
-        orderIds.end()
-    );
+    auto it = orderSlots.find(orderId);
+    if (it == orderSlots.end()) return;
+    const size_t slot = it->second;
+    orderSlots.erase(it);
+    if (slot != orderIds.size() - 1) {
+        orderIds[slot]             = orderIds.back();
+        orderSlots[orderIds[slot]] = slot;
+    }
+    orderIds.pop_back();
+}
+
+bool Counterparty::hasOrderId(long orderId) const {
+    return orderSlots.count(orderId) != 0;
 }
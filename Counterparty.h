@@ -2,37 +2,62 @@
 #define COUNTERPARTY_H
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
-// Notification sent to a counterparty each time one of its orders is filled
+// Notification sent to a counterparty each time one of its orders is filled.
+// Fixed-size: the other party is held by its interned id, not a name copy.
 struct TradeNotification {
-    long        orderId;           // the counterparty's order involved in the trade
-    double      price;             // execution price
-    long        quantity;          // fill quantity
-    bool        wasBuy;            // true = this side was the buyer; false = seller
-    std::string counterpartyName;  // name of the other party in the trade
+    int64_t tsNs;             // wall-clock execution time, as carried by the trade feed
+    long    orderId;          // the counterparty's order involved in the trade
+    double  price;            // execution price
+    long    quantity;         // fill quantity
+    long    counterpartyId;   // the other party in the trade; 0 = none
+    bool    wasBuy;           // true = this side was the buyer; false = seller
+    char    symbol[16];       // NUL-padded; longer symbols are truncated
+
+    std::string counterpartyName() const;   // the other party's name; "unknown" if none
 };
 
 class Counterparty {
 private:
     long id;
     std::string name;
-    std::vector<long> orderIds;
-    std::vector<TradeNotification> trades;
+    std::vector<long> orderIds;                      // open orders, dense for iteration
+    std::unordered_map<long, size_t> orderSlots;     // order id → its index in orderIds
+    std::vector<TradeNotification> trades;   // ring of the newest HISTORY fills
+    size_t tradeHead = 0;                    // oldest retained fill once the ring is full
+    uint64_t tradeCount = 0;                 // every fill ever received
     static std::atomic<long> nextId;
 
 public:
+    static constexpr size_t HISTORY = 1024;   // fills retained per counterparty
+
     Counterparty(std::string name);
 
+    // Name of the counterparty that was given this id; "" if none was.
+    // Ids are never reused, so this stays valid after the object is gone.
+    static std::string nameOf(long id);
+
     long getId() const;
     const std::string& getName() const;
+    // Open order ids, in no particular order once any has been removed
     const std::vector<long>& getOrderIds() const;
-    const std::vector<TradeNotification>& getTrades() const;
+    bool hasOrderId(long orderId) const;
+
+    // The retained fills (the newest HISTORY), oldest first
+    std::vector<TradeNotification> getTrades() const;
+    // The newest limit retained fills stamped at or before toNs, oldest
+    // first, passing over the newest skipAtTo of those stamped exactly toNs
+    std::vector<TradeNotification> getTrades(int64_t toNs, size_t limit, size_t skipAtTo = 0) const;
+    uint64_t getTradeCount() const;   // including fills no longer retained
 
-    void addOrderId(long orderId);
-    void removeOrderId(long orderId);
-    void onTrade(TradeNotification notification);
+    void addOrderId(long orderId);      // O(1); an id already held is ignored
+    void removeOrderId(long orderId);   // O(1); an id not held is ignored
+    void onTrade(const TradeNotification& notification);
 };
 
 #endif
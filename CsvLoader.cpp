@@ -0,0 +1,62 @@
+#include <sstream>
+#include <string>
+#include "Counterparty.h"
+#include "CsvLoader.h"
+#include "Order.h"
+#include "OrderManager.h"
+#include "OrderType.h"
+
+int loadOrdersCsv(std::istream& in,
+                  OrderManager& om,
+                  Counterparty* counterparties,
+                  int cpCount,
+                  std::ostream* log) {
+    std::string line;
+    // Skip the header line
+    std::getline(in, line);
+
+    int orderCount = 0;
+
+    // Read each line from the CSV
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+
+        std::stringstream ss(line);
+        std::string symbol, priceStr, quantityStr, side;
+
+        // Parse CSV fields (Symbol,Price,Quantity,Side)
+        std::getline(ss, symbol, ',');
+        std::getline(ss, priceStr, ',');
+        std::getline(ss, quantityStr, ',');
+        std::getline(ss, side, ',');
+
+        // Convert strings to appropriate types
+        double price = std::stod(priceStr);
+        int quantity = std::stoi(quantityStr);
+
+        // Determine order type based on side
+        OrderType orderType;
+        if (side == "BUY") {
+            orderType = OrderType::SPOT_BUY;
+        } else {
+            orderType = OrderType::SPOT_SELL;
+        }
+
+        // Assign counterparty round-robin and create order
+        Counterparty* cp = &counterparties[orderCount % cpCount];
+        Order order(symbol, price, quantity, orderType, cp);
+        RejectReason reason = om.processNewOrder(order);
+
+        orderCount++;
+        if (log) {
+            *log << (reason == RejectReason::NONE ? "Processed" : "Rejected") << " order #" << orderCount << ": "
+                 << side << " " << quantity << " " << symbol
+                 << " @ " << price
+                 << "  [" << cp->getName() << "]";
+            if (reason != RejectReason::NONE) *log << "  (" << rejectReasonName(reason) << ")";
+            *log << std::endl;
+        }
+    }
+
+    return orderCount;
+}
@@ -0,0 +1,23 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include <istream>
+#include <ostream>
+
+class Counterparty;
+class OrderManager;
+
+// Reads "Symbol,Price,Quantity,Side" rows (the first line is a header and is
+// skipped) and submits each one to the OrderManager as a SPOT order.
+// Counterparties are assigned round-robin from the cpCount-element array.
+// If log is non-null a "Processed order #N" line (or "Rejected order #N" with
+// the risk reason) is written for every row.
+//
+// Returns the number of rows submitted.
+int loadOrdersCsv(std::istream& in,
+                  OrderManager& om,
+                  Counterparty* counterparties,
+                  int cpCount,
+                  std::ostream* log = nullptr);
+
+#endif
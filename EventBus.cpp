@@ -1,10 +1,14 @@
 #include "EventBus.h"
+#include "Latency.h"
+#include "Metrics.h"
 #include <algorithm>
+#include <string>
 
 std::shared_ptr<EventBus::Connection> EventBus::subscribe() {
     auto conn = std::make_shared<Connection>();
     std::lock_guard<std::mutex> lk(mu_);
     conns_.push_back(conn);
+    subscribers_.fetch_add(1, std::memory_order_relaxed);
     return conn;
 }
 
@@ -12,17 +16,50 @@ void EventBus::unsubscribe(std::shared_ptr<Connection> conn) {
     {
         std::lock_guard<std::mutex> lk(conn->mu);
         conn->closed = true;
+        // Messages left behind on a closed connection will never be delivered
+        queued_.fetch_sub(static_cast<long>(conn->queue.size()), std::memory_order_relaxed);
+        conn->queue = {};
     }
     conn->cv.notify_all();
     std::lock_guard<std::mutex> lk(mu_);
-    conns_.erase(std::remove(conns_.begin(), conns_.end(), conn), conns_.end());
+    auto it = std::remove(conns_.begin(), conns_.end(), conn);
+    if (it != conns_.end()) subscribers_.fetch_sub(1, std::memory_order_relaxed);
+    conns_.erase(it, conns_.end());
 }
 
-void EventBus::publish(const std::string& sseMsg) {
+void EventBus::publish(const std::string& sseMsg, uint64_t ingressTicks) {
+    LATENCY_PROBE(LatencyStage::EVENTBUS_PUBLISH);
+    Metrics::increment(Counter::EVENTS_PUBLISHED);
+    const uint64_t now = latencyNow();
+    if (ingressTicks)
+        LatencyRegistry::local(LatencyStage::ORDER_TO_PUBLISH).record(now - ingressTicks);
+
     std::lock_guard<std::mutex> lk(mu_);
     for (auto& c : conns_) {
         std::lock_guard<std::mutex> clk(c->mu);
-        c->queue.push(sseMsg);
+        if (c->closed) continue;
+        c->queue.push({sseMsg, ingressTicks, now});
+        queued_.fetch_add(1, std::memory_order_relaxed);
         c->cv.notify_one();
     }
 }
+
+std::string EventBus::withTrace(const Event& ev, uint64_t popTicks, double ticksPerNs) {
+    // The JSON object closes just before the terminating "\n\n"
+    const std::string& msg = ev.msg;
+    if (!ev.ingressTicks || msg.size() < 3 || msg.compare(msg.size() - 3, 3, "}\n\n") != 0)
+        return msg;
+
+    auto ns = [ticksPerNs](uint64_t from, uint64_t to) {
+        return std::to_string(to > from
+            ? static_cast<uint64_t>(static_cast<double>(to - from) / ticksPerNs + 0.5) : 0);
+    };
+
+    std::string out;
+    out.reserve(msg.size() + 80);
+    out.append(msg, 0, msg.size() - 3);
+    out += ",\"trace\":{\"engineNs\":" + ns(ev.ingressTicks, ev.publishTicks)
+         + ",\"queueNs\":"  + ns(ev.publishTicks, popTicks)
+         + ",\"serverNs\":" + ns(ev.ingressTicks, popTicks) + "}}\n\n";
+    return out;
+}
@@ -1,7 +1,9 @@
 #ifndef EVENTBUS_H
 #define EVENTBUS_H
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -13,22 +15,50 @@
 // then blocks in its provider lambda waiting on the condition variable.
 // publish() pushes a fully-formed SSE string (must end with "\n\n") to every
 // live connection's queue and wakes its waiting thread.
+//
+// Each queued event carries the ingress timestamp of the command that caused
+// it and the time it was published, so the SSE writer can attribute the
+// order-to-socket latency to engine, queue and socket stages.
 class EventBus {
 public:
+    struct Event {
+        std::string msg;
+        uint64_t    ingressTicks;   // latencyNow() at command ingress; 0 = untraced
+        uint64_t    publishTicks;   // latencyNow() when publish() queued it
+    };
+
     struct Connection {
-        std::queue<std::string> queue;
+        std::queue<Event>       queue;
         std::mutex              mu;
         std::condition_variable cv;
         bool                    closed{false};
+        bool                    trace{false};   // splice timings into payloads (GET /events?trace=1)
     };
 
     std::shared_ptr<Connection> subscribe();
     void unsubscribe(std::shared_ptr<Connection> conn);
-    void publish(const std::string& sseMsg);   // sseMsg must end with "\n\n"
+
+    // sseMsg must end with "\n\n"; ingressTicks of 0 marks an untraced event
+    void publish(const std::string& sseMsg, uint64_t ingressTicks = 0);
+
+    // ev.msg with a "trace" object appended to its JSON data:
+    //   {"engineNs": ingress → publish, "queueNs": publish → popTicks,
+    //    "serverNs": ingress → popTicks}
+    // Untraced events, and messages without a JSON object, are returned unchanged.
+    static std::string withTrace(const Event& ev, uint64_t popTicks, double ticksPerNs);
+
+    // Called by the SSE writer after it pops n messages off a connection queue
+    void onDelivered(long n) { queued_.fetch_sub(n, std::memory_order_relaxed); }
+
+    // Lock-free gauges for GET /metrics
+    long subscriberCount() const { return subscribers_.load(std::memory_order_relaxed); }
+    long queuedMessages()  const { return queued_.load(std::memory_order_relaxed); }
 
 private:
     std::vector<std::shared_ptr<Connection>> conns_;
     std::mutex                               mu_;
+    std::atomic<long>                        subscribers_{0};
+    std::atomic<long>                        queued_{0};   // undelivered messages, all connections
 };
 
 #endif
@@ -0,0 +1,128 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "FeedReplayer.h"
+#include "MarketManager.h"
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FeedReplayer::~FeedReplayer() {
+    close();
+}
+
+// ── Recording ─────────────────────────────────────────────────────────────────
+
+bool FeedReplayer::record(const std::string& path, const MarketPrice* ticks, size_t count) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out.write(reinterpret_cast<const char*>(ticks),
+              static_cast<std::streamsize>(count * sizeof(MarketPrice)));
+    return static_cast<bool>(out);
+}
+
+long FeedReplayer::recordText(std::istream& in, const std::string& path) {
+    std::vector<MarketPrice> ticks;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        MarketPrice tick;
+        if (MarketManager::parseTickLine(line, tick)) ticks.push_back(tick);
+    }
+    return record(path, ticks.data(), ticks.size()) ? static_cast<long>(ticks.size()) : -1;
+}
+
+// ── Mapping ───────────────────────────────────────────────────────────────────
+
+bool FeedReplayer::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || st.st_size % sizeof(MarketPrice) != 0) {
+        std::cerr << "Feed replay: " << path << " is not a MarketPrice recording" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    count_ = static_cast<size_t>(st.st_size) / sizeof(MarketPrice);
+    if (count_ == 0) {   // mmap rejects empty mappings; an empty recording is fine
+        ::close(fd);
+        return true;
+    }
+
+    void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        count_ = 0;
+        return false;
+    }
+    madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    ticks_     = static_cast<const MarketPrice*>(p);
+    mapLength_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void FeedReplayer::close() {
+    if (ticks_) munmap(const_cast<MarketPrice*>(ticks_), mapLength_);
+    ticks_     = nullptr;
+    count_     = 0;
+    mapLength_ = 0;
+}
+
+// ── Playback ──────────────────────────────────────────────────────────────────
+
+void FeedReplayer::pace(size_t i, double speed, int64_t startNs) const {
+    if (speed <= 0 || ticks_[0].getTimestampNs() == 0) return;
+    int64_t offset = ticks_[i].getTimestampNs() - ticks_[0].getTimestampNs();
+    int64_t dueNs  = startNs + static_cast<int64_t>(static_cast<double>(offset) / speed);
+    int64_t waitNs = dueNs - steadyNs();
+    if (waitNs > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+}
+
+long FeedReplayer::replayInto(MarketManager& mm, double speed) const {
+    if (speed <= 0) return mm.onTicks(ticks_, count_);
+
+    long    delivered = 0;
+    int64_t startNs   = steadyNs();
+    for (size_t i = 0; i < count_; ++i) {
+        pace(i, speed, startNs);
+        if (mm.onTick(ticks_[i])) ++delivered;
+    }
+    return delivered;
+}
+
+long FeedReplayer::sendTo(int port, double speed) const {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(static_cast<uint16_t>(port));
+
+    // Paced replays send each record on its due time; flat out sends batches
+    size_t  batch     = speed > 0 ? 1 : BATCH;
+    long    delivered = 0;
+    int64_t startNs   = steadyNs();
+    for (size_t i = 0; i < count_; i += batch) {
+        size_t n = count_ - i < batch ? count_ - i : batch;
+        pace(i, speed, startNs);
+        if (sendto(fd, ticks_ + i, n * sizeof(MarketPrice), 0,
+                   reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            break;
+        delivered += static_cast<long>(n);
+    }
+    ::close(fd);
+    return delivered;
+}
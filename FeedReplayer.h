@@ -0,0 +1,56 @@
+#ifndef FEEDREPLAYER_H
+#define FEEDREPLAYER_H
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include "MarketPrice.h"
+
+class MarketManager;
+
+// ─── Recorded feed replay ────────────────────────────────────────────────────
+//
+// A recording is a flat file of MarketPrice records exactly as they travel on
+// a binary feed.  FeedReplayer maps one read-only and plays it back either
+// straight into a MarketManager or as datagrams to a binary UDP feed, flat
+// out or paced by the recorded timestamps.
+class FeedReplayer {
+public:
+    FeedReplayer() = default;
+    ~FeedReplayer();
+
+    FeedReplayer(const FeedReplayer&)            = delete;
+    FeedReplayer& operator=(const FeedReplayer&) = delete;
+
+    // Write count records to path; false on I/O error
+    static bool record(const std::string& path, const MarketPrice* ticks, size_t count);
+    // Convert tick lines (see MarketManager) into a recording; returns the
+    // number of records written, or -1 on I/O error
+    static long recordText(std::istream& in, const std::string& path);
+
+    // Map a recording; false if it cannot be opened or is not a whole
+    // number of records
+    bool open(const std::string& path);
+    void close();
+
+    const MarketPrice* data() const { return ticks_; }
+    size_t             size() const { return count_; }
+
+    // speed 0 replays flat out; otherwise recorded gaps are divided by speed
+    // (1 = recorded pace).  Both return the number of records delivered.
+    long replayInto(MarketManager& mm, double speed = 0) const;
+    long sendTo(int port, double speed = 0) const;
+
+    // Records per datagram for sendTo (32 KiB, well under the UDP limit)
+    static constexpr size_t BATCH = 512;
+
+private:
+    const MarketPrice* ticks_     = nullptr;
+    size_t             count_     = 0;
+    size_t             mapLength_ = 0;
+
+    // Sleep until the record at index i is due under the given pacing
+    void pace(size_t i, double speed, int64_t startNs) const;
+};
+
+#endif
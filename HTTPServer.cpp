@@ -1,13 +1,25 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <thread>
+#include "CandleAggregator.h"
 #include "EventBus.h"
 #include "HTTPServer.h"
+#include "Latency.h"
+#include "MarketManager.h"
+#include "Metrics.h"
 #include "Order.h"
 #include "OrderManager.h"
+#include "PositionKeeper.h"
 #include "OrderType.h"
 #include "SubBook.h"
+#include "TradeFeed.h"
+#include "TradeStore.h"
 
 // ── JSON helpers ──────────────────────────────────────────────────────────────
 
@@ -35,24 +47,49 @@ static std::string levelsJson(const MapT& map) {
     for (const auto& [price, orders] : map) {
         if (!first) j << ",";
         first = false;
-        long total = 0;
         std::string ids = "[";
         bool fst = true;
         for (const auto& o : orders) {
-            total += o.getQuantity();
             if (!fst) ids += ",";
             fst = false;
             ids += std::to_string(o.getId());
         }
         ids += "]";
         j << "{\"price\":"    << price
-          << ",\"quantity\":" << total
+          << ",\"quantity\":" << orders.quantity
           << ",\"orderIds\":" << ids << "}";
     }
     j << "]";
     return j.str();
 }
 
+// Serialise one symbol's market state
+static std::string quoteJson(const std::string& symbol, const MarketQuote& q) {
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(6);
+    j << "{\"symbol\":"    << jsonStr(symbol)
+      << ",\"bid\":"       << q.bid
+      << ",\"bidQty\":"    << q.bidQty
+      << ",\"ask\":"       << q.ask
+      << ",\"askQty\":"    << q.askQty
+      << ",\"last\":"      << q.last
+      << ",\"lastQty\":"   << q.lastQty
+      << ",\"volume\":"    << q.volume
+      << ",\"updateNs\":"  << q.updateNs
+      << "}";
+    return j.str();
+}
+
+// The "error" label of a 422 reply: risk gate refusals share one, so
+// clients branch on it before reading "reason"
+static const char* rejectError(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::NO_PEG_REFERENCE: return "\"peg_rejected\"";
+        case RejectReason::NO_NEAR_RATE:     return "\"swap_rejected\"";
+        default:                             return "\"risk_rejected\"";
+    }
+}
+
 // Simple field extractors for the POST /orders JSON body
 static std::string extractStr(const std::string& body, const std::string& key) {
     auto pos = body.find("\"" + key + "\"");
@@ -68,14 +105,21 @@ static std::string extractStr(const std::string& body, const std::string& key) {
     return body.substr(pos, end - pos);
 }
 
-static double extractDouble(const std::string& body, const std::string& key) {
+// False if key is missing or its value is not a number
+static bool parseDouble(const std::string& body, const std::string& key, double& out) {
     auto pos = body.find("\"" + key + "\"");
-    if (pos == std::string::npos) return 0.0;
+    if (pos == std::string::npos) return false;
     pos = body.find(':', pos);
-    if (pos == std::string::npos) return 0.0;
+    if (pos == std::string::npos) return false;
     ++pos;
     while (pos < body.size() && (body[pos] == ' ' || body[pos] == '\t')) ++pos;
-    try { return std::stod(body.substr(pos)); } catch (...) { return 0.0; }
+    try { out = std::stod(body.substr(pos)); } catch (...) { return false; }
+    return true;
+}
+
+static double extractDouble(const std::string& body, const std::string& key) {
+    double value = 0.0;
+    return parseDouble(body, key, value) ? value : 0.0;
 }
 
 static long extractLong(const std::string& body, const std::string& key) {
@@ -88,24 +132,58 @@ static long extractLong(const std::string& body, const std::string& key) {
     try { return std::stol(body.substr(pos)); } catch (...) { return 0; }
 }
 
+// The flat objects of the array under key, each as its own body for the
+// extractors above: {"quotes":[{..},{..}]} → "{..}", "{..}"
+static std::vector<std::string> extractObjects(const std::string& body, const std::string& key) {
+    std::vector<std::string> out;
+    auto pos = body.find("\"" + key + "\"");
+    if (pos == std::string::npos) return out;
+    pos = body.find('[', pos);
+    const auto end = body.find(']', pos);
+    while (pos != std::string::npos && (pos = body.find('{', pos)) < end) {
+        auto close = body.find('}', pos);
+        if (close == std::string::npos || close > end) break;
+        out.push_back(body.substr(pos, close - pos + 1));
+        pos = close + 1;
+    }
+    return out;
+}
+
 // ── HTTPServer ────────────────────────────────────────────────────────────────
 
 HTTPServer::HTTPServer(OrderManager& om, EventBus& bus)
     : om_(om), bus_(bus) {
-    counterparties_.emplace("Goldman Sachs", Counterparty("Goldman Sachs"));
-    counterparties_.emplace("JP Morgan",     Counterparty("JP Morgan"));
-    counterparties_.emplace("Deutsche Bank", Counterparty("Deutsche Bank"));
+    for (const char* name : { "Goldman Sachs", "JP Morgan", "Deutsche Bank" }) {
+        Counterparty& cp = ownCounterparties_.emplace(name, Counterparty(name)).first->second;
+        counterparties_[name] = &cp;
+    }
     setupRoutes();
+
+    // External ticks fill crossed resting orders, under the same lock as HTTP
+    // order flow.  Runs on the feed thread that ingested the tick.
+    if (MarketManager* market = om_.getMarketManager())
+        market->setTickListener([this, market](int symbolId, uint64_t ingressTicks) {
+            std::lock_guard<std::mutex> lk(mu_);
+            om_.processMarketTick(market->symbolName(symbolId), ingressTicks);
+        });
+}
+
+HTTPServer::~HTTPServer() {
+    if (MarketManager* market = om_.getMarketManager()) market->setTickListener(nullptr);
+}
+
+void HTTPServer::addCounterparty(Counterparty* cp) {
+    counterparties_[cp->getName()] = cp;
 }
 
 void HTTPServer::addCors(httplib::Response& res) {
     res.set_header("Access-Control-Allow-Origin",  "*");
-    res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, OPTIONS");
+    res.set_header("Access-Control-Allow-Methods", "GET, POST, PATCH, DELETE, OPTIONS");
     res.set_header("Access-Control-Allow-Headers", "Content-Type");
 }
 
-std::string HTTPServer::bookJson(const std::string& symbol) {
-    SubBook& sb = om_.getSubBook(symbol);
+std::string HTTPServer::bookJson(const std::string& symbol, bool swap) {
+    SubBook& sb = swap ? om_.getSwapBook(symbol) : om_.getSubBook(symbol);
     std::ostringstream j;
     j << "{\"symbol\":" << jsonStr(symbol)
       << ",\"bids\":"   << levelsJson(sb.getBuyOrdersRef())
@@ -155,6 +233,55 @@ void HTTPServer::setupRoutes() {
         res.set_content(json, "application/json");
     });
 
+    // ── GET /swapbook/:symbol ────────────────────────────────────────────────
+    // The pair's swap book; prices are forward points
+    svr_.Get(R"(/swapbook/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string symbol = req.matches[1];
+        std::string json;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            json = bookJson(symbol, true);
+        }
+        addCors(res);
+        res.set_content(json, "application/json");
+    });
+
+    // ── GET /implied ─────────────────────────────────────────────────────────
+    // Every configured cross's implied touch
+    svr_.Get("/implied", [this](const httplib::Request&, httplib::Response& res) {
+        std::ostringstream j;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            const ImpliedPricer& implied = om_.getImpliedPricer();
+            j << "[";
+            for (int c = 0; c < implied.crossCount(); ++c) j << (c ? "," : "") << implied.quoteJson(c);
+            j << "]";
+        }
+        addCors(res);
+        res.set_content(j.str(), "application/json");
+    });
+
+    // ── GET /auction/:symbol ─────────────────────────────────────────────────
+    // The indicative uncross of an auction symbol: what the next auction
+    // would trade if it ran now
+    svr_.Get(R"(/auction/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string symbol = req.matches[1];
+        std::string json;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            const std::vector<std::string>& auctions = om_.getAuctionSymbols();
+            if (std::find(auctions.begin(), auctions.end(), symbol) != auctions.end())
+                json = OrderManager::auctionJson(symbol, om_.indicativeAuction(symbol));
+        }
+        addCors(res);
+        if (json.empty()) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"not an auction symbol\"}", "application/json");
+            return;
+        }
+        res.set_content(json, "application/json");
+    });
+
     // ── GET /books ───────────────────────────────────────────────────────────
     svr_.Get("/books", [this](const httplib::Request&, httplib::Response& res) {
         std::vector<std::string> syms;
@@ -176,15 +303,63 @@ void HTTPServer::setupRoutes() {
     });
 
     // ── GET /trades ──────────────────────────────────────────────────────────
-    svr_.Get("/trades", [this](const httplib::Request&, httplib::Response& res) {
+    // ?symbol=&from=&to=&limit= — the most recent `limit` (default 100) fills,
+    // oldest first.  from/to are inclusive wall-clock ns.  With a TradeStore
+    // this is a query over the full history and never takes mu_; without one
+    // it filters the in-memory window of the last 100 fills, which carry no
+    // timestamps, so from/to are ignored.
+    svr_.Get("/trades", [this](const httplib::Request& req, httplib::Response& res) {
+        addCors(res);
+        TradeQuery q;
+        bool       valid = true;
+        try {
+            if (req.has_param("symbol")) q.symbol = req.get_param_value("symbol");
+            if (req.has_param("from"))   q.fromNs = std::stoll(req.get_param_value("from"));
+            if (req.has_param("to"))     q.toNs   = std::stoll(req.get_param_value("to"));
+            if (req.has_param("limit")) {
+                long long limit = std::stoll(req.get_param_value("limit"));
+                valid   = limit > 0;
+                q.limit = static_cast<size_t>(std::min<long long>(limit, MAX_TRADES_LIMIT));
+            }
+        } catch (...) {
+            valid = false;
+        }
+        if (!valid || q.fromNs > q.toNs) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"from/to must be ns timestamps with from <= to; limit must be positive\"}",
+                            "application/json");
+            return;
+        }
+
         std::ostringstream j;
-        {
+        j << std::fixed << std::setprecision(6);
+        j << "[";
+        bool first = true;
+        if (trades_) {
+            for (const StoredTrade& t : trades_->query(q)) {
+                if (!first) j << ",";
+                first = false;
+                j << "{\"ts\":"          << t.tsNs
+                  << ",\"symbol\":"      << jsonStr(t.symbol)
+                  << ",\"price\":"       << t.price
+                  << ",\"quantity\":"    << t.quantity
+                  << ",\"buyOrderId\":"  << t.buyOrderId
+                  << ",\"sellOrderId\":" << t.sellOrderId
+                  << ",\"buyer\":"       << jsonStr(t.buyer)
+                  << ",\"seller\":"      << jsonStr(t.seller);
+                if (t.linkId)   // a swap leg
+                    j << ",\"linkId\":" << t.linkId << ",\"leg\":\"" << toString(static_cast<SwapLeg>(t.leg)) << "\"";
+                j << "}";
+            }
+        } else {
             std::lock_guard<std::mutex> lk(mu_);
             const auto& trades = om_.getRecentTrades();
-            j << std::fixed << std::setprecision(6);
-            j << "[";
-            bool first = true;
-            for (const auto& t : trades) {
+            std::vector<const Trade*> hits;
+            for (auto it = trades.rbegin(); it != trades.rend() && hits.size() < q.limit; ++it)
+                if (q.symbol.empty() || it->symbol == q.symbol) hits.push_back(&*it);
+            for (auto it = hits.rbegin(); it != hits.rend(); ++it) {
+                const Trade& t = **it;
                 if (!first) j << ",";
                 first = false;
                 j << "{\"symbol\":"      << jsonStr(t.symbol)
@@ -193,15 +368,85 @@ void HTTPServer::setupRoutes() {
                   << ",\"buyOrderId\":"  << t.buyOrderId
                   << ",\"sellOrderId\":" << t.sellOrderId
                   << ",\"buyer\":"       << jsonStr(t.buyer  ? t.buyer->getName()  : "")
-                  << ",\"seller\":"      << jsonStr(t.seller ? t.seller->getName() : "")
-                  << "}";
+                  << ",\"seller\":"      << jsonStr(t.seller ? t.seller->getName() : "");
+                if (t.linkId)   // a swap leg
+                    j << ",\"linkId\":" << t.linkId << ",\"leg\":\"" << toString(t.leg) << "\"";
+                j << "}";
             }
-            j << "]";
         }
+        j << "]";
+        res.set_content(j.str(), "application/json");
+    });
+
+    // ── GET /market, GET /market/:symbol ─────────────────────────────────────
+    // Seqlock snapshots straight from MarketManager; never takes mu_
+    svr_.Get("/market", [this](const httplib::Request&, httplib::Response& res) {
+        const MarketManager* market = om_.getMarketManager();
+        std::ostringstream j;
+        j << "[";
+        bool first = true;
+        for (int id = 0; market && id < market->symbolCount(); ++id) {
+            MarketQuote q;
+            if (!market->getQuote(id, q)) continue;
+            if (!first) j << ",";
+            first = false;
+            j << quoteJson(market->symbolName(id), q);
+        }
+        j << "]";
         addCors(res);
         res.set_content(j.str(), "application/json");
     });
 
+    svr_.Get(R"(/market/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string    symbol = req.matches[1];
+        const MarketManager* market = om_.getMarketManager();
+        MarketQuote q;
+        addCors(res);
+        if (!market || !market->getQuote(symbol, q)) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"no market data\"}", "application/json");
+            return;
+        }
+        res.set_content(quoteJson(symbol, q), "application/json");
+    });
+
+    // ── GET /candles/:symbol ─────────────────────────────────────────────────
+    // Oldest first.  An unknown symbol, or one with no fills yet, is an empty array.
+    svr_.Get(R"(/candles/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string symbol = req.matches[1];
+        addCors(res);
+        if (!candles_) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"candles not enabled\"}", "application/json");
+            return;
+        }
+
+        std::string name     = req.has_param("interval") ? req.get_param_value("interval") : "1m";
+        int         interval = CandleAggregator::intervalIndex(name);
+        long        limit    = static_cast<long>(CandleAggregator::HISTORY);
+        if (req.has_param("limit")) {
+            try { limit = std::stol(req.get_param_value("limit")); } catch (...) { limit = -1; }
+        }
+        if (interval < 0 || limit <= 0) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"interval must be 1s, 1m, 5m or 1h; limit must be positive\"}",
+                            "application/json");
+            return;
+        }
+
+        std::ostringstream j;
+        j << "[";
+        bool first = true;
+        for (const Candle& c : candles_->getCandles(symbol, interval, static_cast<size_t>(limit))) {
+            if (!first) j << ",";
+            first = false;
+            j << CandleAggregator::candleJson(symbol, interval, c);
+        }
+        j << "]";
+        res.set_content(j.str(), "application/json");
+    });
+
     // ── GET /counterparties ──────────────────────────────────────────────────
     svr_.Get("/counterparties", [this](const httplib::Request&, httplib::Response& res) {
         std::ostringstream j;
@@ -217,17 +462,207 @@ void HTTPServer::setupRoutes() {
         res.set_content(j.str(), "application/json");
     });
 
+    // ── GET /positions/:counterparty ─────────────────────────────────────────
+    // One entry per symbol traded, plus the totals.  A known counterparty
+    // with no fills yet has no positions; an unknown name is a 404.
+    svr_.Get(R"(/positions/(.+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string name = req.matches[1];
+        addCors(res);
+        if (!positions_) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"positions not enabled\"}", "application/json");
+            return;
+        }
+
+        std::vector<Position> held = positions_->getPositions(name);
+        if (held.empty() && !counterparties_.count(name)) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"unknown counterparty\"}", "application/json");
+            return;
+        }
+
+        double realised = 0, unrealised = 0;
+        std::ostringstream j;
+        j << std::fixed << std::setprecision(6);
+        j << "{\"counterparty\":" << jsonStr(name) << ",\"positions\":[";
+        bool first = true;
+        for (const Position& p : held) {
+            if (!first) j << ",";
+            first = false;
+            j << PositionKeeper::positionJson(name, p);
+            realised   += p.realised;
+            unrealised += p.unrealised;
+        }
+        j << "],\"realised\":" << realised << ",\"unrealised\":" << unrealised << "}";
+        res.set_content(j.str(), "application/json");
+    });
+
+    // ── GET /counterparties/:name/fills ──────────────────────────────────────
+    // ?to=&skip=&limit= — the newest `limit` (default 100) fills stamped at
+    // or before `to`, passing over the newest `skip` stamped exactly `to`,
+    // oldest first; page back with next's to and skip.  Fills sharing a
+    // nanosecond are ordered as executed by both the ring and the store, so
+    // the (to, skip) cursor neither drops nor repeats them at a page
+    // boundary.  The counterparty's retained fills are read under mu_.  Older
+    // ones, evicted from its ring or from earlier sessions, come from the
+    // TradeStore without mu_.
+    svr_.Get(R"(/counterparties/([^/]+)/fills)", [this](const httplib::Request& req, httplib::Response& res) {
+        const std::string name = req.matches[1];
+        addCors(res);
+        auto cpIt = counterparties_.find(name);
+        if (cpIt == counterparties_.end()) {
+            res.status = 404;
+            res.set_content("{\"success\":false,\"error\":\"unknown counterparty\"}", "application/json");
+            return;
+        }
+
+        int64_t toNs  = std::numeric_limits<int64_t>::max();
+        size_t  skip  = 0;
+        size_t  limit = 100;
+        bool    valid = true;
+        try {
+            if (req.has_param("to")) toNs = std::stoll(req.get_param_value("to"));
+            if (req.has_param("skip")) {
+                long long n = std::stoll(req.get_param_value("skip"));
+                valid = n >= 0;
+                skip  = static_cast<size_t>(std::max<long long>(n, 0));
+            }
+            if (valid && req.has_param("limit")) {
+                long long n = std::stoll(req.get_param_value("limit"));
+                valid = n > 0;
+                limit = static_cast<size_t>(std::min<long long>(n, MAX_TRADES_LIMIT));
+            }
+        } catch (...) {
+            valid = false;
+        }
+        if (!valid) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"to must be a ns timestamp; skip must not be negative; limit must be positive\"}",
+                            "application/json");
+            return;
+        }
+
+        std::vector<TradeNotification> recent;
+        uint64_t                       total;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            recent = cpIt->second->getTrades(toNs, limit, skip);
+            total  = cpIt->second->getTradeCount();
+        }
+        // The cursor just past a run of fills that starts at (toNs, skip):
+        // the oldest one's timestamp, and how many stamped with it are behind
+        // the cursor by then
+        auto cursorAfter = [&](int64_t oldestTs, size_t atOldest) {
+            return std::make_pair(oldestTs, atOldest + (oldestTs == toNs ? skip : 0));
+        };
+        auto countAt = [](int64_t ts, const auto& fills) {
+            size_t n = 0;
+            for (const auto& f : fills) n += f.tsNs == ts;
+            return n;
+        };
+
+        // Every retained fill up to the cursor is in `recent` if it came up
+        // short, and the ring holds the newest of the counterparty's fills,
+        // so the store continues from just past the oldest of them.  A fill
+        // leaves the ring only after it was published, so once the feed is
+        // flushed the store holds everything the ring has evicted.
+        std::vector<StoredTrade> older;
+        if (recent.size() < limit && trades_) {
+            if (tradeFeed_) tradeFeed_->flush();
+            const auto from = recent.empty() ? std::make_pair(toNs, skip)
+                                             : cursorAfter(recent.front().tsNs, countAt(recent.front().tsNs, recent));
+            TradeQuery q;
+            q.counterparty = name;
+            q.toNs         = from.first;
+            q.skipAtTo     = from.second;
+            q.limit        = limit - recent.size();
+            older          = trades_->query(q);
+        }
+
+        std::ostringstream j;
+        j << std::fixed << std::setprecision(6);
+        j << "{\"counterparty\":" << jsonStr(name) << ",\"total\":" << total << ",\"fills\":[";
+        bool first = true;
+        for (const StoredTrade& t : older) {
+            const bool bought = t.buyer == name;
+            if (!first) j << ",";
+            first = false;
+            j << "{\"ts\":"            << t.tsNs
+              << ",\"symbol\":"        << jsonStr(t.symbol)
+              << ",\"side\":"          << (bought ? "\"BUY\"" : "\"SELL\"")
+              << ",\"orderId\":"       << (bought ? t.buyOrderId : t.sellOrderId)
+              << ",\"price\":"         << t.price
+              << ",\"quantity\":"      << t.quantity
+              << ",\"counterparty\":"  << jsonStr(bought ? t.seller : t.buyer)
+              << "}";
+        }
+        for (const TradeNotification& n : recent) {
+            if (!first) j << ",";
+            first = false;
+            j << "{\"ts\":"            << n.tsNs
+              << ",\"symbol\":"        << jsonStr(std::string(n.symbol, strnlen(n.symbol, sizeof(n.symbol))))
+              << ",\"side\":"          << (n.wasBuy ? "\"BUY\"" : "\"SELL\"")
+              << ",\"orderId\":"       << n.orderId
+              << ",\"price\":"         << n.price
+              << ",\"quantity\":"      << n.quantity
+              << ",\"counterparty\":"  << jsonStr(n.counterpartyId ? Counterparty::nameOf(n.counterpartyId) : "")
+              << "}";
+        }
+        j << "],\"next\":";
+        // A full page may have more behind it
+        if (older.size() + recent.size() == limit) {
+            const int64_t oldest = older.empty() ? recent.front().tsNs : older.front().tsNs;
+            const auto    next   = cursorAfter(oldest, countAt(oldest, older) + countAt(oldest, recent));
+            j << "{\"to\":" << next.first << ",\"skip\":" << next.second << "}";
+        } else {
+            j << "null";
+        }
+        j << "}";
+        res.set_content(j.str(), "application/json");
+    });
+
     // ── POST /orders ─────────────────────────────────────────────────────────
     svr_.Post("/orders", [this](const httplib::Request& req, httplib::Response& res) {
-        const std::string& body = req.body;
+        const uint64_t     ingress = latencyNow();   // trace origin for the order's SSE events
+        const std::string& body    = req.body;
 
         std::string symbol      = extractStr(body, "symbol");
         double      price       = extractDouble(body, "price");
         long        quantity    = extractLong(body, "quantity");
         std::string side        = extractStr(body, "side");
         std::string cpName      = extractStr(body, "counterparty");
+        std::string tifName     = extractStr(body, "timeInForce");
+        long        display     = extractLong(body, "displayQuantity");   // iceberg slice; 0 = all shown
+        std::string pegName     = extractStr(body, "peg");
+        double      pegOffset   = extractDouble(body, "pegOffset");
+        std::string typeName    = extractStr(body, "type");                 // SPOT (default) or SWAP
+        std::string stpName     = extractStr(body, "selfTrade");
+
+        TimeInForce tif      = TimeInForce::GTC;   // default when omitted
+        bool        tifKnown = true;
+        if      (tifName == "IOC") tif      = TimeInForce::IOC;
+        else if (tifName == "FOK") tif      = TimeInForce::FOK;
+        else                       tifKnown = tifName.empty() || tifName == "GTC";
+
+        PegType peg      = PegType::NONE;   // fixed price when omitted
+        bool    pegKnown = true;
+        if      (pegName == "PRIMARY") peg      = PegType::PRIMARY;
+        else if (pegName == "MID")     peg      = PegType::MID;
+        else if (pegName == "MARKET")  peg      = PegType::MARKET;
+        else                           pegKnown = pegName.empty() || pegName == "NONE";
 
-        if (symbol.empty() || quantity <= 0 || (side != "BUY" && side != "SELL")) {
+        SelfTradePrevention stp      = defaultSelfTrade_;   // server default when omitted
+        bool                stpKnown = stpName.empty() || parseSelfTrade(stpName, stp);
+
+        // A swap is priced in forward points, which may be negative, and
+        // cannot be pegged
+        const bool swap      = typeName == "SWAP";
+        const bool typeKnown = swap ? peg == PegType::NONE : typeName.empty() || typeName == "SPOT";
+
+        if (symbol.empty() || quantity <= 0 || display < 0 || (side != "BUY" && side != "SELL") || !tifKnown || !pegKnown ||
+            !typeKnown || !stpKnown) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
             addCors(res);
             res.status = 400;
             res.set_content("{\"success\":false,\"error\":\"invalid request\"}", "application/json");
@@ -239,42 +674,259 @@ void HTTPServer::setupRoutes() {
         {
             auto it = counterparties_.find(cpName);
             if (it != counterparties_.end()) {
-                cp = &it->second;
+                cp = it->second;
             } else {
                 // Unknown name — use first available
-                cp = &counterparties_.begin()->second;
+                cp = counterparties_.begin()->second;
             }
         }
 
-        OrderType orderType = (side == "BUY") ? OrderType::SPOT_BUY : OrderType::SPOT_SELL;
-        Order order(symbol, price, static_cast<int>(quantity), orderType, cp);
+        OrderType orderType = swap ? (side == "BUY" ? OrderType::SWAP_BUY : OrderType::SWAP_SELL)
+                                   : (side == "BUY" ? OrderType::SPOT_BUY : OrderType::SPOT_SELL);
+        Order order(symbol, price, quantity, orderType, cp);
+        order.setIngressTicks(ingress);
+        order.setTimeInForce(tif);
+        order.setDisplayQuantity(display);
+        order.setPeg(peg, pegOffset);
+        order.setSelfTrade(stp);
         long newId = order.getId();
 
+        RejectReason reason;
+        long         filled  = 0;
+        long         resting = 0;
         {
             std::lock_guard<std::mutex> lk(mu_);
-            om_.processNewOrder(order);
+            reason = om_.processNewOrder(order, &filled);
+            if (const Order* o = om_.getOrder(newId)) resting = o->getOpenQuantity();
         }
 
         std::ostringstream j;
-        j << "{\"success\":true,\"orderId\":" << newId << "}";
         addCors(res);
+        if (reason != RejectReason::NONE) {
+            // Structured so clients can branch on "reason" without parsing text
+            res.status = 422;
+            j << "{\"success\":false,\"error\":" << rejectError(reason)
+              << ",\"reason\":"  << jsonStr(rejectReasonName(reason))
+              << ",\"message\":" << jsonStr(rejectReasonText(reason))
+              << ",\"orderId\":" << newId << "}";
+            res.set_content(j.str(), "application/json");
+            return;
+        }
+        // IOC/FOK never rest, and self-trade prevention may have cancelled
+        // the rest: whatever did not fill and is not on the book is gone
+        j << "{\"success\":true,\"orderId\":" << newId
+          << ",\"timeInForce\":\"" << toString(tif) << "\""
+          << ",\"filled\":"  << filled
+          << ",\"resting\":" << resting << "}";
         res.set_content(j.str(), "application/json");
     });
 
     // ── DELETE /orders/:id ───────────────────────────────────────────────────
     svr_.Delete(R"(/orders/(\d+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const uint64_t ingress = latencyNow();
         long id = std::stol(req.matches[1]);
         {
             std::lock_guard<std::mutex> lk(mu_);
-            om_.processCancelOrder(id);
+            om_.processCancelOrder(id, ingress);
         }
         addCors(res);
         res.set_content("{\"success\":true}", "application/json");
     });
 
+    // ── PATCH /orders/:id ────────────────────────────────────────────────────
+    // Body {"price":..,"quantity":..}; either may be omitted to keep it
+    svr_.Patch(R"(/orders/(\d+))", [this](const httplib::Request& req, httplib::Response& res) {
+        const uint64_t     ingress = latencyNow();
+        const std::string& body    = req.body;
+        long id = std::stol(req.matches[1]);
+        addCors(res);
+
+        const bool hasPrice    = body.find("\"price\"")    != std::string::npos;
+        const bool hasQuantity = body.find("\"quantity\"") != std::string::npos;
+        if (!hasPrice && !hasQuantity) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"price or quantity required\"}", "application/json");
+            return;
+        }
+
+        double bodyPrice = 0;
+        if (hasPrice && !parseDouble(body, "price", bodyPrice)) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"price is not a number\"}", "application/json");
+            return;
+        }
+
+        AmendResult  result;
+        RejectReason reason = RejectReason::NONE;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            const Order* resting  = om_.getOrder(id);
+            double       price    = hasPrice    ? bodyPrice                     : (resting ? resting->getPrice()    : 0);
+            long         quantity = hasQuantity ? extractLong(body, "quantity") : (resting ? resting->getOpenQuantity() : 0);
+            result = om_.processAmendOrder(id, price, quantity, ingress, &reason);
+        }
+
+        std::ostringstream j;
+        switch (result) {
+            case AmendResult::AMENDED:
+                j << "{\"success\":true,\"orderId\":" << id << "}";
+                break;
+            case AmendResult::NOT_FOUND:
+                res.status = 404;
+                j << "{\"success\":false,\"error\":\"order not found\"}";
+                break;
+            case AmendResult::INVALID:
+                Metrics::increment(Counter::REJECTED_REQUESTS);
+                res.status = 400;
+                j << "{\"success\":false,\"error\":\"invalid request\"}";
+                break;
+            case AmendResult::REJECTED:
+                res.status = 422;
+                j << "{\"success\":false,\"error\":" << rejectError(reason)
+                  << ",\"reason\":"  << jsonStr(rejectReasonName(reason))
+                  << ",\"message\":" << jsonStr(rejectReasonText(reason))
+                  << ",\"orderId\":" << id << "}";
+                break;
+        }
+        res.set_content(j.str(), "application/json");
+    });
+
+    // ── POST /quotes ─────────────────────────────────────────────────────────
+    // One two-sided quote ({"counterparty","symbol","bid","bidQty","ask",
+    // "askQty"}) or a mass quote ({"counterparty","quotes":[{"symbol",..},..]}).
+    // Every quote is checked before any is applied; then all are applied
+    // under one lock, each with one book_update for its symbol.
+    svr_.Post("/quotes", [this](const httplib::Request& req, httplib::Response& res) {
+        const uint64_t     ingress = latencyNow();
+        const std::string& body    = req.body;
+        const std::string  name    = extractStr(body, "counterparty");
+        const std::string  stpName = extractStr(body, "selfTrade");
+        addCors(res);
+
+        SelfTradePrevention stp      = defaultSelfTrade_;
+        bool                stpKnown = stpName.empty() || parseSelfTrade(stpName, stp);
+
+        std::vector<std::string> objects = extractObjects(body, "quotes");
+        if (objects.empty() && body.find("\"quotes\"") == std::string::npos) objects.push_back(body);   // one quote
+        std::vector<Quote> quotes;
+        for (const std::string& o : objects) {
+            Quote q;
+            q.symbol    = extractStr(o, "symbol");
+            q.bidPrice  = extractDouble(o, "bid");
+            q.bidQty    = extractLong(o, "bidQty");
+            q.askPrice  = extractDouble(o, "ask");
+            q.askQty    = extractLong(o, "askQty");
+            q.selfTrade = stp;
+            quotes.push_back(q);
+        }
+        const bool valid = std::all_of(quotes.begin(), quotes.end(), OrderManager::validQuote);
+
+        if (name.empty() || !stpKnown || quotes.empty() || !valid) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"invalid request\"}", "application/json");
+            return;
+        }
+
+        std::vector<QuoteSlot>    sides(quotes.size());
+        std::vector<RejectReason> reasons(quotes.size(), RejectReason::NONE);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto it = counterparties_.find(name);
+            if (it == counterparties_.end()) {
+                res.status = 404;
+                res.set_content("{\"success\":false,\"error\":\"unknown counterparty\"}", "application/json");
+                return;
+            }
+            for (size_t i = 0; i < quotes.size(); ++i)
+                om_.processQuote(*it->second, quotes[i], ingress, &sides[i], &reasons[i]);
+        }
+
+        // A side the risk gate refused is pulled; its quote carries the reason
+        bool               all = true;
+        std::ostringstream entries;
+        for (size_t i = 0; i < quotes.size(); ++i) {
+            if (i) entries << ",";
+            entries << "{\"symbol\":" << jsonStr(quotes[i].symbol)
+                    << ",\"bidId\":"  << sides[i].bidId
+                    << ",\"askId\":"  << sides[i].askId;
+            if (reasons[i] != RejectReason::NONE) {
+                all = false;
+                entries << ",\"reason\":" << jsonStr(rejectReasonName(reasons[i]));
+            }
+            entries << "}";
+        }
+        res.set_content("{\"success\":" + std::string(all ? "true" : "false") + ",\"quotes\":[" + entries.str() + "]}",
+                        "application/json");
+    });
+
+    // ── DELETE /orders?counterparty=X[&symbol=Y] ─────────────────────────────
+    // Mass cancel: every open order of the counterparty, or only those in
+    // symbol, in one engine pass with one book_update per affected symbol
+    svr_.Delete("/orders", [this](const httplib::Request& req, httplib::Response& res) {
+        const uint64_t    ingress = latencyNow();
+        const std::string name    = req.get_param_value("counterparty");
+        const std::string symbol  = req.get_param_value("symbol");
+        addCors(res);
+
+        if (name.empty()) {
+            Metrics::increment(Counter::REJECTED_REQUESTS);
+            res.status = 400;
+            res.set_content("{\"success\":false,\"error\":\"counterparty is required\"}", "application/json");
+            return;
+        }
+
+        int cancelled;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto it = counterparties_.find(name);
+            if (it == counterparties_.end()) {
+                res.status = 404;
+                res.set_content("{\"success\":false,\"error\":\"unknown counterparty\"}", "application/json");
+                return;
+            }
+            cancelled = om_.cancelAll(*it->second, symbol, ingress);
+        }
+        res.set_content("{\"success\":true,\"cancelled\":" + std::to_string(cancelled) + "}",
+                        "application/json");
+    });
+
+    // ── GET /metrics ─────────────────────────────────────────────────────────
+    // Scrape endpoint; reads only per-thread counters, relaxed-atomic gauges
+    // and latency histograms, so a scrape never contends with order
+    // processing for mu_
+    svr_.Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+        addCors(res);
+        res.set_content(Metrics::prometheusText(&bus_) + LatencyRegistry::prometheusText(),
+                        "text/plain; version=0.0.4");
+    });
+
     // ── GET /events (SSE) ────────────────────────────────────────────────────
-    svr_.Get("/events", [this](const httplib::Request&, httplib::Response& res) {
+    // ?trace=1 appends {"engineNs","queueNs","serverNs"} to every traced
+    // event's JSON so clients can split their own latency measurements.
+    // ?cancelOnDisconnect=<counterparty> cancels all of that counterparty's
+    // open orders, as DELETE /orders would, when this stream ends.
+    svr_.Get("/events", [this](const httplib::Request& req, httplib::Response& res) {
+        Counterparty* owner = nullptr;
+        if (req.has_param("cancelOnDisconnect")) {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto it = counterparties_.find(req.get_param_value("cancelOnDisconnect"));
+            if (it == counterparties_.end()) {
+                addCors(res);
+                res.status = 404;
+                res.set_content("{\"success\":false,\"error\":\"unknown counterparty\"}", "application/json");
+                return;
+            }
+            owner = it->second;
+        }
+
         auto conn = bus_.subscribe();
+        if (req.get_param_value("trace") == "1") {
+            std::lock_guard<std::mutex> lk(conn->mu);
+            conn->trace = true;
+        }
 
         res.set_header("Cache-Control",                "no-cache");
         res.set_header("Connection",                   "keep-alive");
@@ -282,10 +934,13 @@ void HTTPServer::setupRoutes() {
 
         res.set_chunked_content_provider(
             "text/event-stream",
-            [conn](size_t, httplib::DataSink& sink) -> bool {
+            [this, conn, owner, idleSec = 0](size_t, httplib::DataSink& sink) mutable -> bool {
                 std::unique_lock<std::mutex> lk(conn->mu);
-                // Block up to 20 s; wake on new event or disconnect
-                conn->cv.wait_for(lk, std::chrono::seconds(20), [&] {
+                // Block up to 20 s; wake on new event or disconnect.  A stream
+                // that cancels on disconnect waits in 1 s slices and probes the
+                // socket between them, so a dropped client is noticed promptly
+                // rather than at the next write
+                bool woken = conn->cv.wait_for(lk, std::chrono::seconds(owner ? 1 : 20), [&] {
                     return !conn->queue.empty() || conn->closed;
                 });
 
@@ -294,32 +949,101 @@ void HTTPServer::setupRoutes() {
                     return false;
                 }
 
+                if (!woken && owner) {
+                    if (!sink.is_writable()) {
+                        conn->closed = true;
+                        return false;
+                    }
+                    if (++idleSec < 20) return true;
+                }
+                idleSec = 0;
+
                 if (conn->queue.empty()) {
                     // Keepalive comment keeps the connection alive through proxies
                     const std::string ka = ": keepalive\n\n";
                     return sink.write(ka.data(), ka.size());
                 }
 
+                const double tpn = conn->trace ? LatencyRegistry::ticksPerNs() : 0.0;
                 while (!conn->queue.empty()) {
-                    const std::string& msg = conn->queue.front();
-                    if (!sink.write(msg.data(), msg.size())) {
+                    const EventBus::Event& ev = conn->queue.front();
+                    const uint64_t popped = latencyNow();
+                    LatencyRegistry::local(LatencyStage::SSE_QUEUE_DWELL).record(popped - ev.publishTicks);
+
+                    std::string        traced;
+                    const std::string* msg = &ev.msg;
+                    if (conn->trace) {
+                        traced = EventBus::withTrace(ev, popped, tpn);
+                        msg    = &traced;
+                    }
+                    if (!sink.write(msg->data(), msg->size())) {
                         conn->closed = true;
                         return false;
                     }
+                    const uint64_t written = latencyNow();
+                    LatencyRegistry::local(LatencyStage::SSE_SOCKET_WRITE).record(written - popped);
+                    if (ev.ingressTicks) {
+                        bool trade = ev.msg.compare(0, 12, "event: trade") == 0;
+                        LatencyRegistry::local(trade ? LatencyStage::TRADE_EVENT_E2E
+                                                     : LatencyStage::BOOK_UPDATE_EVENT_E2E)
+                            .record(written - ev.ingressTicks);
+                    }
+
                     conn->queue.pop();
+                    bus_.onDelivered(1);
                 }
                 return true;
             },
-            [this, conn](bool) {
+            [this, conn, owner](bool) {
                 bus_.unsubscribe(conn);
+                if (owner) {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    om_.cancelAll(*owner, "", latencyNow());
+                }
             }
         );
     });
 }
 
+// Conflated market-data stream: a slow tick rate passes through unchanged,
+// a fast one is thinned to the latest state per symbol per interval
+void HTTPServer::runMarketPump() {
+    const MarketManager* market = om_.getMarketManager();
+    if (!market) return;
+    ConflatingReader reader(*market);
+    while (!pumpStop_.load()) {
+        reader.poll([&](int id, const MarketQuote& q) {
+            bus_.publish("event: market\ndata: " + quoteJson(market->symbolName(id), q) + "\n\n");
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(MARKET_PUMP_MS));
+    }
+}
+
+// Uncross every auction symbol once per interval, under the engine lock.
+// The wait is sliced so stop() is never held up by a long interval.
+void HTTPServer::runAuctionClock() {
+    auto next = std::chrono::steady_clock::now();
+    while (!pumpStop_.load()) {
+        next += std::chrono::milliseconds(auctionMs_);
+        while (!pumpStop_.load() && std::chrono::steady_clock::now() < next)
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                next - std::chrono::steady_clock::now(), std::chrono::milliseconds(MARKET_PUMP_MS)));
+        if (pumpStop_.load()) break;
+
+        std::lock_guard<std::mutex> lk(mu_);
+        for (const std::string& symbol : om_.getAuctionSymbols()) om_.runAuction(symbol);
+    }
+}
+
 void HTTPServer::start(int port) {
+    pumpStop_.store(false);
+    marketPump_ = std::thread([this] { runMarketPump(); });
+    if (auctionMs_ > 0) auctionClock_ = std::thread([this] { runAuctionClock(); });
     std::cout << "HTTP server listening on http://localhost:" << port << "\n";
     svr_.listen("0.0.0.0", port);
+    pumpStop_.store(true);
+    marketPump_.join();
+    if (auctionClock_.joinable()) auctionClock_.join();
 }
 
 void HTTPServer::stop() {
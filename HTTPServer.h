@@ -1,49 +1,159 @@
 #ifndef HTTPSERVER_H
 #define HTTPSERVER_H
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <string>
+#include <thread>
 #include "Counterparty.h"
 #include "EventBus.h"
+#include "OrderType.h"
 #include "httplib.h"
 
+class CandleAggregator;
 class OrderManager;
+class PositionKeeper;
+class TradeFeed;
+class TradeStore;
 
 // REST + SSE HTTP server for the trading UI.
 //
 // Endpoints:
 //   GET  /symbols             — list of symbols with active orders
 //   GET  /book/:symbol        — full bid/ask snapshot for one symbol
+//   GET  /swapbook/:symbol    — the pair's swap book, priced in forward points
 //   GET  /books               — snapshots for every symbol (initial load)
-//   GET  /trades              — recent trades (up to 100)
+//   GET  /implied             — implied top of book of every configured cross
+//   GET  /auction/:symbol     — indicative uncross of an auction symbol: price,
+//                               volume and surplus if it ran now (404 if the
+//                               symbol trades continuously)
+//   GET  /trades              — fills, oldest first; ?symbol=&from=&to= (ns)
+//                               &limit=N (default 100, ≤ 10000).  Full history
+//                               from the TradeStore, else the last 100 fills
+//   GET  /market              — last price, BBO and volume for every symbol
+//   GET  /market/:symbol      — the same for one symbol (404 if none)
+//   GET  /candles/:symbol     — OHLCV + VWAP bars; ?interval=1s|1m|5m|1h
+//                               (default 1m), &limit=N (default all, ≤ 512)
 //   GET  /counterparties      — available counterparty names
-//   POST /orders              — submit a new order
+//   GET  /counterparties/:name/fills
+//                             — the counterparty's fills, oldest first;
+//                               ?to= (ns) &limit=N (default 100, ≤ 10000).
+//                               Retained fills first, then the TradeStore
+//   GET  /positions/:name     — net position, average cost, realised and
+//                               marked unrealised P&L per symbol
+//   POST /orders              — submit a new order ("timeInForce": GTC |
+//                               IOC | FOK, default GTC; "displayQuantity"
+//                               makes it an iceberg showing that much at a
+//                               time; "peg": PRIMARY | MID | MARKET with
+//                               "pegOffset" has the engine price it off the
+//                               market quote and follow it; "type": SWAP
+//                               makes "price" forward points in the swap
+//                               book; "selfTrade": CANCEL_RESTING |
+//                               CANCEL_INCOMING | CANCEL_BOTH | DECREMENT |
+//                               NONE, default --self-trade, decides what
+//                               meeting its own counterparty's order does);
+//                               replies with the quantity filled and left
+//                               resting, hidden reserve included.  422
+//                               with a structured {"error":"risk_rejected",
+//                               "reason":..} body if the risk gate refuses
+//                               it ("peg_rejected" if the quote has no
+//                               price for its peg, "swap_rejected" if a
+//                               crossing swap has no near rate)
+//   POST /quotes              — replace a counterparty's two-sided quote
+//                               ("symbol", "bid", "bidQty", "ask",
+//                               "askQty"; quantity 0 pulls a side), or
+//                               many at once under "quotes": [..].  Each
+//                               side's resting order is amended in place;
+//                               one book_update per symbol.  Replies with
+//                               the resting bidId/askId per symbol, and the
+//                               reason for any side the risk gate pulled.
+//                               400 if any quote is invalid (none applied),
+//                               404 for an unknown counterparty
+//   PATCH /orders/:id         — amend price and/or quantity in place; a
+//                               quantity cut keeps time priority.  404 if
+//                               not resting, 422 if the risk gate refuses
 //   DELETE /orders/:id        — cancel an order by ID
-//   GET  /events              — SSE stream (trade and book_update events)
+//   DELETE /orders?counterparty=X[&symbol=Y]
+//                             — cancel all of X's open orders (in Y only);
+//                               one book_update per affected symbol
+//   GET  /events              — SSE stream (trade, book_update,
+//                               swap_book_update, implied_quote, auction,
+//                               market, candle and position events);
+//                               ?trace=1 embeds per-event server timings;
+//                               ?cancelOnDisconnect=X mass cancels X's
+//                               orders when the stream closes
+//   GET  /metrics             — Prometheus text exposition (counters, book gauges,
+//                               SSE gauges, stage latency histograms including
+//                               the order-to-SSE trace stages)
 //
 // Thread safety: all OrderManager access is serialised through mu_.
 // The SSE handler runs in its own httplib thread, waiting on the EventBus
-// connection queue — it does NOT hold mu_ while waiting.
+// connection queue — it does NOT hold mu_ while waiting.  /metrics never takes
+// mu_: it only reads per-thread counters, atomic gauges and latency histograms.
+// /market never takes it either: MarketManager reads are seqlock snapshots.
+// Market feed threads take mu_ only to fill resting orders an external tick
+// crosses (OrderManager::processMarketTick).
+// The market pump thread publishes conflated "market" events: every 100 ms,
+// one event per symbol that ticked, carrying only its latest state.
+// The auction clock thread takes mu_ once per --auction-interval-ms to
+// uncross every auction symbol (OrderManager::runAuction).
+// /candles reads the CandleAggregator under its own lock, not mu_; so does
+// /trades when a TradeStore is attached, and /positions.
 class HTTPServer {
 public:
     HTTPServer(OrderManager& om, EventBus& bus);
+    ~HTTPServer();
     void start(int port);   // blocks until stop() is called
     void stop();
 
+    // Serve GET /candles from this aggregator (none = 404)
+    void setCandleAggregator(const CandleAggregator* candles) { candles_ = candles; }
+    // Serve GET /trades from this store (none = the in-memory last 100).
+    // feed is the TradeFeed that fills it; it is flushed before the store is
+    // read past a counterparty's ring, so a just-evicted fill is not missed.
+    void setTradeStore(const TradeStore* trades, TradeFeed* feed = nullptr) { trades_ = trades; tradeFeed_ = feed; }
+    // Use an existing Counterparty for this name instead of the server's own,
+    // so orders from the CSV seed and from HTTP share one fill history and
+    // id.  Call before start(); cp must outlive the server.
+    void addCounterparty(Counterparty* cp);
+    // Serve GET /positions from this keeper (none = 404)
+    void setPositionKeeper(const PositionKeeper* positions) { positions_ = positions; }
+    // Run every auction symbol's auction this often (0 = never; call before start())
+    void setAuctionInterval(int ms) { auctionMs_ = ms; }
+    // Self-trade prevention for orders whose POST /orders omits "selfTrade"
+    void setDefaultSelfTrade(SelfTradePrevention stp) { defaultSelfTrade_ = stp; }
+
+    static constexpr int  MARKET_PUMP_MS   = 100;
+    static constexpr long MAX_TRADES_LIMIT = 10000;   // fills per GET /trades response
+
 private:
     httplib::Server svr_;
     OrderManager&   om_;
     EventBus&       bus_;
+    const CandleAggregator* candles_{nullptr};   // internally locked; read without mu_
+    const TradeStore*       trades_{nullptr};    // likewise
+    TradeFeed*              tradeFeed_{nullptr}; // fills trades_; its consumer runs, so flush() only waits
+    const PositionKeeper*   positions_{nullptr}; // likewise
     std::mutex      mu_;    // guards all OrderManager access from HTTP threads
 
-    // Counterparties owned by this server for HTTP-submitted orders
-    std::map<std::string, Counterparty> counterparties_;
+    // Counterparties for HTTP-submitted orders, by name: the server's own
+    // unless addCounterparty replaced them.  Fixed once the server starts.
+    std::map<std::string, Counterparty>  ownCounterparties_;
+    std::map<std::string, Counterparty*> counterparties_;
+
+    std::thread         marketPump_;
+    std::thread         auctionClock_;
+    std::atomic<bool>   pumpStop_{false};
+    int                 auctionMs_{0};
+    SelfTradePrevention defaultSelfTrade_{SelfTradePrevention::NONE};
 
     void setupRoutes();
+    void runMarketPump();
+    void runAuctionClock();
 
-    // Build book JSON object for one symbol (no SSE prefix)
-    std::string bookJson(const std::string& symbol);
+    // Build book JSON object for one symbol's spot or swap book (no SSE prefix)
+    std::string bookJson(const std::string& symbol, bool swap = false);
 
     // Append CORS headers to every response
     static void addCors(httplib::Response& res);
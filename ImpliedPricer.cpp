@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include "ImpliedPricer.h"
+#include "Metrics.h"
+#include "SubBook.h"
+
+// ── Configuration ─────────────────────────────────────────────────────────────
+
+// "EUR/USD" → "EUR", "USD"
+static bool splitPair(const std::string& symbol, std::string& base, std::string& quote) {
+    auto slash = symbol.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 == symbol.size()) return false;
+    base  = symbol.substr(0, slash);
+    quote = symbol.substr(slash + 1);
+    return true;
+}
+
+int ImpliedPricer::leg(const std::string& symbol) {
+    auto [it, inserted] = legIds_.try_emplace(symbol, static_cast<int>(legs_.size()));
+    if (inserted) legs_.push_back({ symbol, {}, {} });
+    return it->second;
+}
+
+int ImpliedPricer::addCross(const std::string& cross, const std::string& a, const std::string& b) {
+    std::string x, y, a1, a2, b1, b2;
+    if (!splitPair(cross, x, y) || !splitPair(a, a1, a2) || !splitPair(b, b1, b2)) return -1;
+    for (const Cross& c : crosses_)
+        if (c.symbol == cross) return -1;
+
+    // The first leg carries X, the second Y, and both share C
+    const bool swapped = a1 != x && a2 != x;
+    const std::string& xLeg = swapped ? b : a;
+    const std::string& yLeg = swapped ? a : b;
+    if (swapped) { std::swap(a1, b1); std::swap(a2, b2); }
+    if ((a1 != x && a2 != x) || (b1 != y && b2 != y)) return -1;
+    const std::string& cx = a1 == x ? a2 : a1;
+    const std::string& cy = b1 == y ? b2 : b1;
+    if (cx != cy || cx == x || cx == y) return -1;
+
+    const int id = static_cast<int>(crosses_.size());
+    Cross c{ cross, { leg(xLeg), leg(yLeg) }, { a1 != x, b1 != y }, {} };
+    crosses_.push_back(c);
+    legs_[c.legs[0]].crosses.push_back(id);
+    legs_[c.legs[1]].crosses.push_back(id);
+    recompute(crosses_.back());
+    return id;
+}
+
+int ImpliedPricer::legIndex(const std::string& symbol) const {
+    auto it = legIds_.find(symbol);
+    return it == legIds_.end() ? -1 : it->second;
+}
+
+// ── Pricing ───────────────────────────────────────────────────────────────────
+
+Touch ImpliedPricer::touchOf(const SubBook& sb) {
+    Touch t;
+    if (!sb.getBuyOrders().empty()) {
+        t.bid    = sb.getBuyOrders().begin()->first;
+        t.bidQty = sb.getBuyOrders().begin()->second.quantity;
+    }
+    if (!sb.getSellOrders().empty()) {
+        t.ask    = sb.getSellOrders().begin()->first;
+        t.askQty = sb.getSellOrders().begin()->second.quantity;
+    }
+    return t;
+}
+
+// A leg's touch seen as CCY/C.  A leg quoted C/CCY is inverted: selling CCY
+// for C lifts its ask, so the CCY/C bid is 1 / ask, for ask × askQty of CCY.
+namespace {
+struct Rate {
+    double bid = 0, bidQty = 0, ask = 0, askQty = 0;   // quantities in CCY
+};
+}
+
+static Rate asRate(const Touch& t, bool inverted) {
+    Rate r;
+    if (!inverted) {
+        r.bid = t.bid;  r.bidQty = static_cast<double>(t.bidQty);
+        r.ask = t.ask;  r.askQty = static_cast<double>(t.askQty);
+        return r;
+    }
+    if (t.ask > 0) { r.bid = 1 / t.ask;  r.bidQty = static_cast<double>(t.askQty) * t.ask; }
+    if (t.bid > 0) { r.ask = 1 / t.bid;  r.askQty = static_cast<double>(t.bidQty) * t.bid; }
+    return r;
+}
+
+// Whole units of a quantity worked out through rates; the slack keeps
+// rounding error (39.999999…) from costing a unit
+static long wholeUnits(double qty) {
+    return static_cast<long>(std::floor(qty + 1e-9));
+}
+
+void ImpliedPricer::recompute(Cross& c) {
+    Metrics::increment(Counter::IMPLIED_RECOMPUTES);
+    const Rate x = asRate(legs_[c.legs[0]].touch, c.inverted[0]);
+    const Rate y = asRate(legs_[c.legs[1]].touch, c.inverted[1]);
+
+    // Selling X at the implied bid sells X for C on leg 1, then buys Y with
+    // that C on leg 2; each leg caps the X quantity
+    Touch q;
+    if (x.bid > 0 && y.ask > 0) {
+        q.bidQty = wholeUnits(std::min(x.bidQty, y.askQty * y.ask / x.bid));
+        if (q.bidQty > 0) q.bid = x.bid / y.ask;
+    }
+    if (x.ask > 0 && y.bid > 0) {
+        q.askQty = wholeUnits(std::min(x.askQty, y.bidQty * y.bid / x.ask));
+        if (q.askQty > 0) q.ask = x.ask / y.bid;
+    }
+    if (q.bid == 0) q.bidQty = 0;
+    if (q.ask == 0) q.askQty = 0;
+    c.quote = q;
+}
+
+const std::vector<int>& ImpliedPricer::onLegChanged(int legId, const Touch& touch) {
+    moved_.clear();
+    Leg& l = legs_[legId];
+    if (touch == l.touch) return moved_;   // depth behind the touch changed: nothing implied moves
+
+    l.touch = touch;
+    for (int id : l.crosses) {
+        Cross& c    = crosses_[id];
+        Touch  prev = c.quote;
+        recompute(c);
+        if (c.quote != prev) moved_.push_back(id);
+    }
+    return moved_;
+}
+
+// ── Execution plan ────────────────────────────────────────────────────────────
+
+// The leg order that buys (or sells) amount of the leg's cross currency
+// against C, moving c of C: a direct leg trades the amount itself, an
+// inverted one trades the C the other way.
+static ImpliedPricer::LegOrder legOrder(int legId, const Touch& t, bool inverted, bool buyCcy,
+                                        double amount, double c) {
+    const bool buy = inverted ? !buyCcy : buyCcy;
+    return { legId, buy, std::lround(inverted ? c : amount), buy ? t.ask : t.bid };
+}
+
+bool ImpliedPricer::plan(int cross, bool buy, long qty, LegOrder out[2]) const {
+    const Cross& cr = crosses_[cross];
+    const Touch& tx = legs_[cr.legs[0]].touch;
+    const Touch& ty = legs_[cr.legs[1]].touch;
+    const Rate   x  = asRate(tx, cr.inverted[0]);
+    const Rate   y  = asRate(ty, cr.inverted[1]);
+
+    // Buying X: buy X with C on leg 1, and raise that C by selling Y on leg 2.
+    // Selling X is the mirror image.
+    const double c = static_cast<double>(qty) * (buy ? x.ask : x.bid);
+    out[0] = legOrder(cr.legs[0], tx, cr.inverted[0],  buy, static_cast<double>(qty), c);
+    out[1] = legOrder(cr.legs[1], ty, cr.inverted[1], !buy, c / (buy ? y.bid : y.ask), c);
+    return out[0].qty > 0 && out[1].qty > 0;
+}
+
+std::string ImpliedPricer::quoteJson(int cross) const {
+    const Cross& c = crosses_[cross];
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(6);
+    j << "{\"symbol\":\"" << c.symbol << "\""
+      << ",\"bid\":"       << c.quote.bid
+      << ",\"bidQty\":"    << c.quote.bidQty
+      << ",\"ask\":"       << c.quote.ask
+      << ",\"askQty\":"    << c.quote.askQty
+      << ",\"legs\":[\""   << legs_[c.legs[0]].symbol << "\",\"" << legs_[c.legs[1]].symbol << "\"]"
+      << "}";
+    return j.str();
+}
@@ -0,0 +1,108 @@
+#ifndef IMPLIEDPRICER_H
+#define IMPLIEDPRICER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SubBook;
+
+// One book's top of book: best bid and ask with their displayed quantity.
+// A side with nothing on it has price 0 and quantity 0.
+struct Touch {
+    double bid    = 0;
+    long   bidQty = 0;
+    double ask    = 0;
+    long   askQty = 0;
+
+    bool operator==(const Touch& o) const {
+        return bid == o.bid && bidQty == o.bidQty && ask == o.ask && askQty == o.askQty;
+    }
+    bool operator!=(const Touch& o) const { return !(*this == o); }
+};
+
+// ─── Implied cross-rate books ────────────────────────────────────────────────
+//
+// A configured cross X/Y (EUR/GBP) is priced from two leg books that each
+// pair one of its currencies with a common one C (EUR/USD and GBP/USD).
+// Either leg may be quoted the other way round (USD/JPY for JPY), and is
+// then inverted.  With both legs seen as X/C and Y/C:
+//
+//   implied bid = X/C bid ÷ Y/C ask      implied ask = X/C ask ÷ Y/C bid
+//
+// and each side's quantity, in X, is the most both legs' touches can carry.
+//
+// Only the legs' touches are kept.  A leg update that leaves its touch
+// unchanged costs one comparison; one that moves it recomputes the crosses
+// built on that leg, each in O(1).  The leg's SubBook carries its leg index,
+// so books that are no leg pay nothing.
+//
+// An implied fill is planned here and executed by OrderManager as two leg
+// orders at the legs' touch prices.  Each plan fits inside the touch
+// quantities, so both legs fill in full, back to back under the engine lock.
+// Leg quantities are rounded to whole units.
+//
+// Top of book only: deeper implied levels would need the legs' depth walked
+// on every update.
+class ImpliedPricer {
+public:
+    // One leg order of an implied fill
+    struct LegOrder {
+        int    leg;     // index of the leg book
+        bool   buy;
+        long   qty;
+        double price;   // the leg's touch on the side it takes
+    };
+
+    // Register cross, priced from legs a and b (either order).  Returns the
+    // cross's index, or -1 if the symbols are not CCY/CCY pairs that share a
+    // common currency or the cross is already configured.
+    int addCross(const std::string& cross, const std::string& a, const std::string& b);
+
+    // Index of symbol's leg book, or -1 if it is no leg of any cross
+    int legIndex(const std::string& symbol) const;
+
+    // A leg's book changed: recompute the crosses on it if its touch moved.
+    // Returns the crosses whose implied touch changed (valid until the next call).
+    const std::vector<int>& onLegChanged(int leg, const Touch& touch);
+
+    const Touch&       quote(int cross) const        { return crosses_[cross].quote; }
+    const std::string& crossSymbol(int cross) const  { return crosses_[cross].symbol; }
+    const std::string& legSymbol(int leg) const      { return legs_[leg].symbol; }
+    int                legOf(int cross, int i) const { return crosses_[cross].legs[i]; }   // i = 0 (X/C), 1 (Y/C)
+    int                crossCount() const            { return static_cast<int>(crosses_.size()); }
+
+    // The two leg orders that fill qty of the cross at its implied touch
+    // (buy = take the implied ask).  False if a leg would round to nothing.
+    bool plan(int cross, bool buy, long qty, LegOrder out[2]) const;
+
+    // The touch of a book
+    static Touch touchOf(const SubBook& sb);
+
+    // {"symbol":..,"bid":..,"bidQty":..,"ask":..,"askQty":..,"legs":[..,..]}
+    std::string quoteJson(int cross) const;
+
+private:
+    struct Leg {
+        std::string      symbol;
+        Touch            touch;
+        std::vector<int> crosses;   // crosses priced from this leg
+    };
+
+    struct Cross {
+        std::string symbol;
+        int         legs[2];       // X/C leg, then Y/C leg
+        bool        inverted[2];   // leg is quoted C/X (C/Y)
+        Touch       quote;         // implied touch, in X
+    };
+
+    std::vector<Leg>                     legs_;
+    std::vector<Cross>                   crosses_;
+    std::unordered_map<std::string, int> legIds_;
+    std::vector<int>                     moved_;   // scratch for onLegChanged
+
+    int  leg(const std::string& symbol);
+    void recompute(Cross& c);
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "Latency.h"
+
+const char* stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::PROCESS_NEW_ORDER:     return "process_new_order";
+        case LatencyStage::PROCESS_CANCEL_ORDER:  return "process_cancel_order";
+        case LatencyStage::PROCESS_AMEND_ORDER:   return "process_amend_order";
+        case LatencyStage::REPRICE_PEGS:          return "reprice_pegs";
+        case LatencyStage::REFRESH_IMPLIED:       return "refresh_implied";
+        case LatencyStage::UNCROSS:               return "uncross";
+        case LatencyStage::PROCESS_QUOTE:         return "process_quote";
+        case LatencyStage::MATCH_SPOT_ORDERS:     return "match_spot_orders";
+        case LatencyStage::MATCH_SWAP_ORDERS:     return "match_swap_orders";
+        case LatencyStage::PUBLISH_BOOK_UPDATE:   return "publish_book_update";
+        case LatencyStage::EVENTBUS_PUBLISH:      return "eventbus_publish";
+        case LatencyStage::ORDER_TO_PUBLISH:      return "order_to_publish";
+        case LatencyStage::SSE_QUEUE_DWELL:       return "sse_queue_dwell";
+        case LatencyStage::SSE_SOCKET_WRITE:      return "sse_socket_write";
+        case LatencyStage::TRADE_EVENT_E2E:       return "trade_event_end_to_end";
+        case LatencyStage::BOOK_UPDATE_EVENT_E2E: return "book_update_event_end_to_end";
+        case LatencyStage::TICK_TO_FILL:          return "tick_to_fill";
+        case LatencyStage::COUNT:                 break;
+    }
+    return "unknown";
+}
+
+// ── LatencyHistogram ──────────────────────────────────────────────────────────
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        uint64_t n = other.counts_[i].load(std::memory_order_relaxed);
+        if (n) counts_[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    total_.fetch_add(other.count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+    if (other.max() > max()) max_.store(other.max(), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketLow(int bucket) {
+    if (bucket < SUB_COUNT) return static_cast<uint64_t>(bucket);
+    int group = bucket / SUB_COUNT;
+    int sub   = bucket % SUB_COUNT;
+    return static_cast<uint64_t>(SUB_COUNT + sub) << (group - 1);
+}
+
+uint64_t LatencyHistogram::bucketHigh(int bucket) {
+    if (bucket < SUB_COUNT) return static_cast<uint64_t>(bucket);
+    int group = bucket / SUB_COUNT;
+    int sub   = bucket % SUB_COUNT;
+    return (static_cast<uint64_t>(SUB_COUNT + sub + 1) << (group - 1)) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    // Bucket counts are summed here rather than trusting total_, so a scrape
+    // racing a writer still walks a self-consistent distribution
+    uint64_t total = 0;
+    for (const auto& c : counts_) total += c.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    if (rank < 1)     rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t mid = bucketLow(i) + (bucketHigh(i) - bucketLow(i)) / 2;
+            return std::min(mid, max());
+        }
+    }
+    return max();
+}
+
+// ── LatencyRegistry ───────────────────────────────────────────────────────────
+
+static constexpr int STAGE_COUNT = static_cast<int>(LatencyStage::COUNT);
+
+// One block of histograms per recording thread
+struct ThreadHistograms {
+    LatencyHistogram stages[STAGE_COUNT];
+};
+
+static std::mutex                     registryMu;
+static std::vector<ThreadHistograms*> registryBlocks;   // never freed: outlive their threads
+
+static ThreadHistograms* registerThread() {
+    auto* block = new ThreadHistograms();
+    std::lock_guard<std::mutex> lk(registryMu);
+    registryBlocks.push_back(block);
+    return block;
+}
+
+// Reference point for TSC calibration, captured at static-initialisation time
+struct CalibrationPoint {
+    uint64_t                              ticks;
+    std::chrono::steady_clock::time_point wall;
+};
+static const CalibrationPoint calibrationBase{latencyNow(), std::chrono::steady_clock::now()};
+
+LatencyHistogram& LatencyRegistry::local(LatencyStage stage) {
+    static thread_local ThreadHistograms* block = registerThread();
+    return block->stages[static_cast<int>(stage)];
+}
+
+void LatencyRegistry::collect(LatencyStage stage, LatencyHistogram& out) {
+    std::lock_guard<std::mutex> lk(registryMu);
+    for (const auto* block : registryBlocks)
+        out.merge(block->stages[static_cast<int>(stage)]);
+}
+
+void LatencyRegistry::resetAll() {
+    std::lock_guard<std::mutex> lk(registryMu);
+    for (auto* block : registryBlocks)
+        for (auto& h : block->stages) h.reset();
+}
+
+double LatencyRegistry::ticksPerNs() {
+#if defined(__x86_64__) || defined(__i386__)
+    // Ratio of TSC ticks to steady_clock nanoseconds since process start.
+    // The longer the process has run, the more precise the estimate; on a
+    // very young process wait a few milliseconds for a usable baseline.
+    auto elapsed = std::chrono::steady_clock::now() - calibrationBase.wall;
+    if (elapsed < std::chrono::milliseconds(5))
+        std::this_thread::sleep_for(std::chrono::milliseconds(5) - elapsed);
+
+    uint64_t ticks = latencyNow();
+    auto     ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - calibrationBase.wall).count();
+    if (ns <= 0) return 1.0;
+    return static_cast<double>(ticks - calibrationBase.ticks) / static_cast<double>(ns);
+#else
+    return 1.0;
+#endif
+}
+
+std::string LatencyRegistry::prometheusText() {
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    const double tpn = ticksPerNs();
+    auto toNs = [tpn](uint64_t ticks) {
+        return static_cast<uint64_t>(static_cast<double>(ticks) / tpn + 0.5);
+    };
+
+    LatencyHistogram merged[STAGE_COUNT];
+    for (int s = 0; s < STAGE_COUNT; ++s)
+        collect(static_cast<LatencyStage>(s), merged[s]);
+
+    std::ostringstream out;
+    out << "# HELP ts_stage_latency_ns Engine stage latency in nanoseconds (TSC probes)\n"
+        << "# TYPE ts_stage_latency_ns summary\n";
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const char* name = stageName(static_cast<LatencyStage>(s));
+        for (double q : quantiles)
+            out << "ts_stage_latency_ns{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << toNs(merged[s].percentile(q)) << "\n";
+        out << "ts_stage_latency_ns_sum{stage=\""   << name << "\"} " << toNs(merged[s].sum()) << "\n"
+            << "ts_stage_latency_ns_count{stage=\"" << name << "\"} " << merged[s].count()      << "\n";
+    }
+
+    out << "# HELP ts_stage_latency_max_ns Largest observed stage latency in nanoseconds\n"
+        << "# TYPE ts_stage_latency_max_ns gauge\n";
+    for (int s = 0; s < STAGE_COUNT; ++s)
+        out << "ts_stage_latency_max_ns{stage=\"" << stageName(static_cast<LatencyStage>(s)) << "\"} "
+            << toNs(merged[s].max()) << "\n";
+
+    return out.str();
+}
@@ -0,0 +1,172 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// ─── Latency instrumentation ─────────────────────────────────────────────────
+//
+// Timing probes for the engine hot path.  A probe reads the CPU timestamp
+// counter on entry and exit and records the elapsed ticks into a histogram
+// owned by the calling thread, so recording never takes a lock and never
+// shares a cache line with another writer.  GET /metrics aggregates all
+// per-thread histograms on scrape and converts ticks to nanoseconds.
+//
+// Build with -DTS_NO_LATENCY_PROBES to compile every LATENCY_PROBE away.
+
+// Engine stages that carry a probe, followed by the order-to-SSE trace
+// stages recorded from ingress timestamps.  Keep in step with stageName().
+enum class LatencyStage
+{
+    PROCESS_NEW_ORDER = 0,
+    PROCESS_CANCEL_ORDER,
+    PROCESS_AMEND_ORDER,
+    REPRICE_PEGS,
+    REFRESH_IMPLIED,
+    UNCROSS,
+    PROCESS_QUOTE,
+    MATCH_SPOT_ORDERS,
+    MATCH_SWAP_ORDERS,
+    PUBLISH_BOOK_UPDATE,
+    EVENTBUS_PUBLISH,
+    ORDER_TO_PUBLISH,        // command ingress → EventBus::publish
+    SSE_QUEUE_DWELL,         // EventBus::publish → SSE writer picks the event up
+    SSE_SOCKET_WRITE,        // one sink.write of an event
+    TRADE_EVENT_E2E,         // command ingress → trade event written to the socket
+    BOOK_UPDATE_EVENT_E2E,   // command ingress → book_update event written to the socket
+    TICK_TO_FILL,            // external market tick arrival → triggered fills done
+    COUNT
+};
+
+const char* stageName(LatencyStage stage);
+
+// Raw timestamp in CPU ticks (TSC on x86, steady_clock nanoseconds elsewhere)
+inline uint64_t latencyNow() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// HDR-style log-linear histogram of tick counts.
+//
+// Values below 2^SUB_BITS are counted exactly.  Above that, every power-of-two
+// range is split into 2^SUB_BITS linear sub-buckets, bounding the relative
+// error of any reported percentile to 1 / 2^SUB_BITS (~3%).
+//
+// A histogram has a single writer (its owning thread) and any number of
+// readers; counts are relaxed atomics so a concurrent scrape reads a
+// consistent-enough view without stalling the writer.
+class LatencyHistogram
+{
+public:
+    static constexpr int    SUB_BITS    = 5;
+    static constexpr int    SUB_COUNT   = 1 << SUB_BITS;
+    static constexpr int    MAX_MSB     = 47;             // ~2^48 ticks, well over a minute
+    static constexpr int    GROUPS      = MAX_MSB - SUB_BITS + 2;
+    static constexpr int    BUCKETS     = GROUPS * SUB_COUNT;
+
+    LatencyHistogram();
+
+    void record(uint64_t value) {
+        // Single writer: plain load/store pairs avoid a locked RMW per sample
+        std::atomic<uint64_t>& slot = counts_[bucketFor(value)];
+        slot.store(slot.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_.store(total_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    // Add another histogram's counts into this one (used on scrape)
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t sum()   const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max()   const { return max_.load(std::memory_order_relaxed); }
+
+    // Value at quantile q (0.0 – 1.0); returns the midpoint of the bucket
+    // holding the q-th sample, or 0 if the histogram is empty
+    uint64_t percentile(double q) const;
+
+    static int bucketFor(uint64_t value) {
+        if (value < static_cast<uint64_t>(SUB_COUNT)) return static_cast<int>(value);
+        int msb = 63 - __builtin_clzll(value);
+        if (msb > MAX_MSB) return BUCKETS - 1;
+        int group = msb - SUB_BITS + 1;
+        int sub   = static_cast<int>((value >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+        return group * SUB_COUNT + sub;
+    }
+
+    static uint64_t bucketLow(int bucket);
+    static uint64_t bucketHigh(int bucket);
+
+private:
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Process-wide registry of per-thread histograms.
+//
+// Each thread lazily allocates one LatencyHistogram per stage the first time
+// it records; the block is registered here and outlives the thread so no
+// samples are lost when an httplib worker exits.
+class LatencyRegistry
+{
+public:
+    // Histogram for `stage` owned by the calling thread
+    static LatencyHistogram& local(LatencyStage stage);
+
+    // Merge every thread's histogram for `stage` into `out` (ticks)
+    static void collect(LatencyStage stage, LatencyHistogram& out);
+
+    // Zero every histogram (tests and benchmarks only — not synchronised
+    // against concurrent writers)
+    static void resetAll();
+
+    // Calibrated TSC frequency, used to convert ticks to nanoseconds
+    static double ticksPerNs();
+
+    // Prometheus text exposition of every stage: p50/p90/p99/p99.9, max,
+    // sum and count in nanoseconds
+    static std::string prometheusText();
+};
+
+// RAII probe: times the enclosing scope into the current thread's histogram
+class LatencyProbe
+{
+public:
+    explicit LatencyProbe(LatencyStage stage)
+        : hist_(LatencyRegistry::local(stage)), start_(latencyNow()) {}
+    ~LatencyProbe() { hist_.record(latencyNow() - start_); }
+
+    LatencyProbe(const LatencyProbe&)            = delete;
+    LatencyProbe& operator=(const LatencyProbe&) = delete;
+
+private:
+    LatencyHistogram& hist_;
+    uint64_t          start_;
+};
+
+#define LATENCY_CONCAT_(a, b) a##b
+#define LATENCY_CONCAT(a, b)  LATENCY_CONCAT_(a, b)
+
+#ifdef TS_NO_LATENCY_PROBES
+#define LATENCY_PROBE(stage) ((void)0)
+#else
+#define LATENCY_PROBE(stage) LatencyProbe LATENCY_CONCAT(latencyProbe_, __LINE__)(stage)
+#endif
+
+#endif
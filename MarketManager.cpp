@@ -1,9 +1,261 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "Latency.h"
 #include "MarketManager.h"
+#include "Metrics.h"
 
-MarketManager::MarketManager() {
-    
+MarketManager::MarketManager()
+    : slots_(new Slot[MAX_SYMBOLS]),
+      names_(new std::string[MAX_SYMBOLS]),
+      index_(new std::atomic<int>[INDEX_SIZE]) {
+    for (int i = 0; i < INDEX_SIZE; ++i) index_[i].store(-1, std::memory_order_relaxed);
 }
 
 MarketManager::~MarketManager() {
-    
-}
\ No newline at end of file
+    stopFeeds();
+}
+
+int64_t MarketManager::wallClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ── Symbol table ──────────────────────────────────────────────────────────────
+
+int MarketManager::symbolId(std::string_view symbol) const {
+    size_t h = std::hash<std::string_view>{}(symbol);
+    for (int probe = 0; probe < INDEX_SIZE; ++probe) {
+        int id = index_[(h + probe) % INDEX_SIZE].load(std::memory_order_acquire);
+        if (id < 0) return -1;
+        if (names_[id] == symbol) return id;
+    }
+    return -1;
+}
+
+int MarketManager::registerSymbol(std::string_view symbol) {
+    int id = symbolId(symbol);
+    if (id >= 0) return id;
+
+    std::lock_guard<std::mutex> lk(registerMu_);
+    id = symbolId(symbol);   // another writer may have won the race
+    if (id >= 0) return id;
+
+    id = count_.load(std::memory_order_relaxed);
+    if (id >= MAX_SYMBOLS) return -1;
+
+    // Name first, then the release-store of the id publishes it to readers
+    names_[id] = symbol;
+    count_.store(id + 1, std::memory_order_release);
+    size_t h = std::hash<std::string_view>{}(symbol);
+    for (int probe = 0; probe < INDEX_SIZE; ++probe) {
+        std::atomic<int>& slot = index_[(h + probe) % INDEX_SIZE];
+        if (slot.load(std::memory_order_relaxed) < 0) {
+            slot.store(id, std::memory_order_release);
+            break;
+        }
+    }
+    return id;
+}
+
+const std::string& MarketManager::symbolName(int id) const {
+    return names_[id];
+}
+
+// ── Ingestion ─────────────────────────────────────────────────────────────────
+
+bool MarketManager::onQuote(std::string_view symbol, double bid, long bidQty,
+                            double ask, long askQty, int64_t tsNs) {
+    const uint64_t ingress = tickListener_ ? latencyNow() : 0;
+    int id = registerSymbol(symbol);
+    if (id < 0) return false;
+    if (!tsNs) tsNs = wallClockNs();
+    slots_[id].quote.update([&](MarketQuote& q) {
+        q.bid      = bid;
+        q.bidQty   = bidQty;
+        q.ask      = ask;
+        q.askQty   = askQty;
+        q.updateNs = tsNs;
+    });
+    Metrics::increment(Counter::MARKET_TICKS);
+    if (tickListener_) tickListener_(id, ingress);
+    return true;
+}
+
+int MarketManager::applyTrade(std::string_view symbol, double price, long quantity, int64_t tsNs) {
+    int id = registerSymbol(symbol);
+    if (id < 0) return -1;
+    if (!tsNs) tsNs = wallClockNs();
+    slots_[id].quote.update([&](MarketQuote& q) {
+        q.last      = price;
+        q.lastQty   = quantity;
+        q.volume   += quantity;
+        q.updateNs  = tsNs;
+    });
+    Metrics::increment(Counter::MARKET_TICKS);
+    return id;
+}
+
+bool MarketManager::onTrade(std::string_view symbol, double price, long quantity, int64_t tsNs) {
+    const uint64_t ingress = tickListener_ ? latencyNow() : 0;
+    int id = applyTrade(symbol, price, quantity, tsNs);
+    if (id < 0) return false;
+    if (tickListener_) tickListener_(id, ingress);
+    return true;
+}
+
+bool MarketManager::recordFill(std::string_view symbol, double price, long quantity) {
+    return applyTrade(symbol, price, quantity, 0) >= 0;
+}
+
+bool MarketManager::onTick(const MarketPrice& tick) {
+    // Records off the wire need not be NUL-terminated
+    std::string_view symbol(tick.getSymbol(), strnlen(tick.getSymbol(), MarketPrice::SYMBOL_CAPACITY));
+    if (symbol.empty()) return false;
+    if (tick.getType() == MarketPrice::QUOTE)
+        return onQuote(symbol, tick.getPrice(), tick.getQuantity(),
+                       tick.getAskPrice(), tick.getAskQuantity(), tick.getTimestampNs());
+    if (tick.getType() == MarketPrice::TRADE)
+        return onTrade(symbol, tick.getPrice(), tick.getQuantity(), tick.getTimestampNs());
+    return false;
+}
+
+long MarketManager::onTicks(const MarketPrice* ticks, size_t count) {
+    long accepted = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (onTick(ticks[i])) ++accepted;
+    return accepted;
+}
+
+bool MarketManager::parseTickLine(const std::string& line, MarketPrice& out) {
+    if (line.empty() || line[0] == '#') return false;
+
+    std::stringstream ss(line);
+    std::string kind, symbol, f1, f2, f3, f4;
+    std::getline(ss, kind, ',');
+    std::getline(ss, symbol, ',');
+    std::getline(ss, f1, ',');
+    std::getline(ss, f2, ',');
+    std::getline(ss, f3, ',');
+    std::getline(ss, f4, ',');
+    if (symbol.empty() || symbol.size() >= MarketPrice::SYMBOL_CAPACITY) return false;
+
+    try {
+        if (kind == "Q" && !f4.empty()) {
+            out = MarketPrice::quote(symbol, std::stod(f1), std::stol(f2), std::stod(f3), std::stol(f4), 0);
+            return true;
+        }
+        if (kind == "T" && !f2.empty()) {
+            out = MarketPrice(symbol, std::stod(f1), std::stol(f2), 0);
+            return true;
+        }
+    } catch (...) {
+        // fall through: malformed number
+    }
+    return false;
+}
+
+bool MarketManager::ingestLine(const std::string& line) {
+    MarketPrice tick;
+    return parseTickLine(line, tick) && onTick(tick);
+}
+
+long MarketManager::loadTicks(std::istream& in) {
+    long accepted = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (ingestLine(line)) ++accepted;
+    }
+    return accepted;
+}
+
+// ── UDP feed ──────────────────────────────────────────────────────────────────
+
+int MarketManager::startUdpFeed(int port) {
+    return startFeed(port, false);
+}
+
+int MarketManager::startBinaryFeed(int port) {
+    return startFeed(port, true);
+}
+
+int MarketManager::startFeed(int port, bool binary) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Market feed: cannot bind UDP port " << port << std::endl;
+        close(fd);
+        return -1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    // Wake every 100 ms to notice stopFeeds()
+    timeval tv{0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    feedStop_.store(false);
+    if (binary) {
+        // Room for bursts while the feed thread is descheduled
+        int rcvbuf = 8 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        feedThreads_.emplace_back([this, fd] {
+            std::unique_ptr<MarketPrice[]> buf(new MarketPrice[1024]);   // one max-size datagram
+            while (!feedStop_.load(std::memory_order_relaxed)) {
+                ssize_t n = recv(fd, buf.get(), 1024 * sizeof(MarketPrice), 0);
+                if (n <= 0) continue;
+                onTicks(buf.get(), static_cast<size_t>(n) / sizeof(MarketPrice));   // drop a torn tail
+            }
+            close(fd);
+        });
+        return ntohs(addr.sin_port);
+    }
+    feedThreads_.emplace_back([this, fd] {
+        char buf[65536];
+        while (!feedStop_.load(std::memory_order_relaxed)) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) continue;
+            std::istringstream in(std::string(buf, static_cast<size_t>(n)));
+            loadTicks(in);   // a datagram may carry several lines
+        }
+        close(fd);
+    });
+    return ntohs(addr.sin_port);
+}
+
+void MarketManager::stopFeeds() {
+    feedStop_.store(true);
+    for (auto& t : feedThreads_) t.join();
+    feedThreads_.clear();
+}
+
+// ── Reads ─────────────────────────────────────────────────────────────────────
+
+bool MarketManager::getQuote(int id, MarketQuote& out) const {
+    if (id < 0 || id >= symbolCount()) return false;
+    out = slots_[id].quote.load();
+    return out.updateNs != 0;
+}
+
+bool MarketManager::getQuote(std::string_view symbol, MarketQuote& out) const {
+    return getQuote(symbolId(symbol), out);
+}
+
+bool MarketManager::getQuote(int id, MarketQuote& out, uint64_t& version) const {
+    if (id < 0 || id >= symbolCount()) return false;
+    out = slots_[id].quote.load(version);
+    return out.updateNs != 0;
+}
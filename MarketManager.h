@@ -1,8 +1,175 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "MarketPrice.h"
+#include "SeqLock.h"
+
+// Latest market state for one symbol.  Prices of 0 mean "no data yet".
+struct MarketQuote {
+    double  bid;
+    long    bidQty;
+    double  ask;
+    long    askQty;
+    double  last;       // most recent trade price
+    long    lastQty;
+    long    volume;     // cumulative traded quantity
+    int64_t updateNs;   // wall-clock ns of the latest tick; 0 = never updated
+};
+
+// ─── Market data ─────────────────────────────────────────────────────────────
+//
+// Ingests price ticks from a tick file, local UDP feeds (text lines or binary
+// MarketPrice records), recorded binary feeds and the engine's own trades, and keeps the latest BBO, last trade and cumulative volume for each
+// symbol.  A symbol gets a dense id the first time it is seen; its state lives
+// in a cache-line-aligned slot guarded by a seqlock, so any thread (matching
+// engine, HTTP handlers) reads a consistent quote without taking a lock while
+// feeds keep writing.  Name → id lookup is lock-free as well; only the first
+// registration of a symbol takes a mutex.
+//
+// Tick line format (files and UDP datagrams; blank lines and '#' ignored):
+//   Q,<symbol>,<bid>,<bidQty>,<ask>,<askQty>     quote (BBO) update
+//   T,<symbol>,<price>,<quantity>                 trade print
+//
+// Binary feeds carry the same ticks as packed 64-byte MarketPrice records.
+// Every tick overwrites its symbol's slot, so the slot is the conflation
+// point: consumers that fall behind read the latest state, and a
+// ConflatingReader tells them which symbols changed without replaying the
+// stale ticks in between.
+//
+// External ticks are also pushed synchronously to an optional tick listener
+// (the engine's trigger for resting orders); the engine's own fills are
+// recorded with recordFill and do not notify it.
 class MarketManager {
-    
 public:
+    static constexpr int MAX_SYMBOLS = 1024;
+
     MarketManager();
     ~MarketManager();
-};
\ No newline at end of file
+
+    MarketManager(const MarketManager&)            = delete;
+    MarketManager& operator=(const MarketManager&) = delete;
+
+    // Dense id for symbol, registering it if new; -1 if the table is full
+    int registerSymbol(std::string_view symbol);
+
+    // Dense id for symbol, or -1 if it has never been seen
+    int symbolId(std::string_view symbol) const;
+
+    const std::string& symbolName(int id) const;
+    int symbolCount() const { return count_.load(std::memory_order_acquire); }
+
+    // Ingest one tick; tsNs of 0 stamps it with the current wall-clock time.
+    // Return false if the symbol table is full or the line is malformed.
+    bool onQuote(std::string_view symbol, double bid, long bidQty,
+                 double ask, long askQty, int64_t tsNs = 0);
+    bool onTrade(std::string_view symbol, double price, long quantity, int64_t tsNs = 0);
+    bool onTick(const MarketPrice& tick);
+    bool ingestLine(const std::string& line);
+
+    // Ingest a run of binary records; returns the number accepted
+    long onTicks(const MarketPrice* ticks, size_t count);
+
+    // An own fill from the engine: updates last and volume like a trade
+    // tick but never calls the tick listener
+    bool recordFill(std::string_view symbol, double price, long quantity);
+
+    // Called on the ingesting thread after every external tick with the
+    // symbol id and the latencyNow() stamp taken on arrival.  Install before
+    // starting feeds; nullptr removes it.
+    using TickListener = std::function<void(int symbolId, uint64_t ingressTicks)>;
+    void setTickListener(TickListener listener) { tickListener_ = std::move(listener); }
+
+    // Parse one tick line into a record (timestamp 0); false if malformed
+    static bool parseTickLine(const std::string& line, MarketPrice& out);
+
+    // Ingest every line of a tick file; returns the number of ticks accepted
+    long loadTicks(std::istream& in);
+
+    // Local stand-in for an exchange feed: a thread receiving tick lines as
+    // UDP datagrams on 127.0.0.1.  Port 0 picks a free port.  Returns the
+    // bound port, or -1 if the socket could not be opened.
+    int  startUdpFeed(int port);
+    // The same, for datagrams of packed MarketPrice records
+    int  startBinaryFeed(int port);
+    void stopFeeds();
+
+    // Consistent snapshot of a symbol's state; false if it has none
+    bool getQuote(int id, MarketQuote& out) const;
+    bool getQuote(std::string_view symbol, MarketQuote& out) const;
+    // ... and the symbol's tick count at the time of the snapshot
+    bool getQuote(int id, MarketQuote& out, uint64_t& version) const;
+
+    // Number of ticks applied to a symbol so far
+    uint64_t version(int id) const { return slots_[id].quote.version(); }
+
+private:
+    struct alignas(64) Slot {
+        SeqLock<MarketQuote> quote;
+    };
+
+    static constexpr int INDEX_SIZE = MAX_SYMBOLS * 2;   // open-addressed, ≤ 50% full
+
+    std::unique_ptr<Slot[]>             slots_;
+    std::unique_ptr<std::string[]>      names_;   // written once, before the id is published
+    std::unique_ptr<std::atomic<int>[]> index_;   // name hash → id; -1 = empty
+    std::atomic<int>                    count_{0};
+    std::mutex                          registerMu_;
+
+    std::atomic<bool>        feedStop_{false};
+    std::vector<std::thread> feedThreads_;
+    TickListener             tickListener_;
+
+    int  startFeed(int port, bool binary);
+    int  applyTrade(std::string_view symbol, double price, long quantity, int64_t tsNs);
+
+    static int64_t wallClockNs();
+};
+
+// ─── Conflated consumer ──────────────────────────────────────────────────────
+//
+// One consumer's view of the market.  poll() visits each symbol that changed
+// since the previous poll exactly once, with its latest quote, however many
+// ticks landed in between; the ticks it never had to look at are counted in
+// conflated().  Each reader belongs to a single consumer thread.
+class ConflatingReader {
+public:
+    explicit ConflatingReader(const MarketManager& mm) : mm_(mm) {}
+
+    // Calls onUpdate(id, quote) for every changed symbol; returns how many
+    template<typename F>
+    size_t poll(F&& onUpdate) {
+        int count = mm_.symbolCount();
+        if (seen_.size() < static_cast<size_t>(count)) seen_.resize(static_cast<size_t>(count), 0);
+
+        size_t updates = 0;
+        for (int id = 0; id < count; ++id) {
+            uint64_t& seen = seen_[static_cast<size_t>(id)];
+            if (mm_.version(id) == seen) continue;
+
+            MarketQuote q;
+            uint64_t    version;
+            if (!mm_.getQuote(id, q, version)) continue;
+            conflated_ += version - seen - 1;
+            seen = version;
+            onUpdate(id, q);
+            ++updates;
+        }
+        return updates;
+    }
+
+    uint64_t conflated() const { return conflated_; }
+
+private:
+    const MarketManager&  mm_;
+    std::vector<uint64_t> seen_;   // per symbol id: version last delivered
+    uint64_t              conflated_ = 0;
+};
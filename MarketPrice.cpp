@@ -1,10 +1,26 @@
+#include <cstring>
+#include <type_traits>
 #include "MarketPrice.h"
 
-MarketPrice::MarketPrice(std::string s, double p, long q, std::string t) {
+static_assert(std::is_trivially_copyable<MarketPrice>::value, "MarketPrice must stay a POD record");
+static_assert(sizeof(MarketPrice) == 64, "MarketPrice is one 64-byte wire record");
+
+MarketPrice::MarketPrice(const std::string& s, double p, long q, int64_t tsNs) {
+    std::memset(this, 0, sizeof(*this));
+    timestampNs = tsNs;
     price = p;
     quantity = q;
-    timestamp = std::string(t);
-    symbol = std::string(s);
+    type = TRADE;
+    setSymbol(s);
+}
+
+MarketPrice MarketPrice::quote(const std::string& s, double bid, long bidQty,
+                               double ask, long askQty, int64_t tsNs) {
+    MarketPrice m(s, bid, bidQty, tsNs);
+    m.askPrice = ask;
+    m.askQuantity = askQty;
+    m.type = QUOTE;
+    return m;
 }
 
 double MarketPrice::getPrice() const {
@@ -13,21 +29,23 @@ double MarketPrice::getPrice() const {
 void MarketPrice::setPrice(double p) {
     price = p;
 }
-long MarketPrice::getQuantity() {
-    return quantity;
+long MarketPrice::getQuantity() const {
+    return static_cast<long>(quantity);
 }
 void MarketPrice::setQuantity(long q) {
     this->quantity = q;
 }
-std::string MarketPrice::getTimestamp() {
-    return timestamp;
+int64_t MarketPrice::getTimestampNs() const {
+    return timestampNs;
 }
-std::string MarketPrice::getSymbol() {
+const char* MarketPrice::getSymbol() const {
     return symbol;
 }
-void MarketPrice::setTimestamp(std::string t) {
-    this->timestamp = t;
+void MarketPrice::setTimestampNs(int64_t tsNs) {
+    this->timestampNs = tsNs;
+}
+void MarketPrice::setSymbol(const std::string& s) {
+    size_t n = s.size() < SYMBOL_CAPACITY - 1 ? s.size() : SYMBOL_CAPACITY - 1;
+    std::memcpy(symbol, s.data(), n);
+    std::memset(symbol + n, 0, SYMBOL_CAPACITY - n);
 }
-void MarketPrice::setSymbol(std::string s) {
-    this->symbol = s;
-}   
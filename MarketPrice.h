@@ -1,28 +1,50 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
+// One market-data tick from an external price source: a trade print, or a
+// BBO quote whose bid side reuses price/quantity.  A fixed-size, trivially
+// copyable 64-byte record, so binary feeds and recordings are arrays of it
+// sent or mapped as-is (host byte order).
 class MarketPrice {
+public:
+    enum Type : char { TRADE = 'T', QUOTE = 'Q' };
+
+    static constexpr int SYMBOL_CAPACITY = 16;   // including the terminating NUL
+
 private:
-    double price;
-    long quantity;
-    std::string timestamp;
-    std::string symbol;
+    int64_t timestampNs;    // source time; 0 = stamp on arrival
+    double  price;          // trade price, or bid
+    int64_t quantity;       // trade quantity, or bid quantity
+    double  askPrice;       // quotes only
+    int64_t askQuantity;    // quotes only
+    char    symbol[SYMBOL_CAPACITY];
+    char    type;
+    char    reserved[7];
 
 public:
     MarketPrice() = default;
-    MarketPrice(std::string s, double p, long q, std::string t);
+    // Trade print; symbols longer than 15 characters are truncated
+    MarketPrice(const std::string& s, double p, long q, int64_t tsNs);
 
-    ~MarketPrice() = default;
+    static MarketPrice quote(const std::string& s, double bid, long bidQty,
+                             double ask, long askQty, int64_t tsNs);
+
+    Type getType() const { return static_cast<Type>(type); }
+    bool isQuote() const { return type == QUOTE; }
 
     double getPrice() const;
     void setPrice(double p);
 
-    long getQuantity();
+    long getQuantity() const;
     void setQuantity(long q);
 
-    std::string getTimestamp();
-    void setTimestamp(std::string t);
+    double getAskPrice() const    { return askPrice; }
+    long   getAskQuantity() const { return static_cast<long>(askQuantity); }
+
+    int64_t getTimestampNs() const;
+    void setTimestampNs(int64_t tsNs);
 
-    std::string getSymbol();
-    void setSymbol(std::string s);
+    const char* getSymbol() const;
+    void setSymbol(const std::string& s);
 };
@@ -0,0 +1,134 @@
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "EventBus.h"
+#include "Metrics.h"
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::ORDERS_RECEIVED:        return "ts_orders_received_total";
+        case Counter::ORDERS_QUEUED:          return "ts_orders_queued_total";
+        case Counter::CANCELS:                return "ts_cancels_total";
+        case Counter::CANCELS_NOT_FOUND:      return "ts_cancels_not_found_total";
+        case Counter::MASS_CANCELS:           return "ts_mass_cancels_total";
+        case Counter::AMENDS:                 return "ts_amends_total";
+        case Counter::TIF_CANCELS:            return "ts_tif_cancels_total";
+        case Counter::ICEBERG_REFRESHES:      return "ts_iceberg_refreshes_total";
+        case Counter::PEG_REPRICES:           return "ts_peg_reprices_total";
+        case Counter::IMPLIED_RECOMPUTES:     return "ts_implied_recomputes_total";
+        case Counter::IMPLIED_FILLS:          return "ts_implied_fills_total";
+        case Counter::AUCTIONS:               return "ts_auctions_total";
+        case Counter::SELF_TRADES_PREVENTED:  return "ts_self_trades_prevented_total";
+        case Counter::QUOTES:                 return "ts_quotes_total";
+        case Counter::FILLS:                  return "ts_fills_total";
+        case Counter::FILLED_QUANTITY:        return "ts_filled_quantity_total";
+        case Counter::REJECTED_REQUESTS:      return "ts_rejected_requests_total";
+        case Counter::EVENTS_PUBLISHED:       return "ts_events_published_total";
+        case Counter::MARKET_TICKS:           return "ts_market_ticks_total";
+        case Counter::MARKET_TRIGGERED_FILLS: return "ts_market_triggered_fills_total";
+        case Counter::TRADE_FEED_OVERFLOWS:   return "ts_trade_feed_overflow_total";
+        case Counter::RISK_REJECTS:           return "ts_risk_rejects_total";
+        case Counter::COUNT:                  break;
+    }
+    return "ts_unknown_total";
+}
+
+// ── Per-thread counter blocks ─────────────────────────────────────────────────
+
+static constexpr int COUNTER_COUNT = static_cast<int>(Counter::COUNT);
+
+// Aligned so two threads' blocks never share a cache line
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> values[COUNTER_COUNT] = {};
+};
+
+static std::mutex                    countersMu;
+static std::vector<ThreadCounters*>  counterBlocks;   // never freed: outlive their threads
+
+static ThreadCounters* registerCounterBlock() {
+    auto* block = new ThreadCounters();
+    std::lock_guard<std::mutex> lk(countersMu);
+    counterBlocks.push_back(block);
+    return block;
+}
+
+void Metrics::increment(Counter counter, uint64_t n) {
+    static thread_local ThreadCounters* block = registerCounterBlock();
+    // Single writer per block: a relaxed load/store pair instead of fetch_add
+    std::atomic<uint64_t>& v = block->values[static_cast<int>(counter)];
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::total(Counter counter) {
+    uint64_t sum = 0;
+    std::lock_guard<std::mutex> lk(countersMu);
+    for (const auto* block : counterBlocks)
+        sum += block->values[static_cast<int>(counter)].load(std::memory_order_relaxed);
+    return sum;
+}
+
+// ── Per-symbol gauges ─────────────────────────────────────────────────────────
+
+static std::mutex                                           gaugesMu;
+static std::map<std::string, std::unique_ptr<SymbolGauges>> symbolGaugeMap;   // sorted for stable output
+
+SymbolGauges& Metrics::symbolGauges(const std::string& symbol) {
+    std::lock_guard<std::mutex> lk(gaugesMu);
+    auto& slot = symbolGaugeMap[symbol];
+    if (!slot) slot = std::make_unique<SymbolGauges>();
+    return *slot;
+}
+
+// ── Exposition ────────────────────────────────────────────────────────────────
+
+// Label values may contain '"' or '\' in principle; escape per the text format
+static std::string labelValue(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+std::string Metrics::prometheusText(const EventBus* bus) {
+    std::ostringstream out;
+
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        const char* name = counterName(static_cast<Counter>(c));
+        out << "# TYPE " << name << " counter\n"
+            << name << " " << total(static_cast<Counter>(c)) << "\n";
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(gaugesMu);
+        out << "# HELP ts_resting_orders Orders resting in the book per symbol\n"
+            << "# TYPE ts_resting_orders gauge\n";
+        for (const auto& [sym, g] : symbolGaugeMap)
+            out << "ts_resting_orders{symbol=\"" << labelValue(sym) << "\"} "
+                << g->restingOrders.load(std::memory_order_relaxed) << "\n";
+
+        out << "# HELP ts_price_levels Price levels per symbol and side\n"
+            << "# TYPE ts_price_levels gauge\n";
+        for (const auto& [sym, g] : symbolGaugeMap) {
+            out << "ts_price_levels{symbol=\"" << labelValue(sym) << "\",side=\"bid\"} "
+                << g->bidLevels.load(std::memory_order_relaxed) << "\n"
+                << "ts_price_levels{symbol=\"" << labelValue(sym) << "\",side=\"ask\"} "
+                << g->askLevels.load(std::memory_order_relaxed) << "\n";
+        }
+    }
+
+    if (bus) {
+        out << "# HELP ts_sse_subscribers Connected SSE clients\n"
+            << "# TYPE ts_sse_subscribers gauge\n"
+            << "ts_sse_subscribers " << bus->subscriberCount() << "\n"
+            << "# HELP ts_sse_queued_messages SSE messages waiting to be written, all connections\n"
+            << "# TYPE ts_sse_queued_messages gauge\n"
+            << "ts_sse_queued_messages " << bus->queuedMessages() << "\n";
+    }
+
+    return out.str();
+}
@@ -0,0 +1,75 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class EventBus;  // forward declaration — only read on scrape
+
+// ─── Engine throughput counters and book gauges ──────────────────────────────
+//
+// Counters are per-thread: each thread increments its own cache-line-aligned
+// block with a relaxed load/store (no locked RMW, no sharing), and GET /metrics
+// sums every block on scrape.  Gauges that describe shared state (resting
+// orders and price levels per symbol) are single relaxed atomics written by
+// the engine thread holding the HTTP mutex.  Nothing here ever takes that
+// mutex, so a scrape cannot stall order processing.
+
+// Monotonic event counters.  Keep in step with counterName().
+enum class Counter
+{
+    ORDERS_RECEIVED = 0,    // OrderManager::processNewOrder calls
+    ORDERS_QUEUED,          // orders (or remainders) placed on the book
+    CANCELS,                // successful OrderBook::cancel calls
+    CANCELS_NOT_FOUND,      // cancels for an unknown order ID
+    MASS_CANCELS,           // OrderManager::cancelAll calls (each may cancel many)
+    AMENDS,                 // resting orders amended in price and/or quantity
+    TIF_CANCELS,            // IOC remainders and FOK orders dropped instead of resting
+    ICEBERG_REFRESHES,      // iceberg slices replenished from reserve
+    PEG_REPRICES,           // pegged orders moved to a new price by a quote change
+    IMPLIED_RECOMPUTES,     // implied cross touches recomputed after a leg's touch moved
+    IMPLIED_FILLS,          // cross orders filled against implied liquidity (two leg trades each)
+    AUCTIONS,               // batch auctions that uncrossed a book (traded at least once)
+    SELF_TRADES_PREVENTED,  // incoming orders that met their own counterparty's resting order
+    QUOTES,                 // valid two-sided quotes processed (one per symbol of a mass quote)
+    FILLS,                  // trades executed by TradeManager
+    FILLED_QUANTITY,        // sum of fill quantities
+    REJECTED_REQUESTS,      // HTTP requests refused as invalid
+    EVENTS_PUBLISHED,       // SSE messages handed to EventBus::publish
+    MARKET_TICKS,           // quote and trade ticks ingested by MarketManager
+    MARKET_TRIGGERED_FILLS, // resting orders filled against the external market
+    TRADE_FEED_OVERFLOWS,   // fills queued behind a full trade feed ring
+    RISK_REJECTS,           // new orders refused by the pre-trade risk gate
+    COUNT
+};
+
+const char* counterName(Counter counter);
+
+// Live per-symbol book shape, one block per symbol, owned by Metrics and
+// referenced from the symbol's SubBook.  Never freed, so the pointer stays
+// valid for the life of the process.
+struct SymbolGauges {
+    std::atomic<long> restingOrders{0};
+    std::atomic<long> bidLevels{0};
+    std::atomic<long> askLevels{0};
+};
+
+class Metrics
+{
+public:
+    // Add n to the calling thread's copy of `counter`
+    static void increment(Counter counter, uint64_t n = 1);
+
+    // Sum of `counter` across every thread
+    static uint64_t total(Counter counter);
+
+    // Gauge block for `symbol`, created on first use
+    static SymbolGauges& symbolGauges(const std::string& symbol);
+
+    // Prometheus text exposition of all counters, per-symbol gauges and
+    // (if bus is non-null) the SSE subscriber and queue-depth gauges
+    static std::string prometheusText(const EventBus* bus);
+};
+
+#endif
@@ -1,11 +1,12 @@
 #include <atomic>
+#include "Counterparty.h"
 #include "Order.h"
 
 std::atomic<long> Order::nextId{1};
 
 Order::Order( std::string symbol,
               double price,
-              int quantity,
+              long quantity,
               OrderType type,
               Counterparty* counterparty ) {
     this->id = nextId.fetch_add(1, std::memory_order_relaxed);
@@ -15,12 +16,22 @@ Order::Order( std::string symbol,
     this->type = type;
     this->active = true;
     this->counterparty = counterparty;
+    this->counterpartyId = counterparty ? counterparty->getId() : 0;
+    this->ingressTicks = 0;
+    this->timeInForce = TimeInForce::GTC;
+    this->displayQuantity = 0;
+    this->reserve = 0;
+    this->pegType = PegType::NONE;
+    this->pegOffset = 0;
+    this->selfTrade = SelfTradePrevention::NONE;
 }
 
 long Order::getId() const { return id; }
 
 Counterparty* Order::getCounterparty() const { return counterparty; }
 
+long Order::getCounterpartyId() const { return counterpartyId; }
+
 Order::~Order()
 {
 }
@@ -49,10 +60,94 @@ void Order::setActive(bool active) {
     this->active = active;
 }
 
+void Order::setPrice(double price) {
+    this->price = price;
+}
+
 void Order::setQuantity(long qty) {
     this->quantity = qty;
 }
 
+uint64_t Order::getIngressTicks() const {
+    return ingressTicks;
+}
+
+void Order::setIngressTicks(uint64_t ticks) {
+    this->ingressTicks = ticks;
+}
+
+TimeInForce Order::getTimeInForce() const {
+    return timeInForce;
+}
+
+void Order::setTimeInForce(TimeInForce tif) {
+    this->timeInForce = tif;
+}
+
+long Order::getDisplayQuantity() const {
+    return displayQuantity;
+}
+
+void Order::setDisplayQuantity(long qty) {
+    this->displayQuantity = qty;
+}
+
+long Order::getReserve() const {
+    return reserve;
+}
+
+void Order::setReserve(long qty) {
+    this->reserve = qty;
+}
+
+long Order::getOpenQuantity() const {
+    return quantity + reserve;
+}
+
+void Order::setOpenQuantity(long qty) {
+    this->quantity = qty;
+    this->reserve = 0;
+}
+
+// An iceberg matches for its full size on arrival; only what rests is split
+void Order::hideReserve() {
+    if (displayQuantity <= 0 || quantity <= displayQuantity) return;
+    reserve += quantity - displayQuantity;
+    quantity = displayQuantity;
+}
+
+long Order::replenish() {
+    long slice = reserve < displayQuantity ? reserve : displayQuantity;
+    reserve -= slice;
+    quantity = slice;
+    return slice;
+}
+
+PegType Order::getPegType() const {
+    return pegType;
+}
+
+double Order::getPegOffset() const {
+    return pegOffset;
+}
+
+void Order::setPeg(PegType type, double offset) {
+    this->pegType = type;
+    this->pegOffset = offset;
+}
+
+bool Order::isPegged() const {
+    return pegType != PegType::NONE;
+}
+
+SelfTradePrevention Order::getSelfTrade() const {
+    return selfTrade;
+}
+
+void Order::setSelfTrade(SelfTradePrevention stp) {
+    this->selfTrade = stp;
+}
+
 bool Order::isLimitOrder() const {
     return type == OrderType::MARKET_BUY || type == OrderType::MARKET_SELL;
 }
@@ -1,4 +1,5 @@
 #include <atomic>
+#include <cstdint>
 #include <string>
 #include "OrderType.h"
 
@@ -17,24 +18,52 @@ private:
     std::string symbol;
     OrderType type;
     Counterparty* counterparty; // non-owning pointer to the counterparty that placed this order
+    long counterpartyId;        // counterparty's id, cached for the self-trade check; 0 = none
+    uint64_t ingressTicks;      // latencyNow() when the command arrived; 0 = untraced
+    TimeInForce timeInForce;    // GTC unless set; only GTC orders ever rest
+    long displayQuantity;       // iceberg slice size; 0 = fully displayed
+    long reserve;               // iceberg quantity hidden behind the displayed slice
+    PegType pegType;            // NONE unless the engine prices this order off the quote
+    double pegOffset;           // added to the peg reference price
+    SelfTradePrevention selfTrade;   // applied when this order meets its own counterparty's
 
     static std::atomic<long> nextId;
 
 public:
     Order( std::string symbol,
            double price,
-           int quantity,
+           long quantity,
            OrderType type,
            Counterparty* counterparty);
     ~Order();
     long getId() const;
     Counterparty* getCounterparty() const;
+    long getCounterpartyId() const;
     const std::string& getSymbol() const;
     double getPrice() const;
     OrderType getType() const;
     long getQuantity() const;
     void setActive(bool active);
+    void setPrice(double price);
     void setQuantity(long qty);
+    uint64_t getIngressTicks() const;
+    void setIngressTicks(uint64_t ticks);
+    TimeInForce getTimeInForce() const;
+    void setTimeInForce(TimeInForce tif);
+    long getDisplayQuantity() const;
+    void setDisplayQuantity(long qty);
+    long getReserve() const;
+    void setReserve(long qty);
+    long getOpenQuantity() const;      // displayed + reserve
+    void setOpenQuantity(long qty);    // all displayed, until hideReserve()
+    void hideReserve();                // iceberg: keep one slice displayed, hide the rest
+    long replenish();                  // iceberg: next slice out of reserve; returns its size
+    PegType getPegType() const;
+    double getPegOffset() const;
+    void setPeg(PegType type, double offset);
+    bool isPegged() const;
+    SelfTradePrevention getSelfTrade() const;
+    void setSelfTrade(SelfTradePrevention stp);
     bool isLimitOrder() const;
     bool isActive() const;
     bool isBuyOrder() const;
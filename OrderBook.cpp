@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <vector>
+#include "Metrics.h"
 #include "OrderBook.h"
 
 /**
@@ -22,14 +24,30 @@ OrderBook::~OrderBook()
  * Retrieves or creates a SubBook for the given trading symbol
  *
  * This method uses lazy initialization - if a SubBook doesn't exist
- * for the given symbol, it will be automatically created by the map's
- * operator[] when accessed.
+ * for the given symbol, it is created in place by try_emplace and wired
+ * to that symbol's GET /metrics gauges.
  *
  * @param symbol The trading symbol to look up (e.g., "AAPL", "GOOGL")
  * @return Reference to the SubBook for this symbol (existing or newly created)
  */
 SubBook& OrderBook::get(const std::string& symbol) {
-    return books[symbol];
+    auto [it, inserted] = books.try_emplace(symbol);
+    if (inserted) it->second.setGauges(&Metrics::symbolGauges(symbol));
+    return it->second;
+}
+
+SubBook* OrderBook::find(const std::string& symbol) {
+    auto it = books.find(symbol);
+    return it == books.end() ? nullptr : &it->second;
+}
+
+SubBook& OrderBook::getSwap(const std::string& symbol) {
+    return swapBooks[symbol];
+}
+
+SubBook* OrderBook::findSwap(const std::string& symbol) {
+    auto it = swapBooks.find(symbol);
+    return it == swapBooks.end() ? nullptr : &it->second;
 }
 
 /**
@@ -42,13 +60,27 @@ SubBook& OrderBook::get(const std::string& symbol) {
  * @param subBook The SubBook to store (will be copied into the map)
  */
 void OrderBook::put(const std::string& symbol, const SubBook& subBook) {
-    books[symbol] = subBook;
+    SubBook& sb = books[symbol];
+    sb = subBook;
+    if (!sb.getGauges()) sb.setGauges(&Metrics::symbolGauges(symbol));
 }
 
 void OrderBook::indexOrder(long orderId, OrderLocation loc) {
     orderIndex[orderId] = loc;
 }
 
+bool OrderBook::setSelfTrade(long orderId, SelfTradePrevention mode) {
+    auto it = orderIndex.find(orderId);
+    if (it == orderIndex.end()) return false;
+    it->second.it->setSelfTrade(mode);
+    return true;
+}
+
+const Order* OrderBook::getOrder(long orderId) const {
+    auto it = orderIndex.find(orderId);
+    return it == orderIndex.end() ? nullptr : &*it->second.it;
+}
+
 Counterparty* OrderBook::getOrderCounterparty(long orderId) const {
     auto it = orderIndex.find(orderId);
     if (it == orderIndex.end()) return nullptr;
@@ -74,6 +106,12 @@ std::string OrderBook::getOrderSymbol(long orderId) const {
 }
 
 bool OrderBook::cancel(long orderId) {
+    if (!remove(orderId)) return false;
+    Metrics::increment(Counter::CANCELS);
+    return true;
+}
+
+bool OrderBook::remove(long orderId) {
     auto indexIt = orderIndex.find(orderId);
     if (indexIt == orderIndex.end()) {
         return false;
@@ -85,17 +123,87 @@ bool OrderBook::cancel(long orderId) {
     // Because the list may contain other orders at the same price, we remove
     // only the targeted node — O(1) and does not invalidate any other iterator
     // in the list, so concurrent OrderLocations at the same price remain valid.
+    location.priceList->quantity -= location.it->getQuantity();
+    location.priceList->reserve  -= location.it->getReserve();
     location.priceList->erase(location.it);
 
     // If this was the last order at this price level, remove the price level
-    // entry from the map entirely so the book stays clean.
-    // eraseLevel is a lambda that was captured at insert time and knows which
-    // map (BidMap or AskMap) owns this price level.
+    // entry from the map entirely so the book stays clean.  The location
+    // records which SubBook and side own the level.
     if (location.priceList->empty()) {
-        location.eraseLevel(location.price);
+        location.book->eraseLevel(location.buy, location.price);
     }
 
     orderIndex.erase(indexIt);
     return true;
 }
 
+bool OrderBook::amend(long orderId, double newPrice, long newQuantity) {
+    auto indexIt = orderIndex.find(orderId);
+    if (indexIt == orderIndex.end()) {
+        return false;
+    }
+
+    OrderLocation& location = indexIt->second;
+    Order&         order    = *location.it;
+
+    // A smaller quantity at the same price is the one change that keeps
+    // time priority: update the node where it stands.  An iceberg's cut
+    // comes out of its hidden reserve first, then its displayed slice.
+    if (newPrice == location.price && newQuantity <= order.getOpenQuantity()) {
+        long shown  = std::min(newQuantity, order.getQuantity());
+        long hidden = newQuantity - shown;
+        location.priceList->quantity -= order.getQuantity() - shown;
+        location.priceList->reserve  -= order.getReserve()  - hidden;
+        order.setQuantity(shown);
+        order.setReserve(hidden);
+        return true;
+    }
+
+    // Otherwise the order goes to the back of its (new) level.  splice moves
+    // the existing node between lists, so its iterator stays valid and no
+    // Order is copied.  The old level is erased only after the move, and only
+    // if it was left empty.
+    PriceLevel& target = location.book->level(location.buy, newPrice);
+    location.priceList->quantity -= order.getQuantity();
+    location.priceList->reserve  -= order.getReserve();
+    order.setOpenQuantity(newQuantity);
+    order.hideReserve();   // an iceberg comes back with a fresh slice
+    target.quantity += order.getQuantity();
+    target.reserve  += order.getReserve();
+    target.splice(target.end(), *location.priceList, location.it);
+    if (location.priceList->empty() && location.priceList != &target) {
+        location.book->eraseLevel(location.buy, location.price);
+    }
+
+    order.setPrice(newPrice);
+    location.priceList = &target;
+    location.price     = newPrice;
+    return true;
+}
+
+bool OrderBook::reprice(long orderId, PriceLevel& target, double newPrice) {
+    auto indexIt = orderIndex.find(orderId);
+    if (indexIt == orderIndex.end()) {
+        return false;
+    }
+
+    OrderLocation& location = indexIt->second;
+    Order&         order    = *location.it;
+    if (location.priceList == &target) return true;
+
+    location.priceList->quantity -= order.getQuantity();
+    location.priceList->reserve  -= order.getReserve();
+    target.quantity += order.getQuantity();
+    target.reserve  += order.getReserve();
+    target.splice(target.end(), *location.priceList, location.it);
+    if (location.priceList->empty()) {
+        location.book->eraseLevel(location.buy, location.price);
+    }
+
+    order.setPrice(newPrice);
+    location.priceList = &target;
+    location.price     = newPrice;
+    return true;
+}
+
@@ -1,4 +1,3 @@
-#include <functional>
 #include <list>
 #include <string>
 #include <unordered_map>
@@ -11,13 +10,15 @@
 
 class Counterparty;  // forward declaration
 
-// Locates a specific order within a price-level list for O(1) cancellation.
-// Uses a type-erased erase function so it works with both BidMap and AskMap.
+// Locates a specific order within a price-level list for O(1) cancellation
+// and amendment.  The owning SubBook and side name the map (BidMap or AskMap)
+// that holds the level, so an emptied level is erased without a callback.
 struct OrderLocation {
-    std::list<Order>*           priceList;   // pointer to the list at this price level
+    PriceLevel*                 priceList;   // the price level holding this order
     double                      price;       // price level key in the map
     std::list<Order>::iterator  it;          // iterator to this order in the list
-    std::function<void(double)> eraseLevel;  // removes the price level from its map
+    SubBook*                    book;        // SubBook whose map holds the level
+    bool                        buy;         // true = BidMap, false = AskMap
 };
 
 /**
@@ -31,6 +32,7 @@ class OrderBook
 {
 private:
     std::unordered_map<std::string, SubBook> books;  // O(1) symbol lookup
+    std::unordered_map<std::string, SubBook> swapBooks;  // per pair, SWAP orders only, priced in points
     std::unordered_map<long, OrderLocation> orderIndex;  // O(1) lookup by order ID
 
 public:
@@ -53,6 +55,15 @@ public:
      */
     SubBook& get(const std::string& symbol);
 
+    // Returns the SubBook for symbol, or nullptr if it has none (never creates one)
+    SubBook* find(const std::string& symbol);
+
+    // The pair's swap book: SWAP_BUY / SWAP_SELL orders keyed by forward
+    // points.  Kept apart from the spot book so the two never cross; its
+    // orders share the one order index.  No book-shape gauges.
+    SubBook& getSwap(const std::string& symbol);
+    SubBook* findSwap(const std::string& symbol);
+
     /**
      * Stores or updates a SubBook for a given trading symbol
      *
@@ -68,6 +79,33 @@ public:
     // Returns true if found and cancelled, false if ID not found
     bool cancel(long orderId);
 
+    // Remove an order from its price-level list and the index without
+    // counting a cancel (the order is being replaced, not withdrawn).
+    // Returns false if the ID is not resting.
+    bool remove(long orderId);
+
+    // Change a resting order's price and/or open quantity (displayed plus
+    // any iceberg reserve) in place.  Cutting the quantity at the same price
+    // keeps its queue position; a new price, or
+    // more quantity, splices its list node to the back of the target level
+    // on the same side — no node is allocated and the index entry is
+    // updated, not rebuilt.  Does not match: the caller checks for a cross.
+    // Returns false if the ID is not resting.
+    bool amend(long orderId, double newPrice, long newQuantity);
+
+    // Move a resting order to the back of target, the level at newPrice on
+    // its own side, keeping its quantities — the pegged-order re-price.  The
+    // caller looks target up once for many orders; the left level is erased
+    // if emptied.  Does not match.  Returns false if the ID is not resting.
+    bool reprice(long orderId, PriceLevel& target, double newPrice);
+
+    // Set a resting order's self-trade prevention mode in place; it keeps
+    // its queue position.  Returns false if the ID is not resting.
+    bool setSelfTrade(long orderId, SelfTradePrevention mode);
+
+    // Returns the resting order with this ID, or nullptr if not found
+    const Order* getOrder(long orderId) const;
+
     // Returns the counterparty for a given order ID, or nullptr if not found
     // Must be called before cancel() — the order is gone after cancellation
     Counterparty* getOrderCounterparty(long orderId) const;
@@ -1,4 +1,4 @@
-#include <functional>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -6,6 +6,8 @@
 #include <sstream>
 #include "Counterparty.h"
 #include "EventBus.h"
+#include "Latency.h"
+#include "Metrics.h"
 #include "MarketManager.h"
 #include "OrderManager.h"
 #include "OrderBook.h"
@@ -19,26 +21,54 @@ static auto appendPriceLevels = [](std::ostringstream& j, auto& map) {
     for (const auto& [price, orders] : map) {
         if (!first) j << ",";
         first = false;
-        long total = 0;
         std::string ids = "[";
         bool fst = true;
         for (const auto& o : orders) {
-            total += o.getQuantity();
             if (!fst) ids += ",";
             fst = false;
             ids += std::to_string(o.getId());
         }
         ids += "]";
         j << "{\"price\":"    << price
-          << ",\"quantity\":" << total
+          << ",\"quantity\":" << orders.quantity
           << ",\"orderIds\":" << ids << "}";
     }
 };
 
+static bool isSpot(const Order& o) {
+    return o.getType() == OrderType::SPOT_BUY || o.getType() == OrderType::SPOT_SELL;
+}
+
+// True if a SPOT order on this side at price would trade with the book
+static bool crossesBook(const SubBook& sb, bool buy, double price) {
+    if (buy) {
+        const AskMap& asks = sb.getSellOrders();
+        return !asks.empty() && TradeManager::pricesMatch(price, asks.begin()->first);
+    }
+    const BidMap& bids = sb.getBuyOrders();
+    return !bids.empty() && TradeManager::pricesMatch(bids.begin()->first, price);
+}
+
+// The price a pegged order rests at under this quote: its reference plus the
+// offset.  False if the quote lacks a side the peg follows.
+static bool pegPrice(PegType type, bool buy, double offset, const MarketQuote& q, double& price) {
+    double ref = 0;
+    switch (type) {
+        case PegType::PRIMARY: ref = buy ? q.bid : q.ask;                             break;
+        case PegType::MARKET:  ref = buy ? q.ask : q.bid;                             break;
+        case PegType::MID:     ref = q.bid > 0 && q.ask > 0 ? (q.bid + q.ask) / 2 : 0; break;
+        case PegType::NONE:                                                           break;
+    }
+    if (ref <= 0) return false;
+    price = ref + offset;
+    return price > 0;
+}
+
 OrderManager::OrderManager(MarketManager* marketMgr) {
     orderBook    = std::make_unique<OrderBook>();
     tradeManager = std::make_unique<TradeManager>();
     marketManager = marketMgr;
+    tradeManager->setMarketManager(marketMgr);
 }
 
 void OrderManager::setEventBus(EventBus* bus) {
@@ -46,21 +76,43 @@ void OrderManager::setEventBus(EventBus* bus) {
     tradeManager->setEventBus(bus);
 }
 
+void OrderManager::setRiskManager(RiskManager* risk) {
+    riskManager_ = risk;
+    tradeManager->setRiskManager(risk);
+}
+
 const std::deque<Trade>& OrderManager::getRecentTrades() const {
     return tradeManager->getRecentTrades();
 }
 
-void OrderManager::publishBookUpdate(const std::string& symbol) {
-    if (!eventBus_) return;
+void OrderManager::publishBookUpdate(const std::string& symbol, uint64_t ingressTicks) {
     SubBook& sb = orderBook->get(symbol);
+    sb.updateLevelGauges();   // every book change passes through here
+    publishLevels("book_update", symbol, sb, ingressTicks);
+    if (sb.getImpliedLeg() >= 0) refreshImplied(sb, ingressTicks);   // ... so implied touches follow it
+}
+
+void OrderManager::publishSwapBookUpdate(const std::string& symbol, uint64_t ingressTicks) {
+    publishLevels("swap_book_update", symbol, orderBook->getSwap(symbol), ingressTicks);
+}
+
+void OrderManager::publishBook(const std::string& symbol, bool swap, uint64_t ingressTicks) {
+    if (swap) publishSwapBookUpdate(symbol, ingressTicks);
+    else      publishBookUpdate(symbol, ingressTicks);
+}
+
+void OrderManager::publishLevels(const char* event, const std::string& symbol, SubBook& sb,
+                                 uint64_t ingressTicks) {
+    if (!eventBus_) return;
+    LATENCY_PROBE(LatencyStage::PUBLISH_BOOK_UPDATE);
     std::ostringstream j;
     j << std::fixed << std::setprecision(6);
-    j << "event: book_update\ndata: {\"symbol\":\"" << symbol << "\",\"bids\":[";
+    j << "event: " << event << "\ndata: {\"symbol\":\"" << symbol << "\",\"bids\":[";
     appendPriceLevels(j, sb.getBuyOrdersRef());
     j << "],\"asks\":[";
     appendPriceLevels(j, sb.getSellOrdersRef());
     j << "]}\n\n";
-    eventBus_->publish(j.str());
+    eventBus_->publish(j.str(), ingressTicks);
 }
 
 OrderManager::~OrderManager() {
@@ -69,32 +121,112 @@ OrderManager::~OrderManager() {
 
 // ── Order processing ──────────────────────────────────────────────────────────
 
-void OrderManager::processNewOrder(const Order& newOrder) {
-    // Get (or lazily create) the SubBook for this trading symbol
-    SubBook& sb = orderBook->get(newOrder.getSymbol());
-    const std::string sym = newOrder.getSymbol();
+RejectReason OrderManager::processNewOrder(const Order& newOrder, long* filled) {
+    LATENCY_PROBE(LatencyStage::PROCESS_NEW_ORDER);
+    Metrics::increment(Counter::ORDERS_RECEIVED);
+    if (!newOrder.isPegged()) return submitOrder(newOrder, filled);
+
+    // A pegged order is priced off the quote, at its group's price.  Swap
+    // points have no quote to follow.
+    if (filled) *filled = 0;
+    if (isSwapOrder(newOrder.getType())) return RejectReason::NO_PEG_REFERENCE;
+    const std::string& sym = newOrder.getSymbol();
+    MarketQuote        quote;
+    double             price = 0;
+    if (!marketManager || !marketManager->getQuote(sym, quote) ||
+        !pegPrice(newOrder.getPegType(), newOrder.isBuyOrder(), newOrder.getPegOffset(), quote, price))
+        return RejectReason::NO_PEG_REFERENCE;
+
+    SubBook&  sb    = orderBook->get(sym);
+    PegGroup& group = sb.pegGroup(newOrder.isBuyOrder(), newOrder.getPegType(), newOrder.getPegOffset(), price);
+    if (group.price != price && repriceGroup(sb, group, price) > 0)   // quote moved without a tick pass
+        publishBookUpdate(sym, newOrder.getIngressTicks());
 
-    // For SPOT orders, attempt to match against the opposite side before queuing.
+    Order priced = newOrder;
+    priced.setPrice(price);
+    RejectReason reason = submitOrder(priced, filled);
+    if (reason == RejectReason::NONE && orderBook->getOrder(priced.getId()))
+        group.ids.push_back(priced.getId());   // it rests: re-priced with the group from now on
+    return reason;
+}
+
+RejectReason OrderManager::submitOrder(const Order& newOrder, long* filled) {
+    bool         changed = false;
+    RejectReason reason  = placeOrder(newOrder, filled, changed);
+    if (changed) publishBook(newOrder.getSymbol(), isSwapOrder(newOrder.getType()), newOrder.getIngressTicks());
+    return reason;
+}
+
+// submitOrder without the book_update: changed is set (never cleared) if
+// the book changed
+RejectReason OrderManager::placeOrder(const Order& newOrder, long* filled, bool& changed) {
+    // Pre-trade gate: a rejected order never reaches the book
+    if (riskManager_) {
+        RejectReason reason = riskManager_->check(newOrder);
+        if (reason != RejectReason::NONE) {
+            Metrics::increment(Counter::RISK_REJECTS);
+            return reason;
+        }
+    }
+
+    // Get (or lazily create) the SubBook for this trading symbol.  Swaps rest
+    // and match in the pair's own swap book, priced in forward points.
+    const bool        swap = isSwapOrder(newOrder.getType());
+    SubBook&          sb   = bookFor(newOrder);
+    const std::string sym  = newOrder.getSymbol();
+    const bool        gtc  = newOrder.getTimeInForce() == TimeInForce::GTC;
+    if (filled) *filled = 0;
+
+    // For SPOT and SWAP orders, attempt to match against the opposite side before queuing.
     // We work with a mutable copy so the matching engine can decrement the quantity.
-    if (newOrder.getType() == OrderType::SPOT_BUY ||
-        newOrder.getType() == OrderType::SPOT_SELL) {
+    if ((isSpot(newOrder) || swap) && !sb.isAuction()) {
+
+        // A swap that would trade needs a near rate to fix its legs at
+        double near = 0;
+        if (swap && crossesBook(sb, newOrder.isBuyOrder(), newOrder.getPrice()) &&
+            !tradeManager->nearRate(sym, near))
+            return RejectReason::NO_NEAR_RATE;
+
+        // Fill-or-kill: decided from level totals before anything trades
+        if (newOrder.getTimeInForce() == TimeInForce::FOK && !TradeManager::canFill(newOrder, sb)) {
+            Metrics::increment(Counter::TIF_CANCELS);
+            return RejectReason::NONE;   // book untouched, nothing to publish
+        }
 
         Order order = newOrder;   // mutable copy (same ID as the original)
 
-        if (tradeManager->matchSpotOrders(order, sb, *orderBook)) {
-            publishBookUpdate(sym);  // book changed by fill(s)
-            return;  // fully filled — nothing left to queue
+        long prevented = 0;
+        bool done      = match(order, sb, &prevented);
+        if (filled) *filled = newOrder.getQuantity() - order.getQuantity() - prevented;
+        if (done) {
+            changed = true;   // book changed by fill(s)
+            return RejectReason::NONE;  // filled, or cancelled by self-trade prevention — nothing left to queue
+        }
+
+        // IOC: the remainder is dropped here; it was never queued or indexed
+        if (!gtc) {
+            Metrics::increment(Counter::TIF_CANCELS);
+            if (order.getQuantity() != newOrder.getQuantity()) changed = true;   // book changed by fill(s)
+            return RejectReason::NONE;
         }
 
         // Partially filled: queue the unfilled remainder.
         queueOrder(order, sb);
-        publishBookUpdate(sym);  // book changed by fill(s) + queued remainder
-        return;
+        changed = true;   // book changed by fill(s) + queued remainder
+        return RejectReason::NONE;
+    }
+
+    // Other order types, and every order in an auction book, never match on
+    // arrival, so IOC and FOK ones have nothing to execute and are dropped
+    if (!gtc) {
+        Metrics::increment(Counter::TIF_CANCELS);
+        return RejectReason::NONE;
     }
 
-    // Non-SPOT orders go straight into the book with no matching
+    // Other order types go straight into the book with no matching
     queueOrder(newOrder, sb);
-    publishBookUpdate(sym);  // book changed by queue
+    changed = true;   // book changed by queue
+    return RejectReason::NONE;
 }
 
 // ── Private helper: insert one order into the book and index it ───────────────
@@ -104,15 +236,12 @@ void OrderManager::processNewOrder(const Order& newOrder) {
 // AskMap uses default ascending so begin() gives the best ask (lowest price).
 //
 // Because the two map types differ, OrderLocation cannot store a raw map
-// pointer that covers both.  Instead we store two type-erased values:
-//   priceListPtr — points to the std::list<Order> at this price level
-//   eraseLevel   — a lambda that removes that price level from its map
-//
-// The lambda captures the map pointer by value at insert time, so cancel()
-// can call eraseLevel(price) later without knowing which map type it owns.
+// pointer that covers both.  Instead it stores the SubBook and the side
+// (buy = BidMap), and SubBook::level / eraseLevel pick the map, so cancel()
+// and amend() can find or drop the level without knowing its map type.
 //
-// operator[] on the map returns the existing list if this price level already
-// has orders, or inserts a new empty list if it doesn't — either way we get a
+// SubBook::level returns the existing list if this price level already has
+// orders, or inserts a new empty list if it doesn't — either way we get a
 // reference to the list where this order belongs.
 //
 // Multiple orders at the same price all share the same list, held in arrival
@@ -121,53 +250,527 @@ void OrderManager::processNewOrder(const Order& newOrder) {
 // be erased independently in O(1) without affecting others.
 
 void OrderManager::queueOrder(const Order& order, SubBook& sb) {
-    std::list<Order>*           priceListPtr;
-    std::function<void(double)> eraseLevel;
-
-    if (order.isBuyOrder()) {
-        BidMap* bids = &sb.getBuyOrdersRef();
-        auto&   pl   = (*bids)[order.getPrice()];
-        pl.push_back(order);
-        priceListPtr = &pl;
-        eraseLevel   = [bids](double price) { bids->erase(price); };
-    } else {
-        AskMap* asks = &sb.getSellOrdersRef();
-        auto&   pl   = (*asks)[order.getPrice()];
-        pl.push_back(order);
-        priceListPtr = &pl;
-        eraseLevel   = [asks](double price) { asks->erase(price); };
-    }
+    const bool  buy = order.isBuyOrder();
+    PriceLevel& pl  = sb.level(buy, order.getPrice());
+    pl.push_back(order);
 
-    auto it = std::prev(priceListPtr->end());
+    auto it = std::prev(pl.end());
+    it->hideReserve();   // an iceberg rests with one slice displayed
+    pl.quantity += it->getQuantity();
+    pl.reserve  += it->getReserve();
     orderBook->indexOrder(order.getId(),
-                          {priceListPtr, order.getPrice(), it, eraseLevel});
+                          {&pl, order.getPrice(), it, &sb, buy});
+    sb.adjustRestingOrders(+1);
+    Metrics::increment(Counter::ORDERS_QUEUED);
+    if (riskManager_) riskManager_->onQueued(order);
 
     // Notify the counterparty that it now owns this order ID
     if (Counterparty* cp = order.getCounterparty())
         cp->addOrderId(order.getId());
 }
 
-void OrderManager::processCancelOrder(long orderId) {
+void OrderManager::processCancelOrder(long orderId, uint64_t ingressTicks) {
+    LATENCY_PROBE(LatencyStage::PROCESS_CANCEL_ORDER);
+
     // Capture symbol before the order is erased (iterator becomes invalid after cancel)
     const std::string sym = orderBook->getOrderSymbol(orderId);
 
     // Retrieve counterparty before the order is erased from the book
     Counterparty* cp = orderBook->getOrderCounterparty(orderId);
 
+    // Release its open exposure, and note which book holds it, while the
+    // order is still readable
+    const Order* resting = orderBook->getOrder(orderId);
+    const bool   swap    = resting && isSwapOrder(resting->getType());
+    if (riskManager_ && resting) riskManager_->onCancelled(*resting);
+
     if (!orderBook->cancel(orderId)) {
+        Metrics::increment(Counter::CANCELS_NOT_FOUND);
         std::cerr << "Cancel failed: order " << orderId << " not found" << std::endl;
         return;
     }
 
     if (cp) cp->removeOrderId(orderId);
+    (swap ? orderBook->getSwap(sym) : orderBook->get(sym)).adjustRestingOrders(-1);
+
+    if (!sym.empty()) publishBook(sym, swap, ingressTicks);  // book changed by cancel
+}
+
+int OrderManager::cancelAll(Counterparty& cp, const std::string& symbol, uint64_t ingressTicks) {
+    LATENCY_PROBE(LatencyStage::PROCESS_CANCEL_ORDER);
+    Metrics::increment(Counter::MASS_CANCELS);
+
+    // Walk the counterparty's open orders back to front: removeOrderId moves
+    // the last id into the freed slot, and that id has already been visited
+    const std::vector<long>& ids = cp.getOrderIds();
+    std::vector<std::pair<std::string, bool>> touched;   // (symbol, swap book) of books that changed
+    int cancelled = 0;
+    for (size_t i = ids.size(); i-- > 0;) {
+        const long   orderId = ids[i];
+        const Order* resting = orderBook->getOrder(orderId);
+        if (!resting) {
+            cp.removeOrderId(orderId);   // stale id: nothing left to cancel
+            continue;
+        }
+        if (!symbol.empty() && resting->getSymbol() != symbol) continue;
+
+        std::pair<std::string, bool> book(resting->getSymbol(), isSwapOrder(resting->getType()));
+        SubBook& sb = bookFor(*resting);
+        if (riskManager_) riskManager_->onCancelled(*resting);
+        if (!orderBook->cancel(orderId)) continue;
+
+        cp.removeOrderId(orderId);
+        sb.adjustRestingOrders(-1);
+        if (std::find(touched.begin(), touched.end(), book) == touched.end()) touched.push_back(book);
+        ++cancelled;
+    }
+
+    for (const auto& [sym, swap] : touched) publishBook(sym, swap, ingressTicks);   // one delta per book
+    return cancelled;
+}
+
+// ── Amend (cancel/replace) ──────────────────────────────────────────────────────
+//
+// One engine pass and one book_update, whatever the change:
+//   - less quantity, same price: the node is updated in place and keeps its
+//     time priority
+//   - new price or more quantity: the node is spliced to the back of its new
+//     level (OrderBook::amend), unless the new price crosses the other side
+//   - a SPOT order whose new price crosses is taken off the book and matched
+//     like a new order with the same ID; any remainder rests at the new price
+// Only changes that add exposure are risk-checked; a rejected amend leaves
+// the order exactly as it was.
+
+AmendResult OrderManager::processAmendOrder(long orderId, double newPrice, long newQuantity,
+                                            uint64_t ingressTicks, RejectReason* reason) {
+    LATENCY_PROBE(LatencyStage::PROCESS_AMEND_ORDER);
+
+    const Order* resting = orderBook->getOrder(orderId);
+    if (!resting) return AmendResult::NOT_FOUND;
+    const bool swap = isSwapOrder(resting->getType());   // a swap is priced in points, which may be negative
+    if (newQuantity <= 0 || (newPrice <= 0 && !swap)) return AmendResult::INVALID;
+    if (resting->isPegged() && newPrice != resting->getPrice()) return AmendResult::INVALID;   // the quote sets it
+    if (newPrice == resting->getPrice() && newQuantity == resting->getOpenQuantity())
+        return AmendResult::AMENDED;   // nothing to do
 
-    if (!sym.empty()) publishBookUpdate(sym);  // book changed by cancel
+    const std::string sym    = resting->getSymbol();
+    AmendResult       result = amendResting(*resting, newPrice, newQuantity, ingressTicks, reason);
+    if (result == AmendResult::AMENDED) publishBook(sym, swap, ingressTicks);   // one delta for the whole amend
+    return result;
+}
+
+// processAmendOrder once the new terms are known to be valid and different;
+// publishes nothing
+AmendResult OrderManager::amendResting(const Order& resting, double newPrice, long newQuantity,
+                                       uint64_t ingressTicks, RejectReason* reason) {
+    const long   orderId  = resting.getId();
+    const bool   swap     = isSwapOrder(resting.getType());
+    const double oldPrice = resting.getPrice();
+    const long   oldQty   = resting.getOpenQuantity();
+
+    Order amended = resting;   // same ID, symbol, side and counterparty
+    amended.setPrice(newPrice);
+    amended.setOpenQuantity(newQuantity);   // an iceberg is re-split if it rests again
+    amended.setIngressTicks(ingressTicks);
+
+    const std::string sym    = amended.getSymbol();
+    const bool        keeps  = newPrice == oldPrice && newQuantity < oldQty;   // keeps priority
+    SubBook&          sb     = bookFor(amended);
+    const bool crosses = !keeps && (isSpot(amended) || swap) && !sb.isAuction() &&
+                         crossesBook(sb, amended.isBuyOrder(), newPrice);
+
+    double near;
+    if (swap && crosses && !tradeManager->nearRate(sym, near)) {   // nothing to fix the near leg against
+        if (reason) *reason = RejectReason::NO_NEAR_RATE;
+        return AmendResult::REJECTED;
+    }
+
+    if (riskManager_) {
+        riskManager_->onCancelled(resting);   // re-screen as if the old order were gone
+        RejectReason r = keeps ? RejectReason::NONE : riskManager_->check(amended);
+        if (r != RejectReason::NONE) {
+            riskManager_->onQueued(resting);
+            Metrics::increment(Counter::RISK_REJECTS);
+            if (reason) *reason = r;
+            return AmendResult::REJECTED;
+        }
+    }
+
+    Metrics::increment(Counter::AMENDS);
+
+    if (!crosses) {
+        orderBook->amend(orderId, newPrice, newQuantity);
+        if (riskManager_) riskManager_->onQueued(amended);
+    } else {
+        orderBook->remove(orderId);
+        sb.adjustRestingOrders(-1);
+        if (Counterparty* cp = amended.getCounterparty()) cp->removeOrderId(orderId);
+        if (!match(amended, sb)) queueOrder(amended, sb);   // remainder rests at the new price
+    }
+    return AmendResult::AMENDED;
+}
+
+// ── Quotes ────────────────────────────────────────────────────────────────────
+//
+// A market maker's quote in a symbol lives in its quote slot (SubBook::
+// quoteSlot): the ids of its resting bid and ask.  A new quote amends those
+// orders where they rest instead of cancelling and re-entering them, and
+// the whole quote publishes one book_update.  The sides are applied ask
+// first if the new bid would reach the old ask (bid first otherwise), so
+// the quote never trades against its own previous side.
+
+QuoteResult OrderManager::processQuote(Counterparty& cp, const Quote& quote, uint64_t ingressTicks,
+                                       QuoteSlot* sides, RejectReason* reason) {
+    LATENCY_PROBE(LatencyStage::PROCESS_QUOTE);
+
+    if (!validQuote(quote)) return QuoteResult::INVALID;
+    Metrics::increment(Counter::QUOTES);
+
+    SubBook&     sb       = orderBook->get(quote.symbol);
+    QuoteSlot&   slot     = sb.quoteSlot(cp.getId());
+    const Order* oldAsk   = slot.askId ? orderBook->getOrder(slot.askId) : nullptr;
+    const bool   askFirst = quote.bidQty > 0 && oldAsk && quote.bidPrice >= oldAsk->getPrice();
+    bool         changed  = false;
+
+    RejectReason first  = quoteSide(cp, quote, !askFirst, askFirst ? slot.askId : slot.bidId, ingressTicks, changed);
+    RejectReason second = quoteSide(cp, quote,  askFirst, askFirst ? slot.bidId : slot.askId, ingressTicks, changed);
+    if (changed) publishBookUpdate(quote.symbol, ingressTicks);   // one delta for the whole quote
+
+    if (sides) *sides = slot;
+    const RejectReason refused = first != RejectReason::NONE ? first : second;
+    if (refused == RejectReason::NONE) return QuoteResult::APPLIED;
+    if (reason) *reason = refused;
+    return QuoteResult::REJECTED;
+}
+
+bool OrderManager::validQuote(const Quote& quote) {
+    const bool bid = quote.bidQty > 0, ask = quote.askQty > 0;
+    return !quote.symbol.empty() && quote.bidQty >= 0 && quote.askQty >= 0 && (!bid || quote.bidPrice > 0) &&
+           (!ask || quote.askPrice > 0) && (!bid || !ask || quote.bidPrice < quote.askPrice);
+}
+
+// Bring one side of the counterparty's quote to its new terms.  slotId is
+// the side's resting order, updated to whatever rests afterwards.
+RejectReason OrderManager::quoteSide(Counterparty& cp, const Quote& quote, bool buy, long& slotId,
+                                     uint64_t ingressTicks, bool& changed) {
+    const double price   = buy ? quote.bidPrice : quote.askPrice;
+    const long   qty     = buy ? quote.bidQty   : quote.askQty;
+    const Order* resting = slotId ? orderBook->getOrder(slotId) : nullptr;
+    SubBook&     sb      = orderBook->get(quote.symbol);
+
+    if (resting && qty > 0) {
+        orderBook->setSelfTrade(slotId, quote.selfTrade);   // the new quote's mode, also if its amend crosses
+        if (price == resting->getPrice() && qty == resting->getOpenQuantity()) return RejectReason::NONE;
+        RejectReason reason = RejectReason::NONE;
+        changed = true;
+        if (amendResting(*resting, price, qty, ingressTicks, &reason) == AmendResult::REJECTED) {
+            pullOrder(*resting, sb);   // a refused side must not leave the old quote standing
+            slotId = 0;
+            return reason;
+        }
+        if (!orderBook->getOrder(slotId)) slotId = 0;   // crossed and filled in full
+        return RejectReason::NONE;
+    }
+    if (resting) {   // quantity 0: pull the side
+        pullOrder(*resting, sb);
+        changed = true;
+    }
+    slotId = 0;
+    if (qty == 0) return RejectReason::NONE;
+
+    Order order(quote.symbol, price, qty, buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, &cp);
+    order.setIngressTicks(ingressTicks);
+    order.setSelfTrade(quote.selfTrade);
+    RejectReason reason = placeOrder(order, nullptr, changed);
+    if (orderBook->getOrder(order.getId())) slotId = order.getId();
+    return reason;
+}
+
+// Take a resting order off the book without publishing
+void OrderManager::pullOrder(const Order& resting, SubBook& sb) {
+    const long    orderId = resting.getId();
+    Counterparty* cp      = resting.getCounterparty();
+    if (riskManager_) riskManager_->onCancelled(resting);
+    if (!orderBook->remove(orderId)) return;
+    sb.adjustRestingOrders(-1);
+    if (cp) cp->removeOrderId(orderId);
+}
+
+// ── Pegged orders ───────────────────────────────────────────────────────────────
+//
+// A quote change costs one price computation per peg group, and nothing for
+// a group whose price is unchanged.  A group that moves is walked once: each
+// live member is spliced to the back of the new level (OrderBook::reprice —
+// no allocation, no re-indexing) and its exposure re-marked, in the order the
+// members joined.  A SPOT member whose new price crosses the book is matched
+// like an amend that crosses, and any remainder rests at the new price.
+
+int OrderManager::repriceGroup(SubBook& sb, PegGroup& group, double price) {
+    group.price = price;
+    PriceLevel& target = sb.level(group.buy, price);   // one lookup for the whole group
+    size_t      live   = 0;
+    int         moved  = 0;
+
+    for (long id : group.ids) {
+        const Order* o = orderBook->getOrder(id);
+        if (!o) continue;   // filled or cancelled since the last pass: dropped
+        group.ids[live++] = id;
+        ++moved;
+        if (riskManager_) riskManager_->onCancelled(*o);
+
+        if (!isSpot(*o) || sb.isAuction() || !crossesBook(sb, group.buy, price)) {
+            orderBook->reprice(id, target, price);
+            if (riskManager_) riskManager_->onQueued(*o);
+            continue;
+        }
+
+        Order crossing = *o;
+        crossing.setOpenQuantity(o->getOpenQuantity());
+        crossing.setPrice(price);
+        orderBook->remove(id);
+        sb.adjustRestingOrders(-1);
+        if (Counterparty* cp = crossing.getCounterparty()) cp->removeOrderId(id);
+        if (match(crossing, sb))
+            --live;                     // filled in full: leaves the group
+        else
+            queueOrder(crossing, sb);   // remainder rests at the new price
+    }
+
+    group.ids.resize(live);
+    if (target.empty()) sb.eraseLevel(group.buy, price);
+    Metrics::increment(Counter::PEG_REPRICES, static_cast<uint64_t>(moved));
+    return moved;
+}
+
+int OrderManager::repricePegs(SubBook& sb, const MarketQuote& quote) {
+    std::vector<PegGroup>& groups = sb.getPegGroups();
+    if (groups.empty()) return 0;
+    LATENCY_PROBE(LatencyStage::REPRICE_PEGS);
+
+    int moved = 0;
+    for (PegGroup& g : groups) {
+        double price = 0;
+        if (!pegPrice(g.type, g.buy, g.offset, quote, price) || price == g.price) continue;   // keep the old price
+        moved += repriceGroup(sb, g, price);
+    }
+
+    // Groups whose every order has gone are forgotten
+    groups.erase(std::remove_if(groups.begin(), groups.end(),
+                                [](const PegGroup& g) { return g.ids.empty(); }),
+                 groups.end());
+    return moved;
+}
+
+// ── Implied crosses ─────────────────────────────────────────────────────────────
+//
+// A cross's implied touch is kept current from its legs' touches, which
+// publishBookUpdate hands over after every leg book change.  A SPOT order in
+// the cross takes the direct book and the implied touch in price order —
+// the direct book first at an equal price — and each implied fill is two
+// leg orders that the plan guarantees fill in full at the legs' touches.
+
+// The touch a leg prices its crosses from.  A leg in auction mode may rest
+// crossed and only trades in its auction, so it offers no implied liquidity.
+static Touch legTouch(const SubBook& leg) {
+    return leg.isAuction() ? Touch{} : ImpliedPricer::touchOf(leg);
+}
+
+// Whether the leg touch a leg order would take (buy: the best ask) holds an
+// order of counterparty cpId
+static bool touchHolds(const SubBook& leg, bool buy, long cpId) {
+    const PriceLevel* level = nullptr;
+    if (buy  && !leg.getSellOrders().empty()) level = &leg.getSellOrders().begin()->second;
+    if (!buy && !leg.getBuyOrders().empty())  level = &leg.getBuyOrders().begin()->second;
+    if (!level) return false;
+    for (const Order& o : *level)
+        if (o.getCounterpartyId() == cpId) return true;
+    return false;
+}
+
+bool OrderManager::addImpliedCross(const std::string& cross, const std::string& legA, const std::string& legB) {
+    const int id = implied_.addCross(cross, legA, legB);
+    if (id < 0) return false;
+    orderBook->get(cross).setImpliedCross(id);
+    for (int i = 0; i < 2; ++i) {
+        const int leg = implied_.legOf(id, i);
+        SubBook&  lb  = orderBook->get(implied_.legSymbol(leg));
+        lb.setImpliedLeg(leg);
+        implied_.onLegChanged(leg, legTouch(lb));   // price off whatever already rests
+    }
+    return true;
+}
+
+void OrderManager::refreshImplied(const SubBook& leg, uint64_t ingressTicks) {
+    LATENCY_PROBE(LatencyStage::REFRESH_IMPLIED);
+    for (int cross : implied_.onLegChanged(leg.getImpliedLeg(), legTouch(leg)))
+        if (eventBus_)
+            eventBus_->publish("event: implied_quote\ndata: " + implied_.quoteJson(cross) + "\n\n", ingressTicks);
+}
+
+bool OrderManager::matchWithImplied(Order& order, SubBook& sb) {
+    const int    cross = sb.getImpliedCross();
+    const bool   buy   = order.isBuyOrder();
+    const double limit = order.getPrice();
+    for (;;) {
+        const Touch& q       = implied_.quote(cross);
+        const double implied = buy ? q.ask : q.bid;
+        const bool   crosses = implied > 0 && (buy ? implied <= limit : implied >= limit);
+
+        // Direct levels up to the implied price first, then the implied touch
+        if (crosses) order.setPrice(implied);
+        const bool done = tradeManager->matchSpotOrders(order, sb, *orderBook);
+        order.setPrice(limit);
+        if (done || !crosses) return done;
+        if (!fillImplied(order, cross)) return tradeManager->matchSpotOrders(order, sb, *orderBook);   // direct book alone
+    }
+}
+
+bool OrderManager::fillImplied(Order& order, int cross) {
+    const bool   buy = order.isBuyOrder();
+    const Touch& q   = implied_.quote(cross);
+    const long   qty = std::min(order.getQuantity(), buy ? q.askQty : q.bidQty);
+    ImpliedPricer::LegOrder legs[2];
+    if (!implied_.plan(cross, buy, qty, legs)) return false;
+
+    // Never trade an auction book continuously.  Self-trade prevention
+    // cannot act inside a leg (the plan relies on both legs filling in full),
+    // so an order that prevents self-trades leaves the implied touch alone if
+    // either leg's touch holds its own counterparty's order.
+    const long selfId = order.getSelfTrade() != SelfTradePrevention::NONE ? order.getCounterpartyId() : 0;
+    for (const ImpliedPricer::LegOrder& leg : legs) {
+        const SubBook& lb = orderBook->get(implied_.legSymbol(leg.leg));
+        if (lb.isAuction() || (selfId && touchHolds(lb, leg.buy, selfId))) return false;
+    }
+
+    // Each leg stays within its touch, so it should fill in full.  If one
+    // falls short anyway, the cross is filled only in the share it took, and
+    // the second leg is re-planned for that share.  The pricer still holds
+    // the touches the first plan was made from, so the re-plan is consistent.
+    long executed = qty;
+    for (int i = 0; i < 2 && executed > 0; ++i) {
+        const ImpliedPricer::LegOrder& leg = legs[i];
+        const std::string&             sym = implied_.legSymbol(leg.leg);
+        Order legOrder(sym, leg.price, leg.qty, leg.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL,
+                       order.getCounterparty());
+        legOrder.setIngressTicks(order.getIngressTicks());
+        tradeManager->matchSpotOrders(legOrder, orderBook->get(sym), *orderBook);
+        if (legOrder.getQuantity() == 0) continue;
+        executed = executed * (leg.qty - legOrder.getQuantity()) / leg.qty;
+        if (i == 0 && executed > 0 && !implied_.plan(cross, buy, executed, legs)) executed = 0;
+    }
+    order.setQuantity(order.getQuantity() - executed);
+    if (executed > 0) Metrics::increment(Counter::IMPLIED_FILLS);
+
+    // Each leg's book_update also re-prices the cross for the next pass
+    for (const ImpliedPricer::LegOrder& leg : legs) publishBookUpdate(implied_.legSymbol(leg.leg), order.getIngressTicks());
+    return executed > 0;   // false: the caller matches the direct book alone
+}
+
+// ── Batch auctions ──────────────────────────────────────────────────────────────
+//
+// An auction book takes orders without matching them; the clock that drives
+// it (HTTPServer, --auction-interval-ms) calls runAuction, which uncrosses the
+// whole book at one price in one pass.
+
+void OrderManager::setAuctionMode(const std::string& symbol, bool on) {
+    SubBook& sb = orderBook->get(symbol);
+    if (sb.isAuction() == on) return;
+    if (on) {
+        auctionSymbols_.push_back(symbol);
+    } else {
+        runAuction(symbol);   // continuous matching never sees a crossed book
+        auctionSymbols_.erase(std::find(auctionSymbols_.begin(), auctionSymbols_.end(), symbol));
+    }
+    sb.setAuction(on);
+    if (sb.getImpliedLeg() >= 0) refreshImplied(sb, 0);   // the leg's implied liquidity goes, or comes back
+}
+
+AuctionResult OrderManager::runAuction(const std::string& symbol, uint64_t ingressTicks) {
+    SubBook* sb = orderBook->find(symbol);
+    if (!sb) return {};
+
+    AuctionResult auction;
+    {
+        LATENCY_PROBE(LatencyStage::UNCROSS);
+        auction = TradeManager::uncrossPrice(*sb);
+        if (auction.volume == 0) return auction;
+        auction.volume = tradeManager->uncross(symbol, auction, *sb, *orderBook, ingressTicks);   // less any self-trades prevented
+    }
+    Metrics::increment(Counter::AUCTIONS);
+
+    if (eventBus_)
+        eventBus_->publish("event: auction\ndata: " + auctionJson(symbol, auction) + "\n\n", ingressTicks);
+    publishBookUpdate(symbol, ingressTicks);   // one delta for the whole uncross
+    return auction;
+}
+
+AuctionResult OrderManager::indicativeAuction(const std::string& symbol) const {
+    const SubBook* sb = orderBook->find(symbol);
+    return sb ? TradeManager::uncrossPrice(*sb) : AuctionResult{};
+}
+
+std::string OrderManager::auctionJson(const std::string& symbol, const AuctionResult& auction) {
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(6);
+    j << "{\"symbol\":\""  << symbol << "\""
+      << ",\"price\":"      << auction.price
+      << ",\"volume\":"     << auction.volume
+      << ",\"surplus\":"    << auction.surplus
+      << "}";
+    return j.str();
+}
+
+// ── Market-triggered fills ──────────────────────────────────────────────────────
+
+int OrderManager::processMarketTick(const std::string& symbol, uint64_t ingressTicks) {
+    if (!marketManager) return 0;
+    SubBook* sb = orderBook->find(symbol);   // market-only symbols have no book
+    if (!sb) return 0;
+
+    MarketQuote quote;
+    if (!marketManager->getQuote(symbol, quote)) return 0;
+
+    // Pegged orders follow the quote first, so the trigger sees them re-priced
+    int moved = repricePegs(*sb, quote);
+    int fills = sb->isAuction() ? 0 : tradeManager->matchAgainstMarket(symbol, quote, *sb, *orderBook, ingressTicks);
+    if (fills == 0 && moved == 0) return 0;
+
+    if (fills && ingressTicks)
+        LatencyRegistry::local(LatencyStage::TICK_TO_FILL).record(latencyNow() - ingressTicks);
+    publishBookUpdate(symbol, ingressTicks);   // book changed by re-pricing and/or fill(s)
+    return fills;
 }
 
 SubBook& OrderManager::getSubBook(const std::string& symbol) {
     return orderBook->get(symbol);
 }
 
+SubBook& OrderManager::getSwapBook(const std::string& symbol) {
+    return orderBook->getSwap(symbol);
+}
+
+void OrderManager::setAllocation(const std::string& symbol, Allocation allocation, long minQty) {
+    orderBook->get(symbol).setAllocation(allocation, std::max(1L, minQty));
+}
+
+// Match an incoming (or crossing) order in its own book: swaps as swaps,
+// spot orders in a configured cross against implied liquidity as well.
+// prevented, if given, receives the quantity self-trade prevention took off
+// order instead of filling; the total is drained either way.
+bool OrderManager::match(Order& order, SubBook& sb, long* prevented) {
+    bool done;
+    if (isSwapOrder(order.getType()))   done = tradeManager->matchSwapOrders(order, sb, *orderBook);
+    else if (sb.getImpliedCross() >= 0) done = matchWithImplied(order, sb);
+    else                                done = tradeManager->matchSpotOrders(order, sb, *orderBook);
+    const long withheld = tradeManager->takeSelfTradePrevented();
+    if (prevented) *prevented = withheld;
+    return done;
+}
+
+SubBook& OrderManager::bookFor(const Order& order) {
+    return isSwapOrder(order.getType()) ? orderBook->getSwap(order.getSymbol()) : orderBook->get(order.getSymbol());
+}
+
 std::vector<std::string> OrderManager::getSymbols() const {
     return orderBook->getSymbols();
 }
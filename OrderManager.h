@@ -1,16 +1,48 @@
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <string>
 #include <vector>
+#include "ImpliedPricer.h"
 #include "OrderBook.h"
 #include "MarketManager.h"
+#include "RiskManager.h"
 #include "SubBook.h"
 #include "TradeManager.h"
 
 #ifndef ORDERMANAGER_H
 #define ORDERMANAGER_H
 
-class EventBus;  // forward declaration
+class EventBus;   // forward declarations
+class TradeFeed;
+
+// Outcome of OrderManager::processAmendOrder
+enum class AmendResult
+{
+    AMENDED = 0,   // applied (or nothing to change)
+    NOT_FOUND,     // no resting order with that ID
+    INVALID,       // quantity ≤ 0, price ≤ 0 (swap points excepted), or a pegged order re-priced
+    REJECTED       // the pre-trade risk gate refused the new terms
+};
+
+// A two-sided quote for OrderManager::processQuote.  A side with quantity 0
+// is pulled.
+struct Quote {
+    std::string         symbol;
+    double              bidPrice  = 0;
+    long                bidQty    = 0;
+    double              askPrice  = 0;
+    long                askQty    = 0;
+    SelfTradePrevention selfTrade = SelfTradePrevention::NONE;   // for the sides' orders
+};
+
+// Outcome of OrderManager::processQuote
+enum class QuoteResult
+{
+    APPLIED = 0,   // both sides as quoted (a side that crossed may have filled)
+    INVALID,       // negative quantity, price ≤ 0 on a quoted side, or bid ≥ ask
+    REJECTED       // the pre-trade risk gate refused a side, which is pulled
+};
 
 class OrderManager
 {
@@ -19,22 +51,142 @@ private:
     std::unique_ptr<TradeManager> tradeManager;
     MarketManager*                marketManager;
     EventBus*                     eventBus_{nullptr};
+    RiskManager*                  riskManager_{nullptr};
+    ImpliedPricer                 implied_;
+    std::vector<std::string>      auctionSymbols_;   // symbols in batch-auction mode
 
-    void queueOrder(const Order& order, SubBook& sb);
-    void publishBookUpdate(const std::string& symbol);
+    void         queueOrder(const Order& order, SubBook& sb);
+    SubBook&     bookFor(const Order& order);   // the spot or swap book the order trades in
+    void         publishLevels(const char* event, const std::string& symbol, SubBook& sb, uint64_t ingressTicks);
+    RejectReason submitOrder(const Order& order, long* filled);   // processNewOrder for a priced order
+    RejectReason placeOrder(const Order& order, long* filled, bool& changed);
+    AmendResult  amendResting(const Order& resting, double newPrice, long newQuantity,
+                              uint64_t ingressTicks, RejectReason* reason);
+    RejectReason quoteSide(Counterparty& cp, const Quote& quote, bool buy, long& slotId,
+                           uint64_t ingressTicks, bool& changed);
+    void         pullOrder(const Order& resting, SubBook& sb);
+    int          repriceGroup(SubBook& sb, PegGroup& group, double price);
+    int          repricePegs(SubBook& sb, const MarketQuote& quote);
+    bool         match(Order& order, SubBook& sb, long* prevented = nullptr);   // SPOT or SWAP order against its book
+    bool         matchWithImplied(Order& order, SubBook& sb);   // direct book and implied touch, best price first
+    bool         fillImplied(Order& order, int cross);
+    void         refreshImplied(const SubBook& leg, uint64_t ingressTicks);
 
 public:
     OrderManager(MarketManager*);
     ~OrderManager();
 
     void setEventBus(EventBus* bus);
+    void setTradeFeed(TradeFeed* feed) { tradeManager->setTradeFeed(feed); }
+
+    // Screen every new order with this gate and keep its per-counterparty
+    // exposure current (none = no pre-trade checks)
+    void setRiskManager(RiskManager* risk);
+
+    // Returns RejectReason::NONE if the order was accepted; a rejected order
+    // never touches the book.  filled (optional) receives the quantity
+    // executed on arrival.  IOC orders drop their unfilled remainder, and FOK
+    // orders that the book cannot fill in full are dropped before any fill;
+    // neither is ever indexed.  A pegged order is priced off the symbol's
+    // market quote (NO_PEG_REFERENCE if the quote has no price for its peg)
+    // and, if it rests, joins its peg group to follow the quote.
+    RejectReason processNewOrder(const Order& order, long* filled = nullptr);
+
+    // ingressTicks is the latencyNow() stamp taken when the cancel arrived;
+    // it travels with the resulting book_update event (0 = untraced)
+    void processCancelOrder(long orderId, uint64_t ingressTicks = 0);
+
+    // Change a resting order's price and/or quantity in one pass with one
+    // book_update.  A quantity cut at the same price keeps time priority;
+    // anything else moves the order to the back of its new level, or matches
+    // it first if a SPOT or SWAP order's new price crosses.  A pegged order's price
+    // belongs to its peg: changing it is INVALID.  reason (optional) is set
+    // when the result is REJECTED.
+    AmendResult processAmendOrder(long orderId, double newPrice, long newQuantity,
+                                  uint64_t ingressTicks = 0, RejectReason* reason = nullptr);
+
+    // Replace the counterparty's bid and ask in quote.symbol with one engine
+    // pass and one book_update.  Each side's resting order from the last
+    // quote is amended in place (see processAmendOrder) — a size cut at the
+    // same price keeps time priority — or entered as a new SPOT GTC order
+    // if there is none; a side quoted with quantity 0 is pulled.  A side
+    // that now crosses the book matches first.  sides (optional) receives
+    // the ids now resting, and reason the risk gate's answer when the
+    // result is REJECTED.  An INVALID quote changes nothing.
+    QuoteResult processQuote(Counterparty& cp, const Quote& quote, uint64_t ingressTicks = 0,
+                             QuoteSlot* sides = nullptr, RejectReason* reason = nullptr);
+
+    // False if processQuote would find the quote INVALID
+    static bool validQuote(const Quote& quote);
+
+    // Cancel every open order of the counterparty (only those in symbol, if
+    // given) in one pass over its own order list, then publish one
+    // book_update per symbol that changed.  Returns the number cancelled.
+    int cancelAll(Counterparty& cp, const std::string& symbol = "", uint64_t ingressTicks = 0);
+
+    // Serialise the symbol's book and publish it as a book_update SSE event.
+    // Called after every book change; public so a client can force a refresh.
+    void publishBookUpdate(const std::string& symbol, uint64_t ingressTicks = 0);
+
+    // The same for the symbol's swap book, as a swap_book_update event, and
+    // the one of the two that an order of that kind changed
+    void publishSwapBookUpdate(const std::string& symbol, uint64_t ingressTicks = 0);
+    void publishBook(const std::string& symbol, bool swap, uint64_t ingressTicks = 0);
+
+    // Re-price the symbol's pegged orders to its latest external market
+    // quote, one pass per peg group that moved, then fill resting orders
+    // that quote crosses (see TradeManager::matchAgainstMarket).
+    // ingressTicks is the tick's arrival stamp.  Returns the number of
+    // market-triggered fills.
+    int processMarketTick(const std::string& symbol, uint64_t ingressTicks = 0);
+
+    // Price cross (e.g. EUR/GBP) from two leg books (EUR/USD, GBP/USD) that
+    // share a currency.  From then on every change to a leg's touch
+    // recomputes the cross's implied touch and publishes it as an
+    // implied_quote event, and a SPOT order in the cross that crosses the
+    // implied touch fills there as two leg trades.  False if the symbols do
+    // not form a cross or it is already configured.
+    bool addImpliedCross(const std::string& cross, const std::string& legA, const std::string& legB);
+    const ImpliedPricer& getImpliedPricer() const { return implied_; }
+
+    // How the orders at one of the symbol's price levels share a fill that
+    // does not clear the level (FIFO unless set).  minQty is the smallest
+    // pro-rata share that is filled; see TradeManager's fillLevel.  Applies
+    // to continuous matching only: runAuction is always FIFO.
+    void setAllocation(const std::string& symbol, Allocation allocation, long minQty = 1);
+
+    // Switch a symbol between continuous matching and periodic batch
+    // auctions.  In an auction book SPOT orders rest without matching (IOC
+    // and FOK orders are dropped) until runAuction uncrosses it.  Leaving
+    // auction mode runs one last auction, so continuous matching starts from
+    // an uncrossed book.
+    void setAuctionMode(const std::string& symbol, bool on);
+    const std::vector<std::string>& getAuctionSymbols() const { return auctionSymbols_; }
+
+    // Uncross the symbol's book at its auction price (TradeManager::uncrossPrice),
+    // every fill at that one price in price-time order, then publish an
+    // auction event and one book_update.  Always FIFO within a level,
+    // whatever setAllocation says.  Self-trade prevention applies: when the
+    // bid and ask next in line are one counterparty's, the later order's
+    // mode is applied as if it had just arrived, and that pair does not
+    // trade.  The price is found on the whole book, so the volume returned,
+    // what actually traded, can fall short of the indicative one (0 if the
+    // book did not cross).
+    AuctionResult runAuction(const std::string& symbol, uint64_t ingressTicks = 0);
+
+    // What an auction would do now, without trading
+    AuctionResult indicativeAuction(const std::string& symbol) const;
 
-    void processNewOrder(const Order& order);
-    void processCancelOrder(long orderId);
+    // {"symbol":..,"price":..,"volume":..,"surplus":..}
+    static std::string auctionJson(const std::string& symbol, const AuctionResult& auction);
 
     SubBook& getSubBook(const std::string& symbol);
+    SubBook& getSwapBook(const std::string& symbol);   // SWAP_BUY / SWAP_SELL orders, priced in points
+    const Order* getOrder(long orderId) const { return orderBook->getOrder(orderId); }   // resting only
+    MarketManager* getMarketManager() const { return marketManager; }
     std::vector<std::string> getSymbols() const;
     const std::deque<Trade>& getRecentTrades() const;
+    const Counterparty& getMarketCounterparty() const { return tradeManager->getMarketCounterparty(); }
 };
 
 #endif
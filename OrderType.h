@@ -1,6 +1,8 @@
 #ifndef ORDERTYPE_H
 #define ORDERTYPE_H
 
+#include <string>
+
 enum class OrderType
 {
     MARKET_BUY = 0,
@@ -16,6 +18,46 @@ enum class OrderType
     //inline bool operator==(int other) const { return *this == other; };
 };
 
+// How long an order may rest.  GTC queues whatever does not fill on
+// arrival; IOC discards it; FOK executes in full on arrival or not at all.
+enum class TimeInForce
+{
+    GTC = 0,   // good till cancelled (default)
+    IOC = 1,   // immediate or cancel
+    FOK = 2,   // fill or kill
+};
+
+// What a pegged order's price follows in the symbol's market quote.  The
+// engine re-prices pegged orders whenever that quote moves; price is the
+// reference plus the order's (signed) peg offset.
+enum class PegType
+{
+    NONE    = 0,   // fixed price
+    PRIMARY = 1,   // own side of the touch: bid for buys, ask for sells
+    MID     = 2,   // (bid + ask) / 2
+    MARKET  = 3,   // far side of the touch: ask for buys, bid for sells
+};
+
+// How the orders at one price level share a fill that does not clear it
+enum class Allocation
+{
+    FIFO      = 0,   // price-time: arrival order (default)
+    PRO_RATA  = 1,   // in proportion to displayed quantity
+    TOP_ORDER = 2,   // the level's oldest order first, then pro rata
+};
+
+// What the matching loop does, instead of trading, when an incoming order
+// meets a resting order of its own counterparty.  The incoming order's
+// setting applies.
+enum class SelfTradePrevention
+{
+    NONE            = 0,   // trade with it (default)
+    CANCEL_RESTING  = 1,   // cancel the resting order and carry on matching
+    CANCEL_INCOMING = 2,   // cancel what is left of the incoming order
+    CANCEL_BOTH     = 3,   // cancel both
+    DECREMENT       = 4,   // take the smaller quantity off both, without a trade
+};
+
 // Helper functions
 inline bool isBuyOrder(OrderType type) {
     return static_cast<int>(type) % 2 == 0;
@@ -25,6 +67,10 @@ inline bool isSellOrder(OrderType type) {
     return !isBuyOrder(type);
 }
 
+inline bool isSwapOrder(OrderType type) {
+    return type == OrderType::SWAP_BUY || type == OrderType::SWAP_SELL;
+}
+
 inline const char* toString(OrderType type) {
     switch(type) {
         case OrderType::MARKET_BUY:  return "MARKET_BUY";
@@ -41,5 +87,53 @@ inline const char* toString(OrderType type) {
     return "UNKNOWN";
 }
 
+inline const char* toString(TimeInForce tif) {
+    switch(tif) {
+        case TimeInForce::GTC: return "GTC";
+        case TimeInForce::IOC: return "IOC";
+        case TimeInForce::FOK: return "FOK";
+    }
+    return "UNKNOWN";
+}
+
+inline const char* toString(Allocation allocation) {
+    switch(allocation) {
+        case Allocation::FIFO:      return "FIFO";
+        case Allocation::PRO_RATA:  return "PRO_RATA";
+        case Allocation::TOP_ORDER: return "TOP_ORDER";
+    }
+    return "UNKNOWN";
+}
+
+inline const char* toString(SelfTradePrevention stp) {
+    switch(stp) {
+        case SelfTradePrevention::NONE:            return "NONE";
+        case SelfTradePrevention::CANCEL_RESTING:  return "CANCEL_RESTING";
+        case SelfTradePrevention::CANCEL_INCOMING: return "CANCEL_INCOMING";
+        case SelfTradePrevention::CANCEL_BOTH:     return "CANCEL_BOTH";
+        case SelfTradePrevention::DECREMENT:       return "DECREMENT";
+    }
+    return "UNKNOWN";
+}
+
+// The mode toString names name; false if it names none
+inline bool parseSelfTrade(const std::string& name, SelfTradePrevention& stp) {
+    for (int i = 0; i <= static_cast<int>(SelfTradePrevention::DECREMENT); ++i) {
+        const auto mode = static_cast<SelfTradePrevention>(i);
+        if (name == toString(mode)) { stp = mode; return true; }
+    }
+    return false;
+}
+
+inline const char* toString(PegType peg) {
+    switch(peg) {
+        case PegType::NONE:    return "NONE";
+        case PegType::PRIMARY: return "PRIMARY";
+        case PegType::MID:     return "MID";
+        case PegType::MARKET:  return "MARKET";
+    }
+    return "UNKNOWN";
+}
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include "Counterparty.h"
+#include "EventBus.h"
+#include "MarketManager.h"
+#include "PositionKeeper.h"
+#include "TradeManager.h"
+
+PositionKeeper::PositionKeeper(const MarketManager* market, EventBus* bus) : market_(market), bus_(bus) {
+}
+
+// ── Accounting ────────────────────────────────────────────────────────────────
+
+void PositionKeeper::apply(Slot& s, long signedQty, double price) {
+    if (signedQty > 0) s.bought += signedQty;
+    else               s.sold   -= signedQty;
+
+    if (s.net == 0 || (s.net > 0) == (signedQty > 0)) {
+        // Opening or adding: re-average the cost
+        const double held = static_cast<double>(std::labs(s.net));
+        const double add  = static_cast<double>(std::labs(signedQty));
+        s.avgCost = (s.avgCost * held + price * add) / (held + add);
+        s.net    += signedQty;
+        return;
+    }
+
+    // Reducing: realise the closed quantity, then open whatever goes through flat
+    const long closed = std::min(std::labs(signedQty), std::labs(s.net));
+    s.realised += (price - s.avgCost) * static_cast<double>(s.net > 0 ? closed : -closed);
+    s.net      += signedQty;
+    if (s.net == 0)                          s.avgCost = 0;
+    else if ((s.net > 0) == (signedQty > 0)) s.avgCost = price;
+}
+
+PositionKeeper::Book* PositionKeeper::bookFor(int64_t counterpartyId) {
+    auto it = byId_.find(counterpartyId);
+    if (it != byId_.end()) return it->second;
+
+    std::string name = Counterparty::nameOf(counterpartyId);
+    auto& book = books_[name];
+    if (!book) {
+        book = std::make_unique<Book>();
+        book->name = name;
+    }
+    byId_.emplace(counterpartyId, book.get());
+    return book.get();
+}
+
+void PositionKeeper::fill(int64_t counterpartyId, const std::string& symbol, long signedQty, double price) {
+    if (counterpartyId == 0) return;   // no counterparty on this side
+    Book* book = bookFor(counterpartyId);
+    auto  it   = book->slots.try_emplace(symbol).first;
+    apply(it->second, signedQty, price);
+    if (!it->second.touched) {
+        it->second.touched = true;
+        touched_.push_back({ book, &it->first, &it->second });
+    }
+}
+
+void PositionKeeper::onTrades(const TradeRecord* records, size_t count) {
+    std::vector<std::string> events;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (size_t i = 0; i < count; ++i) {
+            const TradeRecord& r = records[i];
+            std::string symbol(r.symbol, strnlen(r.symbol, sizeof(r.symbol)));
+            const long  qty = static_cast<long>(r.quantity);
+
+            fill(r.buyerId,  symbol,  qty, r.price);
+            fill(r.sellerId, symbol, -qty, r.price);
+            if (r.leg != static_cast<uint8_t>(SwapLeg::FAR))   // a forward rate, not a spot mark
+                lastFill_[symbol] = r.price;
+        }
+
+        for (const Touched& t : touched_) {
+            t.slot->touched = false;
+            if (bus_)
+                events.push_back("event: position\ndata: " +
+                                 positionJson(t.book->name, view(*t.symbol, *t.slot)) + "\n\n");
+        }
+        touched_.clear();
+    }
+
+    for (const auto& e : events) bus_->publish(e);
+}
+
+// ── Reads ─────────────────────────────────────────────────────────────────────
+
+double PositionKeeper::markFor(const std::string& symbol) const {
+    MarketQuote q;
+    if (market_ && market_->getQuote(symbol, q)) {
+        if (q.bid > 0 && q.ask > 0) return (q.bid + q.ask) / 2;
+        if (q.last > 0)             return q.last;
+    }
+    auto it = lastFill_.find(symbol);
+    return it == lastFill_.end() ? 0.0 : it->second;
+}
+
+Position PositionKeeper::view(const std::string& symbol, const Slot& s) const {
+    Position p{ symbol, s.net, s.avgCost, s.realised, s.bought, s.sold, 0.0, 0.0 };
+    p.mark = markFor(symbol);
+    if (p.mark > 0) p.unrealised = (p.mark - s.avgCost) * static_cast<double>(s.net) + 0.0;   // never -0
+    return p;
+}
+
+std::vector<Position> PositionKeeper::getPositions(const std::string& counterparty) const {
+    std::vector<Position> out;
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = books_.find(counterparty);
+    if (it == books_.end()) return out;
+
+    out.reserve(it->second->slots.size());
+    for (const auto& [symbol, slot] : it->second->slots) out.push_back(view(symbol, slot));
+    std::sort(out.begin(), out.end(), [](const Position& a, const Position& b) { return a.symbol < b.symbol; });
+    return out;
+}
+
+bool PositionKeeper::hasPositions(const std::string& counterparty) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return books_.count(counterparty) != 0;
+}
+
+std::string PositionKeeper::positionJson(const std::string& counterparty, const Position& p) {
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(6);
+    j << "{\"counterparty\":\"" << counterparty << "\""
+      << ",\"symbol\":\""       << p.symbol << "\""
+      << ",\"net\":"            << p.net
+      << ",\"avgCost\":"        << p.avgCost
+      << ",\"realised\":"       << p.realised
+      << ",\"unrealised\":"     << p.unrealised
+      << ",\"mark\":"           << p.mark
+      << ",\"bought\":"         << p.bought
+      << ",\"sold\":"           << p.sold
+      << "}";
+    return j.str();
+}
@@ -0,0 +1,99 @@
+#ifndef POSITIONKEEPER_H
+#define POSITIONKEEPER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TradeFeed.h"
+
+class EventBus;
+class MarketManager;
+
+// One counterparty's position in one symbol, as read back.  P&L is in the
+// symbol's quote currency.
+struct Position {
+    std::string symbol;
+    long        net;          // + long, − short
+    double      avgCost;      // average entry price of the open position; 0 when flat
+    double      realised;     // P&L locked in by fills that reduced the position
+    long        bought;       // cumulative quantities
+    long        sold;
+    double      mark;         // price the open position is valued at; 0 if none known
+    double      unrealised;   // (mark − avgCost) × net
+};
+
+// ─── Positions and P&L ───────────────────────────────────────────────────────
+//
+// A TradeFeed sink that keeps every counterparty's net position, average
+// cost and realised P&L per symbol.  Each fill updates the buyer's and the
+// seller's slot in O(1): adding to a position re-averages its cost, reducing
+// one realises (price − avgCost) on the closed quantity, and a fill through
+// flat opens the remainder at the fill price.  Memory is one slot per
+// (counterparty, symbol) ever traded, however many fills there are.
+//
+// Counterparties are keyed by name, so Counterparty objects that share a
+// name (the CSV loader's and the server's) share a book.
+//
+// Unrealised P&L is marked when read: against the BBO mid from the
+// MarketManager when both sides are quoted, else its last trade, else the
+// last fill seen here.
+//
+// After each batch, every (counterparty, symbol) the batch touched is
+// published once as an SSE "position" event.  onTrades runs on the feed's
+// consumer thread; reads may come from any thread and never take the
+// engine lock.
+class PositionKeeper {
+public:
+    explicit PositionKeeper(const MarketManager* market = nullptr, EventBus* bus = nullptr);
+
+    // TradeFeed sink
+    void onTrades(const TradeRecord* records, size_t count);
+
+    // Every symbol the counterparty has traded, sorted by symbol; empty if none
+    std::vector<Position> getPositions(const std::string& counterparty) const;
+    bool                  hasPositions(const std::string& counterparty) const;
+
+    // {"counterparty":..,"symbol":..,"net":..,"avgCost":..,"realised":..,"unrealised":..,...}
+    static std::string positionJson(const std::string& counterparty, const Position& p);
+
+private:
+    struct Slot {
+        long   net      = 0;
+        double avgCost  = 0;
+        double realised = 0;
+        long   bought   = 0;
+        long   sold     = 0;
+        bool   touched  = false;
+    };
+
+    struct Book {
+        std::string                           name;
+        std::unordered_map<std::string, Slot> slots;   // by symbol
+    };
+
+    struct Touched {
+        Book*              book;
+        const std::string* symbol;   // key of the slot in book->slots
+        Slot*              slot;
+    };
+
+    const MarketManager*                                   market_;
+    EventBus*                                              bus_;
+    mutable std::mutex                                     mu_;
+    std::unordered_map<std::string, std::unique_ptr<Book>> books_;       // by counterparty name
+    std::unordered_map<int64_t, Book*>                     byId_;        // Counterparty id → its book
+    std::unordered_map<std::string, double>                lastFill_;    // fallback mark per symbol; far swap legs skipped
+    std::vector<Touched>                                   touched_;     // consumer thread only
+
+    Book*    bookFor(int64_t counterpartyId);
+    void     fill(int64_t counterpartyId, const std::string& symbol, long signedQty, double price);
+    double   markFor(const std::string& symbol) const;
+    Position view(const std::string& symbol, const Slot& s) const;
+
+    static void apply(Slot& s, long signedQty, double price);
+};
+
+#endif
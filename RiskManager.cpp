@@ -0,0 +1,150 @@
+#include <cmath>
+#include "Counterparty.h"
+#include "MarketManager.h"
+#include "Order.h"
+#include "RiskManager.h"
+#include "TradeManager.h"
+
+const char* rejectReasonName(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::NONE:             return "none";
+        case RejectReason::MAX_ORDER_QTY:    return "max_order_qty";
+        case RejectReason::MAX_NOTIONAL:     return "max_notional";
+        case RejectReason::PRICE_BAND:       return "price_band";
+        case RejectReason::OPEN_EXPOSURE:    return "open_exposure";
+        case RejectReason::CREDIT_LIMIT:     return "credit_limit";
+        case RejectReason::NO_PEG_REFERENCE: return "no_peg_reference";
+        case RejectReason::NO_NEAR_RATE:     return "no_near_rate";
+        case RejectReason::COUNT:            break;
+    }
+    return "unknown";
+}
+
+const char* rejectReasonText(RejectReason reason) {
+    switch (reason) {
+        case RejectReason::NONE:             return "accepted";
+        case RejectReason::MAX_ORDER_QTY:    return "quantity exceeds the per-order limit";
+        case RejectReason::MAX_NOTIONAL:     return "notional exceeds the per-order limit";
+        case RejectReason::PRICE_BAND:       return "price is outside the band around the market reference";
+        case RejectReason::OPEN_EXPOSURE:    return "resting notional would exceed the counterparty's open exposure limit";
+        case RejectReason::CREDIT_LIMIT:     return "filled plus resting notional would exceed the counterparty's credit limit";
+        case RejectReason::NO_PEG_REFERENCE: return "the market quote has no price for this peg";
+        case RejectReason::NO_NEAR_RATE:     return "no market rate to fix the swap's near leg";
+        case RejectReason::COUNT:            break;
+    }
+    return "unknown";
+}
+
+RiskManager::RiskManager(const MarketManager* market) : market_(market) {
+}
+
+// ── Per-counterparty state ────────────────────────────────────────────────────
+
+RiskManager::State& RiskManager::state(const Counterparty& cp) {
+    size_t id = static_cast<size_t>(cp.getId());
+    if (id >= states_.size()) states_.resize(id + 1);
+    return states_[id];
+}
+
+const RiskManager::State* RiskManager::find(const Counterparty* cp) const {
+    if (!cp) return nullptr;
+    size_t id = static_cast<size_t>(cp->getId());
+    return id < states_.size() ? &states_[id] : nullptr;
+}
+
+void RiskManager::setLimits(const Counterparty& cp, const RiskLimits& limits) {
+    State& s = state(cp);
+    s.limits = limits;
+    s.custom = 1;
+}
+
+const RiskLimits& RiskManager::getLimits(const Counterparty& cp) const {
+    const State* s = find(&cp);
+    return s && s->custom ? s->limits : defaults_;
+}
+
+double RiskManager::openNotional(const Counterparty& cp) const {
+    const State* s = find(&cp);
+    return s ? s->openNotional : 0.0;
+}
+
+double RiskManager::filledNotional(const Counterparty& cp) const {
+    const State* s = find(&cp);
+    return s ? s->filledNotional : 0.0;
+}
+
+long RiskManager::openOrders(const Counterparty& cp) const {
+    const State* s = find(&cp);
+    return s ? s->openOrders : 0;
+}
+
+// ── Gate ──────────────────────────────────────────────────────────────────────
+
+// A swap's price is forward points, not a rate: it adds no resting notional
+// and is not banded.  Its legs count as filled notional when they trade.
+static double exposurePrice(const Order& order) {
+    return isSwapOrder(order.getType()) ? 0.0 : order.getPrice();
+}
+
+RejectReason RiskManager::check(const Order& order) const {
+    const State*      s        = find(order.getCounterparty());
+    const RiskLimits& limits   = s && s->custom ? s->limits : defaults_;
+    const long        qty      = order.getOpenQuantity();
+    const double      price    = exposurePrice(order);
+    const double      notional = price * static_cast<double>(qty);
+
+    if (limits.maxOrderQty > 0 && qty > limits.maxOrderQty)       return RejectReason::MAX_ORDER_QTY;
+    if (limits.maxNotional > 0 && notional > limits.maxNotional)  return RejectReason::MAX_NOTIONAL;
+
+    if (limits.priceBand > 0 && price > 0 && market_) {
+        MarketQuote q;
+        if (market_->getQuote(order.getSymbol(), q)) {
+            double ref = (q.bid > 0 && q.ask > 0) ? (q.bid + q.ask) / 2 : q.last;
+            if (ref > 0 && std::fabs(price - ref) > limits.priceBand * ref) return RejectReason::PRICE_BAND;
+        }
+    }
+
+    if (!s) return RejectReason::NONE;   // nothing open or filled yet
+    if (limits.maxOpenNotional > 0 && s->openNotional + notional > limits.maxOpenNotional)
+        return RejectReason::OPEN_EXPOSURE;
+    if (limits.creditLimit > 0 && s->filledNotional + s->openNotional + notional > limits.creditLimit)
+        return RejectReason::CREDIT_LIMIT;
+    return RejectReason::NONE;
+}
+
+// ── Incremental updates ───────────────────────────────────────────────────────
+
+void RiskManager::release(State& s, double notional, bool orderGone) {
+    s.openNotional -= notional;
+    if (orderGone) --s.openOrders;
+    if (s.openOrders <= 0) {   // no rounding residue once nothing rests
+        s.openOrders   = 0;
+        s.openNotional = 0;
+    }
+}
+
+void RiskManager::onQueued(const Order& order) {
+    Counterparty* cp = order.getCounterparty();
+    if (!cp) return;
+    State& s = state(*cp);
+    s.openNotional += exposurePrice(order) * static_cast<double>(order.getOpenQuantity());
+    ++s.openOrders;
+}
+
+void RiskManager::onRestingFill(const Order& resting, long fillQty) {
+    Counterparty* cp = resting.getCounterparty();
+    if (!cp) return;
+    release(state(*cp), exposurePrice(resting) * static_cast<double>(fillQty), fillQty >= resting.getOpenQuantity());
+}
+
+void RiskManager::onCancelled(const Order& order) {
+    Counterparty* cp = order.getCounterparty();
+    if (!cp) return;
+    release(state(*cp), exposurePrice(order) * static_cast<double>(order.getOpenQuantity()), true);
+}
+
+void RiskManager::onFill(const Trade& trade) {
+    const double notional = trade.price * static_cast<double>(trade.quantity);
+    if (trade.buyer)  state(*trade.buyer).filledNotional  += notional;
+    if (trade.seller) state(*trade.seller).filledNotional += notional;
+}
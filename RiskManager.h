@@ -0,0 +1,97 @@
+#ifndef RISKMANAGER_H
+#define RISKMANAGER_H
+
+#include <cstdint>
+#include <vector>
+
+class Counterparty;   // forward declarations — state is keyed by Counterparty id
+class MarketManager;
+class Order;
+struct Trade;
+
+// Why an order was refused: by the pre-trade gate, or by the engine when a
+// pegged order has nothing to peg to.  Keep in step with rejectReasonName()
+// and rejectReasonText().
+enum class RejectReason
+{
+    NONE = 0,         // accepted
+    MAX_ORDER_QTY,    // quantity above the per-order cap
+    MAX_NOTIONAL,     // price × quantity above the per-order cap
+    PRICE_BAND,       // price too far from the market reference (fat finger)
+    OPEN_EXPOSURE,    // resting notional would exceed the counterparty's limit
+    CREDIT_LIMIT,     // filled + resting notional would exceed the credit line
+    NO_PEG_REFERENCE, // pegged order, but the market quote has no price to peg to
+    NO_NEAR_RATE,     // swap would trade, but there is no market rate to fix its near leg
+    COUNT
+};
+
+const char* rejectReasonName(RejectReason reason);   // "max_notional", ...
+const char* rejectReasonText(RejectReason reason);   // one-line human-readable cause
+
+// A counterparty's limits.  Zero disables a limit.
+struct RiskLimits {
+    long   maxOrderQty;       // per order
+    double maxNotional;       // per order, price × quantity
+    double priceBand;         // max |price − reference| / reference, e.g. 0.05 = 5%
+    double maxOpenNotional;   // Σ price × remaining quantity of resting orders
+    double creditLimit;       // filled notional + open notional
+};
+
+// ─── Pre-trade risk ──────────────────────────────────────────────────────────
+//
+// Screens every new order before it can match or rest.  Each counterparty
+// has one cache-line state block — its limits, open (resting) notional,
+// filled notional and open order count — in a vector indexed by its
+// Counterparty id, so a check is an array load, a handful of comparisons and
+// (for the price band) one seqlock read of the symbol's quote.  No walk over
+// the counterparty's orders is ever needed: the engine keeps the block
+// current as orders rest, fill and cancel.
+//
+// The price band's reference is the BBO mid, or the last trade when only
+// one side is quoted; a symbol with no market data skips the band.
+//
+// Counterparties without limits of their own use the defaults.  Orders with
+// no counterparty get the per-order checks only.  All calls are made under
+// the engine lock.
+class RiskManager {
+public:
+    explicit RiskManager(const MarketManager* market = nullptr);
+
+    void              setDefaultLimits(const RiskLimits& limits) { defaults_ = limits; }
+    const RiskLimits& getDefaultLimits() const { return defaults_; }
+    void              setLimits(const Counterparty& cp, const RiskLimits& limits);
+    const RiskLimits& getLimits(const Counterparty& cp) const;
+
+    // NONE if the order may proceed
+    RejectReason check(const Order& order) const;
+
+    // Incremental state updates from the engine
+    void onQueued(const Order& order);                        // order (or remainder) now rests
+    void onRestingFill(const Order& resting, long fillQty);   // before its quantity is reduced
+    void onCancelled(const Order& order);                     // before it is erased
+    void onFill(const Trade& trade);                          // credit use, both sides
+
+    double openNotional(const Counterparty& cp) const;
+    double filledNotional(const Counterparty& cp) const;
+    long   openOrders(const Counterparty& cp) const;
+
+private:
+    struct alignas(64) State {
+        RiskLimits limits;
+        double     openNotional   = 0;
+        double     filledNotional = 0;
+        int32_t    openOrders     = 0;
+        int32_t    custom         = 0;   // limits set for this counterparty
+    };
+    static_assert(sizeof(State) == 64, "one cache line per counterparty");
+
+    const MarketManager* market_;
+    RiskLimits           defaults_{};
+    std::vector<State>   states_;   // by Counterparty id; grown on first touch
+
+    State&       state(const Counterparty& cp);
+    const State* find(const Counterparty* cp) const;
+    void         release(State& s, double notional, bool orderGone);
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// ─── Sequence lock ───────────────────────────────────────────────────────────
+//
+// Holds one trivially-copyable value that any number of threads read without
+// locking while writers update it in place.  The sequence number is odd while
+// a write is in progress; a reader copies the value between two loads of the
+// sequence and retries if it moved, so it never sees a torn value and never
+// blocks a writer.  Writers serialise among themselves by CAS-ing the
+// sequence from even to odd.
+//
+// The value is kept as relaxed atomic words rather than a plain T, so the
+// copy a reader races against a writer is well-defined under the C++ memory
+// model (and compiles to plain loads and stores on x86).
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock() {
+        for (auto& w : words_) w.store(0, std::memory_order_relaxed);
+    }
+
+    SeqLock(const SeqLock&)            = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Consistent snapshot of the value
+    T load() const {
+        uint64_t version;
+        return load(version);
+    }
+
+    // Snapshot plus the number of writes it reflects
+    T load(uint64_t& version) const {
+        uint64_t buf[WORDS];
+        uint64_t before;
+        for (;;) {
+            before = seq_.load(std::memory_order_acquire);
+            if (before & 1) { cpuRelax(); continue; }
+            for (int i = 0; i < WORDS; ++i) buf[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == before) break;
+        }
+        version = before / 2;
+        T out;
+        std::memcpy(&out, buf, sizeof(T));
+        return out;
+    }
+
+    void store(const T& value) {
+        update([&value](T& v) { v = value; });
+    }
+
+    // Read-modify-write under the writer lock: f receives the current value
+    // by reference and whatever it leaves there is published
+    template<typename F>
+    void update(F&& f) {
+        uint64_t s = seq_.load(std::memory_order_relaxed);
+        while ((s & 1) || !seq_.compare_exchange_weak(s, s + 1, std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+            cpuRelax();
+            s = seq_.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t buf[WORDS];
+        for (int i = 0; i < WORDS; ++i) buf[i] = words_[i].load(std::memory_order_relaxed);
+        T value;
+        std::memcpy(&value, buf, sizeof(T));
+        f(value);
+        std::memcpy(buf, &value, sizeof(T));
+        for (int i = 0; i < WORDS; ++i) words_[i].store(buf[i], std::memory_order_relaxed);
+
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    // Number of completed writes
+    uint64_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr int WORDS = static_cast<int>((sizeof(T) + 7) / 8);
+
+    static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    }
+
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+#endif
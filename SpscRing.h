@@ -0,0 +1,80 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// ─── Single-producer / single-consumer ring ──────────────────────────────────
+//
+// Bounded lock-free queue of trivially-copyable records.  tryPush never
+// blocks or allocates: when the ring is full it returns false and the
+// producer decides what to drop.  The producer and consumer indices sit on
+// separate cache lines, and each side caches the other's index so the shared
+// line is only re-read when the ring looks full (producer) or when the
+// consumer's view holds less than the batch it asked for.
+//
+// "Single producer" means one push at a time: several threads may produce if
+// they are already serialised by a lock, which also orders their accesses.
+template<typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing requires a trivially copyable type");
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        mask_  = n - 1;
+        slots_.reset(new T[n]);
+    }
+
+    SpscRing(const SpscRing&)            = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side
+    bool tryPush(const T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tailCache_ > mask_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head - tailCache_ > mask_) return false;
+        }
+        slots_[head & mask_] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: copy up to max records into out; returns how many
+    size_t popBatch(T* out, size_t max) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (headCache_ - tail < max) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (headCache_ == tail) return 0;
+        }
+        size_t n = headCache_ - tail;
+        if (n > max) n = max;
+        for (size_t i = 0; i < n; ++i) out[i] = slots_[(tail + i) & mask_];
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Approximate when called concurrently with either side
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::unique_ptr<T[]> slots_;
+    size_t               mask_;
+
+    alignas(64) std::atomic<size_t> head_{0};        // next slot to write
+    size_t                          tailCache_{0};   // producer's view of tail_
+    alignas(64) std::atomic<size_t> tail_{0};        // next slot to read
+    size_t                          headCache_{0};   // consumer's view of head_
+};
+
+#endif
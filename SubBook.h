@@ -1,22 +1,80 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <vector>
+#include "Metrics.h"
 #include "Order.h"
 
 #ifndef SUBBOOK_H
 #define SUBBOOK_H
 
+// One price level: its resting orders in FIFO arrival order, plus their
+// total quantity.  Everything that inserts, fills, cuts or removes an order
+// keeps quantity current, so depth is read per level, not summed per order.
+// quantity is what the level displays; iceberg reserves are kept apart.
+struct PriceLevel : std::list<Order> {
+    long quantity = 0;   // sum of getQuantity() over the level's orders
+    long reserve  = 0;   // sum of getReserve(): hidden, but executable
+
+    // Refresh an iceberg whose displayed slice has just filled: the next
+    // slice comes out of its reserve and the node moves to the back of the
+    // level.  splice relinks the node, so the order's index entry stays
+    // valid.  Returns the next order to visit — the iceberg itself if it
+    // was already last.
+    iterator replenish(iterator it) {
+        long slice = it->replenish();
+        quantity += slice;
+        reserve  -= slice;
+        Metrics::increment(Counter::ICEBERG_REFRESHES);
+
+        auto next = std::next(it);
+        if (next == end()) return it;
+        splice(end(), *this, it);
+        return next;
+    }
+};
+
+// Pegged orders with the same side, peg and offset always share a price, so
+// they are re-priced as one group: the new price is worked out once, and
+// each live member is spliced to the back of that level.  ids are in the
+// order the orders joined; ids of orders filled or cancelled since are
+// dropped on the group's next pass.
+struct PegGroup {
+    bool              buy;
+    PegType           type;
+    double            offset;
+    double            price;   // where the group's orders rest
+    std::vector<long> ids;
+};
+
+// A counterparty's two-sided quote in one book: the ids of the orders
+// resting for its bid and ask (0 = none).  Each new quote amends them in
+// place; an id filled or cancelled since is replaced by a new order.
+struct QuoteSlot {
+    long counterpartyId;
+    long bidId;
+    long askId;
+};
+
 // Sell (ask) map: ascending — begin() == best ask (lowest price)
-using AskMap = std::map<double, std::list<Order>>;
+using AskMap = std::map<double, PriceLevel>;
 
 // Buy (bid) map: descending — begin() == best bid (highest price)
-using BidMap = std::map<double, std::list<Order>, std::greater<double>>;
+using BidMap = std::map<double, PriceLevel, std::greater<double>>;
 
 class SubBook
 {
 private:
     BidMap buyOrders;
     AskMap sellOrders;
+    std::vector<PegGroup> pegGroups;
+    std::vector<QuoteSlot> quoteSlots;
+    SymbolGauges* gauges{nullptr};   // live book-shape gauges for GET /metrics; owned by Metrics
+    int impliedLeg{-1};              // ImpliedPricer leg index; -1 = no leg of a cross
+    int impliedCross{-1};            // ImpliedPricer cross index; -1 = not a configured cross
+    bool auction{false};             // batch-auction mode: orders rest until the next uncross
+    Allocation allocation{Allocation::FIFO};   // how a level's orders share a fill
+    long minAllocation{1};           // smallest pro-rata share filled; smaller ones are carried on
 
 public:
     SubBook();
@@ -27,6 +85,62 @@ public:
 
     BidMap& getBuyOrdersRef()  { return buyOrders; }
     AskMap& getSellOrdersRef() { return sellOrders; }
+
+    // The level at price on one side, created empty if absent
+    PriceLevel& level(bool buy, double price) {
+        return buy ? buyOrders[price] : sellOrders[price];
+    }
+
+    // Remove a price level from one side (called once its list is empty)
+    void eraseLevel(bool buy, double price) {
+        if (buy) buyOrders.erase(price);
+        else     sellOrders.erase(price);
+    }
+
+    std::vector<PegGroup>& getPegGroups() { return pegGroups; }
+
+    // The group for this side, peg and offset, created (at price) if absent
+    PegGroup& pegGroup(bool buy, PegType type, double offset, double price) {
+        for (PegGroup& g : pegGroups)
+            if (g.buy == buy && g.type == type && g.offset == offset) return g;
+        pegGroups.push_back({ buy, type, offset, price, {} });
+        return pegGroups.back();
+    }
+
+    // The counterparty's quote slot, created empty if absent
+    QuoteSlot& quoteSlot(long counterpartyId) {
+        for (QuoteSlot& q : quoteSlots)
+            if (q.counterpartyId == counterpartyId) return q;
+        quoteSlots.push_back({ counterpartyId, 0, 0 });
+        return quoteSlots.back();
+    }
+
+    SymbolGauges* getGauges() const           { return gauges; }
+    void          setGauges(SymbolGauges* g)  { gauges = g; }
+
+    int  getImpliedLeg() const      { return impliedLeg; }
+    void setImpliedLeg(int leg)     { impliedLeg = leg; }
+    int  getImpliedCross() const    { return impliedCross; }
+    void setImpliedCross(int cross) { impliedCross = cross; }
+
+    bool isAuction() const          { return auction; }
+    void setAuction(bool on)        { auction = on; }
+
+    Allocation getAllocation() const    { return allocation; }
+    long       getMinAllocation() const { return minAllocation; }
+    void setAllocation(Allocation a, long minQty) { allocation = a; minAllocation = minQty; }
+
+    // Refresh the level-count gauges after the book has changed shape
+    void updateLevelGauges() {
+        if (!gauges) return;
+        gauges->bidLevels.store(static_cast<long>(buyOrders.size()),  std::memory_order_relaxed);
+        gauges->askLevels.store(static_cast<long>(sellOrders.size()), std::memory_order_relaxed);
+    }
+
+    // Adjust the resting-order gauge by delta (+1 on queue, -1 on fill/cancel)
+    void adjustRestingOrders(long delta) {
+        if (gauges) gauges->restingOrders.fetch_add(delta, std::memory_order_relaxed);
+    }
 };
 
 
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include "Metrics.h"
+#include "TradeFeed.h"
+#include "TradeManager.h"
+
+int64_t TradeFeed::wallClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TradeFeed::TradeFeed(size_t capacity) : ring_(capacity) {
+}
+
+TradeFeed::~TradeFeed() {
+    stop();
+}
+
+void TradeFeed::addSink(Sink sink) {
+    sinks_.push_back(std::move(sink));
+}
+
+void TradeFeed::start() {
+    if (consumer_.joinable()) return;
+    stop_.store(false);
+    consumer_ = std::thread([this] { run(); });
+}
+
+void TradeFeed::stop() {
+    if (!consumer_.joinable()) return;
+    stop_.store(true);
+    consumer_.join();
+}
+
+// ── Producer ──────────────────────────────────────────────────────────────────
+
+bool TradeFeed::publish(const Trade& trade, int64_t tsNs) {
+    TradeRecord r;
+    r.tsNs        = tsNs ? tsNs : wallClockNs();
+    r.price       = trade.price;
+    r.quantity    = trade.quantity;
+    r.buyOrderId  = trade.buyOrderId;
+    r.sellOrderId = trade.sellOrderId;
+    r.buyerId     = trade.buyer  ? trade.buyer->getId()  : 0;
+    r.sellerId    = trade.seller ? trade.seller->getId() : 0;
+    r.linkId      = trade.linkId;
+    r.leg         = static_cast<uint8_t>(trade.leg);
+    size_t n = trade.symbol.size() < sizeof(r.symbol) - 1 ? trade.symbol.size() : sizeof(r.symbol) - 1;
+    std::memcpy(r.symbol, trade.symbol.data(), n);
+    std::memset(r.symbol + n, 0, sizeof(r.symbol) - n);
+    return publish(r);
+}
+
+bool TradeFeed::publish(const TradeRecord& record) {
+    // Once a record has overflowed, later ones queue behind it until the
+    // consumer has taken the list, so fills are never delivered out of order
+    const bool pushed = !overflowing_.load(std::memory_order_acquire) && ring_.tryPush(record);
+    if (!pushed) {
+        std::lock_guard<std::mutex> lock(overflowMutex_);
+        overflow_.push_back(record);
+        overflowing_.store(true, std::memory_order_release);
+        overflowed_.fetch_add(1, std::memory_order_relaxed);
+        Metrics::increment(Counter::TRADE_FEED_OVERFLOWS);
+    }
+    published_.store(published_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return pushed;
+}
+
+// ── Consumer ──────────────────────────────────────────────────────────────────
+
+size_t TradeFeed::drainOnce(TradeRecord* batch) {
+    size_t n = ring_.popBatch(batch, BATCH);
+    if (n == 0) return drainOverflow();
+    for (auto& sink : sinks_) sink(batch, n);
+    delivered_.fetch_add(n, std::memory_order_release);
+    return n;
+}
+
+// Called with the ring empty.  While the overflow list is non-empty the
+// producer does not touch the ring, so everything in the list is newer than
+// what the ring held and older than what it will hold next.
+size_t TradeFeed::drainOverflow() {
+    if (!overflowing_.load(std::memory_order_acquire)) return 0;
+    std::vector<TradeRecord> backlog;
+    {
+        std::lock_guard<std::mutex> lock(overflowMutex_);
+        backlog.swap(overflow_);
+        overflowing_.store(false, std::memory_order_release);
+    }
+    for (size_t i = 0; i < backlog.size(); i += BATCH) {
+        size_t n = std::min(BATCH, backlog.size() - i);
+        for (auto& sink : sinks_) sink(backlog.data() + i, n);
+        delivered_.fetch_add(n, std::memory_order_release);
+    }
+    return backlog.size();
+}
+
+void TradeFeed::run() {
+    std::unique_ptr<TradeRecord[]> batch(new TradeRecord[BATCH]);
+    for (;;) {
+        if (drainOnce(batch.get())) continue;
+        if (stop_.load()) {
+            while (drainOnce(batch.get())) {}   // anything pushed since the last look
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_US));
+    }
+}
+
+void TradeFeed::flush() {
+    const uint64_t target = published_.load(std::memory_order_acquire);
+    if (!consumer_.joinable()) {
+        std::unique_ptr<TradeRecord[]> batch(new TradeRecord[BATCH]);
+        while (drainOnce(batch.get())) {}
+        return;
+    }
+    while (delivered_.load(std::memory_order_acquire) < target)
+        std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_US));
+}
@@ -0,0 +1,95 @@
+#ifndef TRADEFEED_H
+#define TRADEFEED_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+
+struct Trade;
+
+// One executed fill as it leaves the matcher: a fixed-size copy of the Trade
+// that can cross threads without allocating
+struct TradeRecord {
+    int64_t tsNs;          // wall-clock execution time
+    double  price;
+    int64_t quantity;
+    int64_t buyOrderId;
+    int64_t sellOrderId;
+    int64_t buyerId;       // Counterparty ids (see Counterparty::nameOf); 0 = none
+    int64_t sellerId;
+    int64_t linkId;        // swap execution both legs share; 0 = outright (spot) fill
+    char    symbol[16];    // NUL-padded; longer symbols are truncated
+    uint8_t leg;           // SwapLeg; NONE (0) for a spot fill
+};
+
+// ─── Trade feed ──────────────────────────────────────────────────────────────
+//
+// Carries fills from the matcher to post-trade consumers (candles, the trade
+// store, positions, ...) without ever blocking it or losing a fill.
+// TradeManager::logAndNotify copies each fill onto an SPSC ring — a bounded,
+// lock-free push.  If the ring is full the record goes to an overflow list
+// under a mutex instead, counted in ts_trade_feed_overflow_total, and so do
+// the records after it until the consumer has taken the list, so sinks still
+// see every fill in execution order.  The list only grows while the consumer
+// is behind.  A consumer thread drains the ring, then the overflow, in
+// batches and hands each batch to every sink in turn.
+//
+// publish() must not be called from two threads at once; the engine already
+// serialises all matching under one lock.
+class TradeFeed {
+public:
+    // Receives consecutive records on the consumer thread
+    using Sink = std::function<void(const TradeRecord* records, size_t count)>;
+
+    static constexpr size_t BATCH         = 256;   // records per sink call, at most
+    static constexpr int    IDLE_SLEEP_US = 500;   // consumer back-off when the ring is empty
+
+    explicit TradeFeed(size_t capacity = 65536);
+    ~TradeFeed();
+
+    TradeFeed(const TradeFeed&)            = delete;
+    TradeFeed& operator=(const TradeFeed&) = delete;
+
+    // Register before start()
+    void addSink(Sink sink);
+
+    void start();
+    void stop();   // delivers whatever is still queued, then joins
+
+    // Producer side; false if the fill took the overflow path.
+    // tsNs 0 stamps the record now.
+    bool publish(const Trade& trade, int64_t tsNs = 0);
+    bool publish(const TradeRecord& record);
+
+    // Return once every record published so far has reached the sinks.
+    // Without a running consumer the caller drains the ring itself.
+    void flush();
+
+    uint64_t overflowed() const { return overflowed_.load(std::memory_order_relaxed); }
+
+    static int64_t wallClockNs();   // the timestamp fills are stamped with
+
+private:
+    SpscRing<TradeRecord> ring_;
+    std::vector<Sink>     sinks_;
+    std::thread           consumer_;
+    std::atomic<bool>     stop_{false};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> overflowed_{0};
+
+    std::mutex               overflowMutex_;
+    std::vector<TradeRecord> overflow_;            // records behind a full ring, oldest first
+    std::atomic<bool>        overflowing_{false};  // overflow_ is non-empty: don't use the ring
+
+    void   run();
+    size_t drainOnce(TradeRecord* batch);
+    size_t drainOverflow();
+};
+
+#endif
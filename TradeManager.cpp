@@ -4,8 +4,13 @@
 #include <sstream>
 #include "Counterparty.h"
 #include "EventBus.h"
+#include "Latency.h"
+#include "MarketManager.h"
+#include "Metrics.h"
 #include "OrderBook.h"
+#include "RiskManager.h"
 #include "SubBook.h"
+#include "TradeFeed.h"
 #include "TradeManager.h"
 #include "Order.h"
 
@@ -24,6 +29,16 @@ bool TradeManager::checkForTrade(const Order& order, double marketPrice) {
     }
 }
 
+bool TradeManager::checkForTrade(const Order& order, const MarketManager& market) {
+    MarketQuote q;
+    if (!market.getQuote(order.getSymbol(), q)) return false;
+
+    double reference = order.isBuyOrder() ? q.ask : q.bid;
+    if (reference <= 0) reference = q.last;
+    if (reference <= 0) return false;
+    return checkForTrade(order, reference);
+}
+
 bool TradeManager::checkForSecuritiesTrade(const Order& order, double marketPrice) {
     if (!order.isActive()) {
         return false;
@@ -64,13 +79,32 @@ void TradeManager::logAndNotify(const Trade& trade) {
               << "  | Buy#"  << trade.buyOrderId
               << " ("  << (trade.buyer  ? trade.buyer->getName()  : "?") << ")"
               << "  Sell#" << trade.sellOrderId
-              << " ("  << (trade.seller ? trade.seller->getName() : "?") << ")"
-              << "\n";
+              << " ("  << (trade.seller ? trade.seller->getName() : "?") << ")";
+    if (trade.linkId) std::cout << "  swap#" << trade.linkId << " " << toString(trade.leg);
+    std::cout << "\n";
+
+    Metrics::increment(Counter::FILLS);
+    Metrics::increment(Counter::FILLED_QUANTITY, static_cast<uint64_t>(trade.quantity));
+
+    if (riskManager_) riskManager_->onFill(trade);
+
+    // Own fills are market data too: last price and volume.  Swap legs are
+    // not spot prints (the far leg is a forward rate), so they stay out of
+    // market data; they still go to the post-trade feed below, tagged with
+    // their linkId, so the store and positions see every fill.
+    if (marketManager_ && trade.linkId == 0) marketManager_->recordFill(trade.symbol, trade.price, trade.quantity);
 
     // Store in ring buffer (newest at back, capped at 100)
     recentTrades_.push_back(trade);
     if (recentTrades_.size() > 100) recentTrades_.pop_front();
 
+    // One stamp for the feed and both notifications, so a counterparty's
+    // retained fills and the trade store agree on execution times
+    const int64_t tsNs = TradeFeed::wallClockNs();
+
+    // Hand off to post-trade consumers: a lock-free ring push, never lost
+    if (tradeFeed_) tradeFeed_->publish(trade, tsNs);
+
     // Publish SSE event to all connected UI clients
     if (eventBus_) {
         std::ostringstream j;
@@ -82,30 +116,30 @@ void TradeManager::logAndNotify(const Trade& trade) {
           << ",\"buyOrderId\":"  << trade.buyOrderId
           << ",\"sellOrderId\":" << trade.sellOrderId
           << ",\"buyer\":\""     << (trade.buyer  ? trade.buyer->getName()  : "") << "\""
-          << ",\"seller\":\""    << (trade.seller ? trade.seller->getName() : "") << "\""
-          << "}\n\n";
-        eventBus_->publish(j.str());
-    }
-
-    if (trade.buyer) {
-        trade.buyer->onTrade({
-            trade.buyOrderId,
-            trade.price,
-            trade.quantity,
-            true,   // this side was the buyer
-            trade.seller ? trade.seller->getName() : "unknown"
-        });
+          << ",\"seller\":\""    << (trade.seller ? trade.seller->getName() : "") << "\"";
+        if (trade.linkId)
+            j << ",\"linkId\":" << trade.linkId
+              << ",\"leg\":\""  << toString(trade.leg) << "\"";
+        j << "}\n\n";
+        eventBus_->publish(j.str(), trade.ingressTicks);
     }
 
-    if (trade.seller) {
-        trade.seller->onTrade({
-            trade.sellOrderId,
-            trade.price,
-            trade.quantity,
-            false,  // this side was the seller
-            trade.buyer ? trade.buyer->getName() : "unknown"
-        });
-    }
+    if (trade.buyer)  trade.buyer->onTrade(notification(trade, true, tsNs));
+    if (trade.seller) trade.seller->onTrade(notification(trade, false, tsNs));
+}
+
+// The fill as one side sees it; the other party is referenced by id
+TradeNotification TradeManager::notification(const Trade& trade, bool buySide, int64_t tsNs) {
+    const Counterparty* other = buySide ? trade.seller : trade.buyer;
+    TradeNotification n{};
+    n.tsNs           = tsNs;
+    n.orderId        = buySide ? trade.buyOrderId : trade.sellOrderId;
+    n.price          = trade.price;
+    n.quantity       = trade.quantity;
+    n.counterpartyId = other ? other->getId() : 0;
+    n.wasBuy         = buySide;
+    trade.symbol.copy(n.symbol, sizeof(n.symbol) - 1);   // n is zeroed, so NUL-padded
+    return n;
 }
 
 // ── Matching engine ───────────────────────────────────────────────────────────
@@ -115,124 +149,566 @@ void TradeManager::logAndNotify(const Trade& trade) {
 // fills for as long as prices cross and quantity remains.
 //
 // For each fill:
-//   • A Trade record is created, logged, and counterparties are notified.
+//   • The fill is executed: for spot, one Trade is created, logged, and
+//     counterparties are notified.
 //   • The incoming order's quantity is decremented.
 //   • If the standing order is fully consumed it is erased from the price-level
 //     list, removed from the order index, and de-registered from its counterparty.
 //   • If only partially consumed, its stored quantity is reduced in-place via
 //     setQuantity(); its position in the list and its index entry remain valid.
+//   • If it is an iceberg whose displayed slice is used up, the next slice
+//     comes out of its reserve and its node is spliced to the back of the
+//     level (PriceLevel::replenish) — O(1), and its index entry still holds.
+//     The walk carries on, so one incoming order may take several slices.
 //   • If a price level becomes empty after fills, the map entry is erased.
+//   • If the standing order is the incoming order's own counterparty's and
+//     the incoming order prevents self-trades, there is no fill: the
+//     resting order, the incoming order or both are cancelled, or both are
+//     decremented (preventSelfTrade).
 //
 // std::list iterators remain valid across erasures of other nodes, so advancing
 // the iterator before erasing is safe and keeps the loop correct.
 //
-// Returns true if the incoming order was fully filled (nothing left to queue).
-
-bool TradeManager::matchSpotOrders(Order& incoming, SubBook& sb, OrderBook& book) {
-
-    if (incoming.isBuyOrder()) {
-        // ── Incoming BUY: match against standing asks (lowest price first) ────
-        AskMap& asks = sb.getSellOrdersRef();
-        auto mapIt   = asks.begin();
+// Returns true if nothing is left of the incoming order to queue: it was
+// fully filled, or cancelled by self-trade prevention.
+//
+// sweep is the walk itself; execute(standing, price, qty) reports each fill,
+// so spot and swap books share one matching loop and differ only in what a
+// fill produces.  Its Allocation parameter decides, at compile time, how
+// one level's orders share the incoming quantity (fillLevel); the book's
+// own setting picks the instantiation (allocate).
+
+// One standing order has just filled qty: reduce it, refill it (an iceberg
+// whose slice is used up) or remove it.  Returns the next order to visit.
+static PriceLevel::iterator fillStanding(PriceLevel& level, PriceLevel::iterator it, long qty,
+                                         SubBook& sb, OrderBook& book, RiskManager* risk) {
+    Order& standing = *it;
+    if (risk) risk->onRestingFill(standing, qty);
+    level.quantity -= qty;
+
+    if (qty == standing.getQuantity() && standing.getReserve() > 0) {
+        // Iceberg slice used up: the next one joins the back of the level
+        return level.replenish(it);
+    }
+    if (qty == standing.getQuantity()) {
+        // Standing order fully consumed: erase from list, index, and counterparty
+        long          standingId = standing.getId();
+        Counterparty* cp         = standing.getCounterparty();
+        it = level.erase(it);   // advance before erase
+        book.removeFromIndex(standingId);
+        sb.adjustRestingOrders(-1);
+        if (cp) cp->removeOrderId(standingId);
+        return it;
+    }
+    // Partially consumed: reduce its remaining quantity in place
+    standing.setQuantity(standing.getQuantity() - qty);
+    return std::next(it);
+}
 
-        while (mapIt != asks.end() && incoming.getQuantity() > 0) {
-            double askPrice = mapIt->first;
+// What one sweep's helpers share
+struct SweepContext {
+    SubBook&     sb;
+    OrderBook&   book;
+    RiskManager* risk;
+    long         minQty;      // the book's smallest pro-rata fill
+    long         selfId;      // incoming's counterparty id if it prevents self-trades, else -1
+    long&        prevented;   // incoming quantity cancelled or decremented instead of trading
+};
+
+// Take a standing order off the book as a cancel would, reserve and all.
+// Returns the next order to visit.
+static PriceLevel::iterator cancelStanding(PriceLevel& level, PriceLevel::iterator it, SweepContext& ctx) {
+    Order&        standing   = *it;
+    long          standingId = standing.getId();
+    Counterparty* cp         = standing.getCounterparty();
+    if (ctx.risk) ctx.risk->onCancelled(standing);
+    level.quantity -= standing.getQuantity();
+    level.reserve  -= standing.getReserve();
+    it = level.erase(it);
+    ctx.book.removeFromIndex(standingId);
+    ctx.sb.adjustRestingOrders(-1);
+    if (cp) cp->removeOrderId(standingId);
+    return it;
+}
 
-            // Stop as soon as the best available ask exceeds the bid's limit
-            if (!pricesMatch(incoming.getPrice(), askPrice)) break;
+// The standing order is the incoming order's own counterparty's and qty of
+// it would have traded: apply incoming's self-trade prevention instead.
+// Cancelling incoming zeroes it, which ends the sweep; a decrement comes off
+// the standing order as a fill would, without the trade.  Returns the next
+// order to visit.
+static PriceLevel::iterator preventSelfTrade(PriceLevel& level, PriceLevel::iterator it, long qty,
+                                             Order& incoming, SweepContext& ctx) {
+    Metrics::increment(Counter::SELF_TRADES_PREVENTED);
+    switch (incoming.getSelfTrade()) {
+        case SelfTradePrevention::CANCEL_INCOMING:
+            ctx.prevented += incoming.getQuantity();
+            incoming.setQuantity(0);
+            return it;
+        case SelfTradePrevention::CANCEL_BOTH:
+            ctx.prevented += incoming.getQuantity();
+            incoming.setQuantity(0);
+            return cancelStanding(level, it, ctx);
+        case SelfTradePrevention::DECREMENT:
+            ctx.prevented += qty;
+            incoming.setQuantity(incoming.getQuantity() - qty);
+            return fillStanding(level, it, qty, ctx.sb, ctx.book, ctx.risk);
+        case SelfTradePrevention::CANCEL_RESTING:
+        case SelfTradePrevention::NONE:   // never reached: selfId is -1
+            break;
+    }
+    return cancelStanding(level, it, ctx);
+}
 
-            std::list<Order>& level   = mapIt->second;
-            auto              orderIt = level.begin();
+// Fill incoming from one crossed level at price, as policy A shares it out.
+//
+// FIFO: orders fill in arrival order, each in full until incoming is done.
+//
+// PRO_RATA: if incoming does not clear the level, each order gets a share
+// in proportion to its displayed quantity.  Shares are rounded on the
+// running total: order i gets ⌊Q·Cᵢ/L⌋ − ⌊Q·Cᵢ₋₁/L⌋, where Cᵢ is the
+// displayed quantity up to and including it and L the level's maintained
+// aggregate, so the shares add up to exactly Q in one pass, with no
+// re-summing, and each is its exact share rounded up or down.  A share
+// below minQty is not filled but carried to the next order in the queue;
+// whatever is still carried at the end fills FIFO.
+//
+// TOP_ORDER: the level's oldest order fills first, in full, then the rest
+// is shared pro rata.
+//
+// Before each fill, the standing order's cached counterparty id is compared
+// with ctx.selfId: one integer compare, never true unless incoming prevents
+// self-trades.  A cancelled resting order's pro-rata share is carried on to
+// the orders behind it.
+template<Allocation A, typename Execute>
+static void fillLevel(PriceLevel& level, double price, Order& incoming, SweepContext& ctx, Execute& execute) {
+    auto orderIt = level.begin();
+
+    if constexpr (A != Allocation::FIFO) {
+        size_t n     = level.size();
+        long   total = 0;   // the displayed quantity the shares are taken from
+        if constexpr (A == Allocation::TOP_ORDER) {
+            const long topId = orderIt->getId();
+            const long qty   = std::min(incoming.getQuantity(), orderIt->getQuantity());
+            if (orderIt->getCounterpartyId() == ctx.selfId) {
+                orderIt = preventSelfTrade(level, orderIt, qty, incoming, ctx);
+            } else {
+                execute(*orderIt, price, qty);
+                incoming.setQuantity(incoming.getQuantity() - qty);
+                orderIt = fillStanding(level, orderIt, qty, ctx.sb, ctx.book, ctx.risk);
+            }
+            --n;   // a refilled top order has moved behind the others ...
+            if (!level.empty() && level.back().getId() == topId)
+                total -= level.back().getQuantity();   // ... and its new slice takes no share
+        }
 
-            while (orderIt != level.end() && incoming.getQuantity() > 0) {
+        total += level.quantity;   // the aggregate, not re-summed
+        const long q     = incoming.getQuantity();
+        if (q > 0 && q < total) {
+            long cumulative = 0, allotted = 0, carry = 0;
+            for (size_t i = 0; i < n && incoming.getQuantity() > 0; ++i) {
                 Order& standing = *orderIt;
-                long   fillQty  = std::min(incoming.getQuantity(), standing.getQuantity());
-
-                // Execution is at the standing order's (ask) price
-                Trade trade{
-                    incoming.getSymbol(),
-                    askPrice,
-                    fillQty,
-                    incoming.getId(),           // buyOrderId
-                    standing.getId(),           // sellOrderId
-                    incoming.getCounterparty(), // buyer
-                    standing.getCounterparty()  // seller
-                };
-                logAndNotify(trade);
-
-                incoming.setQuantity(incoming.getQuantity() - fillQty);
-
-                if (fillQty == standing.getQuantity()) {
-                    // Standing ask fully consumed: erase from list, index, and counterparty
-                    long          standingId = standing.getId();
-                    Counterparty* cp         = standing.getCounterparty();
-                    orderIt = level.erase(orderIt);   // advance before erase
-                    book.removeFromIndex(standingId);
-                    if (cp) cp->removeOrderId(standingId);
-                } else {
-                    // Standing ask partially consumed: reduce its remaining quantity
-                    standing.setQuantity(standing.getQuantity() - fillQty);
-                    ++orderIt;
+                cumulative += standing.getQuantity();
+                const long due = static_cast<long>(static_cast<__int128>(q) * cumulative / total);
+                long       qty = due - allotted + carry;
+                allotted = due;
+                carry    = 0;
+                if (qty > standing.getQuantity()) { carry = qty - standing.getQuantity(); qty = standing.getQuantity(); }
+                if (qty < ctx.minQty)             { carry += qty;                           qty = 0; }
+                if (qty == 0) { ++orderIt; continue; }
+
+                if (standing.getCounterpartyId() == ctx.selfId) {
+                    if (incoming.getSelfTrade() == SelfTradePrevention::CANCEL_RESTING) carry += qty;
+                    orderIt = preventSelfTrade(level, orderIt, qty, incoming, ctx);
+                    continue;
                 }
+                execute(standing, price, qty);
+                incoming.setQuantity(incoming.getQuantity() - qty);
+                orderIt = fillStanding(level, orderIt, qty, ctx.sb, ctx.book, ctx.risk);
             }
+            orderIt = level.begin();   // the carry, if any, fills FIFO
+        }
+    }
+
+    while (orderIt != level.end() && incoming.getQuantity() > 0) {
+        Order& standing = *orderIt;
+        long   fillQty  = std::min(incoming.getQuantity(), standing.getQuantity());
 
-            // Advance map iterator before potentially erasing the current level
-            auto nextMapIt = std::next(mapIt);
-            if (level.empty()) asks.erase(mapIt);
-            mapIt = nextMapIt;
+        if (standing.getCounterpartyId() == ctx.selfId) {
+            orderIt = preventSelfTrade(level, orderIt, fillQty, incoming, ctx);
+            continue;
         }
 
-    } else {
-        // ── Incoming SELL: match against standing bids (highest price first) ──
-        BidMap& bids = sb.getBuyOrdersRef();
-        auto    mapIt = bids.begin();
+        // Execution is at the standing order's price
+        execute(standing, price, fillQty);
+
+        incoming.setQuantity(incoming.getQuantity() - fillQty);
+        orderIt = fillStanding(level, orderIt, fillQty, ctx.sb, ctx.book, ctx.risk);
+    }
+}
+
+// Walk one side best-first, filling each level the incoming order crosses
+template<Allocation A, typename MapT, typename Execute>
+static void sweepSide(MapT& levels, Order& incoming, SweepContext& ctx, Execute& execute) {
+    const bool buy   = incoming.isBuyOrder();
+    auto       mapIt = levels.begin();
 
-        while (mapIt != bids.end() && incoming.getQuantity() > 0) {
-            double bidPrice = mapIt->first;
+    while (mapIt != levels.end() && incoming.getQuantity() > 0) {
+        const double price = mapIt->first;
 
-            // Stop as soon as the best bid falls below the ask's limit
-            if (!pricesMatch(bidPrice, incoming.getPrice())) break;
+        // Stop as soon as the best standing price is beyond the incoming limit
+        if (buy ? !TradeManager::pricesMatch(incoming.getPrice(), price)
+                : !TradeManager::pricesMatch(price, incoming.getPrice())) break;
 
-            std::list<Order>& level   = mapIt->second;
-            auto              orderIt = level.begin();
+        PriceLevel& level = mapIt->second;
+        fillLevel<A>(level, price, incoming, ctx, execute);
 
-            while (orderIt != level.end() && incoming.getQuantity() > 0) {
-                Order& standing = *orderIt;
-                long   fillQty  = std::min(incoming.getQuantity(), standing.getQuantity());
-
-                // Execution is at the standing order's (bid) price
-                Trade trade{
-                    incoming.getSymbol(),
-                    bidPrice,
-                    fillQty,
-                    standing.getId(),           // buyOrderId  (standing bid)
-                    incoming.getId(),           // sellOrderId (incoming ask)
-                    standing.getCounterparty(), // buyer
-                    incoming.getCounterparty()  // seller
-                };
-                logAndNotify(trade);
-
-                incoming.setQuantity(incoming.getQuantity() - fillQty);
-
-                if (fillQty == standing.getQuantity()) {
-                    // Standing bid fully consumed
-                    long          standingId = standing.getId();
-                    Counterparty* cp         = standing.getCounterparty();
-                    orderIt = level.erase(orderIt);
-                    book.removeFromIndex(standingId);
-                    if (cp) cp->removeOrderId(standingId);
-                } else {
-                    // Standing bid partially consumed
-                    standing.setQuantity(standing.getQuantity() - fillQty);
-                    ++orderIt;
-                }
+        // Advance map iterator before potentially erasing the current level
+        auto nextMapIt = std::next(mapIt);
+        if (level.empty()) levels.erase(mapIt);
+        mapIt = nextMapIt;
+    }
+}
+
+template<Allocation A, typename Execute>
+bool TradeManager::sweep(Order& incoming, SubBook& sb, OrderBook& book, Execute&& execute) {
+    const long   cpId     = incoming.getCounterpartyId();
+    const bool   prevents = incoming.getSelfTrade() != SelfTradePrevention::NONE && cpId != 0;
+    SweepContext ctx{ sb, book, riskManager_, sb.getMinAllocation(), prevents ? cpId : -1, selfTradePrevented_ };
+    if (incoming.isBuyOrder())
+        sweepSide<A>(sb.getSellOrdersRef(), incoming, ctx, execute);   // asks, lowest first
+    else
+        sweepSide<A>(sb.getBuyOrdersRef(), incoming, ctx, execute);    // bids, highest first
+    return incoming.getQuantity() == 0;
+}
+
+template<typename Execute>
+bool TradeManager::allocate(Order& incoming, SubBook& sb, OrderBook& book, Execute&& execute) {
+    switch (sb.getAllocation()) {
+        case Allocation::PRO_RATA:  return sweep<Allocation::PRO_RATA>(incoming, sb, book, execute);
+        case Allocation::TOP_ORDER: return sweep<Allocation::TOP_ORDER>(incoming, sb, book, execute);
+        case Allocation::FIFO:      break;
+    }
+    return sweep<Allocation::FIFO>(incoming, sb, book, execute);
+}
+
+long TradeManager::takeSelfTradePrevented() {
+    const long qty = selfTradePrevented_;
+    selfTradePrevented_ = 0;
+    return qty;
+}
+
+bool TradeManager::matchSpotOrders(Order& incoming, SubBook& sb, OrderBook& book) {
+    LATENCY_PROBE(LatencyStage::MATCH_SPOT_ORDERS);
+
+    return allocate(incoming, sb, book, [&](const Order& standing, double price, long qty) {
+        const bool   buys   = incoming.isBuyOrder();
+        const Order& buyer  = buys ? incoming : standing;
+        const Order& seller = buys ? standing : incoming;
+        logAndNotify(Trade{
+            incoming.getSymbol(),
+            price,
+            qty,
+            buyer.getId(),
+            seller.getId(),
+            buyer.getCounterparty(),
+            seller.getCounterparty(),
+            incoming.getIngressTicks()
+        });
+    });
+}
+
+// ── Swap matching ─────────────────────────────────────────────────────────────
+//
+// A swap's price is its forward points: far rate − near rate.  SWAP_BUY buys
+// the far leg — it sells the base currency on the near leg and buys it back
+// on the far leg, paying the points — so a higher bid is a better bid, as in
+// the spot book.  Each fill is executed as two Trades of the same quantity
+// with one linkId, logged back to back under the engine lock: the near leg
+// at the near rate, the far leg at near rate + points.
+
+bool TradeManager::nearRate(const std::string& symbol, double& rate) const {
+    MarketQuote q;
+    if (!marketManager_ || !marketManager_->getQuote(symbol, q)) return false;
+    rate = (q.bid > 0 && q.ask > 0) ? (q.bid + q.ask) / 2 : q.last;
+    return rate > 0;
+}
+
+bool TradeManager::matchSwapOrders(Order& incoming, SubBook& swapBook, OrderBook& book) {
+    LATENCY_PROBE(LatencyStage::MATCH_SWAP_ORDERS);
+
+    double near = 0;
+    if (!nearRate(incoming.getSymbol(), near)) return false;   // nothing can be fixed: no fills
+
+    return allocate(incoming, swapBook, book, [&](const Order& standing, double points, long qty) {
+        const bool   buys      = incoming.isBuyOrder();
+        const Order& farBuyer  = buys ? incoming : standing;   // the SWAP_BUY side
+        const Order& nearBuyer = buys ? standing : incoming;   // the SWAP_SELL side
+        const long   link      = nextLinkId_++;
+        logAndNotify(Trade{
+            incoming.getSymbol(), near, qty,
+            nearBuyer.getId(), farBuyer.getId(),
+            nearBuyer.getCounterparty(), farBuyer.getCounterparty(),
+            incoming.getIngressTicks(), link, SwapLeg::NEAR
+        });
+        logAndNotify(Trade{
+            incoming.getSymbol(), near + points, qty,
+            farBuyer.getId(), nearBuyer.getId(),
+            farBuyer.getCounterparty(), nearBuyer.getCounterparty(),
+            incoming.getIngressTicks(), link, SwapLeg::FAR
+        });
+    });
+}
+
+// ── Fill-or-kill pre-check ─────────────────────────────────────────────────────
+
+template<typename MapT>
+static bool crossedDepthCovers(const MapT& levels, bool incomingBuy, double limit, long needed,
+                               long selfId, SelfTradePrevention stp) {
+    for (const auto& [price, level] : levels) {
+        if (incomingBuy ? !TradeManager::pricesMatch(limit, price) : !TradeManager::pricesMatch(price, limit))
+            return false;
+        long available = level.quantity + level.reserve;   // icebergs refill within the sweep
+        if (selfId >= 0) {
+            // Own orders never fill incoming: CANCEL_RESTING clears them out of
+            // the way, every other mode stops or shrinks incoming on reaching
+            // one.  Any own order on a level the sweep reaches kills, even one
+            // queued behind enough depth: never a partial fill.
+            for (const Order& o : level) {
+                if (o.getCounterpartyId() != selfId) continue;
+                if (stp != SelfTradePrevention::CANCEL_RESTING) return false;
+                available -= o.getQuantity() + o.getReserve();
             }
+        }
+        needed -= available;
+        if (needed <= 0) return true;
+    }
+    return false;
+}
+
+bool TradeManager::canFill(const Order& incoming, const SubBook& sb) {
+    const SelfTradePrevention stp    = incoming.getSelfTrade();
+    const long                cpId   = incoming.getCounterpartyId();
+    const long                selfId = stp != SelfTradePrevention::NONE && cpId != 0 ? cpId : -1;   // as the sweep
+    return incoming.isBuyOrder()
+        ? crossedDepthCovers(sb.getSellOrders(), true,  incoming.getPrice(), incoming.getQuantity(), selfId, stp)
+        : crossedDepthCovers(sb.getBuyOrders(),  false, incoming.getPrice(), incoming.getQuantity(), selfId, stp);
+}
 
-            auto nextMapIt = std::next(mapIt);
-            if (level.empty()) bids.erase(mapIt);
-            mapIt = nextMapIt;
+// ── Market-triggered fills ────────────────────────────────────────────────────
+//
+// Both maps are sorted best-first, so the orders an external price crosses are
+// always a prefix of their side: the walk ends at the first level that does not
+// cross, or when the market's displayed size is used up.  Each fill goes
+// through fillStanding, as in the sweep.
+
+template<typename MapT>
+int TradeManager::fillCrossedLevels(MapT& levels, bool restingBuys, const std::string& symbol,
+                                    double marketPrice, long available, SubBook& sb,
+                                    OrderBook& book, uint64_t ingressTicks) {
+    int  fills = 0;
+    auto mapIt = levels.begin();
+
+    while (mapIt != levels.end() && available > 0) {
+        // Levels are best-first: once one is not crossed, none beyond it are
+        double levelPrice = mapIt->first;
+        if (restingBuys ? !pricesMatch(levelPrice, marketPrice) : !pricesMatch(marketPrice, levelPrice))
+            break;
+
+        PriceLevel& level   = mapIt->second;
+        auto        orderIt = level.begin();
+        while (orderIt != level.end() && available > 0) {
+            Order& resting = *orderIt;
+            if (!checkForTrade(resting, marketPrice)) { ++orderIt; continue; }
+            long fillQty = std::min(available, resting.getQuantity());
+
+            Trade trade{
+                symbol,
+                marketPrice,
+                fillQty,
+                restingBuys ? resting.getId() : 0,             // buyOrderId  (0 = external)
+                restingBuys ? 0 : resting.getId(),             // sellOrderId
+                restingBuys ? resting.getCounterparty() : &marketCp_,
+                restingBuys ? &marketCp_ : resting.getCounterparty(),
+                ingressTicks
+            };
+            logAndNotify(trade);
+            Metrics::increment(Counter::MARKET_TRIGGERED_FILLS);
+            available -= fillQty;
+            ++fills;
+            orderIt = fillStanding(level, orderIt, fillQty, sb, book, riskManager_);
         }
+
+        auto nextMapIt = std::next(mapIt);
+        if (level.empty()) levels.erase(mapIt);
+        mapIt = nextMapIt;
     }
+    return fills;
+}
 
-    return incoming.getQuantity() == 0;
+int TradeManager::matchAgainstMarket(const std::string& symbol, const MarketQuote& quote,
+                                     SubBook& sb, OrderBook& book, uint64_t ingressTicks) {
+    // Resting buys trade with the market's offer, resting sells with its bid
+    double askPrice = quote.ask > 0 ? quote.ask    : quote.last;
+    long   askSize  = quote.ask > 0 ? quote.askQty : quote.lastQty;
+    double bidPrice = quote.bid > 0 ? quote.bid    : quote.last;
+    long   bidSize  = quote.bid > 0 ? quote.bidQty : quote.lastQty;
+
+    int fills = 0;
+    if (askPrice > 0)
+        fills += fillCrossedLevels(sb.getBuyOrdersRef(), true, symbol, askPrice, askSize,
+                                   sb, book, ingressTicks);
+    if (bidPrice > 0)
+        fills += fillCrossedLevels(sb.getSellOrdersRef(), false, symbol, bidPrice, bidSize,
+                                   sb, book, ingressTicks);
+    return fills;
+}
+
+// ── Batch auctions ────────────────────────────────────────────────────────────
+//
+// In an auction book orders rest without matching, so the book may cross.
+// Only prices from the best ask up to the best bid can trade.  Walking them
+// in ascending order, supply (asks at or below p) only grows and demand
+// (bids at or above p) only shrinks, so both cumulative curves come out of
+// one merge of the two ladders: each level is added to (or taken from) a
+// running total once.  The executable volume min(supply, demand) therefore
+// rises to a plateau and falls, and its ties are one contiguous run of
+// prices.  Among them the smallest |demand − supply| wins; if that still
+// ties, a surplus of bids takes the highest such price, a surplus of asks
+// the lowest, and otherwise the price midway between the two sides.
+
+namespace {
+struct CurvePoint {
+    double price  = 0;
+    long   supply = 0;   // asks at or below price
+    long   demand = 0;   // bids at or above price
+    long surplus() const { return demand - supply; }
+};
+}
+
+AuctionResult TradeManager::uncrossPrice(const SubBook& sb) {
+    const BidMap& bids = sb.getBuyOrders();
+    const AskMap& asks = sb.getSellOrders();
+    if (bids.empty() || asks.empty() || !pricesMatch(bids.begin()->first, asks.begin()->first)) return {};
+    const double highBid = bids.begin()->first;
+
+    // Demand at the best ask: every bid that can trade at all
+    auto bidEnd = bids.upper_bound(asks.begin()->first);   // first bid below the best ask
+    long demand = 0;
+    for (auto b = bids.begin(); b != bidEnd; ++b) demand += b->second.quantity + b->second.reserve;
+
+    auto a      = asks.begin();
+    auto b      = std::make_reverse_iterator(bidEnd);   // lowest bid that can trade
+    long supply = 0;
+    long volume = 0;
+    CurvePoint lo, hi, lastBid, firstAsk;   // the tied run, and where its surplus changes side
+
+    while (true) {
+        const bool askLeft = a != asks.end() && a->first <= highBid;
+        const bool bidLeft = b != bids.rend();
+        if (!askLeft && !bidLeft) break;
+        const double p = !bidLeft ? a->first : !askLeft ? b->first : std::min(a->first, b->first);
+
+        if (askLeft && a->first == p) { supply += a->second.quantity + a->second.reserve; ++a; }
+        const CurvePoint pt{ p, supply, demand };
+        const long       v = std::min(supply, demand);
+        if (v > volume || (v == volume && std::labs(pt.surplus()) < std::labs(lo.surplus()))) {
+            volume = v;
+            lo = hi = pt;
+            lastBid = firstAsk = CurvePoint{};
+            if (pt.surplus() > 0) lastBid  = pt;
+            if (pt.surplus() < 0) firstAsk = pt;
+        } else if (v == volume && std::labs(pt.surplus()) == std::labs(lo.surplus())) {
+            hi = pt;
+            if (pt.surplus() > 0)                          lastBid  = pt;
+            if (pt.surplus() < 0 && firstAsk.price == 0)   firstAsk = pt;
+        }
+        if (bidLeft && b->first == p) { demand -= b->second.quantity + b->second.reserve; ++b; }
+    }
+    if (volume == 0) return {};
+
+    if (lo.surplus() > 0 && hi.surplus() > 0) return { hi.price, volume, hi.surplus() };
+    if (lo.surplus() < 0 && hi.surplus() < 0) return { lo.price, volume, lo.surplus() };
+    if (lo.surplus() == 0)                    return { (lo.price + hi.price) / 2, volume, 0 };
+
+    // Bids left over below the midpoint, asks above it: no level lies between
+    // the two, so supply there is lastBid's and demand firstAsk's
+    return { (lastBid.price + firstAsk.price) / 2, volume, firstAsk.demand - lastBid.supply };
+}
+
+// Take qty off the first order of a side's best level; the level goes once
+// it is empty
+template<typename MapT>
+static void fillFront(MapT& levels, long qty, SubBook& sb, OrderBook& book, RiskManager* risk) {
+    auto        levelIt = levels.begin();
+    PriceLevel& level   = levelIt->second;
+    fillStanding(level, level.begin(), qty, sb, book, risk);
+    if (level.empty()) levels.erase(levelIt);
+}
+
+// Cancel the first order of a side's best level, as a cancel would; the
+// level goes once it is empty
+template<typename MapT>
+static void cancelFront(MapT& levels, SweepContext& ctx) {
+    auto        levelIt = levels.begin();
+    PriceLevel& level   = levelIt->second;
+    cancelStanding(level, level.begin(), ctx);
+    if (level.empty()) levels.erase(levelIt);
+}
+
+long TradeManager::uncross(const std::string& symbol, const AuctionResult& auction, SubBook& sb,
+                           OrderBook& book, uint64_t ingressTicks) {
+    BidMap& bids   = sb.getBuyOrdersRef();
+    AskMap& asks   = sb.getSellOrdersRef();
+    long    left   = auction.volume;
+    long    traded = 0;
+    long    unused = 0;
+    SweepContext ctx{ sb, book, riskManager_, 1, -1, unused };   // for cancelStanding only
+
+    while (left > 0 && !bids.empty() && !asks.empty()) {
+        if (bids.begin()->first < auction.price || asks.begin()->first > auction.price) break;
+        const Order& buy  = bids.begin()->second.front();
+        const Order& sell = asks.begin()->second.front();
+        const long   qty  = std::min({ left, buy.getQuantity(), sell.getQuantity() });
+
+        // One counterparty on both sides: the later order of the two plays
+        // the incoming role and its mode applies, as it would have on arrival
+        // in continuous matching.  Each pass removes or shrinks a front order.
+        const SelfTradePrevention stp = buy.getCounterpartyId() != 0 && buy.getCounterpartyId() == sell.getCounterpartyId()
+                                      ? (buy.getId() > sell.getId() ? buy : sell).getSelfTrade()
+                                      : SelfTradePrevention::NONE;
+        if (stp != SelfTradePrevention::NONE) {
+            Metrics::increment(Counter::SELF_TRADES_PREVENTED);
+            const bool buyLater = buy.getId() > sell.getId();
+            switch (stp) {
+                case SelfTradePrevention::CANCEL_RESTING:
+                    if (buyLater) cancelFront(asks, ctx); else cancelFront(bids, ctx);
+                    break;
+                case SelfTradePrevention::CANCEL_INCOMING:
+                    if (buyLater) cancelFront(bids, ctx); else cancelFront(asks, ctx);
+                    break;
+                case SelfTradePrevention::CANCEL_BOTH:
+                    cancelFront(bids, ctx);
+                    cancelFront(asks, ctx);
+                    break;
+                case SelfTradePrevention::DECREMENT:
+                case SelfTradePrevention::NONE:   // not reached
+                    fillFront(bids, qty, sb, book, riskManager_);
+                    fillFront(asks, qty, sb, book, riskManager_);
+                    break;
+            }
+            continue;
+        }
+
+        logAndNotify(Trade{
+            symbol, auction.price, qty,
+            buy.getId(), sell.getId(),
+            buy.getCounterparty(), sell.getCounterparty(),
+            ingressTicks
+        });
+        left   -= qty;
+        traded += qty;
+        fillFront(bids, qty, sb, book, riskManager_);
+        fillFront(asks, qty, sb, book, riskManager_);
+    }
+    return traded;
 }
@@ -1,16 +1,38 @@
 #ifndef TRADEMANAGER_H
 #define TRADEMANAGER_H
 
+#include <cstdint>
 #include <deque>
 #include <string>
 #include "Counterparty.h"
 #include "Order.h"
 
-class EventBus;  // forward declaration — TradeManager holds a non-owning pointer
+class EventBus;       // forward declarations — TradeManager holds non-owning pointers
+class MarketManager;
+class RiskManager;
+class TradeFeed;
+struct MarketQuote;
 
 class SubBook;   // forward declarations — full types only needed in TradeManager.cpp
 class OrderBook;
 
+// Which leg of a swap a fill is; NONE for an outright (spot) fill
+enum class SwapLeg
+{
+    NONE = 0,
+    NEAR = 1,
+    FAR  = 2,
+};
+
+inline const char* toString(SwapLeg leg) {
+    switch (leg) {
+        case SwapLeg::NONE: return "NONE";
+        case SwapLeg::NEAR: return "NEAR";
+        case SwapLeg::FAR:  return "FAR";
+    }
+    return "UNKNOWN";
+}
+
 // Represents a single executed fill between a buyer and a seller
 struct Trade {
     std::string   symbol;
@@ -20,21 +42,58 @@ struct Trade {
     long          sellOrderId;
     Counterparty* buyer;        // non-owning pointer; may be nullptr
     Counterparty* seller;       // non-owning pointer; may be nullptr
+    uint64_t      ingressTicks; // aggressor's ingress timestamp, carried to the SSE event
+    long          linkId = 0;   // shared by the two legs of one swap execution; 0 = outright
+    SwapLeg       leg    = SwapLeg::NONE;
+};
+
+// The price a batch auction uncrosses a book at, and what trades there
+struct AuctionResult {
+    double price   = 0;   // uncrossing price; 0 = the book does not cross
+    long   volume  = 0;   // executable quantity at price: min(bids at or above, asks at or below)
+    long   surplus = 0;   // bid minus ask quantity at price; the side left over when positive (bids) or negative (asks)
 };
 
 class TradeManager
 {
     EventBus*         eventBus_{nullptr};
+    MarketManager*    marketManager_{nullptr};   // receives every fill as a trade tick
+    TradeFeed*        tradeFeed_{nullptr};       // post-trade consumers (candles); never blocks
+    RiskManager*      riskManager_{nullptr};     // kept current on every resting fill and trade
     std::deque<Trade> recentTrades_;   // capped at 100; newest at back
+    Counterparty      marketCp_{"MARKET"};   // other side of fills against the external market
+    long              nextLinkId_{1};        // next swap execution's linkId
+    long              selfTradePrevented_{0};   // incoming quantity withheld by self-trade prevention
+
+    template<Allocation A, typename Execute>
+    bool sweep(Order& incoming, SubBook& sb, OrderBook& book, Execute&& execute);
+
+    // sweep with the book's allocation policy
+    template<typename Execute>
+    bool allocate(Order& incoming, SubBook& sb, OrderBook& book, Execute&& execute);
+
+    template<typename MapT>
+    int fillCrossedLevels(MapT& levels, bool restingBuys, const std::string& symbol,
+                          double marketPrice, long available, SubBook& sb, OrderBook& book,
+                          uint64_t ingressTicks);
 
 public:
     TradeManager();
     ~TradeManager();
 
     void setEventBus(EventBus* bus) { eventBus_ = bus; }
+    void setMarketManager(MarketManager* market) { marketManager_ = market; }
+    void setTradeFeed(TradeFeed* feed) { tradeFeed_ = feed; }
+    void setRiskManager(RiskManager* risk) { riskManager_ = risk; }
     const std::deque<Trade>& getRecentTrades() const { return recentTrades_; }
+    const Counterparty&      getMarketCounterparty() const { return marketCp_; }
 
     bool checkForTrade(const Order& order, double marketPrice);
+
+    // Same check against the live market: buys test the best ask and sells
+    // the best bid, falling back to the last trade price.  False if the
+    // symbol has no market data.
+    bool checkForTrade(const Order& order, const MarketManager& market);
     bool checkForSecuritiesTrade(const Order& order, double marketPrice);
     bool checkForSpotTrade(const Order& order, double marketPrice);
 
@@ -43,12 +102,62 @@ public:
 
     // Logs the fill to stdout and delivers a TradeNotification to each counterparty
     void logAndNotify(const Trade& trade);
+    static TradeNotification notification(const Trade& trade, bool buySide, int64_t tsNs);
 
     // Match an incoming SPOT order against the standing orders on the opposite side.
     // Fills are executed in-place: standing orders are modified or removed from the
     // book as they are consumed, and incoming.quantity is decremented for each fill.
     // Returns true if the incoming order was fully filled (caller should not queue it).
+    // A standing order of incoming's own counterparty is handled by incoming's
+    // SelfTradePrevention mode instead of traded (see takeSelfTradePrevented).
     bool matchSpotOrders(Order& incoming, SubBook& sb, OrderBook& book);
+
+    // Match an incoming SWAP order against the pair's swap book, priced in
+    // forward points.  Each fill executes both legs atomically as two linked
+    // Trades (same linkId and quantity): NEAR at the near rate, FAR at near
+    // rate + points.  SWAP_BUY sells near and buys far.  Returns false with
+    // no fills if the pair has no near rate (see nearRate).
+    bool matchSwapOrders(Order& incoming, SubBook& swapBook, OrderBook& book);
+
+    // Incoming quantity cancelled or decremented by self-trade prevention
+    // since the last call, rather than filled; resets the total.
+    long takeSelfTradePrevented();
+
+    // The rate a swap's near leg is fixed at: the pair's quote mid, else its
+    // last trade.  False if the market has neither.
+    bool nearRate(const std::string& symbol, double& rate) const;
+
+    // True if the opposite side holds at least incoming's quantity at prices
+    // it crosses.  Reads one aggregate per crossed level and changes nothing,
+    // so fill-or-kill is decided before any fill (no fill-then-roll-back).
+    // With self-trade prevention on it walks the crossed levels' orders:
+    // own depth never counts, and outside CANCEL_RESTING an own order the
+    // sweep would reach means no.
+    static bool canFill(const Order& incoming, const SubBook& sb);
+
+    // Fill the resting orders that the external market now crosses.  Resting
+    // buys lift the market ask up to its displayed size and resting sells hit
+    // the bid; a side with no quote falls back to the last trade price and
+    // size.  Fills execute at the market price against the MARKET
+    // counterparty.  Each side is walked from its best price and stops at the
+    // first level the market does not cross, so only the crossed range is
+    // touched; checkForTrade screens each order in it.  Returns the fill count.
+    int matchAgainstMarket(const std::string& symbol, const MarketQuote& quote,
+                           SubBook& sb, OrderBook& book, uint64_t ingressTicks);
+
+    // The batch-auction uncrossing price of a book whose orders have been
+    // left to cross: the price that executes the most quantity, then leaves
+    // the smallest imbalance.  Reads one cumulative total per level of the
+    // crossed range, in one ascending pass, and changes nothing.
+    static AuctionResult uncrossPrice(const SubBook& sb);
+
+    // Execute an auction: every fill is at auction.price, bids best first
+    // against asks best first, FIFO within a level, until auction.volume has
+    // traded.  A front bid and ask of one counterparty do not trade if the
+    // later of the two prevents self-trades: its mode applies, with it as the
+    // incoming order.  Returns the quantity traded.
+    long uncross(const std::string& symbol, const AuctionResult& auction, SubBook& sb, OrderBook& book,
+                 uint64_t ingressTicks);
 };
 
 #endif
@@ -0,0 +1,367 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include "Counterparty.h"
+#include "TradeStore.h"
+
+static const char* const COLUMN_FILES[] = {
+    "ts.col", "symbol.col", "price.col", "quantity.col",
+    "buy_order.col", "sell_order.col", "buyer.col", "seller.col",
+    "link.col", "leg.col"
+};
+static const size_t COLUMN_SIZES[] = {
+    sizeof(int64_t), sizeof(uint32_t), sizeof(int64_t), sizeof(int64_t),
+    sizeof(int64_t), sizeof(int64_t), sizeof(uint32_t), sizeof(uint32_t),
+    sizeof(int64_t), sizeof(uint8_t)
+};
+
+static const char* const SYMBOL_DICT       = "symbols.dict";
+static const char* const COUNTERPARTY_DICT = "counterparties.dict";
+
+TradeStore::~TradeStore() {
+    close();
+}
+
+// ── Files ─────────────────────────────────────────────────────────────────────
+
+bool TradeStore::open(const std::string& dir) {
+    close();
+    if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+        std::cerr << "Trade store: cannot create " << dir << std::endl;
+        return false;
+    }
+    dir_ = dir;
+
+    // Row count first: it says how much of each column is valid
+    metaFd_ = ::open((dir + "/rows").c_str(), O_RDWR | O_CREAT, 0644);
+    if (metaFd_ < 0 || ftruncate(metaFd_, sizeof(uint64_t)) < 0) {
+        std::cerr << "Trade store: cannot open " << dir << "/rows" << std::endl;
+        close();
+        return false;
+    }
+    void* p = mmap(nullptr, sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, metaFd_, 0);
+    if (p == MAP_FAILED) {
+        close();
+        return false;
+    }
+    rows_ = static_cast<uint64_t*>(p);
+
+    size_t onDisk = SIZE_MAX;
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        Column& col  = cols_[c];
+        col.elemSize = COLUMN_SIZES[c];
+        col.fd       = ::open((dir + "/" + COLUMN_FILES[c]).c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat st{};
+        if (col.fd < 0 || fstat(col.fd, &st) < 0) {
+            std::cerr << "Trade store: cannot open " << dir << "/" << COLUMN_FILES[c] << std::endl;
+            close();
+            return false;
+        }
+        // A later column missing from an older store is zero-filled by grow()
+        if (c < LINK) onDisk = std::min(onDisk, static_cast<size_t>(st.st_size) / col.elemSize);
+    }
+    // Columns are extended before the row count moves, so this only trips on
+    // a store damaged outside the engine
+    if (*rows_ > onDisk) {
+        std::cerr << "Trade store: " << dir << " is truncated; keeping " << onDisk << " rows" << std::endl;
+        *rows_ = onDisk;
+    }
+    if (!grow(std::max(onDisk, INITIAL_ROWS))) {
+        close();
+        return false;
+    }
+
+    // Dictionaries: one name per line, in id order
+    auto loadDict = [&dir](const char* file, std::vector<std::string>& names,
+                           std::unordered_map<std::string, uint32_t>& ids) {
+        std::ifstream in(dir + "/" + file);
+        std::string   name;
+        while (std::getline(in, name)) {
+            ids.emplace(name, static_cast<uint32_t>(names.size()));
+            names.push_back(name);
+        }
+    };
+    counterparties_.push_back("");
+    counterpartyIds_.emplace("", 0);
+    loadDict(SYMBOL_DICT, symbols_, symbolIds_);
+    loadDict(COUNTERPARTY_DICT, counterparties_, counterpartyIds_);
+
+    extendIndex(0, static_cast<size_t>(*rows_));
+    return true;
+}
+
+void TradeStore::close() {
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    for (Column& c : cols_) {
+        if (c.base) munmap(c.base, capacity_ * c.elemSize);
+        if (c.fd >= 0) ::close(c.fd);
+        c = Column{};
+    }
+    if (rows_) munmap(rows_, sizeof(uint64_t));
+    if (metaFd_ >= 0) ::close(metaFd_);
+    rows_     = nullptr;
+    metaFd_   = -1;
+    capacity_ = 0;
+    blocks_.clear();
+    ordered_ = true;
+    symbols_.clear();
+    symbolIds_.clear();
+    counterparties_.clear();
+    counterpartyIds_.clear();
+    engineCpIds_.clear();
+}
+
+bool TradeStore::mapColumn(Column& c, size_t rows) {
+    size_t length = rows * c.elemSize;
+    if (ftruncate(c.fd, static_cast<off_t>(length)) < 0) return false;
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, c.fd, 0);
+    if (p == MAP_FAILED) return false;
+    if (c.base) munmap(c.base, capacity_ * c.elemSize);
+    c.base = static_cast<char*>(p);
+    return true;
+}
+
+// Caller holds mu_ exclusively (or is open())
+bool TradeStore::grow(size_t rows) {
+    if (rows <= capacity_) return true;
+    size_t newCapacity = capacity_ ? capacity_ : INITIAL_ROWS;
+    while (newCapacity < rows) newCapacity *= 2;
+    for (Column& c : cols_) {
+        if (!mapColumn(c, newCapacity)) {
+            std::cerr << "Trade store: cannot grow " << dir_ << " to " << newCapacity << " rows" << std::endl;
+            return false;
+        }
+    }
+    capacity_ = newCapacity;
+    return true;
+}
+
+uint32_t TradeStore::intern(std::vector<std::string>& names, std::unordered_map<std::string, uint32_t>& ids,
+                            const std::string& name, const char* dictFile) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    ids.emplace(name, id);
+    std::ofstream out(dir_ + "/" + dictFile, std::ios::app);
+    out << name << '\n';
+    return id;
+}
+
+uint32_t TradeStore::counterpartyId(int64_t engineId) {
+    if (engineId == 0) return 0;
+    auto it = engineCpIds_.find(engineId);
+    if (it != engineCpIds_.end()) return it->second;
+    uint32_t id = intern(counterparties_, counterpartyIds_, Counterparty::nameOf(engineId), COUNTERPARTY_DICT);
+    engineCpIds_.emplace(engineId, id);
+    return id;
+}
+
+// ── Block index ───────────────────────────────────────────────────────────────
+
+void TradeStore::extendIndex(size_t fromRow, size_t toRow) {
+    const int64_t*  ts  = col<int64_t>(TS);
+    const uint32_t* sym = col<uint32_t>(SYM);
+    for (size_t r = fromRow; r < toRow; ++r) {
+        size_t b = r / BLOCK_ROWS;
+        if (b == blocks_.size())
+            blocks_.push_back(Block{ ts[r], ts[r], sym[r], sym[r], 0 });
+        Block& blk  = blocks_[b];
+        blk.minTs   = std::min(blk.minTs, ts[r]);
+        blk.maxTs   = std::max(blk.maxTs, ts[r]);
+        blk.minSym  = std::min(blk.minSym, sym[r]);
+        blk.maxSym  = std::max(blk.maxSym, sym[r]);
+        blk.symMask |= uint64_t{1} << (sym[r] % 64);
+        if (b > 0 && blk.minTs < blocks_[b - 1].maxTs) ordered_ = false;
+    }
+}
+
+std::pair<size_t, size_t> TradeStore::blockRange(int64_t fromNs, int64_t toNs) const {
+    if (!ordered_) return { 0, blocks_.size() };
+    // Ordered blocks: both bounds are monotonic, so binary search
+    auto lo = std::partition_point(blocks_.begin(), blocks_.end(),
+                                   [fromNs](const Block& b) { return b.maxTs < fromNs; });
+    auto hi = std::partition_point(lo, blocks_.end(),
+                                   [toNs](const Block& b) { return b.minTs <= toNs; });
+    return { static_cast<size_t>(lo - blocks_.begin()), static_cast<size_t>(hi - blocks_.begin()) };
+}
+
+// ── Append ────────────────────────────────────────────────────────────────────
+
+void TradeStore::onTrades(const TradeRecord* records, size_t count) {
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    if (!rows_) return;
+    const size_t start = static_cast<size_t>(*rows_);
+    if (!grow(start + count)) return;   // disk full: the batch is lost, the store stays consistent
+
+    int64_t*  ts     = col<int64_t>(TS);
+    uint32_t* sym    = col<uint32_t>(SYM);
+    int64_t*  price  = col<int64_t>(PRICE);
+    int64_t*  qty    = col<int64_t>(QTY);
+    int64_t*  buy    = col<int64_t>(BUY_ORDER);
+    int64_t*  sell   = col<int64_t>(SELL_ORDER);
+    uint32_t* buyer  = col<uint32_t>(BUYER);
+    uint32_t* seller = col<uint32_t>(SELLER);
+    int64_t*  link   = col<int64_t>(LINK);
+    uint8_t*  leg    = col<uint8_t>(LEG);
+
+    for (size_t i = 0; i < count; ++i) {
+        const TradeRecord& r   = records[i];
+        const size_t       row = start + i;
+        ts[row]     = r.tsNs;
+        sym[row]    = intern(symbols_, symbolIds_,
+                             std::string(r.symbol, strnlen(r.symbol, sizeof(r.symbol))), SYMBOL_DICT);
+        price[row]  = std::llround(r.price * static_cast<double>(PRICE_SCALE));
+        qty[row]    = r.quantity;
+        buy[row]    = r.buyOrderId;
+        sell[row]   = r.sellOrderId;
+        buyer[row]  = counterpartyId(r.buyerId);
+        seller[row] = counterpartyId(r.sellerId);
+        link[row]   = r.linkId;
+        leg[row]    = r.leg;
+    }
+    extendIndex(start, start + count);
+    *rows_ = start + count;   // publish the rows only once they are complete
+}
+
+// ── Queries ───────────────────────────────────────────────────────────────────
+
+size_t TradeStore::size() const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    return rows_ ? static_cast<size_t>(*rows_) : 0;
+}
+
+template<typename F>
+void TradeStore::scanBackward(const TradeQuery& q, F&& f) const {
+    const bool anySymbol = q.symbol.empty();
+    uint32_t   symId     = 0;
+    if (!anySymbol) {
+        auto it = symbolIds_.find(q.symbol);
+        if (it == symbolIds_.end()) return;
+        symId = it->second;
+    }
+    const bool anyCp = q.counterparty.empty();
+    uint32_t   cpId  = 0;
+    if (!anyCp) {
+        auto it = counterpartyIds_.find(q.counterparty);
+        if (it == counterpartyIds_.end()) return;
+        cpId = it->second;
+    }
+    const uint64_t  bit    = uint64_t{1} << (symId % 64);
+    const size_t    rows   = static_cast<size_t>(*rows_);
+    const int64_t*  ts     = col<int64_t>(TS);
+    const uint32_t* sym    = col<uint32_t>(SYM);
+    const uint32_t* buyer  = col<uint32_t>(BUYER);
+    const uint32_t* seller = col<uint32_t>(SELLER);
+
+    const auto [lo, hi] = blockRange(q.fromNs, q.toNs);
+    for (size_t b = hi; b-- > lo;) {
+        const Block& blk = blocks_[b];
+        if (blk.maxTs < q.fromNs || blk.minTs > q.toNs) continue;
+        if (!anySymbol && (symId < blk.minSym || symId > blk.maxSym || !(blk.symMask & bit))) continue;
+
+        const size_t first = b * BLOCK_ROWS;
+        for (size_t r = std::min(first + BLOCK_ROWS, rows); r-- > first;) {
+            if (ts[r] < q.fromNs || ts[r] > q.toNs) continue;
+            if (!anySymbol && sym[r] != symId) continue;
+            if (!anyCp && buyer[r] != cpId && seller[r] != cpId) continue;
+            if (!f(r)) return;
+        }
+    }
+}
+
+std::vector<StoredTrade> TradeStore::query(const TradeQuery& q) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    std::vector<StoredTrade> out;
+    if (!rows_ || q.limit == 0) return out;
+
+    std::vector<size_t> hits;
+    size_t              skip = q.skipAtTo;
+    const int64_t*      ts   = col<int64_t>(TS);
+    scanBackward(q, [&](size_t r) {
+        if (skip > 0 && ts[r] == q.toNs) { --skip; return true; }
+        hits.push_back(r);
+        return hits.size() < q.limit;
+    });
+
+    out.reserve(hits.size());
+    for (auto it = hits.rbegin(); it != hits.rend(); ++it) {
+        const size_t r = *it;
+        out.push_back(StoredTrade{
+            col<int64_t>(TS)[r],
+            symbols_[col<uint32_t>(SYM)[r]],
+            static_cast<double>(col<int64_t>(PRICE)[r]) / static_cast<double>(PRICE_SCALE),
+            static_cast<long>(col<int64_t>(QTY)[r]),
+            static_cast<long>(col<int64_t>(BUY_ORDER)[r]),
+            static_cast<long>(col<int64_t>(SELL_ORDER)[r]),
+            counterparties_[col<uint32_t>(BUYER)[r]],
+            counterparties_[col<uint32_t>(SELLER)[r]],
+            static_cast<long>(col<int64_t>(LINK)[r]),
+            col<uint8_t>(LEG)[r],
+        });
+    }
+    return out;
+}
+
+size_t TradeStore::count(const TradeQuery& q) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    if (!rows_) return 0;
+
+    const bool anySymbol = q.symbol.empty();
+    uint32_t   symId     = 0;
+    if (!anySymbol) {
+        auto it = symbolIds_.find(q.symbol);
+        if (it == symbolIds_.end()) return 0;
+        symId = it->second;
+    }
+    const bool anyCp = q.counterparty.empty();
+    uint32_t   cpId  = 0;
+    if (!anyCp) {
+        auto it = counterpartyIds_.find(q.counterparty);
+        if (it == counterpartyIds_.end()) return 0;
+        cpId = it->second;
+    }
+    const uint64_t  bit    = uint64_t{1} << (symId % 64);
+    const size_t    rows   = static_cast<size_t>(*rows_);
+    const int64_t*  ts     = col<int64_t>(TS);
+    const uint32_t* sym    = col<uint32_t>(SYM);
+    const uint32_t* buyer  = col<uint32_t>(BUYER);
+    const uint32_t* seller = col<uint32_t>(SELLER);
+
+    size_t matches = 0;
+    const auto [lo, hi] = blockRange(q.fromNs, q.toNs);
+    for (size_t b = lo; b < hi; ++b) {
+        const Block& blk = blocks_[b];
+        if (blk.maxTs < q.fromNs || blk.minTs > q.toNs) continue;
+        if (!anySymbol && (symId < blk.minSym || symId > blk.maxSym || !(blk.symMask & bit))) continue;
+
+        const size_t first  = b * BLOCK_ROWS;
+        const size_t last   = std::min(first + BLOCK_ROWS, rows);
+        const bool   inTime = blk.minTs >= q.fromNs && blk.maxTs <= q.toNs;
+        if (inTime && anyCp && (anySymbol || (blk.minSym == symId && blk.maxSym == symId))) {
+            matches += last - first;   // the summary alone answers it
+            continue;
+        }
+        // Branch-free so the compiler can vectorise the column scan; the
+        // counterparty columns are only read when filtering on them
+        size_t n = 0;
+        if (anyCp) {
+            for (size_t r = first; r < last; ++r)
+                n += static_cast<size_t>((ts[r] >= q.fromNs) & (ts[r] <= q.toNs) & (anySymbol | (sym[r] == symId)));
+        } else {
+            for (size_t r = first; r < last; ++r)
+                n += static_cast<size_t>((ts[r] >= q.fromNs) & (ts[r] <= q.toNs) & (anySymbol | (sym[r] == symId)) &
+                                         ((buyer[r] == cpId) | (seller[r] == cpId)));
+        }
+        matches += n;
+    }
+    return matches;
+}
@@ -0,0 +1,149 @@
+#ifndef TRADESTORE_H
+#define TRADESTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "TradeFeed.h"
+
+// One fill read back from the store
+struct StoredTrade {
+    int64_t     tsNs;
+    std::string symbol;
+    double      price;
+    long        quantity;
+    long        buyOrderId;
+    long        sellOrderId;
+    std::string buyer;    // "" if the fill had no counterparty on that side
+    std::string seller;
+    long        linkId;   // swap execution both legs share; 0 = spot fill
+    uint8_t     leg;      // SwapLeg; NONE (0) for a spot fill
+};
+
+// Filter for TradeStore::query / count.  Bounds are inclusive.
+struct TradeQuery {
+    std::string symbol;                                           // "" = every symbol
+    std::string counterparty;                                     // "" = any; else buyer or seller
+    int64_t     fromNs   = std::numeric_limits<int64_t>::min();
+    int64_t     toNs     = std::numeric_limits<int64_t>::max();
+    size_t      limit    = 100;                                   // query() only
+    size_t      skipAtTo = 0;                                     // query() only: newest matches at toNs passed over
+};
+
+// ─── Trade history store ─────────────────────────────────────────────────────
+//
+// Append-only, on-disk history of the fills the trade feed delivers — all of
+// them, swap legs included, since the feed never drops a record; only a
+// batch that cannot be written (disk full) is lost.  Kept column by column:
+// one memory-mapped file each for timestamp, symbol id, price (integer
+// ticks), quantity, buy/sell order ids, buyer/seller ids and swap link id
+// and leg, plus a mapped row count.  A store written before the swap
+// columns existed opens with them zero-filled: its rows read back as spot.
+// Symbol and counterparty names are interned into dense ids whose
+// dictionaries live next to the columns, so a store reopened after a restart
+// reads back the same names.
+//
+// Rows are grouped into blocks of BLOCK_ROWS, each summarised by its min/max
+// timestamp and symbol id and a 64-bit symbol mask (bit id % 64).  A query
+// checks the summary first and only touches the timestamp and symbol columns
+// of blocks that can match; the remaining columns are read for the rows it
+// returns; a counterparty filter reads the buyer and seller columns of those
+// blocks too.  Fills arrive in time order, so while no block overlaps the one
+// before it (a wall-clock step back breaks this) the blocks for a time range
+// are found by binary search instead of a walk over every summary.
+//
+// onTrades is a TradeFeed sink (one writer thread).  Queries may run on any
+// thread; they share a reader lock that the writer takes exclusively per
+// batch, because growing a column remaps it.
+class TradeStore {
+public:
+    static constexpr size_t  BLOCK_ROWS   = 4096;
+    static constexpr int64_t PRICE_SCALE  = 1000000;   // price ticks per unit
+    static constexpr size_t  INITIAL_ROWS = 1 << 16;   // column capacity of a new store
+
+    TradeStore() = default;
+    ~TradeStore();
+
+    TradeStore(const TradeStore&)            = delete;
+    TradeStore& operator=(const TradeStore&) = delete;
+
+    // Open the store in dir, creating the directory and an empty store if
+    // needed; false (with a message on stderr) on I/O error.  Not concurrent
+    // with the other calls.
+    bool open(const std::string& dir);
+    void close();
+
+    // TradeFeed sink: append a batch of fills
+    void onTrades(const TradeRecord* records, size_t count);
+
+    // The most recent q.limit matching fills, oldest first.  To page back,
+    // repeat with toNs the first returned timestamp and skipAtTo the number
+    // of fills stamped with it seen so far (returned, plus any skipAtTo
+    // already at that toNs), so fills sharing a timestamp across the page
+    // boundary are neither skipped nor repeated.
+    std::vector<StoredTrade> query(const TradeQuery& q) const;
+
+    // Number of matching fills (q.limit is ignored)
+    size_t count(const TradeQuery& q) const;
+
+    size_t size() const;
+
+private:
+    struct Column {
+        int    fd       = -1;
+        char*  base     = nullptr;
+        size_t elemSize = 0;
+    };
+
+    struct Block {
+        int64_t  minTs;
+        int64_t  maxTs;
+        uint32_t minSym;
+        uint32_t maxSym;
+        uint64_t symMask;
+    };
+
+    // Columns from LINK on came later; an older store may lack their files
+    enum { TS, SYM, PRICE, QTY, BUY_ORDER, SELL_ORDER, BUYER, SELLER, LINK, LEG, COLUMN_COUNT };
+
+    std::string        dir_;
+    Column             cols_[COLUMN_COUNT];
+    int                metaFd_   = -1;
+    uint64_t*          rows_     = nullptr;   // mapped; written after the row's columns
+    size_t             capacity_ = 0;         // rows every column has room for
+    std::vector<Block> blocks_;
+    bool               ordered_  = true;      // every block starts at or after the previous one ends
+
+    // Interned names; id 0 of counterparties_ is "" (no counterparty)
+    std::vector<std::string>                  symbols_;
+    std::unordered_map<std::string, uint32_t> symbolIds_;
+    std::vector<std::string>                  counterparties_;
+    std::unordered_map<std::string, uint32_t> counterpartyIds_;
+    std::unordered_map<int64_t, uint32_t>     engineCpIds_;   // Counterparty::getId() → interned id
+
+    mutable std::shared_mutex mu_;
+
+    template<typename T> T*       col(int c)       { return reinterpret_cast<T*>(cols_[c].base); }
+    template<typename T> const T* col(int c) const { return reinterpret_cast<const T*>(cols_[c].base); }
+
+    bool     mapColumn(Column& c, size_t rows);
+    bool     grow(size_t rows);
+    uint32_t intern(std::vector<std::string>& names, std::unordered_map<std::string, uint32_t>& ids,
+                    const std::string& name, const char* dictFile);
+    uint32_t counterpartyId(int64_t engineId);
+    void     extendIndex(size_t fromRow, size_t toRow);
+
+    // Blocks [first, last) that can hold timestamps in [fromNs, toNs]
+    std::pair<size_t, size_t> blockRange(int64_t fromNs, int64_t toNs) const;
+
+    // Visit matching rows, newest first, until f returns false
+    template<typename F>
+    void scanBackward(const TradeQuery& q, F&& f) const;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstdlib>
 #include <iomanip>
 #include <memory>
 #include <string>
@@ -7,12 +8,19 @@
 #include <iostream>
 #include <thread>
 #include <vector>
+#include "CandleAggregator.h"
 #include "Counterparty.h"
+#include "CsvLoader.h"
 #include "EventBus.h"
+#include "FeedReplayer.h"
 #include "HTTPServer.h"
 #include "OrderManager.h"
+#include "PositionKeeper.h"
 #include "MarketManager.h"
+#include "RiskManager.h"
 #include "SubBook.h"
+#include "TradeFeed.h"
+#include "TradeStore.h"
 
 // ── Order book display helpers ──────────────────────────────────────────────
 
@@ -68,8 +76,7 @@ void printOrderBook(OrderManager& om) {
         } else {
             for (auto it = asks.begin(); it != asks.end(); ++it) {
                 bool isBest = (it == asks.begin());
-                long total  = 0;
-                for (const auto& o : it->second) total += o.getQuantity();
+                long total  = it->second.quantity;
 
                 std::cout << std::fixed << std::setprecision(4)
                           << "    " << std::setw(10) << std::right << it->first
@@ -90,8 +97,7 @@ void printOrderBook(OrderManager& om) {
         } else {
             for (auto it = bids.begin(); it != bids.end(); ++it) {
                 bool isBest = (it == bids.begin());
-                long total  = 0;
-                for (const auto& o : it->second) total += o.getQuantity();
+                long total  = it->second.quantity;
 
                 std::cout << std::fixed << std::setprecision(4)
                           << "    " << std::setw(10) << std::right << it->first
@@ -107,15 +113,144 @@ void printOrderBook(OrderManager& om) {
     std::cout << "\n";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Optional market data sources:
+    //   --ticks <file>      tick lines to load before the server starts
+    //   --udp-feed <port>   live tick lines as UDP datagrams on 127.0.0.1
+    //   --feed-file <file>  binary MarketPrice recording to replay before start
+    //   --binary-feed <port> live MarketPrice records as UDP datagrams
+    // Trade history:
+    //   --trade-store <dir> keep every fill in a columnar store (GET /trades)
+    // Pre-trade risk (per counterparty; 0 = no limit):
+    //   --max-open-notional <n>  resting notional
+    //   --credit-limit <n>       filled + resting notional
+    // Implied liquidity (repeatable):
+    //   --implied <X/Y=X/C,Y/C>  price cross X/Y from its two legs, e.g. EUR/GBP=EUR/USD,GBP/USD
+    // Batch auctions:
+    //   --auction <symbol>         trade the symbol in periodic auctions (repeatable)
+    //   --auction-interval-ms <n>  time between auctions (default 1000)
+    // Fill allocation within a price level (repeatable; FIFO otherwise):
+    //   --allocation <symbol>=FIFO|PRO_RATA|TOP_ORDER[:<min qty>]
+    // Self-trade prevention for HTTP orders that do not set their own:
+    //   --self-trade NONE|CANCEL_RESTING|CANCEL_INCOMING|CANCEL_BOTH|DECREMENT
+    std::string ticksPath, feedPath, storeDir, selfTradeName;
+    std::vector<std::string> impliedSpecs, auctionSymbols, allocationSpecs;
+    int         udpPort = -1, binaryPort = -1, auctionMs = 1000;
+    double      maxOpenNotional = 0, creditLimit = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if      (arg == "--ticks")               ticksPath       = argv[i + 1];
+        else if (arg == "--udp-feed")            udpPort         = std::atoi(argv[i + 1]);
+        else if (arg == "--feed-file")           feedPath        = argv[i + 1];
+        else if (arg == "--binary-feed")         binaryPort      = std::atoi(argv[i + 1]);
+        else if (arg == "--trade-store")         storeDir        = argv[i + 1];
+        else if (arg == "--max-open-notional")   maxOpenNotional = std::atof(argv[i + 1]);
+        else if (arg == "--credit-limit")        creditLimit     = std::atof(argv[i + 1]);
+        else if (arg == "--implied")             impliedSpecs.push_back(argv[i + 1]);
+        else if (arg == "--auction")             auctionSymbols.push_back(argv[i + 1]);
+        else if (arg == "--auction-interval-ms") auctionMs       = std::atoi(argv[i + 1]);
+        else if (arg == "--allocation")          allocationSpecs.push_back(argv[i + 1]);
+        else if (arg == "--self-trade")          selfTradeName   = argv[i + 1];
+    }
+
     // Create the Market and Trade Managers
     auto marketManager = std::make_unique<MarketManager>();
+    if (!ticksPath.empty()) {
+        std::ifstream ticks(ticksPath);
+        if (!ticks.is_open()) {
+            std::cerr << "Error: Could not open " << ticksPath << std::endl;
+            return 1;
+        }
+        std::cout << "Loaded " << marketManager->loadTicks(ticks) << " market ticks from "
+                  << ticksPath << std::endl;
+    }
+    if (!feedPath.empty()) {
+        FeedReplayer replayer;
+        if (!replayer.open(feedPath)) {
+            std::cerr << "Error: Could not open " << feedPath << std::endl;
+            return 1;
+        }
+        std::cout << "Replayed " << replayer.replayInto(*marketManager) << " market ticks from "
+                  << feedPath << std::endl;
+    }
     auto orderManager  = std::make_unique<OrderManager>(marketManager.get());
 
+    // Every new order passes the pre-trade gate: 1M max quantity, 50M max
+    // notional, prices within 10% of the market
+    RiskManager riskManager(marketManager.get());
+    riskManager.setDefaultLimits({ 1000000, 50000000.0, 0.10, maxOpenNotional, creditLimit });
+    orderManager->setRiskManager(&riskManager);
+
     // Wire the event bus so fills and book changes stream to the UI
     EventBus eventBus;
     orderManager->setEventBus(&eventBus);
 
+    // Implied crosses, priced from their legs as the legs' books fill up
+    for (const std::string& spec : impliedSpecs) {
+        const auto eq    = spec.find('=');
+        const auto comma = spec.find(',', eq == std::string::npos ? 0 : eq);
+        if (eq == std::string::npos || comma == std::string::npos ||
+            !orderManager->addImpliedCross(spec.substr(0, eq), spec.substr(eq + 1, comma - eq - 1),
+                                           spec.substr(comma + 1))) {
+            std::cerr << "Error: --implied " << spec << " is not X/Y=X/C,Y/C" << std::endl;
+            return 1;
+        }
+        std::cout << "Implied cross " << spec << std::endl;
+    }
+
+    // Per-symbol allocation policies
+    for (const std::string& spec : allocationSpecs) {
+        const auto  eq     = spec.find('=');
+        const auto  colon  = spec.find(':', eq == std::string::npos ? 0 : eq);
+        std::string policy = eq == std::string::npos ? "" : spec.substr(eq + 1, colon - eq - 1);
+        long        minQty = colon == std::string::npos ? 1 : std::atol(spec.c_str() + colon + 1);
+        Allocation  allocation;
+        if      (policy == "FIFO")      allocation = Allocation::FIFO;
+        else if (policy == "PRO_RATA")  allocation = Allocation::PRO_RATA;
+        else if (policy == "TOP_ORDER") allocation = Allocation::TOP_ORDER;
+        else {
+            std::cerr << "Error: --allocation " << spec << " is not SYMBOL=FIFO|PRO_RATA|TOP_ORDER[:MIN]" << std::endl;
+            return 1;
+        }
+        orderManager->setAllocation(spec.substr(0, eq), allocation, minQty);
+        std::cout << "Allocation " << spec.substr(0, eq) << ": " << toString(allocation)
+                  << " (min " << std::max(1L, minQty) << ")" << std::endl;
+    }
+
+    SelfTradePrevention selfTrade = SelfTradePrevention::NONE;
+    if (!selfTradeName.empty() && !parseSelfTrade(selfTradeName, selfTrade)) {
+        std::cerr << "Error: --self-trade " << selfTradeName
+                  << " is not NONE|CANCEL_RESTING|CANCEL_INCOMING|CANCEL_BOTH|DECREMENT" << std::endl;
+        return 1;
+    }
+    if (selfTrade != SelfTradePrevention::NONE)
+        std::cout << "Self-trade prevention: " << toString(selfTrade) << std::endl;
+
+    // Auction symbols rest every order until the auction clock uncrosses them
+    if (!auctionSymbols.empty() && auctionMs <= 0) {
+        std::cerr << "Error: --auction-interval-ms must be positive" << std::endl;
+        return 1;
+    }
+    for (const std::string& symbol : auctionSymbols) {
+        orderManager->setAuctionMode(symbol, true);
+        std::cout << "Batch auctions in " << symbol << " every " << auctionMs << " ms" << std::endl;
+    }
+
+    // Fills fan out to post-trade consumers on the trade feed's own thread
+    TradeFeed        tradeFeed;
+    CandleAggregator candles(&eventBus);
+    tradeFeed.addSink([&candles](const TradeRecord* r, size_t n) { candles.onTrades(r, n); });
+    PositionKeeper positions(marketManager.get(), &eventBus);
+    tradeFeed.addSink([&positions](const TradeRecord* r, size_t n) { positions.onTrades(r, n); });
+    TradeStore tradeStore;
+    if (!storeDir.empty()) {
+        if (!tradeStore.open(storeDir)) return 1;
+        std::cout << "Trade store " << storeDir << ": " << tradeStore.size() << " fills on record" << std::endl;
+        tradeFeed.addSink([&tradeStore](const TradeRecord* r, size_t n) { tradeStore.onTrades(r, n); });
+    }
+    tradeFeed.start();
+    orderManager->setTradeFeed(&tradeFeed);
+
     // Sample counterparties — orders are assigned round-robin
     Counterparty counterparties[] = {
         Counterparty("Goldman Sachs"),
@@ -131,46 +266,8 @@ int main() {
         return 1;
     }
 
-    std::string line;
-    // Skip the header line
-    std::getline(file, line);
-
-    int orderCount = 0;
-
-    // Read each line from the CSV
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string symbol, priceStr, quantityStr, side;
-
-        // Parse CSV fields (Symbol,Price,Quantity,Side)
-        std::getline(ss, symbol, ',');
-        std::getline(ss, priceStr, ',');
-        std::getline(ss, quantityStr, ',');
-        std::getline(ss, side, ',');
-
-        // Convert strings to appropriate types
-        double price = std::stod(priceStr);
-        int quantity = std::stoi(quantityStr);
-
-        // Determine order type based on side
-        OrderType orderType;
-        if (side == "BUY") {
-            orderType = OrderType::SPOT_BUY;
-        } else {
-            orderType = OrderType::SPOT_SELL;
-        }
-
-        // Assign counterparty round-robin and create order
-        Counterparty* cp = &counterparties[orderCount % cpCount];
-        Order order(symbol, price, quantity, orderType, cp);
-        orderManager->processNewOrder(order);
-
-        orderCount++;
-        std::cout << "Processed order #" << orderCount << ": "
-                  << side << " " << quantity << " " << symbol
-                  << " @ " << price
-                  << "  [" << cp->getName() << "]" << std::endl;
-    }
+    // Seed the book: one SPOT order per row, counterparties round-robin
+    int orderCount = loadOrdersCsv(file, *orderManager, counterparties, cpCount, &std::cout);
 
     file.close();
 
@@ -180,9 +277,30 @@ int main() {
 
     // Start the HTTP server in the foreground (blocks until Ctrl+C)
     HTTPServer httpServer(*orderManager, eventBus);
+    for (Counterparty& cp : counterparties) httpServer.addCounterparty(&cp);   // one history per name
+    httpServer.setCandleAggregator(&candles);
+    if (!storeDir.empty()) httpServer.setTradeStore(&tradeStore, &tradeFeed);
+    httpServer.setPositionKeeper(&positions);
+    if (!auctionSymbols.empty()) httpServer.setAuctionInterval(auctionMs);
+    httpServer.setDefaultSelfTrade(selfTrade);
+
+    // Live feeds start once the server has wired ticks to the engine lock, so
+    // every tick from here on can trigger resting orders
+    if (udpPort >= 0) {
+        int bound = marketManager->startUdpFeed(udpPort);
+        if (bound < 0) return 1;
+        std::cout << "Market feed listening on udp://127.0.0.1:" << bound << std::endl;
+    }
+    if (binaryPort >= 0) {
+        int bound = marketManager->startBinaryFeed(binaryPort);
+        if (bound < 0) return 1;
+        std::cout << "Binary market feed listening on udp://127.0.0.1:" << bound << std::endl;
+    }
     std::cout << "\nUI available at http://localhost:5173  (run: cd ui && npm run dev)\n";
     std::cout << "Press Ctrl+C to stop.\n\n";
     httpServer.start(9090);
+    marketManager->stopFeeds();   // before the server's tick listener goes away
+    tradeFeed.stop();
 
     return 0;
 }
@@ -0,0 +1,1375 @@
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CandleAggregator.h"
+#include "Counterparty.h"
+#include "CsvLoader.h"
+#include "EventBus.h"
+#include "FeedReplayer.h"
+#include "Latency.h"
+#include "MarketManager.h"
+#include "Metrics.h"
+#include "Order.h"
+#include "OrderManager.h"
+#include "OrderType.h"
+#include "PositionKeeper.h"
+#include "RiskManager.h"
+#include "SubBook.h"
+#include "TradeFeed.h"
+#include "TradeStore.h"
+
+// ─── Minimal benchmark harness ────────────────────────────────────────────────
+//
+// Run every benchmark:            ./run_bench
+// Run those matching a name:      ./run_bench match_sweep
+// Shrink or grow workloads:       ./run_bench --scale 0.1
+// Write machine-readable results: ./run_bench --json bench.json --label <commit>
+//
+// Each benchmark seeds its own RNG, so every run of the same binary performs
+// identical work.  A benchmark body runs twice: once to warm caches and the
+// allocator, then once measured.  Operations are timed individually with the
+// TSC (see Latency.h), so results carry percentiles as well as the mean.
+//
+// Order-flow benchmarks run without an EventBus so they measure the engine
+// itself; book serialisation and fan-out are measured separately.  std::cout
+// is silenced for the whole run so [TRADE] logging does not dominate.
+
+static std::ostream* out = nullptr;   // the real stdout
+static std::string   benchFilter;     // empty = run everything
+static double        scale = 1.0;     // multiplies workload sizes
+
+struct BenchResult {
+    std::string name;
+    std::string workload;
+    long        ops;
+    double      nsPerOp;
+    double      p50Ns;
+    double      p99Ns;
+    double      p999Ns;
+    double      maxNs;
+};
+
+static std::vector<BenchResult> results;
+static std::string              pendingGroup;   // header printed before the group's first result
+
+// Collects per-operation timings for one benchmark run
+class BenchTimer
+{
+public:
+    // Time one operation
+    template<typename F>
+    void time(F&& f) {
+        uint64_t t0 = latencyNow();
+        f();
+        uint64_t dt = latencyNow() - t0;
+        hist_.record(dt);
+        ticks_ += dt;
+        ++ops_;
+    }
+
+    // Time a batch as a single sample that counts as n operations
+    // (for operations too short to time one at a time)
+    template<typename F>
+    void timeBatch(long n, F&& f) {
+        uint64_t t0 = latencyNow();
+        f();
+        uint64_t dt = latencyNow() - t0;
+        hist_.record(dt / static_cast<uint64_t>(n));
+        ticks_ += dt;
+        ops_   += n;
+    }
+
+    const LatencyHistogram& histogram() const { return hist_; }
+    uint64_t ticks() const { return ticks_; }
+    long     ops()   const { return ops_; }
+
+private:
+    LatencyHistogram hist_;
+    uint64_t         ticks_{0};
+    long             ops_{0};
+};
+
+static long scaled(long n) {
+    return std::max(1L, static_cast<long>(static_cast<double>(n) * scale));
+}
+
+static void printGroupHeader(const std::string& name) {
+    *out << "\n" << name << "\n" << std::string(name.size(), '-') << "\n"
+         << "  " << std::left << std::setw(44) << "benchmark" << std::right
+         << std::setw(10) << "ops" << std::setw(14) << "ns/op" << std::setw(13) << "p50 ns"
+         << std::setw(13) << "p99 ns" << std::setw(13) << "p99.9 ns" << std::setw(12) << "ops/s" << "\n";
+}
+
+// Start a new group of benchmarks; its header is only printed if one runs
+static void group(const std::string& name) { pendingGroup = name; }
+
+template<typename F>
+static void bench(const std::string& name, const std::string& workload, F&& body) {
+    std::string label = workload.empty() ? name : name + " [" + workload + "]";
+    if (!benchFilter.empty() && label.find(benchFilter) == std::string::npos) return;
+    if (!pendingGroup.empty()) {
+        printGroupHeader(pendingGroup);
+        pendingGroup.clear();
+    }
+
+    { BenchTimer warm; body(warm); }
+
+    BenchTimer t;
+    body(t);
+    if (t.ops() == 0) return;
+
+    const double tpn = LatencyRegistry::ticksPerNs();
+    BenchResult r{
+        name, workload, t.ops(),
+        static_cast<double>(t.ticks()) / tpn / static_cast<double>(t.ops()),
+        static_cast<double>(t.histogram().percentile(0.50))  / tpn,
+        static_cast<double>(t.histogram().percentile(0.99))  / tpn,
+        static_cast<double>(t.histogram().percentile(0.999)) / tpn,
+        static_cast<double>(t.histogram().max())             / tpn
+    };
+    results.push_back(r);
+
+    *out << std::fixed << std::setprecision(1)
+         << "  " << std::left << std::setw(44) << label << std::right
+         << std::setw(10) << r.ops
+         << std::setw(14) << r.nsPerOp
+         << std::setw(13) << r.p50Ns
+         << std::setw(13) << r.p99Ns
+         << std::setw(13) << r.p999Ns
+         << std::setprecision(0)
+         << std::setw(12) << (r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0.0) << "\n";
+}
+
+
+static void writeJson(const std::string& path, const std::string& label) {
+    std::ofstream f(path);
+    f << std::fixed << std::setprecision(2);
+    f << "{\n  \"label\": \"" << label << "\",\n  \"scale\": " << scale
+      << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        f << "    {\"name\": \"" << r.name << "\", \"workload\": \"" << r.workload << "\""
+          << ", \"ops\": "       << r.ops
+          << ", \"ns_per_op\": " << r.nsPerOp
+          << ", \"p50_ns\": "    << r.p50Ns
+          << ", \"p99_ns\": "    << r.p99Ns
+          << ", \"p999_ns\": "   << r.p999Ns
+          << ", \"max_ns\": "    << r.maxNs << "}"
+          << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    f << "  ]\n}\n";
+}
+
+// ─── Synthetic workloads ──────────────────────────────────────────────────────
+//
+// Order flow around a fixed mid of 1.1000 with a one-pip (0.0001) tick.
+// New orders are always passive (bids below mid, asks above), so the flow
+// exercises queueing and cancellation without triggering matches.
+//
+//   UNIFORM       new orders spread evenly across `levels` ticks per side
+//   CLUSTERED     new orders concentrated near the touch (geometric distance)
+//   CANCEL_HEAVY  clustered adds, with 80% of operations cancelling a random
+//                 live order
+
+enum class Workload { UNIFORM, CLUSTERED, CANCEL_HEAVY };
+
+static const char* workloadName(Workload w) {
+    switch (w) {
+        case Workload::UNIFORM:      return "uniform";
+        case Workload::CLUSTERED:    return "clustered-near-touch";
+        case Workload::CANCEL_HEAVY: return "cancel-heavy";
+    }
+    return "unknown";
+}
+
+struct BenchOp {
+    bool     cancel;     // true = cancel a live order chosen by `pick`
+    bool     buy;
+    double   price;
+    int      quantity;
+    uint32_t pick;       // random selector for the order to cancel
+};
+
+static constexpr long MID_TICKS = 11000;   // 1.1000 in pips
+
+static double tickPrice(long ticks) { return static_cast<double>(ticks) / 10000.0; }
+
+static std::vector<BenchOp> generateFlow(Workload w, long count, int levels, uint64_t seed) {
+    std::mt19937_64                     rng(seed);
+    std::uniform_int_distribution<int>  uniformLevel(0, levels - 1);
+    std::geometric_distribution<int>    nearTouch(0.25);
+    std::uniform_int_distribution<int>  qty(1, 100);
+    std::uniform_int_distribution<int>  percent(0, 99);
+
+    std::vector<BenchOp> ops;
+    ops.reserve(count);
+    long live = 0;
+    for (long i = 0; i < count; ++i) {
+        BenchOp op{};
+        op.pick = static_cast<uint32_t>(rng());
+        if (w == Workload::CANCEL_HEAVY && live > 0 && percent(rng) < 80) {
+            op.cancel = true;
+            --live;
+        } else {
+            int distance = (w == Workload::UNIFORM) ? uniformLevel(rng)
+                                                    : std::min(nearTouch(rng), levels - 1);
+            op.buy      = (rng() & 1) == 0;
+            op.price    = tickPrice(op.buy ? MID_TICKS - 1 - distance : MID_TICKS + 1 + distance);
+            op.quantity = qty(rng) * 1000;
+            ++live;
+        }
+        ops.push_back(op);
+    }
+    return ops;
+}
+
+// A fresh engine per benchmark run.  Counterparties accumulate order IDs and
+// fills, so sharing them between runs would make results order-dependent.
+struct BenchEngine {
+    std::vector<Counterparty> counterparties;
+    MarketManager             mm;
+    OrderManager              om{&mm};
+
+    BenchEngine() {
+        counterparties.reserve(8);
+        for (int i = 0; i < 8; ++i)
+            counterparties.emplace_back("Bench.CP" + std::to_string(i));
+    }
+
+    // Orders are assigned to counterparties round-robin
+    Counterparty* cp(long i) {
+        return &counterparties[static_cast<size_t>(i) % counterparties.size()];
+    }
+};
+
+// Apply a flow to the engine, timing every operation.  Live IDs are tracked
+// so cancels always target a resting order.
+static void runFlow(BenchEngine& e, const std::string& sym,
+                    const std::vector<BenchOp>& flow, BenchTimer& t) {
+    std::vector<long> live;
+    live.reserve(flow.size());
+    long n = 0;
+    for (const BenchOp& op : flow) {
+        if (op.cancel) {
+            size_t idx = op.pick % live.size();
+            long   id  = live[idx];
+            live[idx]  = live.back();
+            live.pop_back();
+            t.time([&] { e.om.processCancelOrder(id); });
+        } else {
+            Order o(sym, op.price, op.quantity,
+                    op.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(n++));
+            live.push_back(o.getId());
+            t.time([&] { e.om.processNewOrder(o); });
+        }
+    }
+}
+
+// ─── Benchmarks ───────────────────────────────────────────────────────────────
+
+static void benchQueueOrder() {
+    group("queueOrder (processNewOrder, passive)");
+    for (Workload w : { Workload::UNIFORM, Workload::CLUSTERED }) {
+        auto flow = generateFlow(w, scaled(50000), 200, 42);
+        bench("queue_order", workloadName(w), [&](BenchTimer& t) {
+            BenchEngine e;
+            runFlow(e, "BENCH/Q", flow, t);
+        });
+    }
+}
+
+static void benchCancel() {
+    group("OrderBook::cancel (processCancelOrder)");
+
+    // Cancel a prefilled book in random order
+    for (long resting : { 1000L, 50000L }) {
+        long n    = scaled(resting);
+        auto flow = generateFlow(Workload::UNIFORM, n, 200, 7);
+        bench("cancel resting=" + std::to_string(n), workloadName(Workload::UNIFORM),
+              [&](BenchTimer& t) {
+            BenchEngine e;
+            std::vector<long> ids;
+            ids.reserve(flow.size());
+            long i = 0;
+            for (const BenchOp& op : flow) {
+                Order o("BENCH/C", op.price, op.quantity,
+                        op.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(i++));
+                ids.push_back(o.getId());
+                e.om.processNewOrder(o);
+            }
+            std::shuffle(ids.begin(), ids.end(), std::mt19937_64(11));
+            for (long id : ids) t.time([&] { e.om.processCancelOrder(id); });
+        });
+    }
+
+    // One market maker holding every resting order: its open-order set is as
+    // large as the book, so per-counterparty bookkeeping dominates if it is
+    // not O(1)
+    for (long resting : { 10000L, 100000L }) {
+        long n    = scaled(resting);
+        auto flow = generateFlow(Workload::UNIFORM, n, 200, 13);
+        bench("cancel one_cp resting=" + std::to_string(n), workloadName(Workload::UNIFORM),
+              [&](BenchTimer& t) {
+            BenchEngine e;
+            std::vector<long> ids;
+            ids.reserve(flow.size());
+            for (const BenchOp& op : flow) {
+                Order o("BENCH/C1", op.price, op.quantity,
+                        op.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(0));
+                ids.push_back(o.getId());
+                e.om.processNewOrder(o);
+            }
+            std::shuffle(ids.begin(), ids.end(), std::mt19937_64(17));
+            for (long id : ids) t.time([&] { e.om.processCancelOrder(id); });
+        });
+    }
+
+    // Pulling all of one market maker's quotes: one DELETE per order against
+    // one cancelAll, with an SSE bus attached so each publishes book deltas
+    for (bool mass : { false, true }) {
+        long n    = scaled(10000);
+        auto flow = generateFlow(Workload::UNIFORM, n, 200, 19);
+        bench(std::string(mass ? "cancel_all" : "cancel_each") + " bus=on resting=" + std::to_string(n),
+              workloadName(Workload::UNIFORM), [&](BenchTimer& t) {
+            BenchEngine e;
+            EventBus    bus;
+            e.om.setEventBus(&bus);
+            std::vector<long> ids;
+            ids.reserve(flow.size());
+            for (const BenchOp& op : flow) {
+                Order o("BENCH/C2", op.price, op.quantity,
+                        op.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(0));
+                ids.push_back(o.getId());
+                e.om.processNewOrder(o);
+            }
+            if (mass) {
+                t.timeBatch(n, [&] { e.om.cancelAll(*e.cp(0)); });
+            } else {
+                for (long id : ids) t.time([&] { e.om.processCancelOrder(id); });
+            }
+        });
+    }
+
+    // Mixed add/cancel flow dominated by cancels
+    auto flow = generateFlow(Workload::CANCEL_HEAVY, scaled(100000), 50, 99);
+    bench("order_flow", workloadName(Workload::CANCEL_HEAVY), [&](BenchTimer& t) {
+        BenchEngine e;
+        runFlow(e, "BENCH/CH", flow, t);
+    });
+}
+
+static void benchMatch() {
+    group("matchSpotOrders (aggressive sweep)");
+
+    // Each iteration rests `depth` ask levels of 4 orders, then times one
+    // buy that sweeps all of them
+    for (int depth : { 1, 10, 100 }) {
+        long iterations = scaled(20000 / depth + 200);
+        bench("match_sweep depth=" + std::to_string(depth), "", [&](BenchTimer& t) {
+            BenchEngine e;
+            long n = 0;
+            for (long it = 0; it < iterations; ++it) {
+                long total = 0;
+                for (int lvl = 0; lvl < depth; ++lvl)
+                    for (int k = 0; k < 4; ++k) {
+                        e.om.processNewOrder(Order("BENCH/M", tickPrice(MID_TICKS + 1 + lvl), 1000,
+                                                 OrderType::SPOT_SELL, e.cp(n++)));
+                        total += 1000;
+                    }
+                Order sweep("BENCH/M", tickPrice(MID_TICKS + depth), static_cast<int>(total),
+                            OrderType::SPOT_BUY, e.cp(n++));
+                t.time([&] { e.om.processNewOrder(sweep); });
+            }
+        });
+    }
+}
+
+static void benchPublishBookUpdate() {
+    group("publishBookUpdate (book_update serialisation)");
+
+    for (int depth : { 10, 100, 1000 }) {
+        long iterations = scaled(200000 / depth);
+        bench("publish_book_update depth=" + std::to_string(depth), "", [&](BenchTimer& t) {
+            BenchEngine e;
+            EventBus      bus;
+            auto          conn = bus.subscribe();
+            long n = 0;
+            for (int lvl = 0; lvl < depth; ++lvl)
+                for (int k = 0; k < 2; ++k) {
+                    e.om.processNewOrder(Order("BENCH/P", tickPrice(MID_TICKS - 1 - lvl), 1000,
+                                             OrderType::SPOT_BUY, e.cp(n++)));
+                    e.om.processNewOrder(Order("BENCH/P", tickPrice(MID_TICKS + 1 + lvl), 1000,
+                                             OrderType::SPOT_SELL, e.cp(n++)));
+                }
+            e.om.setEventBus(&bus);
+            for (long it = 0; it < iterations; ++it) {
+                t.time([&] { e.om.publishBookUpdate("BENCH/P"); });
+                if ((it & 255) == 255) {   // drain outside the timed region
+                    std::lock_guard<std::mutex> lk(conn->mu);
+                    bus.onDelivered(static_cast<long>(conn->queue.size()));
+                    conn->queue = {};
+                }
+            }
+            bus.unsubscribe(conn);
+        });
+    }
+}
+
+static void benchEventBus() {
+    group("EventBus::publish fan-out");
+
+    const std::string msg =
+        "event: trade\ndata: {\"symbol\":\"EUR/USD\",\"price\":1.085000,\"quantity\":1000000,"
+        "\"buyOrderId\":12345,\"sellOrderId\":12346,\"buyer\":\"Goldman Sachs\","
+        "\"seller\":\"JP Morgan\"}\n\n";
+
+    for (int subscribers : { 0, 1, 8, 64 }) {
+        long iterations = scaled(400000 / (subscribers + 1) + 2000);
+        bench("eventbus_publish subscribers=" + std::to_string(subscribers), "", [&](BenchTimer& t) {
+            EventBus bus;
+            std::vector<std::shared_ptr<EventBus::Connection>> conns;
+            for (int s = 0; s < subscribers; ++s) conns.push_back(bus.subscribe());
+            for (long it = 0; it < iterations; ++it) {
+                t.time([&] { bus.publish(msg); });
+                if ((it & 255) == 255) {
+                    for (auto& c : conns) {
+                        std::lock_guard<std::mutex> lk(c->mu);
+                        bus.onDelivered(static_cast<long>(c->queue.size()));
+                        c->queue = {};
+                    }
+                }
+            }
+            for (auto& c : conns) bus.unsubscribe(c);
+        });
+    }
+}
+
+static void benchCsvLoad() {
+    group("CSV loading (loadOrdersCsv)");
+
+    // The shipped sample file, loaded into a fresh engine each time
+    std::ifstream f("forex_orders.csv");
+    if (f) {
+        std::stringstream buf;
+        buf << f.rdbuf();
+        const std::string csv = buf.str();
+        long iterations = scaled(500);
+        bench("csv_load", "forex_orders.csv", [&](BenchTimer& t) {
+            for (long it = 0; it < iterations; ++it) {
+                BenchEngine e;
+                std::istringstream in(csv);
+                long rows = std::count(csv.begin(), csv.end(), '\n') - 1;
+                t.timeBatch(rows, [&] {
+                    loadOrdersCsv(in, e.om, e.counterparties.data(),
+                                  static_cast<int>(e.counterparties.size()));
+                });
+            }
+        });
+    }
+
+    // A large synthetic file drawn from the clustered workload
+    long rows = scaled(100000);
+    auto flow = generateFlow(Workload::CLUSTERED, rows, 200, 5);
+    std::ostringstream csv;
+    csv << "Symbol,Price,Quantity,Side\n" << std::fixed << std::setprecision(4);
+    for (const BenchOp& op : flow)
+        csv << "BENCH/CSV," << op.price << "," << op.quantity << "," << (op.buy ? "BUY" : "SELL") << "\n";
+    const std::string text = csv.str();
+    bench("csv_load", std::string(workloadName(Workload::CLUSTERED)) + " rows=" + std::to_string(rows),
+          [&](BenchTimer& t) {
+        BenchEngine e;
+        std::istringstream in(text);
+        t.timeBatch(rows, [&] {
+            loadOrdersCsv(in, e.om, e.counterparties.data(),
+                          static_cast<int>(e.counterparties.size()));
+        });
+    });
+}
+
+static void benchMarketData() {
+    group("MarketManager (tick ingest, seqlock reads)");
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < 25; ++i) symbols.push_back("MKT/" + std::to_string(i));
+
+    long ticks = scaled(1000000);
+    bench("market_ingest onQuote", "25 symbols", [&](BenchTimer& t) {
+        MarketManager mm;
+        for (long done = 0; done < ticks; done += 1000)
+            t.timeBatch(1000, [&] {
+                for (long i = done; i < done + 1000; ++i)
+                    mm.onQuote(symbols[static_cast<size_t>(i % 25)], 1.0840, 1000, 1.0842, 2000, i + 1);
+            });
+    });
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < 1000; ++i)
+        lines.push_back("Q," + symbols[static_cast<size_t>(i % 25)] + ",1.0840,1000,1.0842,2000");
+    bench("market_ingest ingestLine", "25 symbols", [&](BenchTimer& t) {
+        MarketManager mm;
+        for (long done = 0; done < ticks / 4; done += 1000)
+            t.timeBatch(1000, [&] { for (const auto& l : lines) mm.ingestLine(l); });
+    });
+
+    // Reads time 64 getQuote calls per sample; writers hammer the same symbols
+    for (int writers : { 0, 1, 2 }) {
+        long reads = scaled(2000000);
+        bench("market_read writers=" + std::to_string(writers), "25 symbols", [&](BenchTimer& t) {
+            MarketManager mm;
+            for (const auto& sym : symbols) mm.onQuote(sym, 1.0840, 1000, 1.0842, 2000);
+            std::atomic<bool>        stop{false};
+            std::vector<std::thread> threads;
+            for (int w = 0; w < writers; ++w)
+                threads.emplace_back([&] {
+                    for (long n = 0; !stop.load(std::memory_order_relaxed); ++n)
+                        mm.onQuote(symbols[static_cast<size_t>(n % 25)], 1.0840, 1000, 1.0842, 2000, n + 1);
+                });
+
+            MarketQuote q;
+            double      sink = 0;
+            for (long done = 0; done < reads; done += 64) {
+                t.timeBatch(64, [&] {
+                    for (int i = 0; i < 64; ++i) {
+                        mm.getQuote(static_cast<int>((done + i) % 25), q);
+                        sink += q.bid;
+                    }
+                });
+            }
+            stop.store(true);
+            for (auto& th : threads) th.join();
+            if (sink < 0) *out << sink;   // keep the reads observable
+        });
+    }
+
+    // Binary records straight from an mmap'd recording, 1024 per sample
+    std::vector<MarketPrice> recorded;
+    for (long i = 0; i < ticks; ++i)
+        recorded.push_back(i % 4 == 0
+            ? MarketPrice(symbols[static_cast<size_t>(i % 25)], 1.0841, 100, i + 1)
+            : MarketPrice::quote(symbols[static_cast<size_t>(i % 25)], 1.0840, 1000, 1.0842, 2000, i + 1));
+    const std::string feedPath = "/tmp/ts_bench_feed_" + std::to_string(getpid()) + ".bin";
+    FeedReplayer replayer;
+    if (FeedReplayer::record(feedPath, recorded.data(), recorded.size()) && replayer.open(feedPath)) {
+        bench("market_feed replay", "25 symbols, mmap", [&](BenchTimer& t) {
+            MarketManager mm;
+            for (size_t done = 0; done < replayer.size(); done += 1024) {
+                size_t n = std::min<size_t>(1024, replayer.size() - done);
+                t.timeBatch(static_cast<long>(n), [&] { mm.onTicks(replayer.data() + done, n); });
+            }
+        });
+    }
+    replayer.close();
+    std::remove(feedPath.c_str());
+
+    // A consumer polling every 1000 ticks sees 25 updates, not 1000
+    bench("market_feed conflated_poll", "25 symbols", [&](BenchTimer& t) {
+        MarketManager    mm;
+        ConflatingReader reader(mm);
+        size_t           updates = 0;
+        for (long done = 0; done < ticks / 4; done += 1000) {
+            mm.onTicks(recorded.data() + done, std::min<size_t>(1000, recorded.size() - static_cast<size_t>(done)));
+            t.time([&] { updates += reader.poll([](int, const MarketQuote&) {}); });
+        }
+        if (updates == 0) *out << updates;
+    });
+}
+
+// ─── Market-triggered fills ───────────────────────────────────────────────────
+
+// A tick goes through MarketManager::onQuote, the tick listener and
+// OrderManager::processMarketTick.  The book holds `resting` bids over 100
+// levels; crossing ticks lift exactly the best bid, which is replaced off the
+// clock so the book keeps its shape.
+static void benchMarketTrigger() {
+    group("market_trigger (tick → resting-order fill)");
+
+    for (long resting : { 1000L, 10000L }) {
+        long        ticks = scaled(20000);
+        std::string shape = std::to_string(resting) + " resting";
+
+        bench("market_trigger no_cross", shape, [&](BenchTimer& t) {
+            BenchEngine e;
+            for (long i = 0; i < resting; ++i)
+                e.om.processNewOrder(Order("TRG", 1.0000 + (i % 100) * 0.0001, 100, OrderType::LIMIT_BUY, e.cp(i)));
+            e.mm.setTickListener([&](int id, uint64_t ingress) {
+                e.om.processMarketTick(e.mm.symbolName(id), ingress);
+            });
+            for (long n = 0; n < ticks; ++n)
+                t.time([&] { e.mm.onQuote("TRG", 0.9990, 1000, 1.0100, 1000); });
+        });
+
+        bench("market_trigger tick_to_fill", shape, [&](BenchTimer& t) {
+            BenchEngine e;
+            for (long i = 0; i < resting; ++i)
+                e.om.processNewOrder(Order("TRG", 1.0000 + (i % 100) * 0.0001, 100, OrderType::LIMIT_BUY, e.cp(i)));
+            long fills = 0;
+            e.mm.setTickListener([&](int id, uint64_t ingress) {
+                fills += e.om.processMarketTick(e.mm.symbolName(id), ingress);
+            });
+            for (long n = 0; n < ticks; ++n) {
+                t.time([&] { e.mm.onQuote("TRG", 0.9990, 1000, 1.0099, 100); });
+                e.om.processNewOrder(Order("TRG", 1.0099, 100, OrderType::LIMIT_BUY, e.cp(n)));
+            }
+            if (fills != ticks) *out << "  (unexpected fill count " << fills << ")\n";
+        });
+    }
+}
+
+// ─── Post-trade fan-out ───────────────────────────────────────────────────────
+
+// The matcher-side cost is one ring push per fill; aggregation happens on the
+// feed thread.  candles and positions time onTrades per record, in
+// 256-record batches spread over 25 symbols and a few seconds of timestamps;
+// positions spreads the fills over 16 counterparties.
+static void benchTradeFeed() {
+    group("trade_feed (fill hand-off, candle and position keeping)");
+
+    long fills = scaled(1000000);
+    std::vector<TradeRecord> records(static_cast<size_t>(fills));
+    for (long i = 0; i < fills; ++i) {
+        TradeRecord& r = records[static_cast<size_t>(i)];
+        r = TradeRecord{};
+        r.tsNs     = 1700000000000000000LL + i * 1000;   // 1 µs apart
+        r.price    = 1.0840 + (i % 7) * 0.0001;
+        r.quantity = 100;
+        std::snprintf(r.symbol, sizeof(r.symbol), "MKT/%ld", i % 25);
+    }
+    std::vector<Counterparty> parties;
+    parties.reserve(16);
+    for (int i = 0; i < 16; ++i) parties.emplace_back("BENCH.PK" + std::to_string(i));
+
+    bench("trade_feed publish", "consumer running", [&](BenchTimer& t) {
+        TradeFeed feed;
+        long      seen = 0;
+        feed.addSink([&seen](const TradeRecord*, size_t n) { seen += static_cast<long>(n); });
+        feed.start();
+        for (long done = 0; done < fills; done += 1000) {
+            long n = std::min(1000L, fills - done);
+            t.timeBatch(n, [&] {
+                for (long i = done; i < done + n; ++i) feed.publish(records[static_cast<size_t>(i)]);
+            });
+        }
+        feed.stop();
+    });
+
+    bench("candles onTrades", "25 symbols, 4 intervals", [&](BenchTimer& t) {
+        CandleAggregator agg;
+        for (long done = 0; done < fills; done += 256) {
+            size_t n = static_cast<size_t>(std::min(256L, fills - done));
+            t.timeBatch(static_cast<long>(n), [&] { agg.onTrades(records.data() + done, n); });
+        }
+    });
+
+    bench("positions onTrades", "16 cps, 25 symbols", [&](BenchTimer& t) {
+        std::vector<TradeRecord> flow = records;
+        for (size_t i = 0; i < flow.size(); ++i) {
+            flow[i].buyerId  = parties[i % 16].getId();
+            flow[i].sellerId = parties[(i * 7 + 3) % 16].getId();
+        }
+        PositionKeeper keeper;
+        for (long done = 0; done < fills; done += 256) {
+            size_t n = static_cast<size_t>(std::min(256L, fills - done));
+            t.timeBatch(static_cast<long>(n), [&] { keeper.onTrades(flow.data() + done, n); });
+        }
+    });
+}
+
+// ─── Fill history soak ────────────────────────────────────────────────────────
+
+static long residentKb() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// One resting sell and one crossing buy per fill, for 1M fills (10M with
+// --scale 10), all between the same 8 counterparties.  Counterparty fill
+// history is a fixed ring, so resident memory should stop growing once the
+// rings are full; the growth over the last 90% of the run is reported.
+static void benchFillSoak() {
+    group("fill_history (bounded per-counterparty rings)");
+
+    const long fills      = scaled(1000000);
+    long       rssAtTenth = 0, rssAtEnd = 0;
+    bench("fill_soak", "resting sell + crossing buy", [&](BenchTimer& t) {
+        BenchEngine e;
+        rssAtTenth = 0;
+        for (long done = 0; done < fills; done += 1000) {
+            long n = std::min(1000L, fills - done);
+            t.timeBatch(n, [&] {
+                for (long i = done; i < done + n; ++i) {
+                    e.om.processNewOrder(Order("BENCH/H", 1.1000, 10, OrderType::SPOT_SELL, e.cp(i)));
+                    e.om.processNewOrder(Order("BENCH/H", 1.1000, 10, OrderType::SPOT_BUY,  e.cp(i + 3)));
+                }
+            });
+            if (done + n >= fills / 10 && rssAtTenth == 0) rssAtTenth = residentKb();
+        }
+        rssAtEnd = residentKb();
+    });
+    if (rssAtEnd)
+        *out << "  (" << fills << " fills: resident " << rssAtEnd << " KB, +"
+             << rssAtEnd - rssAtTenth << " KB over the last 90%)\n";
+}
+
+// ─── Time in force ────────────────────────────────────────────────────────────
+
+// Fill-or-kill orders that the book cannot fill, on books of growing depth
+// ("levels=L xK": L levels of K orders each).  The order's limit crosses
+// every level and asks for one lot more than they hold, so the pre-check
+// reads every level total, then rejects without touching an order.  More
+// orders per level only cost cache misses: the level nodes end up spread
+// among the order nodes.
+static void benchTimeInForce() {
+    group("fill-or-kill rejection (TradeManager::canFill)");
+
+    for (long levels : { 10L, 1000L }) {
+        for (long perLevel : { 1L, 100L }) {
+            bench("fok_reject levels=" + std::to_string(levels) + " x" + std::to_string(perLevel),
+                  "deep book", [&](BenchTimer& t) {
+                BenchEngine e;
+                for (long l = 0; l < levels; ++l)
+                    for (long k = 0; k < perLevel; ++k)
+                        e.om.processNewOrder(Order("BENCH/F", 1.0 + 0.0001 * static_cast<double>(l), 10,
+                                                   OrderType::SPOT_SELL, e.cp(k)));
+                Order fok("BENCH/F", 2.0, static_cast<int>(levels * perLevel * 10 + 1), OrderType::SPOT_BUY, e.cp(0));
+                fok.setTimeInForce(TimeInForce::FOK);
+                long filled = 0;
+                for (long i = 0; i < scaled(100000); i += 100)
+                    t.timeBatch(100, [&] {
+                        for (int k = 0; k < 100; ++k) e.om.processNewOrder(fok, &filled);
+                    });
+                if (filled) *out << "  (unexpected fill " << filled << ")\n";
+            });
+        }
+    }
+}
+
+// ─── Iceberg orders ───────────────────────────────────────────────────────────
+
+// One level of K makers showing 10 each, and a stream of 10-lot takers that
+// each clear the front slice.  An iceberg refills from its reserve and is
+// spliced to the back (PriceLevel::replenish); the plain maker has to post a
+// fresh 10-lot, which allocates a node and indexes it again.
+static void benchIceberg() {
+    group("iceberg replenish vs plain re-post");
+
+    for (long makers : { 1L, 100L }) {
+        for (bool iceberg : { true, false }) {
+            bench(std::string(iceberg ? "iceberg refill" : "plain re-post") + " makers=" + std::to_string(makers),
+                  "one level", [&](BenchTimer& t) {
+                BenchEngine e;
+                const long  n = scaled(100000);
+                for (long k = 0; k < makers; ++k) {
+                    Order o("BENCH/I", 1.0, iceberg ? static_cast<int>(10 * (n + 1)) : 10,
+                            OrderType::SPOT_SELL, e.cp(k));
+                    if (iceberg) o.setDisplayQuantity(10);
+                    e.om.processNewOrder(o);
+                }
+                for (long i = 0; i < n; i += 100)
+                    t.timeBatch(100, [&] {
+                        for (long k = 0; k < 100; ++k) {
+                            e.om.processNewOrder(Order("BENCH/I", 1.0, 10, OrderType::SPOT_BUY, e.cp(i + k)));
+                            if (!iceberg)
+                                e.om.processNewOrder(Order("BENCH/I", 1.0, 10, OrderType::SPOT_SELL, e.cp(i + k)));
+                        }
+                    });
+            });
+        }
+    }
+}
+
+// ─── Pegged orders ────────────────────────────────────────────────────────────
+
+// 10k orders quoted 1–10 ticks off the touch on both sides, 500 per (side,
+// offset), and a BBO that moves one tick on every change.  peg: the orders
+// are PRIMARY-pegged and processMarketTick re-prices their 20 groups.
+// amend / cxl+new: the orders are fixed-price and every one is moved by
+// processAmendOrder, or by cancel + new, as a client re-quoting must.
+// One op is one whole BBO change.
+static void benchPeg() {
+    group("pegged re-price per BBO change (10k orders)");
+
+    enum Mode { PEG, AMEND, CANCEL_NEW };
+    const double tick    = 0.0001;
+    const long   perSide = 5000;
+    for (Mode mode : { PEG, AMEND, CANCEL_NEW }) {
+        const char* what = mode == PEG ? "bbo peg" : mode == AMEND ? "bbo amend" : "bbo cxl+new";
+        bench(what, "10k orders", [&](BenchTimer& t) {
+            BenchEngine e;
+            std::vector<long> ids;
+            ids.reserve(static_cast<size_t>(2 * perSide));
+            double bid = 1.1000, ask = 1.1002;
+            e.mm.onQuote("BENCH/P", bid, 1000, ask, 1000);
+            for (long i = 0; i < 2 * perSide; ++i) {
+                const bool   buy    = i < perSide;
+                const double offset = tick * static_cast<double>(1 + i % 10);
+                Order o("BENCH/P", buy ? bid - offset : ask + offset, 100,
+                        buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(i));
+                if (mode == PEG) o.setPeg(PegType::PRIMARY, buy ? -offset : offset);
+                ids.push_back(o.getId());
+                e.om.processNewOrder(o);
+            }
+
+            for (long n = 0; n < scaled(100); ++n) {
+                const double move = (n & 1) ? -tick : tick;
+                bid += move;
+                ask += move;
+                t.time([&] {
+                    e.mm.onQuote("BENCH/P", bid, 1000, ask, 1000);
+                    if (mode == PEG) {
+                        e.om.processMarketTick("BENCH/P");
+                        return;
+                    }
+                    for (long& id : ids) {
+                        const Order* o = e.om.getOrder(id);
+                        if (mode == AMEND) {
+                            e.om.processAmendOrder(id, o->getPrice() + move, o->getQuantity());
+                            continue;
+                        }
+                        Order next("BENCH/P", o->getPrice() + move, 100, o->getType(), o->getCounterparty());
+                        e.om.processCancelOrder(id);
+                        e.om.processNewOrder(next);
+                        id = next.getId();
+                    }
+                });
+            }
+        });
+    }
+}
+
+// ─── Allocation policies ──────────────────────────────────────────────────────
+
+// One ask level of N makers (1–100 lots each) and a taker for half of it, so
+// the level is never cleared: FIFO fills the front orders in full, PRO_RATA
+// and TOP_ORDER give every maker a share.  The level is rebuilt, untimed,
+// before each taker.
+static void benchAllocation() {
+    group("allocation policy (one level, taker for half)");
+
+    for (Allocation policy : { Allocation::FIFO, Allocation::PRO_RATA, Allocation::TOP_ORDER }) {
+        for (long makers : { 10L, 100L }) {
+            bench(std::string("allocate ") + toString(policy), std::to_string(makers) + " orders", [&](BenchTimer& t) {
+                BenchEngine e;
+                e.om.setAllocation("BENCH/L", policy);
+                std::mt19937_64 rng(7);
+                const long n = scaled(2000);
+                for (long i = 0; i < n; ++i) {
+                    long level = 0;
+                    for (long k = 0; k < makers; ++k) {
+                        const long qty = 1 + static_cast<long>(rng() % 100);
+                        level += qty;
+                        e.om.processNewOrder(Order("BENCH/L", 1.1000, qty, OrderType::SPOT_SELL, e.cp(k)));
+                    }
+                    Order taker("BENCH/L", 1.1000, level / 2, OrderType::SPOT_BUY, e.cp(i));
+                    t.time([&] { e.om.processNewOrder(taker); });
+                    for (long c = 0; c < 8; ++c) e.om.cancelAll(*e.cp(c), "BENCH/L");   // what is left of the level
+                }
+            });
+        }
+    }
+}
+
+// ─── Self-trade prevention ────────────────────────────────────────────────────
+
+// One taker sweeps 100 resting orders at one price.  NONE is the plain
+// sweep; CANCEL_RESTING with no own orders in the book pays for the check
+// alone; with every 8th order its own, it also cancels 13 of them.
+static void benchSelfTrade() {
+    group("self-trade prevention (sweep of 100 orders)");
+
+    struct Case { const char* name; SelfTradePrevention stp; long firstMaker; };
+    for (const Case& c : { Case{ "stp NONE", SelfTradePrevention::NONE, 1 },
+                           Case{ "stp CANCEL_RESTING", SelfTradePrevention::CANCEL_RESTING, 1 },
+                           Case{ "stp CANCEL_RESTING", SelfTradePrevention::CANCEL_RESTING, 0 } }) {
+        bench(c.name, c.firstMaker ? "no own orders" : "1 in 8 own", [&](BenchTimer& t) {
+            BenchEngine e;
+            const long n = scaled(5000);
+            for (long i = 0; i < n; ++i) {
+                for (long k = 0; k < 100; ++k)   // makers: cp(1..7), or cp(0..7) with the taker's own
+                    e.om.processNewOrder(Order("BENCH/S", 1.1000, 100, OrderType::SPOT_SELL,
+                                               e.cp(c.firstMaker + k % (8 - c.firstMaker))));
+                Order taker("BENCH/S", 1.1000, 100 * 100, OrderType::SPOT_BUY, e.cp(0));
+                taker.setSelfTrade(c.stp);
+                t.time([&] { e.om.processNewOrder(taker); });
+                for (long cp = 0; cp < 8; ++cp) e.om.cancelAll(*e.cp(cp), "BENCH/S");   // the taker's remainder, if any
+            }
+        });
+    }
+}
+
+// ─── Batch auctions ───────────────────────────────────────────────────────────
+
+// An auction book of 100k orders, half bids and half asks, spread uniformly
+// over the same N ticks either side of 1.1000, so the crossed range is the
+// whole ladder.  uncross price is the price discovery alone (one pass over
+// the levels, read-only); auction is runAuction on a fresh book: discovery
+// plus every fill at that price.  Book builds are not timed.
+static void benchAuction() {
+    group("batch auction (100k orders)");
+
+    auto build = [](BenchEngine& e, long orders, long levels) {
+        std::mt19937_64 rng(42);
+        e.om.setAuctionMode("BENCH/A", true);
+        for (long i = 0; i < orders; ++i) {
+            const bool buy   = i % 2 == 0;
+            const long ticks = MID_TICKS - levels / 2 + static_cast<long>(rng() % static_cast<uint64_t>(levels));
+            const long qty   = 1 + static_cast<long>(rng() % 100);
+            e.om.processNewOrder(Order("BENCH/A", tickPrice(ticks), qty,
+                                       buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(i)));
+        }
+    };
+
+    const long orders = scaled(100000);
+    for (long levels : { 100L, 10000L }) {
+        bench("uncross price", std::to_string(levels) + " levels", [&](BenchTimer& t) {
+            BenchEngine e;
+            build(e, orders, levels);
+            const SubBook& sb = e.om.getSubBook("BENCH/A");
+            for (int n = 0; n < 200; ++n)
+                t.time([&] { TradeManager::uncrossPrice(sb); });
+        });
+    }
+    for (long levels : { 100L, 10000L }) {
+        bench("auction", std::to_string(levels) + " levels", [&](BenchTimer& t) {
+            for (int n = 0; n < 5; ++n) {
+                BenchEngine e;
+                build(e, orders, levels);
+                t.time([&] { e.om.runAuction("BENCH/A"); });
+            }
+        });
+    }
+}
+
+// ─── Amend ────────────────────────────────────────────────────────────────────
+
+// A passive two-sided book, then one change per order in random order: a
+// quantity cut and a one-tick price move through processAmendOrder, against
+// the cancel + new order a client had to send before.  Moves go away from
+// the spread, so nothing crosses.  With bus=on every book change is also
+// serialised for SSE, on a smaller book (50 levels a side).
+// ─── Swap matching ────────────────────────────────────────────────────────────
+
+// One op is a maker post and a taker that fills it, on a book 100 levels
+// deep behind the touch.  A swap fill executes two linked leg Trades and
+// reads the near rate from the quote; a spot fill executes one.
+static void benchSwap() {
+    group("swap vs spot match");
+
+    for (bool swap : { true, false }) {
+        bench(swap ? "swap match" : "spot match", "100 levels", [&](BenchTimer& t) {
+            BenchEngine e;
+            const OrderType sell = swap ? OrderType::SWAP_SELL : OrderType::SPOT_SELL;
+            const OrderType buy  = swap ? OrderType::SWAP_BUY  : OrderType::SPOT_BUY;
+            e.mm.onQuote("BENCH/S", 1.1000, 1000, 1.1002, 1000);
+            for (long k = 1; k <= 100; ++k)
+                e.om.processNewOrder(Order("BENCH/S", 0.0050 + 0.0001 * static_cast<double>(k), 100, sell, e.cp(k)));
+            const long n = scaled(100000);
+            for (long i = 0; i < n; i += 100)
+                t.timeBatch(100, [&] {
+                    for (long k = 0; k < 100; ++k) {
+                        e.om.processNewOrder(Order("BENCH/S", 0.0050, 10, sell, e.cp(i + k)));
+                        e.om.processNewOrder(Order("BENCH/S", 0.0050, 10, buy,  e.cp(i + k + 1)));
+                    }
+                });
+        });
+    }
+}
+
+// ─── Implied crosses ──────────────────────────────────────────────────────────
+
+// leg update: a bid that improves EUR/USD's touch and its cancel (two touch
+// moves per op), with EUR/USD a leg of 0, 1 or 8 crosses.  Each cross is
+// recomputed in O(1) per move, whatever the legs' depth.
+// implied fill: a EUR/GBP buy that fills at the implied ask as two leg
+// trades, and the two leg makers re-posting; direct fill is the same buy
+// against a EUR/GBP maker that re-posts.
+static void benchImplied() {
+    group("implied cross books");
+
+    static const char* others[] = { "GBP", "AUD", "NZD", "CAD", "CHF", "JPY", "SGD", "HKD" };
+    for (int crosses : { 0, 1, 8 }) {
+        bench("leg update crosses=" + std::to_string(crosses), "100 levels", [&](BenchTimer& t) {
+            BenchEngine e;
+            for (long k = 0; k < 100; ++k) {
+                e.om.processNewOrder(Order("EUR/USD", 1.0800 - 0.0001 * static_cast<double>(k), 100, OrderType::SPOT_BUY,  e.cp(k)));
+                e.om.processNewOrder(Order("EUR/USD", 1.0810 + 0.0001 * static_cast<double>(k), 100, OrderType::SPOT_SELL, e.cp(k)));
+            }
+            for (int c = 0; c < crosses; ++c) {
+                const std::string leg = std::string(others[c]) + "/USD";
+                e.om.processNewOrder(Order(leg, 0.50, 1000, OrderType::SPOT_BUY,  e.cp(c)));
+                e.om.processNewOrder(Order(leg, 0.51, 1000, OrderType::SPOT_SELL, e.cp(c)));
+                e.om.addImpliedCross(std::string("EUR/") + others[c], "EUR/USD", leg);
+            }
+            const long n = scaled(100000);
+            for (long i = 0; i < n; i += 100)
+                t.timeBatch(100, [&] {
+                    for (long k = 0; k < 100; ++k) {
+                        Order better("EUR/USD", 1.0805, 100, OrderType::SPOT_BUY, e.cp(i + k));
+                        e.om.processNewOrder(better);
+                        e.om.processCancelOrder(better.getId());
+                    }
+                });
+        });
+    }
+
+    for (bool implied : { true, false }) {
+        bench(implied ? "implied fill" : "direct fill", "EUR/GBP", [&](BenchTimer& t) {
+            BenchEngine e;
+            e.om.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD");
+            const long n = scaled(100000);
+            for (long i = 0; i < n; i += 100)
+                t.timeBatch(100, [&] {
+                    for (long k = 0; k < 100; ++k) {
+                        if (implied) {
+                            e.om.processNewOrder(Order("EUR/USD", 1.0800, 10, OrderType::SPOT_SELL, e.cp(i + k)));
+                            e.om.processNewOrder(Order("GBP/USD", 1.2500, 10, OrderType::SPOT_BUY,  e.cp(i + k)));
+                        } else {
+                            e.om.processNewOrder(Order("EUR/GBP", 0.8640, 10, OrderType::SPOT_SELL, e.cp(i + k)));
+                        }
+                        e.om.processNewOrder(Order("EUR/GBP", 0.8700, 10, OrderType::SPOT_BUY, e.cp(i + k + 1)));
+                    }
+                });
+        });
+    }
+}
+
+static void benchAmend() {
+    group("OrderManager::processAmendOrder vs cancel + new");
+
+    enum Mode { QTY_DOWN, PRICE, CANCEL_NEW };
+    const double tick = 0.0001;
+    for (bool withBus : { false, true }) {
+        const long n      = scaled(withBus ? 1000 : 10000);
+        const long levels = withBus ? 50 : 200;
+        for (Mode mode : { QTY_DOWN, PRICE, CANCEL_NEW }) {
+            const char* what = mode == QTY_DOWN ? "amend qty" : mode == PRICE ? "amend px" : "amend cxl+new";
+            bench(std::string(what) + (withBus ? " bus" : "") + " n=" + std::to_string(n), "passive book",
+                  [&](BenchTimer& t) {
+                BenchEngine e;
+                EventBus    bus;
+                if (withBus) e.om.setEventBus(&bus);
+                std::vector<long> ids;
+                ids.reserve(static_cast<size_t>(n));
+                for (long i = 0; i < n; ++i) {
+                    const bool   buy = (i & 1) == 0;
+                    const double px  = buy ? 1.0 - tick * static_cast<double>(i % levels)
+                                           : 1.1 + tick * static_cast<double>(i % levels);
+                    Order o("BENCH/A", px, 1000, buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(i));
+                    ids.push_back(o.getId());
+                    e.om.processNewOrder(o);
+                }
+                std::shuffle(ids.begin(), ids.end(), std::mt19937_64(23));
+
+                for (long id : ids) {
+                    const Order*  o     = e.om.getOrder(id);
+                    const double  px    = o->getPrice();
+                    const long    qty   = o->getQuantity();
+                    const double  moved = o->isBuyOrder() ? px - tick : px + tick;
+                    const OrderType type = o->getType();
+                    Counterparty* cp    = o->getCounterparty();
+                    switch (mode) {
+                        case QTY_DOWN: t.time([&] { e.om.processAmendOrder(id, px, qty / 2); });    break;
+                        case PRICE:    t.time([&] { e.om.processAmendOrder(id, moved, qty); });     break;
+                        case CANCEL_NEW:
+                            t.time([&] {
+                                e.om.processCancelOrder(id);
+                                e.om.processNewOrder(Order("BENCH/A", moved, qty, type, cp));
+                            });
+                            break;
+                    }
+                }
+            });
+        }
+    }
+}
+
+// ─── Quotes ───────────────────────────────────────────────────────────────────
+
+// A market maker re-prices a two-sided quote by one tick in 1 or 50
+// symbols, each with 20 orders of others resting a side, and an SSE bus
+// attached.  quote is one processQuote per symbol: both sides amended in
+// place, one book_update.  quote cxl+new does what a client without quotes
+// must: cancel both sides and enter two new orders, four book_updates.
+// Each op is one update of every symbol.
+static void benchQuote() {
+    group("OrderManager::processQuote vs cancel + new");
+
+    const double tick = 0.0001;
+    for (long symbols : { 1L, 50L }) {
+        for (bool quotes : { true, false }) {
+            bench(quotes ? "quote" : "quote cxl+new", std::to_string(symbols) + (symbols == 1 ? " symbol" : " symbols"), [&](BenchTimer& t) {
+                BenchEngine e;
+                EventBus    bus;
+                e.om.setEventBus(&bus);
+                std::vector<std::string> syms;
+                for (long s = 0; s < symbols; ++s) {
+                    syms.push_back("BENCH/Q" + std::to_string(s));
+                    for (long k = 0; k < 20; ++k) {
+                        const double away = tick * static_cast<double>(10 + k);
+                        e.om.processNewOrder(Order(syms.back(), 1.1000 - away, 1000, OrderType::SPOT_BUY,  e.cp(1 + k % 7)));
+                        e.om.processNewOrder(Order(syms.back(), 1.1000 + away, 1000, OrderType::SPOT_SELL, e.cp(1 + k % 7)));
+                    }
+                }
+
+                Counterparty&     mm = *e.cp(0);
+                std::vector<long> bids(syms.size(), 0), asks(syms.size(), 0);
+                const long        n  = scaled(symbols == 1 ? 5000 : 200);
+                for (long i = 0; i < n; ++i) {
+                    const double bid = 1.1000 - tick * static_cast<double>(2 + (i & 1));   // alternate one tick
+                    const double ask = bid + 4 * tick;
+                    if (quotes) {
+                        t.time([&] {
+                            for (const std::string& sym : syms) e.om.processQuote(mm, Quote{ sym, bid, 500, ask, 500 });
+                        });
+                        continue;
+                    }
+                    t.time([&] {
+                        for (size_t s = 0; s < syms.size(); ++s) {
+                            if (bids[s]) e.om.processCancelOrder(bids[s]);
+                            if (asks[s]) e.om.processCancelOrder(asks[s]);
+                            Order b(syms[s], bid, 500, OrderType::SPOT_BUY,  &mm);
+                            Order a(syms[s], ask, 500, OrderType::SPOT_SELL, &mm);
+                            bids[s] = b.getId();
+                            asks[s] = a.getId();
+                            e.om.processNewOrder(b);
+                            e.om.processNewOrder(a);
+                        }
+                    });
+                }
+            });
+        }
+    }
+}
+
+// ─── Pre-trade risk ───────────────────────────────────────────────────────────
+
+// risk_check times RiskManager::check alone, 1000 calls per sample, over
+// orders spread across 8 counterparties that already hold resting exposure.
+// queue_order risk=on repeats the clustered queue_order flow with the gate
+// installed, so the difference to queue_order is the gate's cost in place.
+static void benchRisk() {
+    group("risk (pre-trade gate)");
+
+    const RiskLimits limits{ 1000000, 1e9, 0.10, 1e12, 1e12 };
+    auto flow = generateFlow(Workload::CLUSTERED, scaled(50000), 200, 42);
+
+    for (bool band : { false, true }) {
+        bench("risk_check", band ? "all limits, quoted symbol" : "per-order and exposure limits",
+              [&](BenchTimer& t) {
+            BenchEngine e;
+            RiskManager risk(&e.mm);
+            RiskLimits  l = limits;
+            if (!band) l.priceBand = 0;
+            risk.setDefaultLimits(l);
+            e.om.setRiskManager(&risk);
+            e.mm.onQuote("BENCH/R", 1.0999, 1000000, 1.1001, 1000000);
+            for (long i = 0; i < 64; ++i)   // every counterparty has something resting
+                e.om.processNewOrder(Order("BENCH/R", 1.0990, 1000, OrderType::LIMIT_BUY, e.cp(i)));
+
+            std::vector<Order> orders;
+            for (long i = 0; i < 1000; ++i) {
+                const BenchOp& op = flow[static_cast<size_t>(i)];
+                orders.emplace_back("BENCH/R", op.price, op.quantity,
+                                    op.buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, e.cp(i));
+            }
+            long rejected = 0;
+            for (long done = 0; done < scaled(2000000); done += 1000)
+                t.timeBatch(1000, [&] {
+                    for (const Order& o : orders) rejected += risk.check(o) != RejectReason::NONE;
+                });
+            if (rejected) *out << "  (unexpected rejects " << rejected << ")\n";
+        });
+    }
+
+    bench("queue_order risk=on", workloadName(Workload::CLUSTERED), [&](BenchTimer& t) {
+        BenchEngine e;
+        RiskManager risk(&e.mm);
+        risk.setDefaultLimits(limits);
+        e.om.setRiskManager(&risk);
+        e.mm.onQuote("BENCH/Q", 1.0999, 1000000, 1.1001, 1000000);
+        runFlow(e, "BENCH/Q", flow, t);
+    });
+}
+
+// ─── Metrics scrape ───────────────────────────────────────────────────────────
+
+// The clustered queue_order flow with a scraper thread rendering the full
+// GET /metrics text every 2 ms, as a Prometheus server polling at a very
+// short interval would.  A scrape reads per-thread counters and relaxed
+// gauges only, so with a spare core the two rows match within noise; on a
+// single core the scraper's own run time shows up in the engine's samples.
+static void benchMetricsScrape() {
+    group("metrics scrape under load");
+
+    auto flow = generateFlow(Workload::CLUSTERED, scaled(50000), 200, 42);
+    for (bool scraping : { false, true }) {
+        bench("queue_order", scraping ? "scrape every 2 ms" : "no scrape", [&](BenchTimer& t) {
+            std::atomic<bool> done{false};
+            std::atomic<long> scrapes{0};
+            std::thread scraper([&] {
+                while (scraping && !done.load()) {
+                    std::string text = Metrics::prometheusText(nullptr) + LatencyRegistry::prometheusText();
+                    if (!text.empty()) scrapes.fetch_add(1);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            });
+            BenchEngine e;
+            runFlow(e, "BENCH/Q", flow, t);
+            done.store(true);
+            scraper.join();
+        });
+    }
+}
+
+// ─── Trade history ────────────────────────────────────────────────────────────
+
+// A scaled(10M)-fill history (--scale 10 for 100M, ~5 GB under /tmp), 25
+// symbols interleaved 1 µs apart, built once by the first benchmark that needs
+// it.  Scans report rows of history covered per second; the symbol scan reads
+// the timestamp and symbol columns of every block, the window queries show
+// what the block summaries skip.
+static void benchTradeStore() {
+    group("trade_store (columnar history, block-indexed scans)");
+
+    const std::string dir     = "/tmp/ts_bench_store_" + std::to_string(getpid());
+    const int64_t     startNs = 1700000000000000000LL;
+    auto fill = [&](TradeStore& store, long rows) {
+        std::vector<TradeRecord> batch(TradeFeed::BATCH);
+        for (long done = 0; done < rows; done += static_cast<long>(TradeFeed::BATCH)) {
+            size_t n = static_cast<size_t>(std::min(static_cast<long>(TradeFeed::BATCH), rows - done));
+            for (size_t k = 0; k < n; ++k) {
+                long         i = done + static_cast<long>(k);
+                TradeRecord& r = batch[k];
+                r = TradeRecord{};
+                r.tsNs       = startNs + i * 1000;
+                r.price      = 1.0840 + (i % 7) * 0.0001;
+                r.quantity   = 100;
+                r.buyOrderId = i;
+                std::snprintf(r.symbol, sizeof(r.symbol), "MKT/%ld", i % 25);
+            }
+            store.onTrades(batch.data(), n);
+        }
+    };
+
+    long appends = scaled(1000000);
+    bench("trade_store onTrades", "256-fill batches", [&](BenchTimer& t) {
+        std::filesystem::remove_all(dir);
+        TradeStore store;
+        store.open(dir);
+        std::vector<TradeRecord> batch(TradeFeed::BATCH);
+        for (size_t k = 0; k < batch.size(); ++k) {
+            batch[k] = TradeRecord{};
+            batch[k].price = 1.0840;
+            std::snprintf(batch[k].symbol, sizeof(batch[k].symbol), "MKT/%zu", k % 25);
+        }
+        for (long done = 0; done < appends; done += static_cast<long>(batch.size())) {
+            for (size_t k = 0; k < batch.size(); ++k) batch[k].tsNs = startNs + done + static_cast<long>(k);
+            t.timeBatch(static_cast<long>(batch.size()), [&] { store.onTrades(batch.data(), batch.size()); });
+        }
+    });
+    std::filesystem::remove_all(dir);
+
+    const long history = scaled(10000000);
+    TradeStore store;
+    auto ensureHistory = [&] {
+        if (store.size() == static_cast<size_t>(history)) return;
+        std::filesystem::remove_all(dir);
+        store.open(dir);
+        fill(store, history);
+    };
+    const std::string rowsLabel = std::to_string(history / 1000000) + "M";
+
+    bench("trade_store count symbol", rowsLabel + ", full scan", [&](BenchTimer& t) {
+        ensureHistory();
+        TradeQuery q;
+        q.symbol = "MKT/7";
+        size_t n = 0;
+        t.timeBatch(history, [&] { n = store.count(q); });
+        if (n != static_cast<size_t>((history + 17) / 25)) *out << "  (unexpected count " << n << ")\n";
+    });
+
+    bench("trade_store query window", rowsLabel + ", 1 ms window", [&](BenchTimer& t) {
+        ensureHistory();
+        TradeQuery q;
+        q.symbol = "MKT/7";
+        for (long i = 0; i < 2000; ++i) {
+            q.fromNs = startNs + (i * 7919 % history) * 1000;
+            q.toNs   = q.fromNs + 1000000;
+            t.time([&] { store.query(q); });
+        }
+    });
+
+    bench("trade_store query latest", rowsLabel + ", newest 100", [&](BenchTimer& t) {
+        ensureHistory();
+        TradeQuery q;
+        q.symbol = "MKT/7";
+        for (long i = 0; i < 2000; ++i) t.time([&] { store.query(q); });
+    });
+    store.close();
+    std::filesystem::remove_all(dir);
+}
+
+// ─── Main ─────────────────────────────────────────────────────────────────────
+
+int main(int argc, char* argv[]) {
+    std::string jsonPath, label = "local";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if      (arg == "--json"  && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--label" && i + 1 < argc) label    = argv[++i];
+        else if (arg == "--scale" && i + 1 < argc) scale    = std::atof(argv[++i]);
+        else                                       benchFilter = arg;
+    }
+
+    // Keep the real stdout for results; silence engine logging
+    std::ostream realOut(std::cout.rdbuf());
+    out = &realOut;
+    std::cout.rdbuf(nullptr);
+
+    *out << "TradingSystem benchmarks (scale " << scale << ", "
+         << std::setprecision(3) << LatencyRegistry::ticksPerNs() << " ticks/ns)\n";
+
+    benchQueueOrder();
+    benchRisk();
+    benchMetricsScrape();
+    benchCancel();
+    benchAmend();
+    benchQuote();
+    benchTimeInForce();
+    benchIceberg();
+    benchPeg();
+    benchSwap();
+    benchImplied();
+    benchAuction();
+    benchAllocation();
+    benchSelfTrade();
+    benchMatch();
+    benchPublishBookUpdate();
+    benchEventBus();
+    benchCsvLoad();
+    benchMarketData();
+    benchMarketTrigger();
+    benchTradeFeed();
+    benchFillSoak();
+    benchTradeStore();
+
+    if (!jsonPath.empty()) {
+        writeJson(jsonPath, label);
+        *out << "\nWrote " << results.size() << " results to " << jsonPath << "\n";
+    }
+    return 0;
+}
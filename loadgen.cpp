@@ -0,0 +1,498 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Latency.h"
+#include "httplib.h"
+
+// ─── HTTP load generator ──────────────────────────────────────────────────────
+//
+// Drives POST /orders and DELETE /orders/:id against a running HTTPServer
+// from N worker threads, each with its own keep-alive connection, while M SSE
+// clients hold GET /events?trace=1 open.  Records end-to-end request latency,
+// the delay from submitting an aggressive order to receiving its trade event,
+// and the server's own share of that delay (the event's embedded serverNs).
+//
+//   ./loadgen --threads 4 --rate 2000 --duration 30 --sse 2
+//   ./loadgen --replay forex_orders.csv --rate 20 --duration 0   # old run_orders_loop.sh
+//
+// With --rate 0 each worker is closed-loop (next request as soon as the last
+// one returns).  With a rate, each worker follows a fixed send schedule and
+// latency is measured from the *scheduled* send time, so a stalled server
+// shows up as queueing delay instead of being hidden by the client slowing
+// down (coordinated omission).
+//
+// All latencies are steady_clock nanoseconds recorded into LatencyHistograms.
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<bool> stopping{false};
+
+static void onSignal(int) { stopping.store(true); }
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+    std::string              host          = "localhost";
+    int                      port          = 9090;
+    int                      threads       = 4;
+    double                   rate          = 0;      // total requests/s, 0 = closed loop
+    double                   duration      = 10;     // seconds, 0 = until Ctrl+C
+    double                   cancelRatio   = 0.3;    // share of requests that are cancels
+    double                   crossRatio    = 0.2;    // share of new orders priced to trade
+    double                   symbolSkew    = 0;      // Zipf exponent, 0 = uniform
+    double                   cpSkew        = 0;
+    int                      sse           = 1;      // SSE subscribers
+    std::string              csvPath       = "forex_orders.csv";
+    bool                     replay        = false;  // submit CSV rows in order, looping
+    std::vector<std::string> counterparties{ "Goldman Sachs", "JP Morgan", "Deutsche Bank" };
+    std::string              jsonPath;
+    uint64_t                 seed          = 1;
+};
+
+// ─── Workload ─────────────────────────────────────────────────────────────────
+
+struct CsvRow {
+    std::string symbol;
+    double      price;
+    long        quantity;
+    bool        buy;
+};
+
+struct SymbolInfo {
+    std::string name;
+    double      refPrice;   // mean CSV price; synthetic orders are placed around it
+};
+
+static std::vector<CsvRow> readCsv(const std::string& path) {
+    std::vector<CsvRow> rows;
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);   // header
+    while (std::getline(f, line)) {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        std::string symbol, price, quantity, side;
+        std::getline(ss, symbol, ',');
+        std::getline(ss, price, ',');
+        std::getline(ss, quantity, ',');
+        std::getline(ss, side, ',');
+        if (!side.empty() && side.back() == '\r') side.pop_back();
+        rows.push_back({ symbol, std::stod(price), std::stol(quantity), side == "BUY" });
+    }
+    return rows;
+}
+
+// Zipf-weighted index sampler over n items (exponent 0 = uniform)
+class SkewedPicker
+{
+public:
+    SkewedPicker(size_t n, double exponent) {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+            cdf_.push_back(sum);
+        }
+        for (double& c : cdf_) c /= sum;
+    }
+
+    template<typename Rng>
+    size_t pick(Rng& rng) const {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return static_cast<size_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin())
+               % cdf_.size();
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// ─── Results ──────────────────────────────────────────────────────────────────
+
+enum class Op { NEW_ORDER = 0, CANCEL, COUNT };
+
+static const char* opName(Op op) {
+    return op == Op::NEW_ORDER ? "POST /orders" : "DELETE /orders/:id";
+}
+
+// Per-worker results, merged when the run ends
+struct WorkerStats {
+    LatencyHistogram latency[static_cast<int>(Op::COUNT)];
+    long             errors[static_cast<int>(Op::COUNT)] = {};
+
+    // Aggressive orders: id → scheduled send time, joined with trade events
+    std::vector<std::pair<long, int64_t>> aggressorSent;
+};
+
+// Per-subscriber results
+struct SseStats {
+    long trades      = 0;
+    long bookUpdates = 0;
+    long bytes       = 0;
+
+    // First trade event seen for each order id → receive time
+    std::map<long, int64_t> tradeSeen;
+
+    // Server-side ingress → socket-write time embedded by GET /events?trace=1
+    LatencyHistogram serverTrade;
+};
+
+// Pull the integer after "key": out of a JSON fragment
+static long jsonLong(const std::string& s, const std::string& key) {
+    auto pos = s.find("\"" + key + "\":");
+    if (pos == std::string::npos) return 0;
+    return std::strtol(s.c_str() + pos + key.size() + 3, nullptr, 10);
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// ─── Worker ───────────────────────────────────────────────────────────────────
+
+static void runWorker(int index, const Options& opt, const std::vector<CsvRow>& rows,
+                      const std::vector<SymbolInfo>& symbols, int64_t endNs, WorkerStats& stats) {
+    httplib::Client cli(opt.host, opt.port);
+    cli.set_keep_alive(true);
+    cli.set_tcp_nodelay(true);   // headers and body go out in separate writes
+
+    std::mt19937_64 rng(opt.seed * 7919 + static_cast<uint64_t>(index));
+    SkewedPicker    symbolPicker(symbols.size(), opt.symbolSkew);
+    SkewedPicker    cpPicker(opt.counterparties.size(), opt.cpSkew);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::geometric_distribution<int>       distance(0.3);
+    std::uniform_int_distribution<int>     lots(1, 10);
+
+    std::vector<long> open;   // this worker's submitted, not-yet-cancelled orders
+    size_t replayRow = static_cast<size_t>(index);
+
+    const double  perThreadRate = opt.rate / opt.threads;
+    const int64_t intervalNs    = perThreadRate > 0 ? static_cast<int64_t>(1e9 / perThreadRate) : 0;
+    int64_t       scheduled     = nowNs();
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (intervalNs > 0) {
+            int64_t now = nowNs();
+            if (scheduled > now)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(scheduled - now));
+        } else {
+            scheduled = nowNs();
+        }
+        if (endNs && scheduled >= endNs) break;
+
+        // In replay mode a worker cancels everything it placed after each
+        // pass over the file, mirroring the old curl loop
+        bool cancel;
+        if (opt.replay) cancel = replayRow >= rows.size() && !open.empty();
+        else            cancel = !open.empty() && unit(rng) < opt.cancelRatio;
+
+        if (cancel) {
+            size_t idx = opt.replay ? open.size() - 1
+                                    : static_cast<size_t>(rng() % open.size());
+            long id = open[idx];
+            open[idx] = open.back();
+            open.pop_back();
+
+            auto res = cli.Delete("/orders/" + std::to_string(id));
+            stats.latency[static_cast<int>(Op::CANCEL)].record(
+                static_cast<uint64_t>(nowNs() - scheduled));
+            if (!res || res->status != 200) ++stats.errors[static_cast<int>(Op::CANCEL)];
+        } else {
+            if (opt.replay && replayRow >= rows.size()) replayRow = static_cast<size_t>(index);
+
+            std::string symbol, cp = opt.counterparties[cpPicker.pick(rng)];
+            double      price;
+            long        quantity;
+            bool        buy, aggressive = false;
+            if (opt.replay) {
+                const CsvRow& r = rows[replayRow];
+                replayRow += static_cast<size_t>(opt.threads);
+                symbol = r.symbol; price = r.price; quantity = r.quantity; buy = r.buy;
+            } else {
+                const SymbolInfo& s = symbols[symbolPicker.pick(rng)];
+                const double tick = s.refPrice * 1e-4;
+                symbol     = s.name;
+                buy        = (rng() & 1) == 0;
+                aggressive = unit(rng) < opt.crossRatio;
+                // Passive orders rest 1+ ticks off the reference price;
+                // aggressive ones reach 2 ticks through it to the other side
+                int ticks  = aggressive ? -2 : 1 + distance(rng);
+                price      = buy ? s.refPrice - ticks * tick : s.refPrice + ticks * tick;
+                quantity   = lots(rng) * 100000L;
+            }
+
+            std::ostringstream body;
+            body << std::setprecision(10)
+                 << "{\"symbol\":\"" << jsonEscape(symbol) << "\",\"price\":" << price
+                 << ",\"quantity\":" << quantity << ",\"side\":\"" << (buy ? "BUY" : "SELL")
+                 << "\",\"counterparty\":\"" << jsonEscape(cp) << "\"}";
+
+            auto res = cli.Post("/orders", body.str(), "application/json");
+            stats.latency[static_cast<int>(Op::NEW_ORDER)].record(
+                static_cast<uint64_t>(nowNs() - scheduled));
+            if (!res || res->status != 200) {
+                ++stats.errors[static_cast<int>(Op::NEW_ORDER)];
+            } else {
+                long id = jsonLong(res->body, "orderId");
+                if (id > 0) {
+                    open.push_back(id);
+                    if (aggressive || opt.replay) stats.aggressorSent.emplace_back(id, scheduled);
+                }
+            }
+        }
+
+        scheduled += intervalNs;
+    }
+}
+
+// ─── SSE subscriber ───────────────────────────────────────────────────────────
+
+static void runSubscriber(const Options& opt, httplib::Client& cli, SseStats& stats) {
+    std::string buffer;
+    cli.Get("/events?trace=1", [&](const char* data, size_t len) {
+        const int64_t now = nowNs();
+        stats.bytes += static_cast<long>(len);
+        buffer.append(data, len);
+
+        // SSE messages are separated by a blank line
+        size_t end;
+        while ((end = buffer.find("\n\n")) != std::string::npos) {
+            std::string msg = buffer.substr(0, end);
+            buffer.erase(0, end + 2);
+            if (msg.compare(0, 12, "event: trade") == 0) {
+                ++stats.trades;
+                // The aggressor is the newer (larger) of the two order ids
+                long id = std::max(jsonLong(msg, "buyOrderId"), jsonLong(msg, "sellOrderId"));
+                stats.tradeSeen.emplace(id, now);
+                if (long serverNs = jsonLong(msg, "serverNs"))
+                    stats.serverTrade.record(static_cast<uint64_t>(serverNs));
+            } else if (msg.compare(0, 18, "event: book_update") == 0) {
+                ++stats.bookUpdates;
+            }
+        }
+        return !stopping.load(std::memory_order_relaxed);
+    });
+    (void)opt;
+}
+
+// ─── Report ───────────────────────────────────────────────────────────────────
+
+static void printHistogram(std::ostream& out, const std::string& name,
+                           const LatencyHistogram& h, long errors, double seconds) {
+    auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    out << std::fixed << std::setprecision(1)
+        << "  " << std::left << std::setw(22) << name << std::right
+        << std::setw(9)  << h.count()
+        << std::setw(8)  << errors
+        << std::setw(10) << (seconds > 0 ? static_cast<double>(h.count()) / seconds : 0.0)
+        << std::setw(10) << us(h.percentile(0.50))
+        << std::setw(10) << us(h.percentile(0.90))
+        << std::setw(10) << us(h.percentile(0.99))
+        << std::setw(10) << us(h.percentile(0.999))
+        << std::setw(11) << us(h.max()) << "\n";
+}
+
+static void jsonHistogram(std::ostream& out, const std::string& name,
+                          const LatencyHistogram& h, long errors) {
+    out << "    {\"name\": \"" << name << "\", \"count\": " << h.count()
+        << ", \"errors\": " << errors
+        << ", \"p50_ns\": "  << h.percentile(0.50)
+        << ", \"p90_ns\": "  << h.percentile(0.90)
+        << ", \"p99_ns\": "  << h.percentile(0.99)
+        << ", \"p999_ns\": " << h.percentile(0.999)
+        << ", \"max_ns\": "  << h.max() << "}";
+}
+
+static void usage() {
+    std::cerr <<
+        "Usage: loadgen [options]\n"
+        "  --host H            server host (localhost)\n"
+        "  --port P            server port (9090)\n"
+        "  --threads N         worker connections (4)\n"
+        "  --rate R            total requests/s across workers; 0 = closed loop (0)\n"
+        "  --duration S        seconds to run; 0 = until Ctrl+C (10)\n"
+        "  --cancel-ratio F    share of requests that cancel an open order (0.3)\n"
+        "  --cross-ratio F     share of new orders priced to trade (0.2)\n"
+        "  --symbol-skew Z     Zipf exponent over symbols; 0 = uniform (0)\n"
+        "  --cp-skew Z         Zipf exponent over counterparties (0)\n"
+        "  --counterparties L  comma-separated names (the server's three)\n"
+        "  --sse N             SSE subscribers (1)\n"
+        "  --csv PATH          symbols and reference prices (forex_orders.csv)\n"
+        "  --replay PATH       submit PATH's rows in order, cancel, repeat\n"
+        "  --seed N            RNG seed (1)\n"
+        "  --json PATH         also write results as JSON\n";
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(1); }
+            return argv[++i];
+        };
+        if      (arg == "--help")       { usage(); return 0; }
+        else if (arg == "--host")         opt.host        = next();
+        else if (arg == "--port")         opt.port        = std::atoi(next().c_str());
+        else if (arg == "--threads")      opt.threads     = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--rate")         opt.rate        = std::atof(next().c_str());
+        else if (arg == "--duration")     opt.duration    = std::atof(next().c_str());
+        else if (arg == "--cancel-ratio") opt.cancelRatio = std::atof(next().c_str());
+        else if (arg == "--cross-ratio")  opt.crossRatio  = std::atof(next().c_str());
+        else if (arg == "--symbol-skew")  opt.symbolSkew  = std::atof(next().c_str());
+        else if (arg == "--cp-skew")      opt.cpSkew      = std::atof(next().c_str());
+        else if (arg == "--sse")          opt.sse         = std::max(0, std::atoi(next().c_str()));
+        else if (arg == "--csv")          opt.csvPath     = next();
+        else if (arg == "--replay")     { opt.csvPath     = next(); opt.replay = true; }
+        else if (arg == "--seed")         opt.seed        = std::strtoull(next().c_str(), nullptr, 10);
+        else if (arg == "--json")         opt.jsonPath    = next();
+        else if (arg == "--counterparties") {
+            opt.counterparties.clear();
+            std::stringstream ss(next());
+            std::string name;
+            while (std::getline(ss, name, ',')) if (!name.empty()) opt.counterparties.push_back(name);
+        } else { usage(); return 1; }
+    }
+
+    std::vector<CsvRow> rows = readCsv(opt.csvPath);
+    if (rows.empty()) {
+        std::cerr << "Error: no orders in " << opt.csvPath << std::endl;
+        return 1;
+    }
+    if (opt.counterparties.empty()) opt.counterparties.push_back("Goldman Sachs");
+
+    // Reference price per symbol = mean of its CSV prices
+    std::map<std::string, std::pair<double, int>> sums;
+    for (const CsvRow& r : rows) { sums[r.symbol].first += r.price; ++sums[r.symbol].second; }
+    std::vector<SymbolInfo> symbols;
+    for (const auto& [name, s] : sums) symbols.push_back({ name, s.first / s.second });
+
+    {
+        httplib::Client probe(opt.host, opt.port);
+        if (!probe.Get("/symbols")) {
+            std::cerr << "Error: no server at " << opt.host << ":" << opt.port << std::endl;
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, onSignal);
+
+    // SSE subscribers first, so they see every trade
+    std::vector<std::unique_ptr<httplib::Client>> sseClients;
+    std::vector<SseStats>                         sseStats(static_cast<size_t>(opt.sse));
+    std::vector<std::thread>                      sseThreads;
+    for (int i = 0; i < opt.sse; ++i) {
+        sseClients.push_back(std::make_unique<httplib::Client>(opt.host, opt.port));
+        sseThreads.emplace_back(runSubscriber, std::cref(opt), std::ref(*sseClients.back()),
+                                std::ref(sseStats[static_cast<size_t>(i)]));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::cout << "loadgen: " << opt.threads << " workers, "
+              << (opt.rate > 0 ? std::to_string(static_cast<long>(opt.rate)) + " req/s" : "closed loop")
+              << ", " << opt.sse << " SSE subscribers, "
+              << (opt.replay ? "replaying " + opt.csvPath : std::to_string(symbols.size()) + " symbols")
+              << (opt.duration > 0 ? ", " + std::to_string(static_cast<long>(opt.duration)) + " s" : ", Ctrl+C to stop")
+              << std::endl;
+
+    const int64_t startNs = nowNs();
+    const int64_t endNs   = opt.duration > 0 ? startNs + static_cast<int64_t>(opt.duration * 1e9) : 0;
+
+    std::vector<WorkerStats> workerStats(static_cast<size_t>(opt.threads));
+    std::vector<std::thread> workers;
+    for (int i = 0; i < opt.threads; ++i)
+        workers.emplace_back(runWorker, i, std::cref(opt), std::cref(rows), std::cref(symbols),
+                             endNs, std::ref(workerStats[static_cast<size_t>(i)]));
+    for (auto& t : workers) t.join();
+    const double seconds = static_cast<double>(nowNs() - startNs) / 1e9;
+
+    // Let trailing events drain, then disconnect the subscribers
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stopping.store(true);
+    for (auto& c : sseClients) c->stop();
+    for (auto& t : sseThreads) t.join();
+
+    // ── Merge ────────────────────────────────────────────────────────────────
+    LatencyHistogram latency[static_cast<int>(Op::COUNT)];
+    long             errors[static_cast<int>(Op::COUNT)] = {};
+    for (const WorkerStats& w : workerStats)
+        for (int op = 0; op < static_cast<int>(Op::COUNT); ++op) {
+            latency[op].merge(w.latency[op]);
+            errors[op] += w.errors[op];
+        }
+
+    // Trade event delay: scheduled send of the aggressive order → first
+    // trade event for it, per subscriber
+    LatencyHistogram tradeDelay, serverTrade;
+    long sseTrades = 0, sseBooks = 0, sseBytes = 0;
+    for (const SseStats& s : sseStats) {
+        serverTrade.merge(s.serverTrade);
+        sseTrades += s.trades;
+        sseBooks  += s.bookUpdates;
+        sseBytes  += s.bytes;
+        for (const WorkerStats& w : workerStats)
+            for (const auto& [id, sent] : w.aggressorSent) {
+                auto it = s.tradeSeen.find(id);
+                if (it != s.tradeSeen.end() && it->second >= sent)
+                    tradeDelay.record(static_cast<uint64_t>(it->second - sent));
+            }
+    }
+
+    std::cout << "\n  " << std::left << std::setw(22) << "latency (us)" << std::right
+              << std::setw(9) << "count" << std::setw(8) << "errors" << std::setw(10) << "req/s"
+              << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(11) << "max" << "\n";
+    for (int op = 0; op < static_cast<int>(Op::COUNT); ++op)
+        printHistogram(std::cout, opName(static_cast<Op>(op)), latency[op], errors[op], seconds);
+    printHistogram(std::cout, "trade event delay", tradeDelay, 0, seconds);
+    printHistogram(std::cout, "  of which in server", serverTrade, 0, seconds);
+
+    std::cout << std::setprecision(1)
+              << "\n  " << seconds << " s, SSE received " << sseTrades << " trade and "
+              << sseBooks << " book_update events (" << sseBytes / 1024 << " KiB) across "
+              << opt.sse << " subscribers\n";
+
+    if (!opt.jsonPath.empty()) {
+        std::ofstream f(opt.jsonPath);
+        f << std::fixed << std::setprecision(3)
+          << "{\n  \"seconds\": " << seconds
+          << ",\n  \"threads\": " << opt.threads
+          << ",\n  \"rate\": " << opt.rate
+          << ",\n  \"sse_subscribers\": " << opt.sse
+          << ",\n  \"sse_trades\": " << sseTrades
+          << ",\n  \"sse_book_updates\": " << sseBooks
+          << ",\n  \"latency\": [\n";
+        for (int op = 0; op < static_cast<int>(Op::COUNT); ++op) {
+            jsonHistogram(f, opName(static_cast<Op>(op)), latency[op], errors[op]);
+            f << ",\n";
+        }
+        jsonHistogram(f, "trade event delay", tradeDelay, 0);
+        f << ",\n";
+        jsonHistogram(f, "trade event server time", serverTrade, 0);
+        f << "\n  ]\n}\n";
+        std::cout << "  Wrote " << opt.jsonPath << "\n";
+    }
+    return 0;
+}
@@ -7,8 +7,8 @@ echo "Building TradingSystem..."
 g++ -std=c++17 -fdiagnostics-color=always -g \
     Counterparty.cpp Order.cpp OrderBook.cpp OrderManager.cpp SubBook.cpp \
     MarketPrice.cpp MarketManager.cpp TradeManager.cpp \
-    EventBus.cpp HTTPServer.cpp TradingSystem.cpp \
+    EventBus.cpp HTTPServer.cpp Latency.cpp Metrics.cpp CsvLoader.cpp FeedReplayer.cpp TradeFeed.cpp CandleAggregator.cpp TradeStore.cpp RiskManager.cpp PositionKeeper.cpp ImpliedPricer.cpp TradingSystem.cpp \
     -lpthread -o TradingSystem
 
 echo "Starting server..."
-./TradingSystem
+./TradingSystem --trade-store trade_store
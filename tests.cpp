@@ -1,11 +1,40 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "CandleAggregator.h"
 #include "Counterparty.h"
+#include "EventBus.h"
+#include "FeedReplayer.h"
+#include "ImpliedPricer.h"
+#include "Latency.h"
+#include "Metrics.h"
+#include "MarketPrice.h"
 #include "OrderManager.h"
 #include "MarketManager.h"
 #include "Order.h"
 #include "OrderType.h"
+#include "PositionKeeper.h"
+#include "RiskManager.h"
+#include "SpscRing.h"
 #include "SubBook.h"
+#include "TradeFeed.h"
+#include "TradeManager.h"
+#include "TradeStore.h"
 
 // ─── Minimal test framework ───────────────────────────────────────────────────
 //
@@ -61,7 +90,7 @@ int main(int argc, char* argv[]) {
             std::string sym = std::string("BUY.") + names[i];
             Order o(sym, 1.0000, 100, buyTypes[i], &cp);
             om.processNewOrder(o);
-            SubBook& sb = om.getSubBook(sym);
+            SubBook& sb = isSwapOrder(buyTypes[i]) ? om.getSwapBook(sym) : om.getSubBook(sym);   // swaps have their own book
             check(std::string(names[i]) + " routes to buyOrders",  !sb.getBuyOrdersRef().empty());
             check(std::string(names[i]) + " not in sellOrders",     sb.getSellOrdersRef().empty());
         }
@@ -79,7 +108,7 @@ int main(int argc, char* argv[]) {
             std::string sym = std::string("SELL.") + names[i];
             Order o(sym, 1.0000, 100, sellTypes[i], &cp);
             om.processNewOrder(o);
-            SubBook& sb = om.getSubBook(sym);
+            SubBook& sb = isSwapOrder(sellTypes[i]) ? om.getSwapBook(sym) : om.getSubBook(sym);
             check(std::string(names[i]) + " routes to sellOrders",  !sb.getSellOrdersRef().empty());
             check(std::string(names[i]) + " not in buyOrders",       sb.getBuyOrdersRef().empty());
         }
@@ -211,7 +240,7 @@ int main(int argc, char* argv[]) {
         Counterparty trader("Trader A");
 
         Order x("SGD/USD", 0.7400, 500,  OrderType::SWAP_BUY,  &trader);
-        Order y("SGD/USD", 0.7400, 1000, OrderType::SWAP_SELL, &trader);
+        Order y("SGD/USD", 0.7420, 1000, OrderType::SWAP_SELL, &trader);
         Order z("SGD/USD", 0.7410, 750,  OrderType::SWAP_BUY,  &trader);
         long idX = x.getId(), idY = y.getId(), idZ = z.getId();
 
@@ -233,7 +262,7 @@ int main(int argc, char* argv[]) {
         Counterparty beta("Beta Fund");
 
         Order a("HKD/USD", 0.1280, 200, OrderType::SWAP_BUY,  &alpha);
-        Order b("HKD/USD", 0.1280, 300, OrderType::SWAP_SELL, &beta);
+        Order b("HKD/USD", 0.1290, 300, OrderType::SWAP_SELL, &beta);
         Order c("HKD/USD", 0.1285, 400, OrderType::SWAP_BUY,  &alpha);
 
         om.processNewOrder(a);
@@ -276,6 +305,24 @@ int main(int argc, char* argv[]) {
         check("Counterparty unchanged",       desk.getOrderIds().size() == 1);
     }
 
+    // Open orders are an indexed set: removal from the middle swaps in the
+    // last id, duplicates and unknown ids are ignored
+    {
+        Counterparty mm("Set Desk");
+        for (long id = 1; id <= 5; ++id) mm.addOrderId(id);
+        mm.addOrderId(3);
+        check("Duplicate add ignored",        mm.getOrderIds().size() == 5);
+
+        mm.removeOrderId(2);
+        const auto& ids = mm.getOrderIds();
+        check("Middle removal swaps in last", ids.size() == 4 && ids[1] == 5);
+        check("Membership follows removal",   !mm.hasOrderId(2) && mm.hasOrderId(5) && mm.hasOrderId(1));
+        mm.removeOrderId(42);
+        mm.removeOrderId(5);
+        mm.removeOrderId(4);
+        check("Unknown id ignored; set kept", ids.size() == 2 && mm.hasOrderId(3) && !mm.hasOrderId(5));
+    }
+
     // ── 7. SPOT Matching Engine ───────────────────────────────────────────────
     section("SPOT Matching Engine");
 
@@ -301,7 +348,7 @@ int main(int argc, char* argv[]) {
         check("Exact: buyer's orderId removed",  buyer.getOrderIds().empty());
         check("Exact: seller never queued",      seller.getOrderIds().empty());
         check("Exact: seller's counterparty name seen by buyer",
-              buyer.getTrades()[0].counterpartyName == "Seller.A");
+              buyer.getTrades()[0].counterpartyName() == "Seller.A");
     }
 
     // 7b. Incoming buy larger than standing ask — ask consumed, buy remainder queued
@@ -426,7 +473,7 @@ int main(int argc, char* argv[]) {
         check("Sell exact: buyer's orderId removed",  buyer.getOrderIds().empty());
         check("Sell exact: seller never queued",      seller.getOrderIds().empty());
         check("Sell exact: buyer's counterparty name seen by seller",
-              seller.getTrades()[0].counterpartyName == "Buyer.G");
+              seller.getTrades()[0].counterpartyName() == "Buyer.G");
     }
 
     // ── 8. Trade Pricing — execution at the maker (standing-order) price ─────
@@ -579,9 +626,9 @@ int main(int argc, char* argv[]) {
         om.processNewOrder(ask);
 
         check("ND 10c: buyer sees seller's name",
-              buyer.getTrades()[0].counterpartyName  == "ND.Seller.C");
+              buyer.getTrades()[0].counterpartyName()  == "ND.Seller.C");
         check("ND 10c: seller sees buyer's name",
-              seller.getTrades()[0].counterpartyName == "ND.Buyer.C");
+              seller.getTrades()[0].counterpartyName() == "ND.Buyer.C");
     }
 
     // 10d. Partial fill: notification quantity is the fill qty, not the original order qty
@@ -727,6 +774,2242 @@ int main(int argc, char* argv[]) {
         check("PB 12d: ask stays in book",                  !om.getSubBook("PB/D").getSellOrdersRef().empty());
     }
 
+    // ── 13. Latency Histograms ───────────────────────────────────────────────
+    section("Latency Histograms");
+
+    // 13a. Small values are counted exactly; larger ones within 1/32 relative error
+    {
+        LatencyHistogram h;
+        for (uint64_t v = 1; v <= 10000; ++v) h.record(v);
+
+        uint64_t p50 = h.percentile(0.50);
+        uint64_t p99 = h.percentile(0.99);
+        check("LH 13a: count is 10000",                h.count() == 10000);
+        check("LH 13a: max is 10000",                  h.max()   == 10000);
+        check("LH 13a: values below 32 map 1:1",       LatencyHistogram::bucketFor(31) == 31);
+        check("LH 13a: p50 within 1/32 of 5000",       p50 > 5000 - 5000 / 32 && p50 < 5000 + 5000 / 32);
+        check("LH 13a: p99 within 1/32 of 9900",       p99 > 9900 - 9900 / 32 && p99 < 9900 + 9900 / 32);
+        check("LH 13a: p100 never exceeds max",        h.percentile(1.0) <= h.max());
+    }
+
+    // 13b. Bucket bounds are contiguous across a power-of-two boundary
+    {
+        int b = LatencyHistogram::bucketFor(64);
+        check("LH 13b: 63 and 64 land in adjacent buckets",
+              LatencyHistogram::bucketFor(63) + 1 == b);
+        check("LH 13b: bucket low of 64 is 64",        LatencyHistogram::bucketLow(b) == 64);
+        check("LH 13b: next bucket starts after high",
+              LatencyHistogram::bucketLow(b + 1) == LatencyHistogram::bucketHigh(b) + 1);
+    }
+
+    // 13c. Engine probes feed the registry and the exposition text
+    {
+        LatencyHistogram before, after;
+        LatencyRegistry::collect(LatencyStage::PROCESS_NEW_ORDER, before);
+        om.processNewOrder(Order("LAT/A", 1.0000, 100, OrderType::SPOT_BUY, &cp));
+        LatencyRegistry::collect(LatencyStage::PROCESS_NEW_ORDER, after);
+
+        std::string text = LatencyRegistry::prometheusText();
+#ifndef TS_NO_LATENCY_PROBES
+        check("LH 13c: processNewOrder recorded one sample", after.count() == before.count() + 1);
+#endif
+        check("LH 13c: exposition lists match_spot_orders",
+              text.find("stage=\"match_spot_orders\",quantile=\"0.999\"") != std::string::npos);
+        check("LH 13c: exposition lists eventbus_publish max",
+              text.find("ts_stage_latency_max_ns{stage=\"eventbus_publish\"}") != std::string::npos);
+    }
+
+    // ── 14. Metrics Counters and Gauges ──────────────────────────────────────
+    section("Metrics Counters");
+
+    // 14a. Counters and per-symbol gauges track queue, fill and cancel
+    {
+        Counterparty buyer("MC.Buyer"), seller("MC.Seller");
+        uint64_t received0 = Metrics::total(Counter::ORDERS_RECEIVED);
+        uint64_t fills0    = Metrics::total(Counter::FILLS);
+        uint64_t qty0      = Metrics::total(Counter::FILLED_QUANTITY);
+        uint64_t cancels0  = Metrics::total(Counter::CANCELS);
+        uint64_t missing0  = Metrics::total(Counter::CANCELS_NOT_FOUND);
+
+        Order bidA("MC/A", 1.0000, 100, OrderType::SPOT_BUY,  &buyer);
+        Order bidB("MC/A", 0.9990, 100, OrderType::SPOT_BUY,  &buyer);
+        Order ask ("MC/A", 1.0000, 40,  OrderType::SPOT_SELL, &seller);
+        om.processNewOrder(bidA);
+        om.processNewOrder(bidB);
+
+        SymbolGauges& g = Metrics::symbolGauges("MC/A");
+        check("MC 14a: 2 resting orders after 2 bids", g.restingOrders.load() == 2);
+        check("MC 14a: 2 bid levels",                  g.bidLevels.load() == 2);
+        check("MC 14a: 0 ask levels",                  g.askLevels.load() == 0);
+
+        om.processNewOrder(ask);                       // partial fill of bidA
+        om.processCancelOrder(bidB.getId());
+        om.processCancelOrder(777777);                 // bogus ID
+
+        check("MC 14a: 3 orders received",             Metrics::total(Counter::ORDERS_RECEIVED) - received0 == 3);
+        check("MC 14a: 1 fill counted",                Metrics::total(Counter::FILLS) - fills0 == 1);
+        check("MC 14a: filled quantity 40",            Metrics::total(Counter::FILLED_QUANTITY) - qty0 == 40);
+        check("MC 14a: 1 successful cancel",           Metrics::total(Counter::CANCELS) - cancels0 == 1);
+        check("MC 14a: 1 cancel not found",            Metrics::total(Counter::CANCELS_NOT_FOUND) - missing0 == 1);
+        check("MC 14a: 1 resting order remains",       g.restingOrders.load() == 1);
+        check("MC 14a: 1 bid level remains",           g.bidLevels.load() == 1);
+
+        om.processNewOrder(Order("MC/A", 1.0000, 60, OrderType::SPOT_SELL, &seller));
+        check("MC 14a: resting gauge 0 after full fill", g.restingOrders.load() == 0);
+        check("MC 14a: exposition carries symbol gauge",
+              Metrics::prometheusText(nullptr).find("ts_resting_orders{symbol=\"MC/A\"} 0") != std::string::npos);
+    }
+
+    // 14b. Scraping while the engine runs is safe and loses no counts.  A
+    //      scraper renders /metrics every 2 ms while orders are placed and
+    //      cancelled; the counters must still match the work done exactly.
+    //      (Its cost to engine latency is measured by run_bench "metrics scrape".)
+    {
+        MarketManager loadMm;
+        OrderManager  loadOm(&loadMm);
+        Counterparty  loadCp("MC.Load");
+
+        std::atomic<bool> done{false};
+        std::atomic<long> scrapes{0};
+        std::thread scraper([&] {
+            while (!done.load()) {
+                std::string text = Metrics::prometheusText(nullptr) + LatencyRegistry::prometheusText();
+                if (!text.empty()) scrapes.fetch_add(1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        });
+
+        const uint64_t received0 = Metrics::total(Counter::ORDERS_RECEIVED);
+        const uint64_t cancels0  = Metrics::total(Counter::CANCELS);
+        const int      ORDERS    = 20000;
+        std::vector<long> ids;
+        ids.reserve(ORDERS);
+        for (int i = 0; i < ORDERS; ++i) {
+            bool   buy   = (i % 2) == 0;
+            double price = buy ? 1.0000 - (i % 20) * 0.0001 : 1.1000 + (i % 20) * 0.0001;
+            Order  o("MC/LOAD", price, 100, buy ? OrderType::SPOT_BUY : OrderType::SPOT_SELL, &loadCp);
+            ids.push_back(o.getId());
+            loadOm.processNewOrder(o);
+            if (i % 1000 == 999) std::this_thread::sleep_for(std::chrono::milliseconds(1));   // let scrapes interleave
+        }
+        for (long id : ids) loadOm.processCancelOrder(id);
+        done.store(true);
+        scraper.join();
+
+        check("MC 14b: scraper ran during load",             scrapes.load() > 0);
+        check("MC 14b: every order and cancel counted under scrape",
+              Metrics::total(Counter::ORDERS_RECEIVED) - received0 == ORDERS &&
+              Metrics::total(Counter::CANCELS) - cancels0 == ORDERS);
+    }
+
+    // ── 15. Order-to-SSE Event Tracing ──────────────────────────────────────
+    section("Event Tracing");
+
+    // 15a. Ingress stamps travel from the order through the engine onto every
+    //      event it causes; untraced orders publish untraced events
+    {
+        MarketManager tmm;
+        OrderManager  tom(&tmm);
+        EventBus      bus;
+        tom.setEventBus(&bus);
+        auto conn = bus.subscribe();
+        Counterparty buyer("ET.Buyer"), seller("ET.Seller");
+
+        auto popEvent = [&]() {
+            EventBus::Event ev = conn->queue.front();
+            conn->queue.pop();
+            bus.onDelivered(1);
+            return ev;
+        };
+
+        LatencyHistogram before, after;
+        LatencyRegistry::collect(LatencyStage::ORDER_TO_PUBLISH, before);
+
+        Order untraced("ET/A", 1.0010, 100, OrderType::SPOT_SELL, &seller);
+        check("ET 15a: orders start untraced",                untraced.getIngressTicks() == 0);
+        tom.processNewOrder(untraced);
+        check("ET 15a: untraced order publishes untraced event",
+              conn->queue.size() == 1 && popEvent().ingressTicks == 0);
+
+        Order ask("ET/A", 1.0000, 100, OrderType::SPOT_SELL, &seller);
+        const uint64_t askIngress = latencyNow();
+        ask.setIngressTicks(askIngress);
+        tom.processNewOrder(ask);
+        EventBus::Event askBook = popEvent();
+        check("ET 15a: queued order's book_update carries ingress",
+              askBook.ingressTicks == askIngress);
+        check("ET 15a: published no earlier than ingress",    askBook.publishTicks >= askIngress);
+
+        Order bid("ET/A", 1.0000, 100, OrderType::SPOT_BUY, &buyer);
+        const uint64_t bidIngress = latencyNow();
+        bid.setIngressTicks(bidIngress);
+        tom.processNewOrder(bid);
+        check("ET 15a: fill publishes trade then book_update", conn->queue.size() == 2);
+        EventBus::Event trade = popEvent();
+        EventBus::Event book  = popEvent();
+        check("ET 15a: trade event is first",                 trade.msg.compare(0, 12, "event: trade") == 0);
+        check("ET 15a: trade carries aggressor's ingress",    trade.ingressTicks == bidIngress);
+        check("ET 15a: book_update carries aggressor's ingress", book.ingressTicks == bidIngress);
+        check("ET 15a: recent trade keeps ingress",
+              tom.getRecentTrades().back().ingressTicks == bidIngress);
+
+        const uint64_t cancelIngress = latencyNow();
+        tom.processCancelOrder(untraced.getId(), cancelIngress);
+        check("ET 15a: cancel's book_update carries ingress",
+              conn->queue.size() == 1 && popEvent().ingressTicks == cancelIngress);
+
+        LatencyRegistry::collect(LatencyStage::ORDER_TO_PUBLISH, after);
+        check("ET 15a: traced events recorded engine dwell",  after.count() == before.count() + 4);
+        bus.unsubscribe(conn);
+    }
+
+    // 15b. Trace timings are spliced into the event's JSON object
+    {
+        EventBus::Event ev{"event: trade\ndata: {\"symbol\":\"ET/B\"}\n\n", 1000, 3000};
+        check("ET 15b: timings appended in nanoseconds",
+              EventBus::withTrace(ev, 6000, 2.0) ==
+              "event: trade\ndata: {\"symbol\":\"ET/B\",\"trace\":"
+              "{\"engineNs\":1000,\"queueNs\":1500,\"serverNs\":2500}}\n\n");
+
+        EventBus::Event untraced{ev.msg, 0, 3000};
+        check("ET 15b: untraced event unchanged",             EventBus::withTrace(untraced, 6000, 2.0) == ev.msg);
+
+        EventBus::Event comment{": keepalive\n\n", 1000, 3000};
+        check("ET 15b: non-JSON message unchanged",           EventBus::withTrace(comment, 6000, 2.0) == comment.msg);
+    }
+
+    // ── 16. Market Data ──────────────────────────────────────────────────────
+    section("Market Data");
+
+    // 16a. Symbols get dense ids; quotes and trades update the snapshot
+    {
+        MarketManager md;
+        check("MD 16a: unknown symbol has no id",             md.symbolId("MD/A") == -1);
+        int a = md.registerSymbol("MD/A");
+        int b = md.registerSymbol("MD/B");
+        check("MD 16a: ids are dense",                        a == 0 && b == 1 && md.symbolCount() == 2);
+        check("MD 16a: re-registering returns the same id",   md.registerSymbol("MD/A") == a);
+        check("MD 16a: lookup finds the id",                  md.symbolId("MD/B") == b);
+
+        MarketQuote q;
+        check("MD 16a: registered symbol has no quote yet",   !md.getQuote(a, q));
+
+        md.onQuote("MD/A", 1.0840, 1000, 1.0842, 2000, 42);
+        md.onTrade("MD/A", 1.0841, 300);
+        md.onTrade("MD/A", 1.0842, 200);
+        check("MD 16a: quote visible",                        md.getQuote("MD/A", q));
+        check("MD 16a: BBO stored",
+              q.bid == 1.0840 && q.bidQty == 1000 && q.ask == 1.0842 && q.askQty == 2000);
+        check("MD 16a: last trade stored",                    q.last == 1.0842 && q.lastQty == 200);
+        check("MD 16a: volume accumulates",                   q.volume == 500);
+        check("MD 16a: trade keeps the BBO",                  q.bid == 1.0840);
+    }
+
+    // 16b. Tick lines: quotes, trades, comments and malformed input
+    {
+        MarketManager md;
+        std::istringstream ticks(
+            "# recorded ticks\n"
+            "Q,MD/C,1.2500,500,1.2502,700\n"
+            "T,MD/C,1.2501,100\r\n"
+            "\n"
+            "Q,MD/C,not-a-price,1,2,3\n"
+            "X,MD/C,1,2\n");
+        check("MD 16b: two valid ticks accepted",             md.loadTicks(ticks) == 2);
+        MarketQuote q;
+        md.getQuote("MD/C", q);
+        check("MD 16b: quote line parsed",                    q.bid == 1.2500 && q.ask == 1.2502);
+        check("MD 16b: trade line parsed",                    q.last == 1.2501 && q.volume == 100);
+        check("MD 16b: MarketPrice print ingested",           md.onTick(MarketPrice("MD/C", 1.2503, 50, 0)) &&
+                                                              md.getQuote("MD/C", q) && q.volume == 150);
+    }
+
+    // 16c. The engine's own fills feed last price and volume
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        Counterparty buyer("MD.Buyer"), seller("MD.Seller");
+        mom.processNewOrder(Order("MD/D", 1.1000, 400, OrderType::SPOT_SELL, &seller));
+        mom.processNewOrder(Order("MD/D", 1.1000, 150, OrderType::SPOT_BUY,  &buyer));
+        mom.processNewOrder(Order("MD/D", 1.1000, 100, OrderType::SPOT_BUY,  &buyer));
+        MarketQuote q;
+        check("MD 16c: fills reach MarketManager",            md.getQuote("MD/D", q));
+        check("MD 16c: last is the fill price",               q.last == 1.1000 && q.lastQty == 100);
+        check("MD 16c: volume sums the fills",                q.volume == 250);
+    }
+
+    // 16d. checkForTrade against the live BBO
+    {
+        MarketManager md;
+        TradeManager  tm;
+        Counterparty  trader("MD.Trader");
+        Order buy ("MD/E", 1.0842, 100, OrderType::LIMIT_BUY,  &trader);
+        Order sell("MD/E", 1.0841, 100, OrderType::LIMIT_SELL, &trader);
+        check("MD 16d: no market data → no trade",            !tm.checkForTrade(buy, md));
+
+        md.onTrade("MD/E", 1.0845, 10);
+        check("MD 16d: falls back to last without a BBO",     !tm.checkForTrade(buy, md) &&
+                                                              tm.checkForTrade(sell, md));
+
+        md.onQuote("MD/E", 1.0840, 100, 1.0842, 100);
+        check("MD 16d: buy at the ask triggers",              tm.checkForTrade(buy, md));
+        check("MD 16d: sell above the bid does not",          !tm.checkForTrade(sell, md));
+        md.onQuote("MD/E", 1.0841, 100, 1.0843, 100);
+        check("MD 16d: sell at the new bid triggers",         tm.checkForTrade(sell, md));
+        check("MD 16d: buy below the new ask does not",       !tm.checkForTrade(buy, md));
+    }
+
+    // 16e. Readers never see a torn quote while writers update it
+    {
+        MarketManager md;
+        int id = md.registerSymbol("MD/F");
+        md.onQuote("MD/F", 1.0, 1, 1.5, 1);
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> writers;
+        for (int w = 0; w < 2; ++w)
+            writers.emplace_back([&md, &stop, w] {
+                // Every write keeps ask == bid + 0.5 and askQty == bidQty
+                for (long n = 1; !stop.load(std::memory_order_relaxed); ++n)
+                    md.onQuote("MD/F", static_cast<double>(n * 2 + w), n, static_cast<double>(n * 2 + w) + 0.5, n);
+            });
+
+        long reads = 0, torn = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        while (std::chrono::steady_clock::now() < deadline) {
+            MarketQuote q;
+            md.getQuote(id, q);
+            if (q.ask != q.bid + 0.5 || q.askQty != q.bidQty) ++torn;
+            ++reads;
+        }
+        stop.store(true);
+        for (auto& t : writers) t.join();
+        check("MD 16e: reader made progress under writers",   reads > 1000);
+        check("MD 16e: no torn snapshots",                    torn == 0);
+    }
+
+    // 16f. UDP feed delivers tick lines from a socket
+    {
+        MarketManager md;
+        int port = md.startUdpFeed(0);
+        check("MD 16f: feed bound a port",                    port > 0);
+        if (port > 0) {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family      = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port        = htons(static_cast<uint16_t>(port));
+            const std::string datagram = "Q,MD/G,0.9000,10,0.9002,20\nT,MD/G,0.9001,5\n";
+            sendto(fd, datagram.data(), datagram.size(), 0,
+                   reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            close(fd);
+
+            MarketQuote q{};
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (!(md.getQuote("MD/G", q) && q.volume == 5) &&
+                   std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            check("MD 16f: datagram's quote and trade ingested",
+                  q.bid == 0.9000 && q.ask == 0.9002 && q.last == 0.9001 && q.volume == 5);
+        }
+        md.stopFeeds();
+    }
+
+    // ── 17. Binary Feed ──────────────────────────────────────────────────────
+    section("Binary Feed");
+
+    const std::string feedPath = "/tmp/ts_tests_feed_" + std::to_string(getpid()) + ".bin";
+
+    // 17a. MarketPrice is a fixed-size record carrying trades and quotes
+    {
+        check("BF 17a: record is trivially copyable",         std::is_trivially_copyable<MarketPrice>::value);
+        check("BF 17a: record is 64 bytes",                   sizeof(MarketPrice) == 64);
+
+        MarketPrice quote = MarketPrice::quote("BF/A", 1.0840, 1000, 1.0842, 2000, 123456789);
+        check("BF 17a: quote fields round-trip",
+              quote.isQuote() && quote.getPrice() == 1.0840 && quote.getQuantity() == 1000 &&
+              quote.getAskPrice() == 1.0842 && quote.getAskQuantity() == 2000 &&
+              quote.getTimestampNs() == 123456789 && std::string(quote.getSymbol()) == "BF/A");
+        check("BF 17a: long symbol truncated to 15 chars",
+              std::string(MarketPrice("ABCDEFGHIJKLMNOPQ", 1.0, 1, 0).getSymbol()) == "ABCDEFGHIJKLMNO");
+
+        MarketManager md;
+        MarketQuote   q;
+        check("BF 17a: quote record ingested",                md.onTick(quote) && md.getQuote("BF/A", q));
+        check("BF 17a: record timestamp kept",                q.updateNs == 123456789 && q.bidQty == 1000);
+
+        unsigned char garbage[sizeof(MarketPrice)];
+        std::memset(garbage, 'X', sizeof(garbage));   // unterminated symbol, unknown type
+        MarketPrice bad;
+        std::memcpy(&bad, garbage, sizeof(bad));
+        check("BF 17a: unknown record type rejected",         !md.onTick(bad));
+    }
+
+    // 17b. Tick lines → recording → mmap replay
+    {
+        std::istringstream text(
+            "Q,BF/B,1.2500,500,1.2502,700\n"
+            "T,BF/B,1.2501,100\n"
+            "bogus\n"
+            "T,BF/C,0.9000,40\n");
+        check("BF 17b: three records written",                FeedReplayer::recordText(text, feedPath) == 3);
+
+        FeedReplayer replayer;
+        check("BF 17b: recording maps",                       replayer.open(feedPath) && replayer.size() == 3);
+        MarketManager md;
+        check("BF 17b: replay delivers every record",         replayer.replayInto(md) == 3);
+        MarketQuote q;
+        md.getQuote("BF/B", q);
+        check("BF 17b: replayed state matches the text",
+              q.bid == 1.2500 && q.ask == 1.2502 && q.last == 1.2501 && q.volume == 100);
+        replayer.close();
+
+        { std::ofstream torn(feedPath, std::ios::binary | std::ios::app); torn << "x"; }
+        check("BF 17b: torn recording rejected",              !replayer.open(feedPath));
+    }
+
+    // 17c. A conflating reader sees each changed symbol once, at its latest state
+    {
+        MarketManager    md;
+        ConflatingReader reader(md);
+        for (int i = 1; i <= 3; ++i) md.onTrade("BF/D", 1.0 + i, 10);
+        md.onTrade("BF/E", 2.0, 5);
+
+        std::vector<std::string> seen;
+        double lastD = 0;
+        check("BF 17c: two symbols changed",
+              reader.poll([&](int id, const MarketQuote& q) {
+                  seen.push_back(md.symbolName(id));
+                  if (seen.back() == "BF/D") lastD = q.last;
+              }) == 2);
+        check("BF 17c: latest price delivered",               lastD == 4.0);
+        check("BF 17c: stale ticks counted as conflated",     reader.conflated() == 2);
+        check("BF 17c: nothing new → no updates",             reader.poll([](int, const MarketQuote&) {}) == 0);
+        md.onTrade("BF/E", 2.5, 5);
+        check("BF 17c: only the symbol that ticked",
+              reader.poll([&](int id, const MarketQuote&) { seen.push_back(md.symbolName(id)); }) == 1 &&
+              seen.back() == "BF/E");
+    }
+
+    // 17d. Recorded feed replayed over a binary UDP feed
+    {
+        std::vector<MarketPrice> ticks;
+        for (int i = 0; i < 1500; ++i) ticks.push_back(MarketPrice("BF/F", 1.0, 1, 0));   // spans 3 datagrams
+        FeedReplayer::record(feedPath, ticks.data(), ticks.size());
+
+        MarketManager md;
+        int port = md.startBinaryFeed(0);
+        check("BF 17d: binary feed bound a port",             port > 0);
+        FeedReplayer replayer;
+        if (port > 0 && replayer.open(feedPath)) {
+            check("BF 17d: replayer sent every record",       replayer.sendTo(port) == 1500);
+            MarketQuote q{};
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (!(md.getQuote("BF/F", q) && q.volume == 1500) &&
+                   std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            check("BF 17d: every record ingested",            q.volume == 1500);
+        }
+        md.stopFeeds();
+    }
+
+    // 17e. Paced replay keeps the recorded gaps
+    {
+        MarketPrice ticks[] = { MarketPrice("BF/G", 1.0, 1, 1000000000),
+                                MarketPrice("BF/G", 1.0, 1, 1010000000),
+                                MarketPrice("BF/G", 1.0, 1, 1020000000) };
+        FeedReplayer::record(feedPath, ticks, 3);
+        FeedReplayer replayer;
+        replayer.open(feedPath);
+        MarketManager md;
+        auto t0 = std::chrono::steady_clock::now();
+        replayer.replayInto(md, 1.0);
+        auto elapsed = std::chrono::steady_clock::now() - t0;
+        check("BF 17e: 20 ms recording takes ≥ 20 ms",        elapsed >= std::chrono::milliseconds(19));
+        replayer.close();
+    }
+    std::remove(feedPath.c_str());
+
+    // ── 18. Market Triggers ──────────────────────────────────────────────────
+    section("Market Triggers");
+
+    // 18a. A market offer at or below a resting bid fills it at the market price
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        Counterparty  buyer("MT.Buyer");
+        Order high("MT/A", 1.0850, 500, OrderType::LIMIT_BUY, &buyer);
+        Order low ("MT/A", 1.0840, 500, OrderType::LIMIT_BUY, &buyer);
+        mom.processNewOrder(high);
+        mom.processNewOrder(low);
+
+        md.onQuote("MT/A", 1.0830, 1000, 1.0846, 1000);
+        check("MT 18a: one crossed order fills",              mom.processMarketTick("MT/A") == 1);
+        check("MT 18a: buyer filled at the market ask",       buyer.getTrades().size() == 1 &&
+                                                              buyer.getTrades()[0].orderId == high.getId() &&
+                                                              buyer.getTrades()[0].price == 1.0846 &&
+                                                              buyer.getTrades()[0].counterpartyName() == "MARKET");
+        check("MT 18a: uncrossed bid still resting",          mom.getSubBook("MT/A").getBuyOrders().size() == 1 &&
+                                                              mom.getSubBook("MT/A").getBuyOrders().begin()->first == 1.0840);
+        check("MT 18a: MARKET counterparty sold",             mom.getMarketCounterparty().getTrades().size() == 1 &&
+                                                              !mom.getMarketCounterparty().getTrades()[0].wasBuy);
+        check("MT 18a: same tick again finds nothing",        mom.processMarketTick("MT/A") == 0);
+    }
+
+    // 18b. Fills are capped at the market's displayed size, in FIFO order
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        Counterparty  buyer("MT.Buyer");
+        Order first ("MT/B", 1.2000, 600, OrderType::LIMIT_BUY, &buyer);
+        Order second("MT/B", 1.2000, 600, OrderType::LIMIT_BUY, &buyer);
+        mom.processNewOrder(first);
+        mom.processNewOrder(second);
+
+        md.onQuote("MT/B", 1.1990, 100, 1.1995, 1000);
+        check("MT 18b: two fills from 1000 displayed",        mom.processMarketTick("MT/B") == 2);
+        const auto& level = mom.getSubBook("MT/B").getBuyOrders().begin()->second;
+        check("MT 18b: first order fully filled",             level.size() == 1 && level.front().getId() == second.getId());
+        check("MT 18b: second order has 200 left",            level.front().getQuantity() == 200);
+        check("MT 18b: filled order dropped by its owner",    buyer.getOrderIds().size() == 1);
+    }
+
+    // 18c. A market bid at or above resting offers hits them, best first
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        Counterparty  seller("MT.Seller");
+        mom.processNewOrder(Order("MT/C", 0.9000, 100, OrderType::LIMIT_SELL, &seller));
+        mom.processNewOrder(Order("MT/C", 0.9010, 100, OrderType::LIMIT_SELL, &seller));
+        mom.processNewOrder(Order("MT/C", 0.9020, 100, OrderType::LIMIT_SELL, &seller));
+
+        md.onQuote("MT/C", 0.9010, 1000, 0.9030, 1000);
+        check("MT 18c: two offers at or below the bid fill",  mom.processMarketTick("MT/C") == 2);
+        check("MT 18c: fills at the market bid",              seller.getTrades().size() == 2 &&
+                                                              seller.getTrades()[0].price == 0.9010 &&
+                                                              seller.getTrades()[1].price == 0.9010);
+        check("MT 18c: the uncrossed offer remains",          mom.getSubBook("MT/C").getSellOrders().size() == 1 &&
+                                                              mom.getSubBook("MT/C").getSellOrders().begin()->first == 0.9020);
+    }
+
+    // 18d. Without a BBO a trade print triggers at its price and size
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        Counterparty  buyer("MT.Buyer");
+        mom.processNewOrder(Order("MT/D", 1.5000, 300, OrderType::LIMIT_BUY, &buyer));
+        md.onTrade("MT/D", 1.4990, 100);
+        check("MT 18d: last-price fallback fills",            mom.processMarketTick("MT/D") == 1 &&
+                                                              buyer.getTrades()[0].quantity == 100 &&
+                                                              buyer.getTrades()[0].price == 1.4990);
+    }
+
+    // 18e. Tick listener: ticks trigger, own fills and market-only symbols do not
+    {
+        MarketManager md;
+        OrderManager  mom(&md);
+        int notified = 0, fills = 0;
+        md.setTickListener([&](int id, uint64_t ingressTicks) {
+            ++notified;
+            fills += mom.processMarketTick(md.symbolName(id), ingressTicks);
+        });
+
+        Counterparty buyer("MT.Buyer"), seller("MT.Seller");
+        mom.processNewOrder(Order("MT/E", 1.1000, 100, OrderType::SPOT_SELL, &seller));
+        mom.processNewOrder(Order("MT/E", 1.1000, 100, OrderType::SPOT_BUY,  &buyer));
+        check("MT 18e: own fill does not notify",             notified == 0);
+
+        md.onQuote("MT/X", 1.0, 1, 1.1, 1);
+        check("MT 18e: market-only symbol gets no book",      notified == 1 && fills == 0 &&
+                                                              mom.getSymbols().size() == 1);
+
+        LatencyHistogram before, after;
+        LatencyRegistry::collect(LatencyStage::TICK_TO_FILL, before);
+        mom.processNewOrder(Order("MT/E", 1.1010, 100, OrderType::LIMIT_BUY, &buyer));
+        md.onQuote("MT/E", 1.1000, 100, 1.1005, 100);
+        LatencyRegistry::collect(LatencyStage::TICK_TO_FILL, after);
+        check("MT 18e: tick filled through the listener",     fills == 1);
+        check("MT 18e: tick_to_fill recorded",                after.count() == before.count() + 1);
+        check("MT 18e: trade carries the tick's stamp",       mom.getRecentTrades().back().ingressTicks != 0 &&
+                                                              mom.getRecentTrades().back().sellOrderId == 0);
+        md.setTickListener(nullptr);
+    }
+
+    // ── 19. Trade Feed & Candles ─────────────────────────────────────────────
+    section("Trade Feed & Candles");
+
+    // 19a. SPSC ring: FIFO order, bounded, wraps around
+    {
+        SpscRing<long> ring(3);   // rounds up to 4
+        check("TF 19a: capacity rounded to a power of two",   ring.capacity() == 4);
+        bool pushed = true;
+        for (long i = 0; i < 4; ++i) pushed = pushed && ring.tryPush(i);
+        check("TF 19a: accepts up to capacity",               pushed && ring.size() == 4);
+        check("TF 19a: rejects when full",                    !ring.tryPush(99));
+
+        long out[8];
+        check("TF 19a: batch pop respects max",               ring.popBatch(out, 3) == 3 && out[0] == 0 && out[2] == 2);
+        ring.tryPush(4); ring.tryPush(5); ring.tryPush(6);
+        size_t n = ring.popBatch(out, 8);
+        check("TF 19a: FIFO across the wrap",                 n == 4 && out[0] == 3 && out[3] == 6);
+        check("TF 19a: empty after draining",                 ring.popBatch(out, 8) == 0);
+    }
+
+    // 19b. OHLCV, VWAP and trade count inside one interval; roll to the next
+    {
+        CandleAggregator agg;
+        auto rec = [](int64_t ts, double px, long qty) {
+            TradeRecord r{};
+            r.tsNs = ts; r.price = px; r.quantity = qty;
+            std::strcpy(r.symbol, "CA/A");
+            return r;
+        };
+        const int64_t S = 1000000000LL;
+        TradeRecord batch[] = { rec(10 * S + 1, 1.10, 100), rec(10 * S + 2, 1.30, 100),
+                                rec(10 * S + 3, 1.00, 200), rec(10 * S + 4, 1.20, 100) };
+        agg.onTrades(batch, 4);
+
+        auto sec = agg.getCandles("CA/A", CandleAggregator::intervalIndex("1s"));
+        check("CA 19b: one 1s candle",                        sec.size() == 1 && sec[0].startNs == 10 * S);
+        check("CA 19b: OHLC",                                 sec[0].open == 1.10 && sec[0].high == 1.30 &&
+                                                              sec[0].low == 1.00 && sec[0].close == 1.20);
+        check("CA 19b: volume and trade count",               sec[0].volume == 500 && sec[0].trades == 4);
+        check("CA 19b: VWAP",                                 std::abs(sec[0].vwap() - 1.12) < 1e-9);
+
+        TradeRecord next = rec(11 * S + 5, 1.25, 50);
+        agg.onTrades(&next, 1);
+        sec = agg.getCandles("CA/A", CandleAggregator::intervalIndex("1s"));
+        check("CA 19b: next second opens a new candle",       sec.size() == 2 && sec[1].startNs == 11 * S &&
+                                                              sec[1].open == 1.25 && sec[1].volume == 50);
+        auto min = agg.getCandles("CA/A", CandleAggregator::intervalIndex("1m"));
+        check("CA 19b: 1m candle spans both seconds",         min.size() == 1 && min[0].volume == 550 &&
+                                                              min[0].trades == 5 && min[0].close == 1.25);
+        check("CA 19b: limit returns the newest",             agg.getCandles("CA/A", 0, 1).size() == 1 &&
+                                                              agg.getCandles("CA/A", 0, 1)[0].startNs == 11 * S);
+        check("CA 19b: unknown symbol is empty",              agg.getCandles("CA/NONE", 0).empty());
+        check("CA 19b: interval names",                       CandleAggregator::intervalIndex("5m") == 2 &&
+                                                              CandleAggregator::intervalIndex("1h") == 3 &&
+                                                              CandleAggregator::intervalIndex("2m") == -1);
+
+        // The ring keeps the newest HISTORY candles
+        for (size_t i = 0; i < CandleAggregator::HISTORY + 10; ++i) {
+            TradeRecord r = rec(static_cast<int64_t>(100 + i) * S, 1.0, 1);
+            agg.onTrades(&r, 1);
+        }
+        sec = agg.getCandles("CA/A", 0);
+        check("CA 19b: ring capped at HISTORY",               sec.size() == CandleAggregator::HISTORY);
+        check("CA 19b: oldest evicted first",                 sec.front().startNs == static_cast<int64_t>(110) * S &&
+                                                              sec.back().startNs == static_cast<int64_t>(100 + CandleAggregator::HISTORY + 9) * S);
+    }
+
+    // 19c. Engine fills reach the candles through the feed thread; SSE candle events
+    {
+        EventBus         bus;
+        auto             conn = bus.subscribe();
+        TradeFeed        feed;
+        CandleAggregator agg(&bus);
+        feed.addSink([&agg](const TradeRecord* r, size_t n) { agg.onTrades(r, n); });
+        feed.start();
+
+        OrderManager mom(nullptr);
+        mom.setTradeFeed(&feed);
+        Counterparty buyer("CA.Buyer"), seller("CA.Seller");
+        mom.processNewOrder(Order("CA/B", 2.0000, 300, OrderType::SPOT_SELL, &seller));
+        mom.processNewOrder(Order("CA/B", 2.0000, 100, OrderType::SPOT_BUY,  &buyer));
+        mom.processNewOrder(Order("CA/B", 2.0000, 100, OrderType::SPOT_BUY,  &buyer));
+        feed.flush();
+
+        auto candles = agg.getCandles("CA/B", CandleAggregator::intervalIndex("1h"));
+        check("CA 19c: fills aggregated off-thread",          candles.size() == 1 && candles[0].volume == 200 &&
+                                                              candles[0].trades == 2);
+
+        int candleEvents = 0;
+        {
+            std::lock_guard<std::mutex> lk(conn->mu);
+            while (!conn->queue.empty()) {
+                if (conn->queue.front().msg.rfind("event: candle\n", 0) == 0) ++candleEvents;
+                conn->queue.pop();
+            }
+        }
+        check("CA 19c: candle events published",              candleEvents >= 4);
+        feed.stop();
+        bus.unsubscribe(conn);
+    }
+
+    // 19d. A full ring overflows instead of blocking the matcher, and every
+    //      fill still reaches the sinks in execution order
+    {
+        TradeFeed   feed(4);   // consumer not started
+        TradeRecord r{};
+        std::strcpy(r.symbol, "CA/C");
+        int accepted = 0;
+        for (int i = 0; i < 6; ++i) {
+            r.quantity = i + 1;
+            accepted += feed.publish(r) ? 1 : 0;
+        }
+        check("TF 19d: excess fills overflow and are counted", accepted == 4 && feed.overflowed() == 2);
+        std::vector<int64_t> delivered;
+        feed.addSink([&delivered](const TradeRecord* rs, size_t n) {
+            for (size_t i = 0; i < n; ++i) delivered.push_back(rs[i].quantity);
+        });
+        feed.flush();
+        check("TF 19d: flush without a consumer drains",      delivered.size() == 6);
+        check("TF 19d: overflowed fills delivered in order",  delivered == std::vector<int64_t>{ 1, 2, 3, 4, 5, 6 });
+
+        // The ring is used again once the overflow has been taken
+        r.quantity = 7;
+        check("TF 19d: ring reused after the overflow drains", feed.publish(r));
+    }
+
+    // ── 20. Trade Store ──────────────────────────────────────────────────────
+    section("Trade Store");
+
+    const std::string storeDir = "/tmp/ts_tests_store_" + std::to_string(getpid());
+    std::filesystem::remove_all(storeDir);
+    Counterparty tsBuyer("TS.Buyer"), tsSeller("TS.Seller");
+    auto tsRec = [&](int64_t ts, const char* sym, double px, long qty, long buyId, long sellId) {
+        TradeRecord r{};
+        r.tsNs = ts; r.price = px; r.quantity = qty;
+        r.buyOrderId = buyId; r.sellOrderId = sellId;
+        r.buyerId = tsBuyer.getId(); r.sellerId = tsSeller.getId();
+        std::strcpy(r.symbol, sym);
+        return r;
+    };
+
+    // 20a. Append, then query by symbol, time range and limit
+    {
+        TradeStore store;
+        check("TS 20a: opens a new store",                    store.open(storeDir) && store.size() == 0);
+        TradeRecord batch[] = { tsRec(100, "TS/A", 1.084213, 10, 1, 2), tsRec(200, "TS/B", 2.5, 20, 3, 4),
+                                tsRec(300, "TS/A", 1.0843,   30, 5, 6), tsRec(400, "TS/A", 1.0844, 40, 7, 8) };
+        store.onTrades(batch, 4);
+        check("TS 20a: rows appended",                        store.size() == 4);
+
+        auto all = store.query(TradeQuery{});
+        check("TS 20a: oldest first",                         all.size() == 4 && all[0].tsNs == 100 && all[3].tsNs == 400);
+        check("TS 20a: columns round-trip",                   all[0].symbol == "TS/A" && all[0].quantity == 10 &&
+                                                              all[0].buyOrderId == 1 && all[0].sellOrderId == 2 &&
+                                                              std::abs(all[0].price - 1.084213) < 1e-9);
+        check("TS 20a: counterparty names resolved",          all[1].buyer == "TS.Buyer" && all[1].seller == "TS.Seller");
+
+        TradeQuery q;
+        q.symbol = "TS/A";
+        check("TS 20a: symbol filter",                        store.query(q).size() == 3 && store.count(q) == 3);
+        q.fromNs = 150; q.toNs = 300;
+        auto ranged = store.query(q);
+        check("TS 20a: inclusive time range",                 ranged.size() == 1 && ranged[0].tsNs == 300);
+        q = TradeQuery{};
+        q.limit = 2;
+        auto newest = store.query(q);
+        check("TS 20a: limit keeps the newest",               newest.size() == 2 && newest[0].tsNs == 300 && newest[1].tsNs == 400);
+        q.symbol = "TS/NONE";
+        check("TS 20a: unknown symbol is empty",              store.query(q).empty() && store.count(q) == 0);
+    }
+
+    // 20b. Rows and dictionaries survive a reopen, also from a store written
+    //      before the swap columns; appends continue
+    {
+        std::filesystem::remove(storeDir + "/link.col");
+        std::filesystem::remove(storeDir + "/leg.col");
+        TradeStore store;
+        check("TS 20b: reopens with its rows",                store.open(storeDir) && store.size() == 4);
+        auto all = store.query(TradeQuery{});
+        check("TS 20b: names read back from disk",            all.size() == 4 && all[1].symbol == "TS/B" &&
+                                                              all[1].buyer == "TS.Buyer");
+        TradeRecord r = tsRec(500, "TS/B", 2.6, 50, 9, 10);
+        store.onTrades(&r, 1);
+        TradeQuery q;
+        q.symbol = "TS/B";
+        check("TS 20b: appends after reopen",                 store.size() == 5 && store.count(q) == 2);
+        check("TS 20b: older rows read back as spot",         store.query(TradeQuery{})[0].linkId == 0 &&
+                                                              store.query(TradeQuery{})[0].leg == 0);
+
+        TradeRecord far = tsRec(600, "TS/B", 2.61, 5, 11, 12);
+        far.linkId = 42;
+        far.leg    = static_cast<uint8_t>(SwapLeg::FAR);
+        store.onTrades(&far, 1);
+        q.limit = 1;
+        auto last = store.query(q);
+        check("TS 20b: swap link and leg stored",             last.size() == 1 && last[0].linkId == 42 &&
+                                                              last[0].leg == static_cast<uint8_t>(SwapLeg::FAR));
+
+        TradeRecord twin = tsRec(600, "TS/B", 2.62, 6, 13, 14);
+        store.onTrades(&twin, 1);
+        q.toNs     = 600;
+        q.skipAtTo = 1;
+        auto behind = store.query(q);
+        check("TS 20b: skipAtTo pages within one nanosecond", behind.size() == 1 && behind[0].buyOrderId == 11);
+    }
+    std::filesystem::remove_all(storeDir);
+
+    // 20c. Block summaries skip data without changing answers
+    {
+        TradeStore store;
+        store.open(storeDir);
+        const size_t rows = TradeStore::INITIAL_ROWS + 100;   // many blocks, and a column resize
+        const char*  syms[] = { "TS/X", "TS/Y", "TS/Z" };
+        std::vector<TradeRecord> recs;
+        for (size_t i = 0; i < rows; ++i)
+            recs.push_back(tsRec(static_cast<int64_t>(i) * 10, syms[i % 3], 1.0, 1, static_cast<long>(i), 0));
+        for (size_t off = 0; off < rows; off += TradeFeed::BATCH)
+            store.onTrades(recs.data() + off, std::min<size_t>(TradeFeed::BATCH, rows - off));
+
+        TradeQuery q;
+        q.symbol = "TS/Y";
+        check("TS 20c: symbol count over every block",        store.count(q) == (rows + 1) / 3 &&
+                                                              store.query(q).size() == 100);
+        q.fromNs = 50000; q.toNs = 50990;   // rows 5000..5099, one block
+        check("TS 20c: narrow range counted exactly",         store.count(q) == 33);
+        q.limit = 1000;
+        auto hits = store.query(q);
+        bool ok = hits.size() == 33;
+        for (const auto& t : hits) ok = ok && t.symbol == "TS/Y" && t.tsNs >= 50000 && t.tsNs <= 50990;
+        check("TS 20c: narrow range query matches",           ok);
+        q = TradeQuery{};
+        q.fromNs = static_cast<int64_t>(rows) * 10;
+        check("TS 20c: range past the end is empty",          store.count(q) == 0 && store.query(q).empty());
+
+        // A fill stamped in the past (clock step) overlaps earlier blocks
+        TradeRecord late = tsRec(5, "TS/Y", 1.0, 1, -1, 0);
+        store.onTrades(&late, 1);
+        q = TradeQuery{};
+        q.symbol = "TS/Y"; q.fromNs = 0; q.toNs = 10;
+        hits = store.query(q);
+        check("TS 20c: out-of-order fill still found",        store.count(q) == 2 && hits.size() == 2 &&
+                                                              hits[1].buyOrderId == -1);
+    }
+    std::filesystem::remove_all(storeDir);
+
+    // 20d. Engine fills reach the store through the trade feed
+    {
+        TradeStore store;
+        store.open(storeDir);
+        TradeFeed feed;
+        feed.addSink([&store](const TradeRecord* r, size_t n) { store.onTrades(r, n); });
+        feed.start();
+
+        OrderManager som(nullptr);
+        som.setTradeFeed(&feed);
+        som.processNewOrder(Order("TS/E", 1.5000, 100, OrderType::SPOT_SELL, &tsSeller));
+        som.processNewOrder(Order("TS/E", 1.5000, 100, OrderType::SPOT_BUY,  &tsBuyer));
+        feed.flush();
+
+        auto fills = store.query(TradeQuery{});
+        check("TS 20d: fill stored with both parties",        fills.size() == 1 && fills[0].symbol == "TS/E" &&
+                                                              fills[0].quantity == 100 && fills[0].buyer == "TS.Buyer" &&
+                                                              fills[0].seller == "TS.Seller" && fills[0].tsNs > 0);
+        feed.stop();
+    }
+    std::filesystem::remove_all(storeDir);
+
+    // ── 21. Risk Checks ──────────────────────────────────────────────────────
+    section("Risk Checks");
+
+    // 21a. Per-order quantity and notional caps; a rejected order never rests
+    {
+        OrderManager rom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 1000, 5000.0, 0, 0, 0 });
+        rom.setRiskManager(&risk);
+        Counterparty cp("RK.A");
+
+        uint64_t rejects0 = Metrics::total(Counter::RISK_REJECTS);
+        check("RK 21a: within limits accepted",               rom.processNewOrder(Order("RK/A", 2.0, 1000, OrderType::SPOT_BUY, &cp)) == RejectReason::NONE);
+        check("RK 21a: quantity cap",                         rom.processNewOrder(Order("RK/A", 2.0, 1001, OrderType::SPOT_BUY, &cp)) == RejectReason::MAX_ORDER_QTY);
+        check("RK 21a: notional cap",                         rom.processNewOrder(Order("RK/A", 6.0, 1000, OrderType::SPOT_BUY, &cp)) == RejectReason::MAX_NOTIONAL);
+        check("RK 21a: rejected orders never rest",           rom.getSubBook("RK/A").getBuyOrders().size() == 1 &&
+                                                              cp.getOrderIds().size() == 1);
+        check("RK 21a: rejects counted",                      Metrics::total(Counter::RISK_REJECTS) - rejects0 == 2);
+        check("RK 21a: reason names",                         std::string(rejectReasonName(RejectReason::PRICE_BAND)) == "price_band" &&
+                                                              std::string(rejectReasonName(RejectReason::CREDIT_LIMIT)) == "credit_limit");
+    }
+
+    // 21b. Fat-finger band around the BBO mid, else the last trade
+    {
+        MarketManager rmd;
+        OrderManager  rom(&rmd);
+        RiskManager   risk(&rmd);
+        risk.setDefaultLimits({ 0, 0, 0.05, 0, 0 });
+        rom.setRiskManager(&risk);
+        Counterparty cp("RK.B");
+
+        check("RK 21b: no market data skips the band",        rom.processNewOrder(Order("RK/B", 9.0, 10, OrderType::LIMIT_BUY, &cp)) == RejectReason::NONE);
+        rmd.onQuote("RK/B", 0.99, 100, 1.01, 100);
+        check("RK 21b: inside the band vs mid",               rom.processNewOrder(Order("RK/B", 1.049, 10, OrderType::LIMIT_BUY, &cp)) == RejectReason::NONE);
+        check("RK 21b: above the band rejected",              rom.processNewOrder(Order("RK/B", 1.051, 10, OrderType::LIMIT_BUY, &cp)) == RejectReason::PRICE_BAND);
+        check("RK 21b: below the band rejected",              rom.processNewOrder(Order("RK/B", 0.949, 10, OrderType::LIMIT_SELL, &cp)) == RejectReason::PRICE_BAND);
+        rmd.onTrade("RK/C", 2.0, 5);
+        check("RK 21b: last trade is the fallback reference", rom.processNewOrder(Order("RK/C", 2.2, 10, OrderType::LIMIT_BUY, &cp)) == RejectReason::PRICE_BAND &&
+                                                              rom.processNewOrder(Order("RK/C", 2.09, 10, OrderType::LIMIT_BUY, &cp)) == RejectReason::NONE);
+    }
+
+    // 21c. Open exposure tracks queue, partial fill, full fill and cancel
+    {
+        OrderManager rom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 0, 0, 0, 1000.0, 0 });
+        rom.setRiskManager(&risk);
+        Counterparty maker("RK.Maker"), taker("RK.Taker");
+
+        Order resting("RK/D", 2.0, 400, OrderType::SPOT_SELL, &maker);
+        rom.processNewOrder(resting);
+        check("RK 21c: queued order adds open notional",      risk.openNotional(maker) == 800.0 && risk.openOrders(maker) == 1);
+        check("RK 21c: over the open limit rejected",         rom.processNewOrder(Order("RK/D", 2.0, 101, OrderType::SPOT_SELL, &maker)) == RejectReason::OPEN_EXPOSURE);
+
+        rom.processNewOrder(Order("RK/D", 2.0, 150, OrderType::SPOT_BUY, &taker));
+        check("RK 21c: partial fill releases its share",      risk.openNotional(maker) == 500.0 && risk.openOrders(maker) == 1);
+        check("RK 21c: fully filled aggressor holds nothing", risk.openNotional(taker) == 0.0 && risk.openOrders(taker) == 0);
+        check("RK 21c: room freed by the fill is usable",     rom.processNewOrder(Order("RK/D", 2.0, 250, OrderType::SPOT_SELL, &maker)) == RejectReason::NONE);
+
+        rom.processCancelOrder(resting.getId());
+        check("RK 21c: cancel releases the remainder",        risk.openNotional(maker) == 500.0 && risk.openOrders(maker) == 1);
+        rom.processNewOrder(Order("RK/D", 2.0, 250, OrderType::SPOT_BUY, &taker));
+        check("RK 21c: nothing resting, nothing open",        risk.openNotional(maker) == 0.0 && risk.openOrders(maker) == 0);
+    }
+
+    // 21d. Fills consume the credit line on both sides
+    {
+        OrderManager rom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 0, 0, 0, 0, 1000.0 });
+        rom.setRiskManager(&risk);
+        Counterparty a("RK.CreditA"), b("RK.CreditB");
+
+        rom.processNewOrder(Order("RK/E", 1.0, 600, OrderType::SPOT_SELL, &a));
+        rom.processNewOrder(Order("RK/E", 1.0, 600, OrderType::SPOT_BUY,  &b));
+        check("RK 21d: both sides charged the fill",          risk.filledNotional(a) == 600.0 && risk.filledNotional(b) == 600.0);
+        check("RK 21d: filled + new over the line rejected",  rom.processNewOrder(Order("RK/E", 1.0, 401, OrderType::SPOT_SELL, &a)) == RejectReason::CREDIT_LIMIT);
+        check("RK 21d: resting orders count against it too",  rom.processNewOrder(Order("RK/E", 1.0, 300, OrderType::SPOT_SELL, &a)) == RejectReason::NONE &&
+                                                              rom.processNewOrder(Order("RK/E", 1.0, 101, OrderType::SPOT_SELL, &a)) == RejectReason::CREDIT_LIMIT);
+    }
+
+    // 21e. Per-counterparty limits override the defaults
+    {
+        OrderManager rom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 100, 0, 0, 0, 0 });
+        rom.setRiskManager(&risk);
+        Counterparty big("RK.Big"), small("RK.Small");
+        risk.setLimits(big, { 10000, 0, 0, 0, 0 });
+
+        check("RK 21e: own limit applies",                    rom.processNewOrder(Order("RK/F", 1.0, 5000, OrderType::LIMIT_BUY, &big)) == RejectReason::NONE &&
+                                                              risk.getLimits(big).maxOrderQty == 10000);
+        check("RK 21e: others keep the defaults",             rom.processNewOrder(Order("RK/F", 1.0, 5000, OrderType::LIMIT_BUY, &small)) == RejectReason::MAX_ORDER_QTY);
+        check("RK 21e: no counterparty, per-order checks",    rom.processNewOrder(Order("RK/F", 1.0, 101, OrderType::LIMIT_BUY, nullptr)) == RejectReason::MAX_ORDER_QTY &&
+                                                              rom.processNewOrder(Order("RK/F", 1.0, 100, OrderType::LIMIT_BUY, nullptr)) == RejectReason::NONE);
+    }
+
+    // ── 22. Positions & P&L ──────────────────────────────────────────────────
+    section("Positions & P&L");
+
+    // 22a. Average cost on adds, realised P&L on reductions, through flat
+    {
+        PositionKeeper keeper;
+        Counterparty   a("PK.A"), b("PK.B");
+        auto rec = [&](long qty, double px) {   // a buys qty from b (qty < 0: a sells)
+            TradeRecord r{};
+            r.price    = px;
+            r.quantity = std::labs(qty);
+            r.buyerId  = qty > 0 ? a.getId() : b.getId();
+            r.sellerId = qty > 0 ? b.getId() : a.getId();
+            std::strcpy(r.symbol, "PK/A");
+            return r;
+        };
+        TradeRecord opens[] = { rec(100, 1.0), rec(100, 1.2) };
+        keeper.onTrades(opens, 2);
+        auto pa = keeper.getPositions("PK.A");
+        check("PK 22a: adds re-average the cost",             pa.size() == 1 && pa[0].net == 200 &&
+                                                              std::abs(pa[0].avgCost - 1.1) < 1e-9 && pa[0].realised == 0);
+        auto pb = keeper.getPositions("PK.B");
+        check("PK 22a: the other side is short",              pb.size() == 1 && pb[0].net == -200 &&
+                                                              std::abs(pb[0].avgCost - 1.1) < 1e-9);
+
+        TradeRecord reduce = rec(-50, 1.3);
+        keeper.onTrades(&reduce, 1);
+        pa = keeper.getPositions("PK.A");
+        check("PK 22a: reduction realises vs average cost",   pa[0].net == 150 && std::abs(pa[0].realised - 10.0) < 1e-9 &&
+                                                              std::abs(pa[0].avgCost - 1.1) < 1e-9);
+
+        TradeRecord flip = rec(-250, 1.0);
+        keeper.onTrades(&flip, 1);
+        pa = keeper.getPositions("PK.A");
+        check("PK 22a: through flat opens at the fill price", pa[0].net == -100 && std::abs(pa[0].avgCost - 1.0) < 1e-9 &&
+                                                              std::abs(pa[0].realised - (-5.0)) < 1e-9);
+
+        TradeRecord close = rec(100, 0.9);
+        keeper.onTrades(&close, 1);
+        pa = keeper.getPositions("PK.A");
+        pb = keeper.getPositions("PK.B");
+        check("PK 22a: flat again, cost reset",               pa[0].net == 0 && pa[0].avgCost == 0 &&
+                                                              std::abs(pa[0].realised - 5.0) < 1e-9);
+        check("PK 22a: bought and sold totals",               pa[0].bought == 300 && pa[0].sold == 300);
+        check("PK 22a: P&L is zero-sum between the sides",    std::abs(pa[0].realised + pb[0].realised) < 1e-9);
+        check("PK 22a: unknown counterparty has none",        keeper.getPositions("PK.None").empty() &&
+                                                              !keeper.hasPositions("PK.None"));
+    }
+
+    // 22b. Unrealised P&L marked on the BBO mid, last trade, else the last fill
+    {
+        MarketManager  pmd;
+        PositionKeeper keeper(&pmd);
+        Counterparty   a("PK.MarkA"), b("PK.MarkB");
+        TradeRecord r{};
+        r.price = 2.0; r.quantity = 100; r.buyerId = a.getId(); r.sellerId = b.getId();
+        std::strcpy(r.symbol, "PK/B");
+        keeper.onTrades(&r, 1);
+
+        auto pa = keeper.getPositions("PK.MarkA");
+        check("PK 22b: no market data marks on the last fill", pa[0].mark == 2.0 && pa[0].unrealised == 0);
+        pmd.onTrade("PK/B", 2.1, 10);
+        pa = keeper.getPositions("PK.MarkA");
+        check("PK 22b: marked on the market's last trade",    pa[0].mark == 2.1 && std::abs(pa[0].unrealised - 10.0) < 1e-9);
+        pmd.onQuote("PK/B", 2.19, 100, 2.21, 100);
+        pa = keeper.getPositions("PK.MarkA");
+        auto pb = keeper.getPositions("PK.MarkB");
+        check("PK 22b: marked on the BBO mid when quoted",    std::abs(pa[0].mark - 2.2) < 1e-9 && std::abs(pa[0].unrealised - 20.0) < 1e-9);
+        check("PK 22b: short loses as the mark rises",        std::abs(pb[0].unrealised + 20.0) < 1e-9);
+
+        PositionKeeper swaps;
+        TradeRecord legs[2] = { r, r };
+        legs[0].linkId = legs[1].linkId = 1;
+        legs[0].leg    = static_cast<uint8_t>(SwapLeg::NEAR);
+        legs[1].leg    = static_cast<uint8_t>(SwapLeg::FAR);
+        legs[1].price  = 2.05;   // near + forward points
+        swaps.onTrades(legs, 2);
+        check("PK 22b: a far swap leg never sets the mark",  swaps.getPositions("PK.MarkA")[0].mark == 2.0);
+    }
+
+    // 22c. Engine fills via the trade feed; same-named counterparties share a
+    //      book; one SSE position event per touched slot per batch; bounded
+    {
+        EventBus       bus;
+        auto           conn = bus.subscribe();
+        TradeFeed      feed;
+        PositionKeeper keeper(nullptr, &bus);
+        feed.addSink([&keeper](const TradeRecord* r, size_t n) { keeper.onTrades(r, n); });
+
+        OrderManager pom(nullptr);
+        pom.setTradeFeed(&feed);
+        Counterparty buyer("PK.Buyer"), buyerAgain("PK.Buyer"), seller("PK.Seller");
+        pom.processNewOrder(Order("PK/C", 1.5, 300, OrderType::SPOT_SELL, &seller));
+        pom.processNewOrder(Order("PK/C", 1.5, 100, OrderType::SPOT_BUY,  &buyer));
+        pom.processNewOrder(Order("PK/C", 1.5, 200, OrderType::SPOT_BUY,  &buyerAgain));
+        feed.flush();   // no consumer running: one batch of both fills
+
+        auto pb = keeper.getPositions("PK.Buyer");
+        check("PK 22c: same name, one book",                  pb.size() == 1 && pb[0].net == 300 && pb[0].avgCost == 1.5);
+        check("PK 22c: seller short the total",               keeper.getPositions("PK.Seller")[0].net == -300);
+
+        int positionEvents = 0;
+        {
+            std::lock_guard<std::mutex> lk(conn->mu);
+            while (!conn->queue.empty()) {
+                if (conn->queue.front().msg.rfind("event: position\n", 0) == 0) ++positionEvents;
+                conn->queue.pop();
+            }
+        }
+        check("PK 22c: one event per touched slot per batch", positionEvents == 2);
+
+        for (int i = 0; i < 100; ++i) {
+            pom.processNewOrder(Order("PK/C", 1.5, 10, OrderType::SPOT_SELL, &seller));
+            pom.processNewOrder(Order("PK/C", 1.5, 10, OrderType::SPOT_BUY,  &buyer));
+        }
+        feed.flush();
+        pb = keeper.getPositions("PK.Buyer");
+        check("PK 22c: one slot however many fills",          pb.size() == 1 && pb[0].net == 1300 && pb[0].bought == 1300);
+        bus.unsubscribe(conn);
+    }
+
+    // 22d. A feed ring far smaller than the burst loses no fill, so the
+    //      position still adds up
+    {
+        TradeFeed      feed(4);   // consumer not started: all but 4 overflow
+        PositionKeeper keeper;
+        feed.addSink([&keeper](const TradeRecord* r, size_t n) { keeper.onTrades(r, n); });
+
+        OrderManager pom(nullptr);
+        pom.setTradeFeed(&feed);
+        Counterparty buyer("PK.Burst"), seller("PK.BurstSeller");
+        for (int i = 0; i < 100; ++i) {
+            pom.processNewOrder(Order("PK/D", 1.0 + i * 0.01, 10, OrderType::SPOT_SELL, &seller));
+            pom.processNewOrder(Order("PK/D", 1.0 + i * 0.01, 10, OrderType::SPOT_BUY,  &buyer));
+        }
+        feed.flush();
+        auto pb = keeper.getPositions("PK.Burst");
+        check("PK 22d: fills past a full feed ring all counted", feed.overflowed() == 96 && pb.size() == 1 &&
+                                                              pb[0].net == 1000 && std::abs(pb[0].avgCost - 1.495) < 1e-9);
+    }
+
+    // ── 23. Counterparty History ─────────────────────────────────────────────
+    section("Counterparty History");
+
+    // 23a. Fixed-size records in a bounded ring, oldest evicted first
+    {
+        Counterparty cp("CH.A");
+        auto note = [](int64_t ts) {
+            TradeNotification n{};
+            n.tsNs = ts; n.orderId = ts; n.price = 1.0; n.quantity = 10;
+            return n;
+        };
+        const long extra = 10;
+        for (long i = 1; i <= static_cast<long>(Counterparty::HISTORY) + extra; ++i) cp.onTrade(note(i));
+
+        auto kept = cp.getTrades();
+        check("CH 23a: fixed-size, trivially copyable",       std::is_trivially_copyable<TradeNotification>::value);
+        check("CH 23a: ring holds HISTORY fills",             kept.size() == Counterparty::HISTORY);
+        check("CH 23a: oldest evicted, order kept",           kept.front().tsNs == extra + 1 &&
+                                                              kept.back().tsNs == static_cast<long>(Counterparty::HISTORY) + extra);
+        check("CH 23a: every fill counted",                   cp.getTradeCount() == Counterparty::HISTORY + extra);
+
+        auto page = cp.getTrades(500, 3);
+        check("CH 23a: page is the newest at or before to",   page.size() == 3 && page[0].tsNs == 498 && page[2].tsNs == 500);
+        check("CH 23a: page stops at the oldest retained",    cp.getTrades(extra + 2, 100).size() == 2);
+
+        Counterparty same("CH.SameNs");
+        for (long id = 1; id <= 3; ++id) { TradeNotification n = note(700); n.orderId = id; same.onTrade(n); }
+        auto first = same.getTrades(700, 2);
+        auto rest  = same.getTrades(700, 2, first.size());
+        check("CH 23a: skip pages within one nanosecond",     first.size() == 2 && first[0].orderId == 2 &&
+                                                              rest.size() == 1 && rest[0].orderId == 1);
+    }
+
+    // 23b. Engine fills: one stamp shared with the trade feed, other party by id
+    {
+        TradeFeed   feed;
+        TradeRecord seen{};
+        feed.addSink([&seen](const TradeRecord* r, size_t n) { seen = r[n - 1]; });
+        OrderManager hom(nullptr);
+        hom.setTradeFeed(&feed);
+        Counterparty buyer("CH.Buyer"), seller("CH.Seller");
+        Order ask("CH/B", 1.25, 100, OrderType::SPOT_SELL, &seller);
+        hom.processNewOrder(ask);
+        hom.processNewOrder(Order("CH/B", 1.25, 100, OrderType::SPOT_BUY, &buyer));
+        feed.flush();
+
+        const TradeNotification s = seller.getTrades().at(0);
+        check("CH 23b: other party held by id",               s.counterpartyId == buyer.getId() &&
+                                                              s.counterpartyName() == "CH.Buyer");
+        check("CH 23b: symbol and order carried",             std::string(s.symbol) == "CH/B" && s.orderId == ask.getId() && !s.wasBuy);
+        check("CH 23b: same timestamp as the trade feed",     s.tsNs > 0 && s.tsNs == seen.tsNs &&
+                                                              buyer.getTrades().at(0).tsNs == seen.tsNs);
+    }
+
+    // 23c. The trade store answers for fills no longer retained
+    {
+        std::string dir = "/tmp/ts_tests_history_" + std::to_string(getpid());
+        std::filesystem::remove_all(dir);
+        TradeStore   store;
+        store.open(dir);
+        Counterparty a("CH.StoreA"), b("CH.StoreB"), c("CH.StoreC");
+        auto rec = [](int64_t ts, const Counterparty& buyer, const Counterparty& seller) {
+            TradeRecord r{};
+            r.tsNs = ts; r.price = 1.0; r.quantity = 5;
+            r.buyerId = buyer.getId(); r.sellerId = seller.getId();
+            std::strcpy(r.symbol, "CH/C");
+            return r;
+        };
+        TradeRecord batch[] = { rec(1, a, b), rec(2, b, c), rec(3, c, a), rec(4, b, c) };
+        store.onTrades(batch, 4);
+
+        TradeQuery q;
+        q.counterparty = "CH.StoreA";
+        auto fills = store.query(q);
+        check("CH 23c: store filters on buyer or seller",     fills.size() == 2 && fills[0].tsNs == 1 && fills[1].tsNs == 3);
+        check("CH 23c: counted the same way",                 store.count(q) == 2);
+        q.toNs = 2;
+        check("CH 23c: pages back with to",                   store.query(q).size() == 1);
+        q.counterparty = "CH.Nobody";
+        check("CH 23c: unknown counterparty matches nothing", store.query(q).empty() && store.count(q) == 0);
+        store.close();
+        std::filesystem::remove_all(dir);
+    }
+
+    // 23d. Every fill the ring evicts, swap legs included, is in the store,
+    //      even through a feed ring too small for the burst
+    {
+        std::string dir = "/tmp/ts_tests_spill_" + std::to_string(getpid());
+        std::filesystem::remove_all(dir);
+        TradeStore store;
+        store.open(dir);
+        TradeFeed  feed(64);
+        feed.addSink([&store](const TradeRecord* r, size_t n) { store.onTrades(r, n); });
+        feed.start();
+
+        MarketManager hmm;
+        OrderManager  hom(&hmm);
+        hom.setTradeFeed(&feed);
+        hmm.onQuote("CH/D", 1.0, 1000, 1.2, 1000);
+        Counterparty buyer("CH.Soak"), seller("CH.SoakSeller");
+        const long spot = static_cast<long>(Counterparty::HISTORY) + 100;
+        for (long i = 0; i < spot; ++i) {
+            hom.processNewOrder(Order("CH/D", 1.1, 1, OrderType::SPOT_SELL, &seller));
+            hom.processNewOrder(Order("CH/D", 1.1, 1, OrderType::SPOT_BUY,  &buyer));
+        }
+        hom.processNewOrder(Order("CH/D", 0.01, 1, OrderType::SWAP_SELL, &seller));
+        hom.processNewOrder(Order("CH/D", 0.01, 1, OrderType::SWAP_BUY,  &buyer));
+        feed.flush();
+
+        TradeQuery q;
+        q.counterparty = "CH.Soak";
+        check("CH 23d: ring evicted the oldest",              buyer.getTradeCount() == static_cast<uint64_t>(spot) + 2 &&
+                                                              buyer.getTrades().size() == Counterparty::HISTORY);
+        check("CH 23d: store holds every fill, legs too",     store.count(q) == buyer.getTradeCount());
+        feed.stop();
+        store.close();
+        std::filesystem::remove_all(dir);
+    }
+
+    // ── 24. Mass Cancel ───────────────────────────────────────────────────────
+    section("Mass Cancel");
+
+    // 24a. One pass over the counterparty's own orders, one delta per symbol
+    {
+        OrderManager mom(nullptr);
+        EventBus     bus;
+        RiskManager  risk;
+        mom.setEventBus(&bus);
+        mom.setRiskManager(&risk);
+        auto conn = bus.subscribe();
+        Counterparty mm("MC.Maker"), other("MC.Other");
+
+        for (int i = 0; i < 5; ++i) {
+            mom.processNewOrder(Order("MC/A", 1.00 - 0.01 * i, 100, OrderType::SPOT_BUY,  &mm));
+            mom.processNewOrder(Order("MC/A", 1.10 + 0.01 * i, 100, OrderType::SPOT_SELL, &mm));
+        }
+        for (int i = 0; i < 3; ++i) mom.processNewOrder(Order("MC/B", 2.00, 100, OrderType::SPOT_BUY, &mm));
+        Order kept("MC/A", 0.90, 100, OrderType::SPOT_BUY, &other);
+        mom.processNewOrder(kept);
+        while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+
+        uint64_t mass0 = Metrics::total(Counter::MASS_CANCELS);
+        check("MC 24a: symbol filter cancels only that book",  mom.cancelAll(mm, "MC/B") == 3 &&
+                                                               mom.getSubBook("MC/B").getBuyOrders().empty() &&
+                                                               mm.getOrderIds().size() == 10);
+        check("MC 24a: one book_update for the symbol",        conn->queue.size() == 1);
+        while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+
+        check("MC 24a: rest of the counterparty cancelled",    mom.cancelAll(mm) == 10 && mm.getOrderIds().empty());
+        check("MC 24a: one book_update per affected symbol",   conn->queue.size() == 1);
+        SubBook& a = mom.getSubBook("MC/A");
+        check("MC 24a: other counterparties untouched",        a.getSellOrdersRef().empty() && a.getBuyOrdersRef().size() == 1 &&
+                                                               a.getBuyOrdersRef().begin()->second.front().getId() == kept.getId());
+        check("MC 24a: open exposure released",                risk.openOrders(mm) == 0 && risk.openNotional(mm) == 0.0 &&
+                                                               risk.openOrders(other) == 1);
+        check("MC 24a: nothing left is a no-op",               mom.cancelAll(mm) == 0 && conn->queue.size() == 1);
+        check("MC 24a: mass cancels counted",                  Metrics::total(Counter::MASS_CANCELS) - mass0 == 3);
+        bus.unsubscribe(conn);
+    }
+
+    // ── 25. Order Amend ───────────────────────────────────────────────────────
+    section("Order Amend");
+
+    // 25a. Quantity cut keeps priority; more quantity or a new price goes to the back
+    {
+        OrderManager aom(nullptr);
+        EventBus     bus;
+        aom.setEventBus(&bus);
+        auto conn = bus.subscribe();
+        Counterparty cp("AM.Maker");
+        auto drain = [&]() {
+            size_t n = conn->queue.size();
+            while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+            return n;
+        };
+
+        Order a("AM/A", 1.10, 100, OrderType::SPOT_SELL, &cp);
+        Order b("AM/A", 1.10, 100, OrderType::SPOT_SELL, &cp);
+        aom.processNewOrder(a);
+        aom.processNewOrder(b);
+        drain();
+        auto& asks = aom.getSubBook("AM/A").getSellOrdersRef();
+
+        check("AM 25a: quantity cut applied",                 aom.processAmendOrder(a.getId(), 1.10, 60) == AmendResult::AMENDED &&
+                                                              aom.getOrder(a.getId())->getQuantity() == 60);
+        check("AM 25a: quantity cut keeps queue position",    asks.at(1.10).front().getId() == a.getId());
+        check("AM 25a: one book_update per amend",            drain() == 1);
+
+        aom.processAmendOrder(a.getId(), 1.10, 150);
+        check("AM 25a: more quantity goes to the back",       asks.at(1.10).front().getId() == b.getId() &&
+                                                              asks.at(1.10).back().getQuantity() == 150);
+
+        aom.processAmendOrder(b.getId(), 1.12, 100);
+        check("AM 25a: new price moves the order",            asks.count(1.12) == 1 && asks.at(1.12).front().getId() == b.getId() &&
+                                                              asks.at(1.10).size() == 1);
+        aom.processAmendOrder(a.getId(), 1.12, 150);
+        check("AM 25a: emptied level erased, order at back",  asks.count(1.10) == 0 && asks.at(1.12).back().getId() == a.getId());
+        check("AM 25a: counterparty still holds both",        cp.getOrderIds().size() == 2);
+
+        aom.processCancelOrder(b.getId());
+        aom.processCancelOrder(a.getId());
+        check("AM 25a: moved orders cancel cleanly",          asks.empty() && cp.getOrderIds().empty());
+        drain();
+
+        check("AM 25a: unknown order",                        aom.processAmendOrder(999999, 1.0, 10) == AmendResult::NOT_FOUND);
+        Order c("AM/A", 1.20, 100, OrderType::SPOT_SELL, &cp);
+        aom.processNewOrder(c);
+        check("AM 25a: zero quantity invalid",                aom.processAmendOrder(c.getId(), 1.20, 0) == AmendResult::INVALID &&
+                                                              aom.getOrder(c.getId())->getQuantity() == 100);
+        check("AM 25a: zero price invalid",                   aom.processAmendOrder(c.getId(), 0.0, 100) == AmendResult::INVALID &&
+                                                              aom.getOrder(c.getId())->getPrice() == 1.20);
+        bus.unsubscribe(conn);
+    }
+
+    // 25b. A SPOT amend that crosses trades like a new order; the rest rests
+    {
+        OrderManager aom(nullptr);
+        Counterparty maker("AM.Ask"), taker("AM.Bid");
+        Order ask("AM/B", 1.05, 40, OrderType::SPOT_SELL, &maker);
+        Order bid("AM/B", 1.00, 100, OrderType::SPOT_BUY, &taker);
+        aom.processNewOrder(ask);
+        aom.processNewOrder(bid);
+        size_t trades0 = aom.getRecentTrades().size();
+
+        aom.processAmendOrder(bid.getId(), 1.06, 100);
+        const Trade& t = aom.getRecentTrades().back();
+        check("AM 25b: crossing amend trades at the resting price",
+              aom.getRecentTrades().size() == trades0 + 1 && t.price == 1.05 && t.quantity == 40 &&
+              t.buyOrderId == bid.getId());
+        auto& bids = aom.getSubBook("AM/B").getBuyOrdersRef();
+        check("AM 25b: remainder rests at the new price",     bids.size() == 1 && bids.count(1.06) == 1 &&
+                                                              aom.getOrder(bid.getId())->getQuantity() == 60);
+        check("AM 25b: filled ask gone, ids current",         aom.getSubBook("AM/B").getSellOrders().empty() &&
+                                                              maker.getOrderIds().empty() && taker.hasOrderId(bid.getId()));
+    }
+
+    // 25c. Only amends that add exposure are screened; a refused one changes nothing
+    {
+        OrderManager aom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 100, 0, 0, 0, 0 });
+        aom.setRiskManager(&risk);
+        Counterparty cp("AM.Risk");
+        Order o("AM/C", 2.0, 80, OrderType::SPOT_BUY, &cp);
+        aom.processNewOrder(o);
+
+        RejectReason reason = RejectReason::NONE;
+        check("AM 25c: over the cap refused",                 aom.processAmendOrder(o.getId(), 2.0, 101, 0, &reason) == AmendResult::REJECTED &&
+                                                              reason == RejectReason::MAX_ORDER_QTY);
+        check("AM 25c: refused amend leaves order and exposure",
+              aom.getOrder(o.getId())->getQuantity() == 80 && risk.openNotional(cp) == 160.0 && risk.openOrders(cp) == 1);
+        aom.processAmendOrder(o.getId(), 1.5, 50);
+        check("AM 25c: exposure follows the new terms",       risk.openNotional(cp) == 75.0 && risk.openOrders(cp) == 1);
+    }
+
+    // ── 26. Time in Force ─────────────────────────────────────────────────────
+    section("Time in Force");
+
+    // 26a. Per-level totals follow every queue, fill, cut, move and cancel
+    {
+        OrderManager tom(nullptr);
+        Counterparty maker("TF.Maker"), taker("TF.Taker");
+        Order a("TF/A", 1.10, 100, OrderType::SPOT_SELL, &maker);
+        Order b("TF/A", 1.10, 200, OrderType::SPOT_SELL, &maker);
+        tom.processNewOrder(a);
+        tom.processNewOrder(b);
+        auto& asks = tom.getSubBook("TF/A").getSellOrdersRef();
+        check("TF 26a: queued orders summed per level",      asks.at(1.10).quantity == 300);
+
+        tom.processNewOrder(Order("TF/A", 1.10, 130, OrderType::SPOT_BUY, &taker));
+        check("TF 26a: full and partial fills subtracted",   asks.at(1.10).quantity == 170);
+        tom.processAmendOrder(b.getId(), 1.10, 120);
+        check("TF 26a: quantity cut subtracted",             asks.at(1.10).quantity == 120);
+        tom.processAmendOrder(b.getId(), 1.11, 150);
+        check("TF 26a: move carries quantity across levels", asks.count(1.10) == 0 && asks.at(1.11).quantity == 150);
+        tom.processNewOrder(Order("TF/A", 1.11, 50, OrderType::SPOT_SELL, &maker));
+        tom.processCancelOrder(b.getId());
+        check("TF 26a: cancel subtracted",                   asks.at(1.11).quantity == 50);
+    }
+
+    // 26b. IOC fills what it can and drops the rest without indexing it
+    {
+        OrderManager tom(nullptr);
+        EventBus     bus;
+        tom.setEventBus(&bus);
+        auto conn = bus.subscribe();
+        Counterparty maker("TF.IocMaker"), taker("TF.IocTaker");
+        tom.processNewOrder(Order("TF/B", 1.00, 60, OrderType::SPOT_SELL, &maker));
+        tom.processNewOrder(Order("TF/B", 1.01, 30, OrderType::SPOT_SELL, &maker));
+        tom.processNewOrder(Order("TF/B", 1.05, 40, OrderType::SPOT_SELL, &maker));
+        while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+
+        uint64_t tif0 = Metrics::total(Counter::TIF_CANCELS);
+        Order ioc("TF/B", 1.02, 150, OrderType::SPOT_BUY, &taker);
+        ioc.setTimeInForce(TimeInForce::IOC);
+        long filled = -1;
+        tom.processNewOrder(ioc, &filled);
+        auto& sb = tom.getSubBook("TF/B");
+        check("TF 26b: IOC fills the crossed levels",        filled == 90 && sb.getSellOrders().size() == 1);
+        check("TF 26b: remainder never rests or is indexed", sb.getBuyOrders().empty() && tom.getOrder(ioc.getId()) == nullptr &&
+                                                             taker.getOrderIds().empty());
+        check("TF 26b: one book_update, remainder counted",  conn->queue.size() == 3 &&   // two trades + one book
+                                                             Metrics::total(Counter::TIF_CANCELS) - tif0 == 1);
+        while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+
+        Order miss("TF/B", 1.00, 10, OrderType::SPOT_BUY, &taker);
+        miss.setTimeInForce(TimeInForce::IOC);
+        tom.processNewOrder(miss, &filled);
+        check("TF 26b: IOC with no cross changes nothing",   filled == 0 && sb.getBuyOrders().empty() && conn->queue.empty());
+        bus.unsubscribe(conn);
+    }
+
+    // 26c. FOK is decided from level totals before any fill
+    {
+        OrderManager tom(nullptr);
+        EventBus     bus;
+        tom.setEventBus(&bus);
+        auto conn = bus.subscribe();
+        Counterparty maker("TF.FokMaker"), taker("TF.FokTaker");
+        tom.processNewOrder(Order("TF/C", 2.00, 100, OrderType::SPOT_BUY, &maker));
+        tom.processNewOrder(Order("TF/C", 1.99, 100, OrderType::SPOT_BUY, &maker));
+        tom.processNewOrder(Order("TF/C", 1.98, 500, OrderType::SPOT_BUY, &maker));
+        while (!conn->queue.empty()) { conn->queue.pop(); bus.onDelivered(1); }
+        size_t trades0 = tom.getRecentTrades().size();
+
+        Order tooBig("TF/C", 1.99, 201, OrderType::SPOT_SELL, &taker);
+        tooBig.setTimeInForce(TimeInForce::FOK);
+        check("TF 26c: depth beyond the limit not counted",  !TradeManager::canFill(tooBig, tom.getSubBook("TF/C")));
+        long filled = -1;
+        tom.processNewOrder(tooBig, &filled);
+        check("TF 26c: unfillable FOK: no fills, no event",  filled == 0 && tom.getRecentTrades().size() == trades0 &&
+                                                             conn->queue.empty() && tom.getSubBook("TF/C").getBuyOrders().size() == 3);
+
+        Order exact("TF/C", 1.99, 200, OrderType::SPOT_SELL, &taker);
+        exact.setTimeInForce(TimeInForce::FOK);
+        tom.processNewOrder(exact, &filled);
+        check("TF 26c: exactly enough depth fills in full",  filled == 200 && tom.getRecentTrades().size() == trades0 + 2 &&
+                                                             tom.getSubBook("TF/C").getBuyOrders().size() == 1);
+
+        Order limit("TF/C", 1.98, 10, OrderType::LIMIT_SELL, &taker);
+        limit.setTimeInForce(TimeInForce::IOC);
+        tom.processNewOrder(limit, &filled);
+        check("TF 26c: non-SPOT IOC is dropped, not queued", filled == 0 && tom.getSubBook("TF/C").getSellOrders().empty());
+        bus.unsubscribe(conn);
+    }
+
+    // ── 27. Iceberg Orders ────────────────────────────────────────────────────
+    section("Iceberg Orders");
+
+    // 27a. Only the slice is displayed; a used-up slice refills at the back
+    {
+        OrderManager iom(nullptr);
+        Counterparty maker("IC.Maker"), taker("IC.Taker");
+        Order ice("IC/A", 1.10, 1000, OrderType::SPOT_SELL, &maker);
+        ice.setDisplayQuantity(100);
+        Order plain("IC/A", 1.10, 50, OrderType::SPOT_SELL, &maker);
+        iom.processNewOrder(ice);
+        iom.processNewOrder(plain);
+        PriceLevel& level = iom.getSubBook("IC/A").getSellOrdersRef().at(1.10);
+        check("IC 27a: level displays the slice only",       level.quantity == 150 && level.reserve == 900 &&
+                                                             iom.getOrder(ice.getId())->getQuantity() == 100);
+
+        const Order* node = iom.getOrder(ice.getId());
+        uint64_t refresh0 = Metrics::total(Counter::ICEBERG_REFRESHES);
+        iom.processNewOrder(Order("IC/A", 1.10, 100, OrderType::SPOT_BUY, &taker));
+        check("IC 27a: refilled slice joins the back",       level.front().getId() == plain.getId() &&
+                                                             level.back().getId() == ice.getId() &&
+                                                             level.quantity == 150 && level.reserve == 800);
+        check("IC 27a: same node, index entry untouched",    iom.getOrder(ice.getId()) == node && &level.back() == node);
+
+        size_t trades0 = iom.getRecentTrades().size();
+        iom.processNewOrder(Order("IC/A", 1.10, 250, OrderType::SPOT_BUY, &taker));
+        check("IC 27a: one sweep takes several slices",      iom.getRecentTrades().size() == trades0 + 3 &&
+                                                             level.size() == 1 && level.quantity == 100 && level.reserve == 600);
+        check("IC 27a: every refill counted",                Metrics::total(Counter::ICEBERG_REFRESHES) - refresh0 == 3);
+    }
+
+    // 27b. Hidden size is executable, amendable and carries exposure
+    {
+        OrderManager iom(nullptr);
+        RiskManager  risk;
+        iom.setRiskManager(&risk);
+        Counterparty maker("IC.Hidden"), taker("IC.Sweeper");
+        Order ice("IC/B", 2.00, 500, OrderType::SPOT_SELL, &maker);
+        ice.setDisplayQuantity(100);
+        iom.processNewOrder(ice);
+        check("IC 27b: exposure includes the reserve",       risk.openNotional(maker) == 1000.0);
+
+        iom.processAmendOrder(ice.getId(), 2.00, 250);
+        const Order* o = iom.getOrder(ice.getId());
+        check("IC 27b: cut comes out of the reserve first",  o->getQuantity() == 100 && o->getReserve() == 150 &&
+                                                             risk.openNotional(maker) == 500.0);
+
+        Order fok("IC/B", 2.00, 250, OrderType::SPOT_BUY, &taker);
+        fok.setTimeInForce(TimeInForce::FOK);
+        check("IC 27b: FOK counts hidden depth",             TradeManager::canFill(fok, iom.getSubBook("IC/B")));
+        long filled = -1;
+        iom.processNewOrder(fok, &filled);
+        check("IC 27b: FOK fills through the reserve",       filled == 250 && iom.getSubBook("IC/B").getSellOrders().empty() &&
+                                                             maker.getOrderIds().empty() && risk.openOrders(maker) == 0);
+
+        iom.processNewOrder(Order("IC/B", 1.90, 100, OrderType::SPOT_SELL, &maker));
+        Order bigBuy("IC/B", 1.95, 300, OrderType::SPOT_BUY, &taker);
+        bigBuy.setDisplayQuantity(50);
+        iom.processNewOrder(bigBuy, &filled);
+        const PriceLevel& bid = iom.getSubBook("IC/B").getBuyOrders().at(1.95);
+        check("IC 27b: aggressor matches full size, then splits",
+              filled == 100 && bid.quantity == 50 && bid.reserve == 150);
+    }
+
+    // ── 28. Pegged Orders ─────────────────────────────────────────────────────
+    section("Pegged Orders");
+
+    // 28a. Priced off the quote; a quote move re-prices each group in one pass
+    {
+        MarketManager pmm;
+        OrderManager  pom(&pmm);
+        RiskManager   risk;
+        pom.setRiskManager(&risk);
+        Counterparty mm("PG.Maker");
+        pmm.onQuote("PG/A", 100.0, 500, 102.0, 500);
+
+        auto pegged = [&](OrderType type, PegType peg, double offset) {
+            Order o("PG/A", 0.0, 10, type, &mm);
+            o.setPeg(peg, offset);
+            pom.processNewOrder(o);
+            return o.getId();
+        };
+        Order fixed("PG/A", 100.0, 10, OrderType::SPOT_BUY, &mm);
+        pom.processNewOrder(fixed);
+        long a = pegged(OrderType::SPOT_BUY,  PegType::PRIMARY, -1.0);
+        long b = pegged(OrderType::SPOT_BUY,  PegType::PRIMARY, -1.0);
+        long c = pegged(OrderType::SPOT_BUY,  PegType::MID,     -0.5);
+        long s = pegged(OrderType::SPOT_SELL, PegType::MARKET,   2.0);
+        SubBook& sb = pom.getSubBook("PG/A");
+        check("PG 28a: priced from the quote plus offset",   pom.getOrder(a)->getPrice() == 99.0 && pom.getOrder(c)->getPrice() == 100.5 &&
+                                                             pom.getOrder(s)->getPrice() == 102.0);
+        check("PG 28a: same side, peg and offset: one group", sb.getPegGroups().size() == 3);
+
+        uint64_t moved0 = Metrics::total(Counter::PEG_REPRICES);
+        pmm.onQuote("PG/A", 101.0, 500, 103.0, 500);
+        pom.processMarketTick("PG/A");
+        const PriceLevel& at100 = sb.getBuyOrders().at(100.0);
+        check("PG 28a: group moves behind the new level",    at100.size() == 3 && at100.front().getId() == fixed.getId() &&
+                                                             std::next(at100.begin())->getId() == a && at100.back().getId() == b &&
+                                                             sb.getBuyOrders().count(99.0) == 0);
+        check("PG 28a: every peg followed its reference",    pom.getOrder(c)->getPrice() == 101.5 && pom.getOrder(s)->getPrice() == 103.0 &&
+                                                             Metrics::total(Counter::PEG_REPRICES) - moved0 == 4);
+        check("PG 28a: exposure re-marked at the new prices",
+              risk.openNotional(mm) == 10 * (100.0 + 100.0 + 100.0 + 101.5 + 103.0));
+
+        pom.processMarketTick("PG/A");
+        check("PG 28a: unchanged quote moves nothing",       Metrics::total(Counter::PEG_REPRICES) - moved0 == 4);
+    }
+
+    // 28b. Stale members dropped; a crossing re-price matches; price is the peg's
+    {
+        MarketManager pmm;
+        OrderManager  pom(&pmm);
+        Counterparty mm("PG.Quoter"), other("PG.Other");
+
+        Order lost("PG/B", 0.0, 10, OrderType::SPOT_BUY, &mm);
+        lost.setPeg(PegType::MID, 0.0);
+        check("PG 28b: no quote, no peg",                    pom.processNewOrder(lost) == RejectReason::NO_PEG_REFERENCE &&
+                                                             pom.getSubBook("PG/B").getBuyOrders().empty());
+
+        pmm.onQuote("PG/B", 100.0, 500, 102.0, 500);
+        Order a("PG/B", 0.0, 10, OrderType::SPOT_BUY, &mm);
+        Order b("PG/B", 0.0, 10, OrderType::SPOT_BUY, &mm);
+        a.setPeg(PegType::PRIMARY, -1.0);
+        b.setPeg(PegType::PRIMARY, -1.0);
+        pom.processNewOrder(a);
+        pom.processNewOrder(b);
+        pom.processCancelOrder(a.getId());
+        pom.processNewOrder(Order("PG/B", 101.0, 10, OrderType::SPOT_SELL, &other));
+
+        size_t trades0 = pom.getRecentTrades().size();
+        pmm.onQuote("PG/B", 102.0, 500, 104.0, 500);
+        pom.processMarketTick("PG/B");
+        SubBook& sb = pom.getSubBook("PG/B");
+        check("PG 28b: cancelled member dropped from group", sb.getPegGroups().empty());
+        check("PG 28b: crossing re-price trades at resting", pom.getRecentTrades().size() == trades0 + 1 &&
+                                                             pom.getRecentTrades().back().price == 101.0 &&
+                                                             pom.getOrder(b.getId()) == nullptr && sb.getSellOrders().empty());
+
+        Order c("PG/B", 0.0, 10, OrderType::SPOT_SELL, &mm);
+        c.setPeg(PegType::PRIMARY, 1.0);
+        pom.processNewOrder(c);
+        check("PG 28b: moving a pegged price is refused",    pom.processAmendOrder(c.getId(), 110.0, 10) == AmendResult::INVALID &&
+                                                             pom.processAmendOrder(c.getId(), 105.0, 5)  == AmendResult::AMENDED &&
+                                                             pom.getOrder(c.getId())->getQuantity() == 5);
+    }
+
+    // ── 29. Swap Orders ───────────────────────────────────────────────────────
+    section("Swap Orders");
+
+    // 29a. Swaps match in their own book; each fill is a linked near/far pair
+    {
+        MarketManager smm;
+        OrderManager  som(&smm);
+        Counterparty  maker("SW.Maker"), taker("SW.Taker");
+        smm.onQuote("SW/A", 100.0, 500, 102.0, 500);   // near rate: mid 101
+
+        Order lender("SW/A", 0.5, 100, OrderType::SWAP_SELL, &maker);
+        som.processNewOrder(lender);
+        som.processNewOrder(Order("SW/A", 110.0, 100, OrderType::SPOT_BUY, &taker));
+        check("SW 29a: swap rests in the pair's swap book",  som.getSwapBook("SW/A").getSellOrders().count(0.5) == 1 &&
+                                                             som.getSubBook("SW/A").getSellOrders().empty());
+        check("SW 29a: spot never crosses the swap book",    som.getRecentTrades().empty());
+
+        long filled = 0;
+        Order payer("SW/A", 0.6, 60, OrderType::SWAP_BUY, &taker);
+        som.processNewOrder(payer, &filled);
+        const auto& trades = som.getRecentTrades();
+        check("SW 29a: one fill executes two linked legs",   filled == 60 && trades.size() == 2 &&
+                                                             trades[0].linkId != 0 && trades[0].linkId == trades[1].linkId &&
+                                                             trades[0].quantity == 60 && trades[1].quantity == 60);
+        const Trade& near = trades[0];
+        const Trade& far  = trades[1];
+        check("SW 29a: near leg at the mid, far at + points", near.leg == SwapLeg::NEAR && near.price == 101.0 &&
+                                                             far.leg  == SwapLeg::FAR  && far.price  == 101.5);
+        check("SW 29a: SWAP_BUY sells near and buys far",    near.seller == &taker && near.buyer == &maker &&
+                                                             far.buyer   == &taker && far.seller == &maker &&
+                                                             far.buyOrderId == payer.getId());
+
+        MarketQuote q;
+        smm.getQuote("SW/A", q);
+        check("SW 29a: legs are not spot market data",       q.last == 0 && q.volume == 0);
+        check("SW 29a: standing swap keeps its remainder",   som.getOrder(lender.getId())->getQuantity() == 40);
+    }
+
+    // 29b. No near rate, no swap trade; cancel and amend work on the swap book
+    {
+        MarketManager smm;
+        OrderManager  som(&smm);
+        EventBus      bus;
+        som.setEventBus(&bus);
+        Counterparty  maker("SW.Quoter"), taker("SW.Hitter");
+
+        Order discount("SW/B", -0.25, 10, OrderType::SWAP_SELL, &maker);
+        Order bid("SW/B", -0.75, 10, OrderType::SWAP_BUY, &taker);
+        som.processNewOrder(discount);
+        som.processNewOrder(bid);
+        check("SW 29b: negative points rest",                som.getOrder(discount.getId()) && som.getOrder(bid.getId()));
+        check("SW 29b: crossing without a near rate refused",
+              som.processNewOrder(Order("SW/B", -0.25, 10, OrderType::SWAP_BUY, &taker)) == RejectReason::NO_NEAR_RATE &&
+              som.getOrder(discount.getId())->getQuantity() == 10 && som.getSwapBook("SW/B").getBuyOrders().size() == 1);
+        check("SW 29b: ... and so is an amend into the cross",
+              som.processAmendOrder(bid.getId(), -0.25, 10) == AmendResult::REJECTED);
+
+        smm.onQuote("SW/B", 100.0, 500, 102.0, 500);
+        check("SW 29b: amend that crosses matches both legs",
+              som.processAmendOrder(bid.getId(), -0.25, 4) == AmendResult::AMENDED &&
+              som.getRecentTrades().size() == 2 && som.getRecentTrades().back().price == 100.75 &&
+              som.getOrder(discount.getId())->getQuantity() == 6);
+
+        auto conn = bus.subscribe();
+        som.processCancelOrder(discount.getId());
+        check("SW 29b: cancel publishes the swap book",
+              conn->queue.size() == 1 && conn->queue.front().msg.rfind("event: swap_book_update\n", 0) == 0 &&
+              som.getSwapBook("SW/B").getSellOrders().empty());
+        bus.unsubscribe(conn);
+    }
+
+    // 29c. Legs reach the trade feed tagged with their linkId, so positions
+    //      see them, while candles skip them
+    {
+        MarketManager    smm;
+        OrderManager     som(&smm);
+        TradeFeed        feed;   // consumer not started
+        CandleAggregator agg(nullptr);
+        PositionKeeper   keeper;
+        std::vector<int64_t> links;
+        std::vector<uint8_t> legs;
+        feed.addSink([&](const TradeRecord* r, size_t n) {
+            agg.onTrades(r, n);
+            keeper.onTrades(r, n);
+            for (size_t i = 0; i < n; ++i) { links.push_back(r[i].linkId); legs.push_back(r[i].leg); }
+        });
+        som.setTradeFeed(&feed);
+        Counterparty maker("SW.FeedMaker"), taker("SW.FeedTaker");
+        smm.onQuote("SW/C", 100.0, 500, 102.0, 500);
+
+        som.processNewOrder(Order("SW/C", 0.5, 60, OrderType::SWAP_SELL, &maker));
+        som.processNewOrder(Order("SW/C", 0.5, 60, OrderType::SWAP_BUY,  &taker));
+        feed.flush();
+        check("SW 29c: both legs published, linked",         links.size() == 2 && links[0] != 0 && links[0] == links[1] &&
+                                                             legs == std::vector<uint8_t>{ static_cast<uint8_t>(SwapLeg::NEAR),
+                                                                                           static_cast<uint8_t>(SwapLeg::FAR) });
+        auto pt = keeper.getPositions("SW.FeedTaker");
+        check("SW 29c: positions see the legs",              pt.size() == 1 && pt[0].net == 0 &&
+                                                             pt[0].bought == 60 && pt[0].sold == 60 &&
+                                                             std::abs(pt[0].realised - (-30.0)) < 1e-9);
+        check("SW 29c: legs make no candles",                agg.getCandles("SW/C", 0).empty());
+    }
+
+    // ── 30. Implied Crosses ───────────────────────────────────────────────────
+    section("Implied Crosses");
+
+    // 30a. Implied touch from the legs, recomputed only when a leg's touch moves
+    {
+        OrderManager iom(nullptr);
+        EventBus     bus;
+        iom.setEventBus(&bus);
+        Counterparty mm("IM.Maker");
+        auto post = [&](const char* sym, double px, int qty, OrderType type) {
+            iom.processNewOrder(Order(sym, px, qty, type, &mm));
+        };
+        post("EUR/USD", 1.50, 100, OrderType::SPOT_BUY);
+        post("EUR/USD", 2.00, 100, OrderType::SPOT_SELL);
+        post("GBP/USD", 1.00, 300, OrderType::SPOT_BUY);
+        post("GBP/USD", 1.25,  40, OrderType::SPOT_SELL);
+        post("USD/JPY", 100.0, 1000, OrderType::SPOT_BUY);
+        post("USD/JPY", 125.0, 1000, OrderType::SPOT_SELL);
+
+        check("IM 30a: legs must share a currency",          !iom.addImpliedCross("EUR/GBP", "EUR/USD", "USD/JPY") &&
+                                                             !iom.addImpliedCross("EURGBP", "EUR/USD", "GBP/USD"));
+        check("IM 30a: cross configured once",               iom.addImpliedCross("EUR/GBP", "GBP/USD", "EUR/USD") &&
+                                                             !iom.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD"));
+        const ImpliedPricer& ip = iom.getImpliedPricer();
+        const Touch&         eg = ip.quote(0);
+        check("IM 30a: bid = X/C bid / Y/C ask, capped by legs", eg.bid == 1.5 / 1.25 && eg.bidQty == 33);
+        check("IM 30a: ask = X/C ask / Y/C bid",             eg.ask == 2.0 && eg.askQty == 100);
+
+        check("IM 30a: inverted leg priced through",         iom.addImpliedCross("EUR/JPY", "EUR/USD", "USD/JPY") &&
+                                                             std::fabs(ip.quote(1).bid - 150.0) < 1e-9 &&
+                                                             std::fabs(ip.quote(1).ask - 250.0) < 1e-9 &&
+                                                             ip.quote(1).askQty == 100);
+
+        auto conn = bus.subscribe();
+        uint64_t recomputes0 = Metrics::total(Counter::IMPLIED_RECOMPUTES);
+        post("GBP/USD", 0.90, 500, OrderType::SPOT_BUY);   // behind the touch
+        check("IM 30a: depth behind the touch recomputes nothing",
+              Metrics::total(Counter::IMPLIED_RECOMPUTES) == recomputes0 && conn->queue.size() == 1);
+        post("GBP/USD", 1.20, 50, OrderType::SPOT_SELL);   // new best ask: EUR/GBP only
+        check("IM 30a: a touch move recomputes its crosses",
+              Metrics::total(Counter::IMPLIED_RECOMPUTES) == recomputes0 + 1 &&
+              ip.quote(0).bid == 1.5 / 1.2 && ip.quote(0).bidQty == 40);
+        bool published = false;
+        while (!conn->queue.empty()) {
+            if (conn->queue.front().msg.rfind("event: implied_quote\n", 0) == 0) published = true;
+            conn->queue.pop();
+        }
+        check("IM 30a: moved touch published",               published);
+        bus.unsubscribe(conn);
+    }
+
+    // 30b. Orders in the cross fill against implied liquidity as two leg trades
+    {
+        OrderManager iom(nullptr);
+        Counterparty mm("IM.Legs"), client("IM.Client"), direct("IM.Direct");
+        iom.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD");
+        iom.processNewOrder(Order("EUR/USD", 2.00, 100, OrderType::SPOT_SELL, &mm));
+        iom.processNewOrder(Order("GBP/USD", 1.00, 300, OrderType::SPOT_BUY,  &mm));
+        iom.processNewOrder(Order("EUR/GBP", 2.00,  10, OrderType::SPOT_SELL, &direct));
+
+        long     filled = 0;
+        uint64_t fills0 = Metrics::total(Counter::IMPLIED_FILLS);
+        iom.processNewOrder(Order("EUR/GBP", 2.50, 40, OrderType::SPOT_BUY, &client), &filled);
+        const auto& trades = iom.getRecentTrades();
+        check("IM 30b: direct book first at the same price", trades.size() == 3 && trades[0].symbol == "EUR/GBP" &&
+                                                             trades[0].quantity == 10 && trades[0].seller == &direct);
+        check("IM 30b: implied fill buys X/C and sells Y/C", trades[1].symbol == "EUR/USD" && trades[1].buyer == &client &&
+                                                             trades[1].quantity == 30 && trades[1].price == 2.0 &&
+                                                             trades[2].symbol == "GBP/USD" && trades[2].seller == &client &&
+                                                             trades[2].quantity == 60 && trades[2].price == 1.0);
+        check("IM 30b: whole order filled, one implied fill", filled == 40 &&
+                                                             Metrics::total(Counter::IMPLIED_FILLS) == fills0 + 1);
+        check("IM 30b: implied touch follows the fill",      iom.getImpliedPricer().quote(0).askQty == 70);
+
+        iom.processNewOrder(Order("EUR/GBP", 1.90, 5, OrderType::SPOT_BUY, &client), &filled);
+        check("IM 30b: below the implied ask it rests",      filled == 0 && iom.getRecentTrades().size() == 3 &&
+                                                             iom.getSubBook("EUR/GBP").getBuyOrders().count(1.90) == 1);
+    }
+
+    // 30c. Both legs fill in full and the cross by exactly that, beyond int range
+    {
+        OrderManager iom(nullptr);
+        Counterparty mm("IM.BigLegs"), client("IM.BigClient");
+        iom.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD");
+        iom.processNewOrder(Order("EUR/USD", 2.00, 3000000000L, OrderType::SPOT_SELL, &mm));
+        iom.processNewOrder(Order("GBP/USD", 1.00, 7000000000L, OrderType::SPOT_BUY,  &mm));
+        long filled = 0;
+        Order buy("EUR/GBP", 2.00, 3000000000L, OrderType::SPOT_BUY, &client);
+        iom.processNewOrder(buy, &filled);
+        const auto& trades = iom.getRecentTrades();
+        check("IM 30c: long leg quantities not truncated",   trades.size() == 2 && trades[0].quantity == 3000000000L &&
+                                                             trades[1].quantity == 6000000000L);
+        check("IM 30c: cross filled by what the legs took",  filled == 3000000000L && !iom.getOrder(buy.getId()) &&
+                                                             iom.getSubBook("GBP/USD").getBuyOrders().at(1.00).quantity == 1000000000L);
+    }
+
+    // ── 31. Batch Auctions ────────────────────────────────────────────────────
+    section("Batch Auctions");
+
+    // 31a. Orders rest crossed; the auction uncrosses them at one price, price-time
+    {
+        OrderManager aom(nullptr);
+        EventBus     bus;
+        aom.setEventBus(&bus);
+        Counterparty buyer("BA.Buyer"), seller("BA.Seller");
+        aom.setAuctionMode("BA/A", true);
+        Order b1("BA/A", 1.05, 100, OrderType::SPOT_BUY,  &buyer);
+        Order b2("BA/A", 1.03, 200, OrderType::SPOT_BUY,  &buyer);
+        Order a1("BA/A", 1.00, 150, OrderType::SPOT_SELL, &seller);
+        Order a2("BA/A", 1.02, 100, OrderType::SPOT_SELL, &seller);
+        for (const Order& o : { b1, b2, a1, a2 }) aom.processNewOrder(o);
+        aom.processNewOrder(Order("BA/A", 1.01, 100, OrderType::SPOT_BUY,  &buyer));
+        aom.processNewOrder(Order("BA/A", 1.04, 200, OrderType::SPOT_SELL, &seller));
+        Order ioc("BA/A", 1.10, 50, OrderType::SPOT_BUY, &buyer);
+        ioc.setTimeInForce(TimeInForce::IOC);
+        aom.processNewOrder(ioc);
+        SubBook& sb = aom.getSubBook("BA/A");
+        check("BA 31a: orders rest crossed, IOC dropped",    aom.getRecentTrades().empty() && !aom.getOrder(ioc.getId()) &&
+                                                             sb.getBuyOrders().begin()->first == 1.05 &&
+                                                             sb.getSellOrders().begin()->first == 1.00);
+
+        AuctionResult ind = aom.indicativeAuction("BA/A");
+        check("BA 31a: most volume, then bids' surplus lifts it", ind.price == 1.03 && ind.volume == 250 && ind.surplus == 50);
+
+        auto     conn      = bus.subscribe();
+        uint64_t auctions0 = Metrics::total(Counter::AUCTIONS);
+        AuctionResult run  = aom.runAuction("BA/A");
+        const auto& t = aom.getRecentTrades();
+        check("BA 31a: every fill at the auction price",     run.volume == 250 && t.size() == 3 &&
+                                                             t[0].price == 1.03 && t[1].price == 1.03 && t[2].price == 1.03);
+        check("BA 31a: best bids and asks first, FIFO",      t[0].buyOrderId == b1.getId() && t[0].sellOrderId == a1.getId() &&
+                                                             t[0].quantity == 100 &&
+                                                             t[1].buyOrderId == b2.getId() && t[1].sellOrderId == a1.getId() &&
+                                                             t[1].quantity == 50 &&
+                                                             t[2].buyOrderId == b2.getId() && t[2].sellOrderId == a2.getId() &&
+                                                             t[2].quantity == 100);
+        check("BA 31a: book left uncrossed",                 aom.getOrder(b2.getId())->getQuantity() == 50 &&
+                                                             !aom.getOrder(a1.getId()) && !aom.getOrder(a2.getId()) &&
+                                                             sb.getBuyOrders().begin()->first == 1.03 &&
+                                                             sb.getSellOrders().begin()->first == 1.04 &&
+                                                             buyer.getOrderIds().size() == 2);
+        check("BA 31a: one auction event, one book_update",  Metrics::total(Counter::AUCTIONS) == auctions0 + 1 &&
+                                                             conn->queue.size() == 5 &&
+                                                             conn->queue.back().msg.rfind("event: book_update\n", 0) == 0);
+        bus.unsubscribe(conn);
+        check("BA 31a: uncrossed book: nothing to do",       aom.runAuction("BA/A").volume == 0 && t.size() == 3);
+    }
+
+    // 31b. Tie-breaks, hidden reserve, and leaving auction mode
+    {
+        OrderManager aom(nullptr);
+        Counterparty cp("BA.Cp");
+        auto post = [&](const char* sym, double px, long qty, OrderType type) {
+            aom.processNewOrder(Order(sym, px, qty, type, &cp));
+        };
+        for (const char* sym : { "BA/S", "BA/E", "BA/M", "BA/I" }) aom.setAuctionMode(sym, true);
+        post("BA/S", 1.10, 100, OrderType::SPOT_BUY);   // asks left over: lowest tied price
+        post("BA/S", 1.00, 300, OrderType::SPOT_SELL);
+        post("BA/E", 1.10, 100, OrderType::SPOT_BUY);   // balanced: midway
+        post("BA/E", 1.00, 100, OrderType::SPOT_SELL);
+        post("BA/M", 1.00,  50, OrderType::SPOT_BUY);   // bids left at 1.00, asks at 1.10: midway
+        post("BA/M", 1.10, 100, OrderType::SPOT_BUY);
+        post("BA/M", 1.00, 100, OrderType::SPOT_SELL);
+        post("BA/M", 1.10,  50, OrderType::SPOT_SELL);
+        AuctionResult s = aom.indicativeAuction("BA/S"), e = aom.indicativeAuction("BA/E"),
+                      m = aom.indicativeAuction("BA/M");
+        check("BA 31b: asks' surplus takes the lowest price", s.price == 1.00 && s.volume == 100 && s.surplus == -200);
+        check("BA 31b: no surplus: midway",                  std::fabs(e.price - 1.05) < 1e-12 && e.volume == 100 && e.surplus == 0 &&
+                                                             std::fabs(m.price - 1.05) < 1e-12 && m.volume == 100 && m.surplus == 0);
+
+        Order ice("BA/I", 1.00, 100, OrderType::SPOT_SELL, &cp);
+        ice.setDisplayQuantity(20);
+        aom.processNewOrder(ice);
+        post("BA/I", 1.00, 100, OrderType::SPOT_BUY);
+        check("BA 31b: hidden reserve trades in the auction", aom.runAuction("BA/I").volume == 100 &&
+                                                             aom.getRecentTrades().size() == 5 &&   // one per slice
+                                                             aom.getSubBook("BA/I").getSellOrders().empty());
+
+        aom.setAuctionMode("BA/E", false);
+        post("BA/E", 1.20, 10, OrderType::SPOT_SELL);
+        post("BA/E", 1.20, 10, OrderType::SPOT_BUY);
+        const auto& t = aom.getRecentTrades();
+        check("BA 31b: leaving auction mode uncrosses, then continuous",
+              t.size() == 7 && t[5].symbol == "BA/E" && std::fabs(t[5].price - 1.05) < 1e-12 &&
+              t[6].price == 1.20 && aom.getAuctionSymbols().size() == 3);
+    }
+
+    // 31c. An auction-mode leg offers no implied liquidity, even resting crossed
+    {
+        OrderManager aom(nullptr);
+        Counterparty mm("BA.Legs"), client("BA.Cross");
+        aom.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD");
+        aom.processNewOrder(Order("EUR/USD", 2.00, 100, OrderType::SPOT_SELL, &mm));
+        aom.processNewOrder(Order("GBP/USD", 1.00, 300, OrderType::SPOT_BUY,  &mm));
+        const Touch& q = aom.getImpliedPricer().quote(0);
+        const bool priced = q.ask == 2.0;
+
+        aom.setAuctionMode("GBP/USD", true);
+        aom.processNewOrder(Order("GBP/USD", 0.90, 50, OrderType::SPOT_SELL, &mm));   // rests crossed
+        check("BA 31c: auction leg withdraws the implied touch", priced && q.ask == 0 && q.askQty == 0 &&
+                                                             q.bid == 0 && q.bidQty == 0);
+        aom.processNewOrder(Order("EUR/GBP", 2.50, 40, OrderType::SPOT_BUY, &client));
+        check("BA 31c: cross order never trades the auction leg", aom.getRecentTrades().empty() &&
+                                                             aom.getSubBook("EUR/GBP").getBuyOrders().count(2.50) == 1 &&
+                                                             aom.getSubBook("GBP/USD").getSellOrders().count(0.90) == 1);
+
+        aom.setAuctionMode("GBP/USD", false);
+        check("BA 31c: leaving auction mode restores it",    aom.getRecentTrades().size() == 1 &&
+                                                             aom.getRecentTrades()[0].symbol == "GBP/USD" &&
+                                                             q.ask == 2.0 && q.askQty == 100);
+    }
+
+    // ── 32. Allocation Policies ───────────────────────────────────────────────
+    section("Allocation Policies");
+
+    // 32a. Pro-rata shares: rounded on the running total, small shares carried on
+    {
+        Counterparty maker("AL.Maker"), taker("AL.Taker");
+        // One ask level of 50, 30 and 20 (in arrival order); returns the fills, in order
+        auto fills = [&](Allocation allocation, long minQty, long buyQty) {
+            OrderManager aom(nullptr);
+            aom.setAllocation("AL/A", allocation, minQty);
+            std::vector<long> ids;
+            for (long q : { 50, 30, 20 }) {
+                Order o("AL/A", 1.10, q, OrderType::SPOT_SELL, &maker);
+                ids.push_back(o.getId());
+                aom.processNewOrder(o);
+            }
+            aom.processNewOrder(Order("AL/A", 1.10, buyQty, OrderType::SPOT_BUY, &taker));
+            std::vector<std::pair<int, long>> out;   // (maker index, quantity)
+            for (const Trade& t : aom.getRecentTrades())
+                out.emplace_back(static_cast<int>(std::find(ids.begin(), ids.end(), t.sellOrderId) - ids.begin()),
+                                 t.quantity);
+            return out;
+        };
+        using F = std::vector<std::pair<int, long>>;
+        check("AL 32a: FIFO by default",                     fills(Allocation::FIFO, 1, 10) == F{ { 0, 10 } });
+        check("AL 32a: pro-rata in proportion",              fills(Allocation::PRO_RATA, 1, 10) == F{ { 0, 5 }, { 1, 3 }, { 2, 2 } });
+        check("AL 32a: shares rounded to add up",            fills(Allocation::PRO_RATA, 1, 7) == F{ { 0, 3 }, { 1, 2 }, { 2, 2 } });
+        check("AL 32a: share below minimum carried on",      fills(Allocation::PRO_RATA, 3, 7) == F{ { 0, 3 }, { 2, 4 } });
+        check("AL 32a: carry left at the end fills FIFO",    fills(Allocation::PRO_RATA, 5, 7) == F{ { 1, 5 }, { 0, 2 } });
+        check("AL 32a: clearing the level is FIFO",          fills(Allocation::PRO_RATA, 1, 120) == F{ { 0, 50 }, { 1, 30 }, { 2, 20 } });
+        check("AL 32a: top order first, rest pro rata",      fills(Allocation::TOP_ORDER, 1, 60) == F{ { 0, 50 }, { 1, 6 }, { 2, 4 } });
+    }
+
+    // 32b. Pro-rata over displayed quantity; level aggregates stay exact
+    {
+        OrderManager aom(nullptr);
+        Counterparty maker("AL.Ice"), taker("AL.Taker2");
+        aom.setAllocation("AL/B", Allocation::PRO_RATA);
+        Order ice("AL/B", 1.10, 1000, OrderType::SPOT_SELL, &maker);
+        ice.setDisplayQuantity(100);
+        Order plain("AL/B", 1.10, 100, OrderType::SPOT_SELL, &maker);
+        aom.processNewOrder(ice);
+        aom.processNewOrder(plain);
+        aom.processNewOrder(Order("AL/B", 1.09, 40, OrderType::SPOT_SELL, &maker));
+        aom.processNewOrder(Order("AL/B", 1.10, 140, OrderType::SPOT_BUY, &taker));   // clears 1.09, then 100 of 1.10
+        const PriceLevel& level = aom.getSubBook("AL/B").getSellOrders().at(1.10);
+        check("AL 32b: best level first, then shares of the next",
+              aom.getRecentTrades().size() == 3 && aom.getRecentTrades()[1].quantity == 50 &&
+              aom.getRecentTrades()[2].quantity == 50);
+        check("AL 32b: hidden reserve takes no share",       level.quantity == 100 && level.reserve == 900 &&
+                                                             aom.getOrder(ice.getId())->getQuantity() == 50);
+        check("AL 32b: swap book keeps its own (FIFO) policy", aom.getSwapBook("AL/B").getAllocation() == Allocation::FIFO);
+    }
+
+    // 32c. TOP_ORDER with an iceberg on top: its refilled slice takes no
+    //      pro-rata share, so the shares still add up to the remainder
+    {
+        OrderManager aom(nullptr);
+        Counterparty maker("AL.TopIce"), taker("AL.Taker3");
+        aom.setAllocation("AL/C", Allocation::TOP_ORDER);
+        Order ice("AL/C", 1.10, 100, OrderType::SPOT_SELL, &maker);
+        ice.setDisplayQuantity(10);
+        Order b("AL/C", 1.10, 30, OrderType::SPOT_SELL, &maker);
+        Order c("AL/C", 1.10, 20, OrderType::SPOT_SELL, &maker);
+        aom.processNewOrder(ice);
+        aom.processNewOrder(b);
+        aom.processNewOrder(c);
+        aom.processNewOrder(Order("AL/C", 1.10, 35, OrderType::SPOT_BUY, &taker));   // 10 to the top, 25 shared 30:20
+
+        std::vector<std::pair<long, long>> fills;   // (maker order, quantity)
+        for (const Trade& t : aom.getRecentTrades()) fills.emplace_back(t.sellOrderId, t.quantity);
+        using F = std::vector<std::pair<long, long>>;
+        check("AL 32c: refilled top order shares nothing",   fills == F{ { ice.getId(), 10 }, { b.getId(), 15 }, { c.getId(), 10 } });
+        check("AL 32c: refilled slice rests at the back",    aom.getSubBook("AL/C").getSellOrders().at(1.10).back().getId() == ice.getId() &&
+                                                             aom.getOrder(ice.getId())->getQuantity() == 10);
+    }
+
+    // 32d. An auction uncross is FIFO within a level whatever the policy
+    {
+        OrderManager aom(nullptr);
+        Counterparty buyer("AL.AuctionBuyer"), seller("AL.AuctionSeller");
+        aom.setAllocation("AL/D", Allocation::PRO_RATA);
+        aom.setAuctionMode("AL/D", true);
+        Order a("AL/D", 1.00, 50, OrderType::SPOT_SELL, &seller);
+        Order b("AL/D", 1.00, 50, OrderType::SPOT_SELL, &seller);
+        for (const Order* o : { &a, &b }) aom.processNewOrder(*o);
+        aom.processNewOrder(Order("AL/D", 1.00, 50, OrderType::SPOT_BUY, &buyer));
+        check("AL 32d: auction fills the oldest ask first",  aom.runAuction("AL/D").volume == 50 && !aom.getOrder(a.getId()) &&
+                                                             aom.getOrder(b.getId())->getQuantity() == 50);
+    }
+
+    // ── 33. Self-Trade Prevention ─────────────────────────────────────────────
+    section("Self-Trade Prevention");
+
+    // 33a. Each mode against an own ask of 30 queued ahead of another's 50
+    {
+        Counterparty self("ST.Self"), other("ST.Other");
+        struct Outcome { long filled, ownAsk, otherAsk, bid; size_t trades; };
+        auto run = [&](SelfTradePrevention stp) {
+            OrderManager som(nullptr);
+            Order own("ST/A", 1.10, 30, OrderType::SPOT_SELL, &self);
+            Order theirs("ST/A", 1.10, 50, OrderType::SPOT_SELL, &other);
+            Order buy("ST/A", 1.10, 60, OrderType::SPOT_BUY, &self);
+            buy.setSelfTrade(stp);
+            som.processNewOrder(own);
+            som.processNewOrder(theirs);
+            long filled = -1;
+            som.processNewOrder(buy, &filled);
+            auto open = [&](const Order& o) { const Order* r = som.getOrder(o.getId()); return r ? r->getOpenQuantity() : 0; };
+            return Outcome{ filled, open(own), open(theirs), open(buy), som.getRecentTrades().size() };
+        };
+        uint64_t prevented0 = Metrics::total(Counter::SELF_TRADES_PREVENTED);
+        Outcome n  = run(SelfTradePrevention::NONE);
+        Outcome cr = run(SelfTradePrevention::CANCEL_RESTING);
+        Outcome ci = run(SelfTradePrevention::CANCEL_INCOMING);
+        Outcome cb = run(SelfTradePrevention::CANCEL_BOTH);
+        Outcome d  = run(SelfTradePrevention::DECREMENT);
+        check("ST 33a: NONE trades with itself",             n.filled == 60 && n.trades == 2 && n.otherAsk == 20);
+        check("ST 33a: CANCEL_RESTING skips the own order",  cr.filled == 50 && cr.trades == 1 && cr.ownAsk == 0 &&
+                                                             cr.otherAsk == 0 && cr.bid == 10);
+        check("ST 33a: CANCEL_INCOMING stops the sweep",     ci.filled == 0 && ci.trades == 0 && ci.ownAsk == 30 &&
+                                                             ci.otherAsk == 50 && ci.bid == 0);
+        check("ST 33a: CANCEL_BOTH cancels both",            cb.filled == 0 && cb.trades == 0 && cb.ownAsk == 0 &&
+                                                             cb.otherAsk == 50 && cb.bid == 0);
+        check("ST 33a: DECREMENT nets 30, trades the rest",  d.filled == 30 && d.trades == 1 && d.ownAsk == 0 &&
+                                                             d.otherAsk == 20 && d.bid == 0);
+        check("ST 33a: each prevention counted",             Metrics::total(Counter::SELF_TRADES_PREVENTED) == prevented0 + 4);
+    }
+
+    // 33b. Fills before the own order stand; orders with no counterparty never self-match
+    {
+        OrderManager som(nullptr);
+        Counterparty self("ST.Self2"), other("ST.Other2");
+        som.processNewOrder(Order("ST/B", 1.10, 50, OrderType::SPOT_SELL, &other));
+        som.processNewOrder(Order("ST/B", 1.10, 30, OrderType::SPOT_SELL, &self));
+        Order buy("ST/B", 1.10, 60, OrderType::SPOT_BUY, &self);
+        buy.setSelfTrade(SelfTradePrevention::CANCEL_INCOMING);
+        long filled = -1;
+        som.processNewOrder(buy, &filled);
+        check("ST 33b: fills ahead of the own order stand",  filled == 50 && som.getRecentTrades().size() == 1 &&
+                                                             !som.getOrder(buy.getId()));
+
+        som.processNewOrder(Order("ST/B", 1.12, 10, OrderType::SPOT_SELL, nullptr));
+        Order anon("ST/B", 1.12, 40, OrderType::SPOT_BUY, nullptr);
+        anon.setSelfTrade(SelfTradePrevention::CANCEL_BOTH);
+        som.processNewOrder(anon, &filled);
+        check("ST 33b: no counterparty, no prevention",      filled == 40 && som.getRecentTrades().size() == 3);
+    }
+
+    // 33c. Pro-rata: a cancelled own order's share goes to the orders behind it;
+    // a decrement refills an own iceberg like a fill would
+    {
+        OrderManager som(nullptr);
+        Counterparty self("ST.Self3"), other("ST.Other3");
+        som.setAllocation("ST/C", Allocation::PRO_RATA);
+        Order a("ST/C", 1.10, 50, OrderType::SPOT_SELL, &other);
+        Order own("ST/C", 1.10, 30, OrderType::SPOT_SELL, &self);
+        Order b("ST/C", 1.10, 20, OrderType::SPOT_SELL, &other);
+        for (const Order* o : { &a, &own, &b }) som.processNewOrder(*o);
+        Order buy("ST/C", 1.10, 10, OrderType::SPOT_BUY, &self);
+        buy.setSelfTrade(SelfTradePrevention::CANCEL_RESTING);
+        som.processNewOrder(buy);
+        const std::deque<Trade>& t = som.getRecentTrades();
+        check("ST 33c: own share carried to the next order", t.size() == 2 && t[0].sellOrderId == a.getId() && t[0].quantity == 5 &&
+                                                             t[1].sellOrderId == b.getId() && t[1].quantity == 5 &&
+                                                             !som.getOrder(own.getId()));
+
+        Order ice("ST/D", 1.10, 100, OrderType::SPOT_SELL, &self);
+        ice.setDisplayQuantity(20);
+        som.processNewOrder(ice);
+        Order dec("ST/D", 1.10, 30, OrderType::SPOT_BUY, &self);
+        dec.setSelfTrade(SelfTradePrevention::DECREMENT);
+        long filled = -1;
+        som.processNewOrder(dec, &filled);
+        const PriceLevel& level = som.getSubBook("ST/D").getSellOrders().at(1.10);
+        check("ST 33c: decrement refills an own iceberg",    filled == 0 && som.getOrder(ice.getId())->getOpenQuantity() == 70 &&
+                                                             level.quantity == 10 && level.reserve == 60);
+    }
+
+    // 33d. Implied crosses: an order that prevents self-trades leaves the
+    //      implied touch alone when a leg's touch holds its own order, and
+    //      still takes the direct book
+    {
+        Counterparty self("ST.Cross"), mm("ST.Legs"), direct("ST.Direct");
+        auto run = [&](SelfTradePrevention stp, OrderManager& som, Order& ownLeg, Order& buy) {
+            som.addImpliedCross("EUR/GBP", "EUR/USD", "GBP/USD");
+            som.processNewOrder(ownLeg);                                                    // own EUR/USD ask: implied ask 2.0
+            som.processNewOrder(Order("GBP/USD", 1.00, 300, OrderType::SPOT_BUY, &mm));
+            som.processNewOrder(Order("EUR/GBP", 2.20,  10, OrderType::SPOT_SELL, &direct));
+            buy.setSelfTrade(stp);
+            som.processNewOrder(buy);
+        };
+        OrderManager prevent(nullptr), allow(nullptr);
+        Order ownLeg("EUR/USD", 2.00, 100, OrderType::SPOT_SELL, &self);
+        Order buy("EUR/GBP", 2.50, 40, OrderType::SPOT_BUY, &self);
+        run(SelfTradePrevention::CANCEL_RESTING, prevent, ownLeg, buy);
+        const std::deque<Trade>& t = prevent.getRecentTrades();
+        check("ST 33d: implied touch on an own leg not taken", t.size() == 1 && t[0].symbol == "EUR/GBP" &&
+                                                             t[0].price == 2.20 && t[0].quantity == 10);
+        check("ST 33d: own leg order untouched, rest rests", prevent.getOrder(ownLeg.getId())->getQuantity() == 100 &&
+                                                             prevent.getOrder(buy.getId())->getQuantity() == 30);
+
+        Order ownLeg2("EUR/USD", 2.00, 100, OrderType::SPOT_SELL, &self);
+        Order buy2("EUR/GBP", 2.50, 40, OrderType::SPOT_BUY, &self);
+        run(SelfTradePrevention::NONE, allow, ownLeg2, buy2);
+        const std::deque<Trade>& u = allow.getRecentTrades();
+        check("ST 33d: without prevention the implied fill trades", u.size() == 2 && u[0].symbol == "EUR/USD" &&
+                                                             u[0].buyer == &self && u[0].seller == &self);
+    }
+
+    // 33e. Fill-or-kill counts only depth the sweep could trade: own orders
+    //      are left out, and any prevention but CANCEL_RESTING kills on one
+    {
+        Counterparty self("ST.Fok"), other("ST.FokOther");
+        auto run = [&](SelfTradePrevention stp, long otherQty, long& filled) {
+            OrderManager som(nullptr);
+            som.processNewOrder(Order("ST/E", 1.00, otherQty, OrderType::SPOT_SELL, &other));
+            som.processNewOrder(Order("ST/E", 1.00, 10, OrderType::SPOT_SELL, &self));
+            Order fok("ST/E", 1.00, 20, OrderType::SPOT_BUY, &self);
+            fok.setTimeInForce(TimeInForce::FOK);
+            fok.setSelfTrade(stp);
+            filled = -1;
+            som.processNewOrder(fok, &filled);
+            return som.getRecentTrades().size();
+        };
+        long filled = -1;
+        bool allKilled = true;
+        for (SelfTradePrevention stp : { SelfTradePrevention::CANCEL_RESTING, SelfTradePrevention::CANCEL_INCOMING,
+                                         SelfTradePrevention::CANCEL_BOTH, SelfTradePrevention::DECREMENT })
+            allKilled = allKilled && run(stp, 10, filled) == 0 && filled == 0;
+        check("ST 33e: own depth never lets FOK fill part",   allKilled);
+        check("ST 33e: without prevention own depth counts",  run(SelfTradePrevention::NONE, 10, filled) == 2 && filled == 20);
+        check("ST 33e: CANCEL_RESTING fills from others",     run(SelfTradePrevention::CANCEL_RESTING, 20, filled) == 1 && filled == 20);
+        check("ST 33e: CANCEL_INCOMING kills on an own order", run(SelfTradePrevention::CANCEL_INCOMING, 20, filled) == 0 && filled == 0);
+    }
+
+    // 33f. Auctions: an own bid and ask next in line do not trade; the later
+    //      order's mode applies
+    {
+        Counterparty self("ST.Auction"), other("ST.AuctionOther");
+        auto run = [&](SelfTradePrevention stp, long& volume, bool& bidLeft, bool& askLeft) {
+            OrderManager som(nullptr);
+            som.setAuctionMode("ST/F", true);
+            Order bid("ST/F", 1.00, 10, OrderType::SPOT_BUY, &self);
+            Order ask("ST/F", 1.00, 10, OrderType::SPOT_SELL, &self);
+            ask.setSelfTrade(stp);
+            som.processNewOrder(bid);
+            som.processNewOrder(ask);
+            volume  = som.runAuction("ST/F").volume;
+            bidLeft = som.getOrder(bid.getId()) != nullptr;
+            askLeft = som.getOrder(ask.getId()) != nullptr;
+            return som.getRecentTrades().size();
+        };
+        long volume = -1;
+        bool bidLeft = false, askLeft = false;
+        check("ST 33f: CANCEL_BOTH: no wash trade, both gone", run(SelfTradePrevention::CANCEL_BOTH, volume, bidLeft, askLeft) == 0 &&
+                                                             volume == 0 && !bidLeft && !askLeft);
+        check("ST 33f: CANCEL_RESTING cancels the earlier",  run(SelfTradePrevention::CANCEL_RESTING, volume, bidLeft, askLeft) == 0 &&
+                                                             !bidLeft && askLeft);
+        check("ST 33f: CANCEL_INCOMING cancels the later",   run(SelfTradePrevention::CANCEL_INCOMING, volume, bidLeft, askLeft) == 0 &&
+                                                             bidLeft && !askLeft);
+        check("ST 33f: without prevention the pair trades",  run(SelfTradePrevention::NONE, volume, bidLeft, askLeft) == 1 && volume == 10);
+
+        OrderManager som(nullptr);
+        som.setAuctionMode("ST/G", true);
+        som.processNewOrder(Order("ST/G", 1.00, 10, OrderType::SPOT_BUY, &self));
+        som.processNewOrder(Order("ST/G", 1.00, 10, OrderType::SPOT_BUY, &other));
+        Order ask("ST/G", 1.00, 20, OrderType::SPOT_SELL, &self);
+        ask.setSelfTrade(SelfTradePrevention::DECREMENT);
+        som.processNewOrder(ask);
+        const std::deque<Trade>& t = som.getRecentTrades();
+        check("ST 33f: decrement nets, the next bid trades", som.runAuction("ST/G").volume == 10 && t.size() == 1 &&
+                                                             t[0].buyer == &other && !som.getOrder(ask.getId()));
+    }
+
+    // ── 34. Quotes ────────────────────────────────────────────────────────────
+    section("Quotes");
+
+    // 34a. A quote's sides are amended where they rest, one book_update per quote
+    {
+        OrderManager qom(nullptr);
+        EventBus     bus;
+        qom.setEventBus(&bus);
+        Counterparty mm("QU.MM"), other("QU.Other");
+        auto conn = bus.subscribe();
+        SubBook& sb = qom.getSubBook("QU/A");
+        auto quote = [&](double bid, long bidQty, double ask, long askQty, QuoteSlot* sides = nullptr) {
+            return qom.processQuote(mm, Quote{ "QU/A", bid, bidQty, ask, askQty }, 0, sides);
+        };
+
+        QuoteSlot first{}, moved{};
+        uint64_t  quotes0 = Metrics::total(Counter::QUOTES);
+        check("QU 34a: first quote enters both sides",       quote(1.09, 10, 1.11, 10, &first) == QuoteResult::APPLIED &&
+                                                             first.bidId && first.askId &&
+                                                             sb.getBuyOrders().begin()->first == 1.09 &&
+                                                             sb.getSellOrders().begin()->first == 1.11);
+        quote(1.10, 20, 1.12, 15, &moved);
+        check("QU 34a: requote amends the same orders",      moved.bidId == first.bidId && moved.askId == first.askId &&
+                                                             sb.getBuyOrders().begin()->second.quantity == 20 &&
+                                                             sb.getSellOrders().begin()->first == 1.12 && sb.getSellOrders().size() == 1);
+        check("QU 34a: one book_update per quote",           conn->queue.size() == 2 && Metrics::total(Counter::QUOTES) == quotes0 + 2);
+
+        qom.processNewOrder(Order("QU/A", 1.10, 5, OrderType::SPOT_BUY, &other));
+        quote(1.10, 12, 1.12, 15);
+        check("QU 34a: size cut keeps time priority",        sb.getBuyOrders().begin()->second.front().getId() == first.bidId &&
+                                                             sb.getBuyOrders().begin()->second.quantity == 17);
+        const size_t events = conn->queue.size();
+        quote(1.10, 12, 1.12, 15);
+        check("QU 34a: unchanged quote publishes nothing",   conn->queue.size() == events);
+
+        quote(1.13, 12, 1.14, 15, &moved);   // bid above the old ask: the ask moves first
+        check("QU 34a: moving through itself never trades", qom.getRecentTrades().empty() && moved.bidId == first.bidId &&
+                                                             sb.getBuyOrders().begin()->first == 1.13);
+        quote(1.13, 12, 0, 0, &moved);
+        check("QU 34a: quantity 0 pulls the side",           moved.askId == 0 && sb.getSellOrders().empty() &&
+                                                             !qom.getOrder(first.askId));
+        check("QU 34a: invalid quote changes nothing",       quote(1.14, 5, 1.14, 5) == QuoteResult::INVALID &&
+                                                             quote(1.14, -1, 1.15, 5) == QuoteResult::INVALID &&
+                                                             sb.getBuyOrders().begin()->first == 1.13);
+        bus.unsubscribe(conn);
+    }
+
+    // 34b. A crossing side trades first; a filled or refused side is replaced or pulled
+    {
+        OrderManager qom(nullptr);
+        RiskManager  risk;
+        risk.setDefaultLimits({ 100, 0, 0, 0, 0 });
+        qom.setRiskManager(&risk);
+        Counterparty mm("QU.MM2"), other("QU.Other2");
+        qom.processNewOrder(Order("QU/B", 1.10, 5, OrderType::SPOT_SELL, &other));
+
+        QuoteSlot sides{};
+        qom.processQuote(mm, Quote{ "QU/B", 1.10, 8, 1.12, 10 }, 0, &sides);
+        const long bidId = sides.bidId;
+        check("QU 34b: crossing side fills, rest rests",     qom.getRecentTrades().size() == 1 && qom.getRecentTrades()[0].quantity == 5 &&
+                                                             qom.getOrder(bidId)->getQuantity() == 3);
+
+        qom.processNewOrder(Order("QU/B", 1.09, 3, OrderType::SPOT_SELL, &other));   // fills the quote's bid
+        qom.processQuote(mm, Quote{ "QU/B", 1.08, 8, 1.12, 10 }, 0, &sides);
+        check("QU 34b: filled side re-entered as a new order", sides.bidId != 0 && sides.bidId != bidId &&
+                                                             qom.getOrder(sides.bidId)->getPrice() == 1.08);
+
+        RejectReason reason = RejectReason::NONE;
+        const QuoteResult r = qom.processQuote(mm, Quote{ "QU/B", 1.08, 8, 1.12, 500 }, 0, &sides, &reason);
+        check("QU 34b: refused side pulled, other kept",     r == QuoteResult::REJECTED && reason == RejectReason::MAX_ORDER_QTY &&
+                                                             sides.askId == 0 && qom.getSubBook("QU/B").getSellOrders().empty() &&
+                                                             sides.bidId != 0 && mm.getOrderIds().size() == 1);
+    }
+
+    // 34c. A re-quote's self-trade prevention applies to the amend it makes
+    {
+        OrderManager qom(nullptr);
+        Counterparty mm("QU.MM3");
+        Order own("QU/C", 1.10, 10, OrderType::SPOT_SELL, &mm);   // not part of the quote
+        qom.processNewOrder(own);
+        QuoteSlot sides{};
+        qom.processQuote(mm, Quote{ "QU/C", 1.00, 10, 1.20, 10 }, 0, &sides);
+        qom.processQuote(mm, Quote{ "QU/C", 1.10, 10, 1.20, 10, SelfTradePrevention::CANCEL_RESTING }, 0, &sides);
+        check("QU 34c: crossing amend uses the quote's mode", qom.getRecentTrades().empty() && !qom.getOrder(own.getId()) &&
+                                                             qom.getOrder(sides.bidId)->getPrice() == 1.10 &&
+                                                             qom.getOrder(sides.bidId)->getSelfTrade() == SelfTradePrevention::CANCEL_RESTING);
+    }
+
     // ── Summary ───────────────────────────────────────────────────────────────
     std::cout << "\n" << std::string(45, '=') << "\n";
     std::cout << "Results: " << passed << " passed, " << failed << " failed\n";